@@ -0,0 +1,52 @@
+"""
+Compare two microbenchmark result files written by `pio test -e bench`.
+
+  python3 bench_compare.py BASE.json NEW.json [--threshold PCT]
+
+Prints ns/op, allocations/op and bytes/op side by side for each benchmark in
+both files. Exits 1 if any benchmark got slower by more than the threshold
+(default 10 %) or allocates more than before.
+"""
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {r["name"]: r for r in json.load(f)["results"]}
+
+
+def main(argv):
+    args = [a for a in argv if not a.startswith("--")]
+    threshold = 10.0
+    if "--threshold" in argv:
+        threshold = float(argv[argv.index("--threshold") + 1])
+        args.remove(argv[argv.index("--threshold") + 1])
+    if len(args) != 2:
+        sys.stderr.write(__doc__)
+        return 2
+
+    base, new = load(args[0]), load(args[1])
+    regressions = 0
+    print("%-32s %12s %12s %8s %14s %14s" % (
+        "benchmark", "base ns/op", "new ns/op", "change", "allocs/op", "bytes/op"))
+    for name, n in new.items():
+        b = base.get(name)
+        if not b:
+            print("%-32s %12s %12.1f %8s" % (name, "-", n["ns_per_op"], "new"))
+            continue
+        change = (n["ns_per_op"] / b["ns_per_op"] - 1.0) * 100.0 if b["ns_per_op"] else 0.0
+        slower = change > threshold
+        more_allocs = (n["allocs_per_op"] > b["allocs_per_op"]
+                       or n["alloc_bytes_per_op"] > b["alloc_bytes_per_op"])
+        flag = "  <-- regression" if slower or more_allocs else ""
+        regressions += 1 if flag else 0
+        print("%-32s %12.1f %12.1f %+7.1f%% %6.2f -> %-6.2f %6.0f -> %-6.0f%s" % (
+            name, b["ns_per_op"], n["ns_per_op"], change,
+            b["allocs_per_op"], n["allocs_per_op"],
+            b["alloc_bytes_per_op"], n["alloc_bytes_per_op"], flag))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
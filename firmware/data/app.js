@@ -15,6 +15,23 @@
   var GITHUB_REPO = 'MrMatt57/pitclaw';
   var OTA_CHUNK_SIZE = 4096;
 
+  // Binary WebSocket frames (see firmware/src/binary_frame.h)
+  var BIN_PROTOCOL_VERSION = 1;
+  var BIN_FRAME_DATA = 0x01;
+  var BIN_FRAME_HISTORY = 0x02;
+  var BIN_HISTORY_HEADER_SIZE = 16;
+  var BIN_HISTORY_RECORD_SIZE = 16;
+  var BIN_HISTORY_APPEND = 0x01;
+  var BIN_HISTORY_FINAL = 0x02;
+  var BIN_FLAG_LID = 0x0001;
+  var BIN_FLAG_PIT_DISC = 0x0002;
+  var BIN_FLAG_MEAT1_DISC = 0x0004;
+  var BIN_FLAG_MEAT2_DISC = 0x0008;
+  var BIN_FLAG_PIT_SHORT = 0x0010;
+  var BIN_FLAG_MEAT1_SHORT = 0x0020;
+  var BIN_FLAG_MEAT2_SHORT = 0x0040;
+  var BIN_FAN_MODES = ['fan_only', 'fan_and_damper', 'damper_primary'];
+
   // ---------------------------------------------------------------------------
   // State
   // ---------------------------------------------------------------------------
@@ -39,6 +56,8 @@
   var cookTimerStart = null;  // server timestamp (seconds) when cook started
   var cookTimerInterval = null;
   var latestServerTs = null;  // most recent msg.ts from server (seconds)
+  var sessionId = null;       // cook the chart holds (server start time), for resync
+  var historyReplay = null;   // history chunks being assembled (see handleHistoryChunk)
 
   var debounceTimers = {};
   var seriesShow = null; // persists toggle state across chart recreation
@@ -253,6 +272,7 @@
 
     try {
       ws = new WebSocket(url);
+      ws.binaryType = 'arraybuffer';
     } catch (e) {
       console.error('WebSocket creation failed:', e);
       scheduleReconnect();
@@ -264,12 +284,24 @@
       connected = true;
       wsBackoff = 1000;
       updateConnectionStatus(true);
+      historyReplay = null;
+      // Ask for binary data/history frames; the server answers with the
+      // version it will use (0 = JSON)
+      wsSend({ type: 'hello', bin: BIN_PROTOCOL_VERSION });
+      // The chart survives reconnects: ask only for what was missed. The
+      // server sends a full replay instead if the cook has changed.
+      var n = chartData[0].length;
+      wsSend({
+        type: 'sync',
+        session: sessionId || 0,
+        since: sessionId && n > 0 ? chartData[0][n - 1] : 0
+      });
     };
 
     ws.onmessage = function (evt) {
       try {
-        var msg = JSON.parse(evt.data);
-        handleMessage(msg);
+        var msg = typeof evt.data === 'string' ? JSON.parse(evt.data) : decodeBinaryFrame(evt.data);
+        if (msg) handleMessage(msg);
       } catch (e) {
         console.warn('Failed to parse WS message:', e);
       }
@@ -304,6 +336,88 @@
     }
   }
 
+  // ---------------------------------------------------------------------------
+  // Binary Frames
+  // ---------------------------------------------------------------------------
+  // Decode a binary frame into the same object the JSON message would parse
+  // to, so everything downstream of handleMessage is format-agnostic.
+  function decodeBinaryFrame(buf) {
+    var v = new DataView(buf);
+    if (v.byteLength < 2 || v.getUint8(1) > BIN_PROTOCOL_VERSION) {
+      console.warn('Unsupported binary frame');
+      return null;
+    }
+    var type = v.getUint8(0);
+    if (type === BIN_FRAME_DATA) return decodeDataFrame(v);
+    if (type === BIN_FRAME_HISTORY) return decodeHistoryFrame(v);
+    return null;
+  }
+
+  // Tenths of a degree -> degrees; null when disconnected, -1 when shorted
+  function binTemp(v, offset, flags, discFlag, shortFlag) {
+    if (flags & discFlag) return null;
+    if (flags & shortFlag) return -1;
+    return v.getInt16(offset, true) / 10;
+  }
+
+  function decodeDataFrame(v) {
+    var flags = v.getUint16(2, true);
+    var est = v.getUint32(16, true);
+    var m1t = v.getUint16(22, true);
+    var m2t = v.getUint16(24, true);
+    return {
+      type: 'data',
+      ts: v.getUint32(4, true),
+      pit: binTemp(v, 8, flags, BIN_FLAG_PIT_DISC, BIN_FLAG_PIT_SHORT),
+      meat1: binTemp(v, 10, flags, BIN_FLAG_MEAT1_DISC, BIN_FLAG_MEAT1_SHORT),
+      meat2: binTemp(v, 12, flags, BIN_FLAG_MEAT2_DISC, BIN_FLAG_MEAT2_SHORT),
+      fan: v.getUint8(14),
+      damper: v.getUint8(15),
+      est: est > 0 ? est : null,
+      sp: v.getInt16(20, true),
+      meat1Target: m1t > 0 ? m1t : null,
+      meat2Target: m2t > 0 ? m2t : null,
+      fanMode: BIN_FAN_MODES[v.getUint8(26)],
+      lid: (flags & BIN_FLAG_LID) !== 0,
+      errors: []
+    };
+  }
+
+  function decodeHistoryFrame(v) {
+    var chunkFlags = v.getUint8(2);
+    var session = v.getUint32(4, true);
+    var m1t = v.getUint16(10, true);
+    var m2t = v.getUint16(12, true);
+    var count = v.getUint16(14, true);
+    var data = [];
+    for (var i = 0; i < count; i++) {
+      var o = BIN_HISTORY_HEADER_SIZE + i * BIN_HISTORY_RECORD_SIZE;
+      if (o + BIN_HISTORY_RECORD_SIZE > v.byteLength) break;
+      var flags = v.getUint16(o + 14, true);
+      data.push({
+        ts: v.getUint32(o, true),
+        pit: binTemp(v, o + 4, flags, BIN_FLAG_PIT_DISC, BIN_FLAG_PIT_SHORT),
+        meat1: binTemp(v, o + 6, flags, BIN_FLAG_MEAT1_DISC, BIN_FLAG_MEAT1_SHORT),
+        meat2: binTemp(v, o + 8, flags, BIN_FLAG_MEAT2_DISC, BIN_FLAG_MEAT2_SHORT),
+        fan: v.getUint8(o + 10),
+        damper: v.getUint8(o + 11),
+        sp: v.getInt16(o + 12, true),
+        lid: (flags & BIN_FLAG_LID) !== 0
+      });
+    }
+    return {
+      type: 'history_chunk',
+      seq: v.getUint8(3),
+      session: session,
+      append: (chunkFlags & BIN_HISTORY_APPEND) !== 0,
+      sp: v.getInt16(8, true),
+      meat1Target: m1t > 0 ? m1t : null,
+      meat2Target: m2t > 0 ? m2t : null,
+      data: data,
+      final: (chunkFlags & BIN_HISTORY_FINAL) !== 0
+    };
+  }
+
   function updateConnectionStatus(isConnected) {
     if (isConnected) {
       dom.wifiIcon.classList.add('connected');
@@ -367,8 +481,8 @@
       updateCookTimer(msg);
       updatePredictions();
       checkTargetNotifications(msg);
-    } else if (msg.type === 'history') {
-      loadHistory(msg);
+    } else if (msg.type === 'history_chunk') {
+      handleHistoryChunk(msg);
     } else if (msg.type === 'session' && msg.action === 'reset') {
       handleSessionReset(msg);
     } else if (msg.type === 'session' && msg.action === 'download') {
@@ -385,6 +499,8 @@
     closeSettings();
     resetCookTimer();
     latestServerTs = null;
+    sessionId = null;
+    historyReplay = null;
 
     for (var i = 0; i < chartData.length; i++) {
       chartData[i] = [];
@@ -407,19 +523,17 @@
   }
 
   function handleSessionDownload(msg) {
-    if (!msg.data) return;
-    var blob = new Blob([msg.data], { type: 'text/csv' });
-    var url = URL.createObjectURL(blob);
+    // The server names the streamed export rather than sending the data
+    if (!msg.url) return;
     var a = document.createElement('a');
-    a.href = url;
-    a.download = 'cook-session.csv';
+    a.href = msg.url;
+    a.download = msg.format === 'json' ? 'cook-session.json' : 'cook-session.csv';
     document.body.appendChild(a);
     a.click();
     document.body.removeChild(a);
-    URL.revokeObjectURL(url);
   }
 
-  function loadHistory(msg) {
+  function applyHistoryHeader(msg) {
     // Restore alarm targets and setpoint (server values are always °F)
     if (msg.sp !== undefined) {
       pitSetpoint = msg.sp;
@@ -440,39 +554,69 @@
         hideMeatTarget(2);
       }
     }
+  }
 
-    // Populate chart data from history (stored as °F)
-    if (!msg.data || !msg.data.length) return;
+  function pushHistoryPoint(d) {
+    chartData[0].push(d.ts);
+    chartData[1].push(d.pit !== null && d.pit !== undefined && d.pit !== -1 ? d.pit : null);
+    chartData[2].push(d.meat1 !== null && d.meat1 !== undefined && d.meat1 !== -1 ? d.meat1 : null);
+    chartData[3].push(d.meat2 !== null && d.meat2 !== undefined && d.meat2 !== -1 ? d.meat2 : null);
+    chartData[4].push(d.fan !== undefined ? d.fan : null);
+    chartData[5].push(d.damper !== undefined ? d.damper : null);
+    chartData[6].push(d.sp !== undefined ? d.sp : pitSetpoint);
+    chartData[7].push(meat1Target);
+    chartData[8].push(meat2Target);
+  }
 
-    // Reset chart arrays
-    for (var i = 0; i < chartData.length; i++) {
-      chartData[i] = [];
+  // History arrives as a run of history_chunk messages. Points go into the
+  // chart arrays as each chunk lands, and the chart is redrawn once, on the
+  // final chunk. A full replay (seq 0 without append) replaces the chart; an
+  // append adds the points recorded while we were disconnected.
+  function handleHistoryChunk(msg) {
+    if (msg.seq === 0) {
+      sessionId = msg.session || null;
+      applyHistoryHeader(msg);
+
+      var n = chartData[0].length;
+      historyReplay = {
+        append: !!msg.append,
+        lastTs: msg.append && n > 0 ? chartData[0][n - 1] : 0,
+        last: null
+      };
+      if (!msg.append) {
+        // Reset chart arrays and re-derive the cook timer (server is source of truth)
+        for (var i = 0; i < chartData.length; i++) {
+          chartData[i] = [];
+        }
+        resetCookTimer();
+      }
+    } else if (!historyReplay) {
+      return;  // Tail of a replay that was cut short by a reset
     }
 
-    for (var j = 0; j < msg.data.length; j++) {
-      var d = msg.data[j];
-      chartData[0].push(d.ts);
-      chartData[1].push(d.pit !== null && d.pit !== undefined && d.pit !== -1 ? d.pit : null);
-      chartData[2].push(d.meat1 !== null && d.meat1 !== undefined && d.meat1 !== -1 ? d.meat1 : null);
-      chartData[3].push(d.meat2 !== null && d.meat2 !== undefined && d.meat2 !== -1 ? d.meat2 : null);
-      chartData[4].push(d.fan !== undefined ? d.fan : null);
-      chartData[5].push(d.damper !== undefined ? d.damper : null);
-      chartData[6].push(d.sp !== undefined ? d.sp : pitSetpoint);
-      chartData[7].push(meat1Target);
-      chartData[8].push(meat2Target);
+    var r = historyReplay;
+    var data = msg.data || [];
+    for (var j = 0; j < data.length; j++) {
+      if (data[j].ts <= r.lastTs) continue;
+      pushHistoryPoint(data[j]);
+      r.lastTs = data[j].ts;
+      r.last = data[j];
+      if (!r.append && !cookTimerStart) updateCookTimer(data[j]);
     }
 
-    // Update display with the latest point
-    var last = msg.data[msg.data.length - 1];
-    latestServerTs = last.ts;
-    updateTemperatures(last);
-    updateOutputs(last);
+    if (msg.final) finishHistoryReplay();
+  }
 
-    // Reset cook timer and re-derive from history (server is source of truth)
-    resetCookTimer();
-    for (var k = 0; k < msg.data.length; k++) {
-      updateCookTimer(msg.data[k]);
-      if (cookTimerStart) break;
+  function finishHistoryReplay() {
+    var r = historyReplay;
+    historyReplay = null;
+
+    // Update display with the latest point
+    if (r.last) {
+      latestServerTs = r.last.ts;
+      updateTemperatures(r.last);
+      updateOutputs(r.last);
+      if (r.append) trimChartData(latestServerTs);
     }
 
     if (chart) {
@@ -770,6 +914,15 @@
     chartData[7].push(meat1Target);
     chartData[8].push(meat2Target);
 
+    trimChartData(now);
+
+    if (chart) {
+      chart.setData(buildChartDataWithPrediction());
+    }
+    updateLegendValues(null);
+  }
+
+  function trimChartData(now) {
     // Trim data older than 4 hours (keep extra buffer beyond 2h visible window)
     var cutoff = now - 4 * 60 * 60;
     while (chartData[0].length > 0 && chartData[0][0] < cutoff) {
@@ -777,11 +930,6 @@
         chartData[i].shift();
       }
     }
-
-    if (chart) {
-      chart.setData(buildChartDataWithPrediction());
-    }
-    updateLegendValues(null);
   }
 
   function clearTargetFromChart(seriesIndex) {
@@ -1310,7 +1458,13 @@
     });
 
     dom.btnDownloadCSV.addEventListener('click', function () {
-      wsSend({ type: 'session', action: 'download', format: 'csv' });
+      // Streamed by the server straight from flash, so it covers the whole cook
+      var a = document.createElement('a');
+      a.href = '/api/session.csv';
+      a.download = 'cook-session.csv';
+      document.body.appendChild(a);
+      a.click();
+      document.body.removeChild(a);
     });
 
     // Fan mode buttons
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "config.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <stdint.h>
+
+// Thermistor resistance for a raw count through the REFERENCE_RESISTANCE
+// pull-up divider (0 for counts at or below zero)
+inline float adcCountsToOhms(int16_t raw) {
+    if (raw <= 0) return 0.0f;
+    return REFERENCE_RESISTANCE * ((float)ADC_MAX_VALUE / (float)raw - 1.0f);
+}
+
+// One raw conversion from the diagnostic stream
+struct AdcSample {
+    uint32_t us;        // Sample time (micros(), wraps)
+    uint8_t  probe;     // ProbeIndex
+    int16_t  raw;       // ADS1115 counts
+    float    ohms;      // Thermistor resistance from raw (0 = shorted/invalid)
+};
+
+// Raw ADC samples on their way from the diagnostic sampler (a task on the
+// device, a thread in the simulator) to the web server. The sampler never
+// waits: a sample that finds the ring full is dropped and counted, so a stalled
+// consumer costs data, never sampling time.
+//
+// Single producer (push), single consumer (drain).
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class AdcDiagRing {
+public:
+    AdcDiagRing() : _pushed(0), _dropped(0) {}
+
+    // Producer: queue a sample. Returns false (and counts it) if the ring is full.
+    bool push(const AdcSample& s) {
+        if (!_queue.push(s)) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _pushed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer: move up to max of the oldest samples into out. Returns the count.
+    uint16_t drain(AdcSample* out, uint16_t max) {
+        uint16_t n = 0;
+        while (n < max && _queue.pop(out[n])) n++;
+        return n;
+    }
+
+    size_t size() const { return _queue.size(); }
+    static constexpr size_t capacity() { return decltype(_queue)::capacity(); }
+
+    uint32_t getPushed() const    { return _pushed.load(std::memory_order_relaxed); }
+    uint32_t getDropped() const   { return _dropped.load(std::memory_order_relaxed); }  // Ring full
+    uint32_t getHighWater() const { return _queue.getHighWater(); }
+
+private:
+    SpscQueue<AdcSample, TEMP_DIAG_QUEUE_SIZE> _queue;
+    std::atomic<uint32_t> _pushed;
+    std::atomic<uint32_t> _dropped;
+};
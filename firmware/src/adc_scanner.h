@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+
+// Counters for an AdcScanner, reported by GET /api/stats
+struct AdcScanStats {
+    uint32_t sweeps = 0;            // Sweeps completed
+    uint32_t conversions = 0;       // Results collected
+    uint32_t timeouts = 0;          // Conversions never reported ready
+    uint32_t startErrors = 0;       // Conversions the ADC refused to start
+    uint32_t skipped = 0;           // Sweeps asked for while one was running
+    uint32_t aborted = 0;           // Sweeps abandoned (bus taken by another user)
+    uint32_t maxConversionUs = 0;   // Longest start-to-collect time
+    uint32_t lastSweepUs = 0;       // Start-to-finish time of the last sweep
+};
+
+// Non-blocking round-robin acquisition on a single-shot ADC such as the
+// ADS1115. A sweep starts one conversion, and each poll() collects it once
+// the ADC reports it ready and starts the next channel, so no call ever
+// waits out a conversion. Called from a periodic tick, one conversion
+// finishes per tick whenever a conversion is shorter than the tick.
+//
+// With samples > 1 a sweep goes round the channels that many times, so each
+// channel's conversions are spread across the sweep rather than taken back
+// to back, and a glitch rarely hits two of them.
+//
+// Adc is any type with:
+//   bool    start(uint8_t channel);   // Begin a single-shot conversion
+//   bool    ready();                  // Has it finished? (must not block)
+//   int16_t read();                   // Result of the finished conversion
+//
+// A conversion that is not ready within timeoutUs, or that fails to start,
+// is left out of its slot's samples and the scan moves on.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+template <typename Adc>
+class AdcScanner {
+public:
+    static const uint8_t MAX_CHANNELS = 4;   // ADS1115 single-ended inputs
+    static const uint8_t MAX_SAMPLES = 8;    // Conversions per channel per sweep
+
+    AdcScanner(Adc& adc, const uint8_t* channels, uint8_t count, uint32_t timeoutUs,
+               uint8_t samples = 1)
+        : _adc(adc)
+        , _count(count > MAX_CHANNELS ? MAX_CHANNELS : count)
+        , _samples(samples < 1 ? 1 : (samples > MAX_SAMPLES ? MAX_SAMPLES : samples))
+        , _timeoutUs(timeoutUs)
+        , _step(0)
+        , _busy(false)
+        , _completed(false)
+        , _startUs(0)
+        , _sweepStartUs(0)
+    {
+        for (uint8_t i = 0; i < MAX_CHANNELS; i++) {
+            _channels[i] = i < _count ? channels[i] : 0;
+            _n[i] = 0;
+            for (uint8_t j = 0; j < MAX_SAMPLES; j++) _raw[i][j] = 0;
+        }
+    }
+
+    // Begin a sweep over every channel. Ignored (and counted) while one runs.
+    // The next poll() reports completion, even if no channel would start.
+    void requestSweep(uint32_t nowUs) {
+        if (_busy) {
+            _stats.skipped++;
+            return;
+        }
+        _busy = true;
+        _sweepStartUs = nowUs;
+        _step = 0;
+        for (uint8_t i = 0; i < _count; i++) _n[i] = 0;
+        startStep(nowUs);
+    }
+
+    // Collect a finished conversion and start the next one. Returns true on
+    // the call that completes a sweep; the results stay until the next one.
+    bool poll(uint32_t nowUs) {
+        if (_busy) {
+            if (_adc.ready()) {
+                uint8_t slot = _step % _count;
+                _raw[slot][_n[slot]++] = _adc.read();
+                _stats.conversions++;
+                uint32_t took = nowUs - _startUs;
+                if (took > _stats.maxConversionUs) _stats.maxConversionUs = took;
+                _step++;
+                startStep(nowUs);
+            } else if (nowUs - _startUs >= _timeoutUs) {
+                _stats.timeouts++;
+                _step++;
+                startStep(nowUs);
+            }
+        }
+        if (!_completed) return false;
+        _completed = false;
+        return true;
+    }
+
+    // Drop the sweep in progress, e.g. when something else has used the ADC
+    void abort() {
+        if (!_busy) return;
+        _busy = false;
+        _completed = false;
+        _stats.aborted++;
+    }
+
+    bool busy() const { return _busy; }
+    uint8_t getCount() const { return _count; }
+    uint8_t getSamplesPerChannel() const { return _samples; }
+    uint8_t getChannel(uint8_t slot) const { return slot < _count ? _channels[slot] : 0; }
+
+    // Results of the last sweep for the channel in slot (the order given to
+    // the constructor): the conversions collected, oldest first. isValid()
+    // is false if none were (all timed out or never started).
+    uint8_t getSampleCount(uint8_t slot) const { return slot < _count ? _n[slot] : 0; }
+    const int16_t* getSamples(uint8_t slot) const { return _raw[slot < _count ? slot : 0]; }
+    bool isValid(uint8_t slot) const { return getSampleCount(slot) > 0; }
+
+    // Newest conversion for the channel in slot
+    int16_t getRaw(uint8_t slot) const { return isValid(slot) ? _raw[slot][_n[slot] - 1] : 0; }
+
+    const AdcScanStats& getStats() const { return _stats; }
+
+private:
+    // Start the current step's conversion, moving past any that fail to
+    // start; past the last step the sweep is complete
+    void startStep(uint32_t nowUs) {
+        for (uint16_t total = (uint16_t)_count * _samples; _step < total; _step++) {
+            _startUs = nowUs;
+            if (_adc.start(_channels[_step % _count])) return;
+            _stats.startErrors++;
+        }
+        _busy = false;
+        _completed = true;
+        _stats.sweeps++;
+        _stats.lastSweepUs = nowUs - _sweepStartUs;
+    }
+
+    Adc& _adc;
+    uint8_t  _channels[MAX_CHANNELS];
+    uint8_t  _count;
+    uint8_t  _samples;
+    uint32_t _timeoutUs;
+
+    // Sweep state
+    uint16_t _step;           // Conversion in the sweep; slot = step % count
+    bool     _busy;
+    bool     _completed;      // Finished, not yet reported by poll()
+    uint32_t _startUs;        // Current conversion started
+    uint32_t _sweepStartUs;
+
+    int16_t  _raw[MAX_CHANNELS][MAX_SAMPLES];
+    uint8_t  _n[MAX_CHANNELS];
+
+    AdcScanStats _stats;
+};
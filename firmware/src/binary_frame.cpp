@@ -0,0 +1,249 @@
+#include "binary_frame.h"
+#include <cmath>
+#include <cstring>
+
+namespace bbq_protocol {
+
+// ---------------------------------------------------------------------------
+// Little-endian field access
+// ---------------------------------------------------------------------------
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void putF32(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    putU32(p, bits);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float getF32(const uint8_t* p) {
+    uint32_t bits = getU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Degrees -> int16 tenths, rounded and clamped
+static int16_t toTenths(float v) {
+    float t = roundf(v * 10.0f);
+    if (t > 32767.0f)  return 32767;
+    if (t < -32768.0f) return -32768;
+    return (int16_t)t;
+}
+
+// Whole degrees (setpoint, targets) as the JSON messages send them
+static uint16_t toWhole(float v) {
+    if (!(v > 0)) return 0;
+    if (v > 65535.0f) return 65535;
+    return (uint16_t)v;
+}
+
+// Probe reading -> tenths plus disconnected/shorted flags
+static int16_t encodeTemp(float v, uint16_t discFlag, uint16_t shortFlag, uint16_t& flags) {
+    if (std::isnan(v))  { flags |= discFlag;  return 0; }
+    if (v == -1.0f)     { flags |= shortFlag; return 0; }
+    return toTenths(v);
+}
+
+static float decodeTemp(const uint8_t* p, uint16_t flags, uint16_t discFlag, uint16_t shortFlag) {
+    if (flags & discFlag)  return NAN;
+    if (flags & shortFlag) return -1.0f;
+    return (int16_t)getU16(p) / 10.0f;
+}
+
+// ---------------------------------------------------------------------------
+// Fan mode codes
+// ---------------------------------------------------------------------------
+uint8_t fanModeCode(const char* mode) {
+    if (!mode) return BIN_FAN_MODE_UNKNOWN;
+    if (strcmp(mode, "fan_only") == 0)       return BIN_FAN_MODE_FAN_ONLY;
+    if (strcmp(mode, "fan_and_damper") == 0) return BIN_FAN_MODE_FAN_AND_DAMPER;
+    if (strcmp(mode, "damper_primary") == 0) return BIN_FAN_MODE_DAMPER_PRIMARY;
+    return BIN_FAN_MODE_UNKNOWN;
+}
+
+const char* fanModeName(uint8_t code) {
+    switch (code) {
+        case BIN_FAN_MODE_FAN_ONLY:       return "fan_only";
+        case BIN_FAN_MODE_FAN_AND_DAMPER: return "fan_and_damper";
+        case BIN_FAN_MODE_DAMPER_PRIMARY: return "damper_primary";
+        default:                          return nullptr;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Data frame
+// ---------------------------------------------------------------------------
+size_t encodeDataFrame(uint8_t* buf, size_t bufSize, const DataPayload& d) {
+    if (bufSize < BIN_DATA_FRAME_SIZE) return 0;
+
+    uint16_t flags = d.lid ? BIN_FLAG_LID : 0;
+    int16_t pit   = encodeTemp(d.pit,   BIN_FLAG_PIT_DISC,   BIN_FLAG_PIT_SHORT,   flags);
+    int16_t meat1 = encodeTemp(d.meat1, BIN_FLAG_MEAT1_DISC, BIN_FLAG_MEAT1_SHORT, flags);
+    int16_t meat2 = encodeTemp(d.meat2, BIN_FLAG_MEAT2_DISC, BIN_FLAG_MEAT2_SHORT, flags);
+
+    buf[0] = BIN_FRAME_DATA;
+    buf[1] = BIN_PROTOCOL_VERSION;
+    putU16(buf + 2, flags);
+    putU32(buf + 4, d.ts);
+    putU16(buf + 8,  (uint16_t)pit);
+    putU16(buf + 10, (uint16_t)meat1);
+    putU16(buf + 12, (uint16_t)meat2);
+    buf[14] = d.fan;
+    buf[15] = d.damper;
+    putU32(buf + 16, d.est);
+    putU16(buf + 20, (uint16_t)(int16_t)d.sp);
+    putU16(buf + 22, toWhole(d.meat1Target));
+    putU16(buf + 24, toWhole(d.meat2Target));
+    buf[26] = fanModeCode(d.fanMode);
+    buf[27] = d.errorCount;
+    return BIN_DATA_FRAME_SIZE;
+}
+
+bool decodeDataFrame(const uint8_t* buf, size_t len, DataPayload& out) {
+    if (len < BIN_DATA_FRAME_SIZE) return false;
+    if (buf[0] != BIN_FRAME_DATA || buf[1] > BIN_PROTOCOL_VERSION) return false;
+
+    memset(&out, 0, sizeof(out));
+    uint16_t flags = getU16(buf + 2);
+    out.ts     = getU32(buf + 4);
+    out.pit    = decodeTemp(buf + 8,  flags, BIN_FLAG_PIT_DISC,   BIN_FLAG_PIT_SHORT);
+    out.meat1  = decodeTemp(buf + 10, flags, BIN_FLAG_MEAT1_DISC, BIN_FLAG_MEAT1_SHORT);
+    out.meat2  = decodeTemp(buf + 12, flags, BIN_FLAG_MEAT2_DISC, BIN_FLAG_MEAT2_SHORT);
+    out.fan    = buf[14];
+    out.damper = buf[15];
+    out.est    = getU32(buf + 16);
+    out.sp     = (int16_t)getU16(buf + 20);
+    out.meat1Target = getU16(buf + 22);
+    out.meat2Target = getU16(buf + 24);
+    out.fanMode     = fanModeName(buf[26]);
+    out.errorCount  = buf[27];
+    out.lid = (flags & BIN_FLAG_LID) != 0;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// History chunk
+// ---------------------------------------------------------------------------
+void encodeHistoryChunkHeader(uint8_t* buf, uint32_t seq, uint32_t session, bool append,
+                              float sp, float meat1Target, float meat2Target) {
+    buf[0] = BIN_FRAME_HISTORY;
+    buf[1] = BIN_PROTOCOL_VERSION;
+    buf[2] = append ? BIN_HISTORY_APPEND : 0;
+    buf[3] = (uint8_t)seq;
+    putU32(buf + 4, session);
+    putU16(buf + 8, (uint16_t)(int16_t)sp);
+    putU16(buf + 10, toWhole(meat1Target));
+    putU16(buf + 12, toWhole(meat2Target));
+    putU16(buf + 14, 0);
+}
+
+void finishHistoryChunk(uint8_t* buf, uint16_t count, bool final) {
+    if (final) buf[2] |= BIN_HISTORY_FINAL;
+    putU16(buf + 14, count);
+}
+
+void encodeHistoryRecord(uint8_t* buf, const DataPoint& dp, float sp) {
+    uint16_t flags = 0;
+    if (dp.flags & DP_FLAG_LID_OPEN)   flags |= BIN_FLAG_LID;
+    if (dp.flags & DP_FLAG_PIT_DISC)   flags |= BIN_FLAG_PIT_DISC;
+    if (dp.flags & DP_FLAG_MEAT1_DISC) flags |= BIN_FLAG_MEAT1_DISC;
+    if (dp.flags & DP_FLAG_MEAT2_DISC) flags |= BIN_FLAG_MEAT2_DISC;
+
+    putU32(buf, dp.timestamp);
+    putU16(buf + 4, (flags & BIN_FLAG_PIT_DISC)   ? 0 : (uint16_t)dp.pitTemp);
+    putU16(buf + 6, (flags & BIN_FLAG_MEAT1_DISC) ? 0 : (uint16_t)dp.meat1Temp);
+    putU16(buf + 8, (flags & BIN_FLAG_MEAT2_DISC) ? 0 : (uint16_t)dp.meat2Temp);
+    buf[10] = dp.fanPct;
+    buf[11] = dp.damperPct;
+    putU16(buf + 12, (uint16_t)(int16_t)sp);
+    putU16(buf + 14, flags);
+}
+
+void encodeHistoryRecord(uint8_t* buf, const HistoryPoint& p) {
+    uint16_t flags = p.lid ? BIN_FLAG_LID : 0;
+    int16_t pit   = encodeTemp(p.pit,   BIN_FLAG_PIT_DISC,   BIN_FLAG_PIT_SHORT,   flags);
+    int16_t meat1 = encodeTemp(p.meat1, BIN_FLAG_MEAT1_DISC, BIN_FLAG_MEAT1_SHORT, flags);
+    int16_t meat2 = encodeTemp(p.meat2, BIN_FLAG_MEAT2_DISC, BIN_FLAG_MEAT2_SHORT, flags);
+
+    putU32(buf, p.ts);
+    putU16(buf + 4, (uint16_t)pit);
+    putU16(buf + 6, (uint16_t)meat1);
+    putU16(buf + 8, (uint16_t)meat2);
+    buf[10] = p.fan;
+    buf[11] = p.damper;
+    putU16(buf + 12, (uint16_t)(int16_t)p.sp);
+    putU16(buf + 14, flags);
+}
+
+// ---------------------------------------------------------------------------
+// Diag frame
+// ---------------------------------------------------------------------------
+size_t encodeDiagFrame(uint8_t* buf, size_t bufSize, uint8_t seq, uint32_t dropped,
+                       const AdcSample* samples, uint8_t count) {
+    size_t len = BIN_DIAG_HEADER_SIZE + (size_t)count * BIN_DIAG_RECORD_SIZE;
+    if (bufSize < len) return 0;
+
+    uint32_t t0 = count > 0 ? samples[0].us : 0;
+    buf[0] = BIN_FRAME_DIAG;
+    buf[1] = BIN_PROTOCOL_VERSION;
+    buf[2] = seq;
+    buf[3] = count;
+    putU32(buf + 4, dropped);
+    putU32(buf + 8, t0);
+
+    uint8_t* rec = buf + BIN_DIAG_HEADER_SIZE;
+    uint32_t prev = t0;
+    for (uint8_t i = 0; i < count; i++, rec += BIN_DIAG_RECORD_SIZE) {
+        uint32_t dt = samples[i].us - prev;
+        prev = samples[i].us;
+        putU16(rec, dt > 0xFFFF ? 0xFFFF : (uint16_t)dt);
+        rec[2] = samples[i].probe;
+        putU16(rec + 3, (uint16_t)samples[i].raw);
+        putF32(rec + 5, samples[i].ohms);
+    }
+    return len;
+}
+
+bool decodeDiagFrame(const uint8_t* buf, size_t len, DiagFrameInfo& info,
+                     AdcSample* out, uint8_t maxOut) {
+    if (len < BIN_DIAG_HEADER_SIZE) return false;
+    if (buf[0] != BIN_FRAME_DIAG || buf[1] > BIN_PROTOCOL_VERSION) return false;
+
+    info.seq = buf[2];
+    info.count = buf[3];
+    info.dropped = getU32(buf + 4);
+    info.t0 = getU32(buf + 8);
+    if (len < BIN_DIAG_HEADER_SIZE + (size_t)info.count * BIN_DIAG_RECORD_SIZE) return false;
+
+    const uint8_t* rec = buf + BIN_DIAG_HEADER_SIZE;
+    uint32_t t = info.t0;
+    for (uint8_t i = 0; i < info.count && i < maxOut; i++, rec += BIN_DIAG_RECORD_SIZE) {
+        t += getU16(rec);
+        out[i].us = t;
+        out[i].probe = rec[2];
+        out[i].raw = (int16_t)getU16(rec + 3);
+        out[i].ohms = getF32(rec + 5);
+    }
+    return true;
+}
+
+} // namespace bbq_protocol
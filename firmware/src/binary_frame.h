@@ -0,0 +1,112 @@
+#pragma once
+
+#include "web_protocol.h"
+#include "data_point.h"
+#include "adc_diag.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary WebSocket frames, sent instead of the JSON data and history messages
+// to clients that announced support with {"type":"hello","bin":N}. All fields
+// are little-endian; temperatures are int16 tenths of a degree.
+//
+// Data frame (BIN_DATA_FRAME_SIZE bytes):
+//   0 u8  type (BIN_FRAME_DATA)     16 u32 est (0 = none)
+//   1 u8  version                   20 i16 sp
+//   2 u16 flags (BIN_FLAG_*)        22 u16 meat1Target (0 = none)
+//   4 u32 ts                        24 u16 meat2Target (0 = none)
+//   8 i16 pit, 10 meat1, 12 meat2   26 u8  fanMode (BIN_FAN_MODE_*)
+//  14 u8  fan, 15 damper            27 u8  errorCount
+//
+// History chunk: header (BIN_HISTORY_HEADER_SIZE bytes), then count records
+// of BIN_HISTORY_RECORD_SIZE bytes. A replay is a run of chunks; seq 0 starts
+// it and BIN_HISTORY_FINAL ends it. BIN_HISTORY_APPEND marks points after a
+// client's sync position, to be appended to what it holds:
+//   0 u8 type (BIN_FRAME_HISTORY), 1 u8 version, 2 u8 flags (BIN_HISTORY_*),
+//   3 u8 seq (mod 256), 4 u32 session, 8 i16 sp, 10 u16 meat1Target,
+//   12 u16 meat2Target, 14 u16 count
+//   record: 0 u32 ts, 4 i16 pit, 6 meat1, 8 meat2, 10 u8 fan, 11 damper,
+//           12 i16 sp, 14 u16 flags
+//
+// Diag frame: raw ADC samples for "diag" subscribers, a header
+// (BIN_DIAG_HEADER_SIZE bytes) then count records of BIN_DIAG_RECORD_SIZE.
+// seq counts frames so a gap shows a lost batch; dropped counts samples the
+// device lost before framing (its ring was full). Record times are deltas from
+// the previous sample (the first from t0), saturating at 65535 us:
+//   0 u8 type (BIN_FRAME_DIAG), 1 u8 version, 2 u8 seq (mod 256), 3 u8 count,
+//   4 u32 dropped, 8 u32 t0 (us, wraps)
+//   record: 0 u16 dt (us), 2 u8 probe, 3 i16 raw, 5 f32 ohms
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+
+#define BIN_PROTOCOL_VERSION    1
+
+#define BIN_FRAME_DATA          0x01
+#define BIN_FRAME_HISTORY       0x02
+#define BIN_FRAME_DIAG          0x03
+
+#define BIN_DATA_FRAME_SIZE     28
+#define BIN_HISTORY_HEADER_SIZE 16
+#define BIN_HISTORY_RECORD_SIZE 16
+#define BIN_DIAG_HEADER_SIZE    12
+#define BIN_DIAG_RECORD_SIZE    9
+#define BIN_DIAG_MAX_SAMPLES    255
+
+#define BIN_HISTORY_APPEND      0x01
+#define BIN_HISTORY_FINAL       0x02
+
+#define BIN_FLAG_LID            0x0001
+#define BIN_FLAG_PIT_DISC       0x0002
+#define BIN_FLAG_MEAT1_DISC     0x0004
+#define BIN_FLAG_MEAT2_DISC     0x0008
+#define BIN_FLAG_PIT_SHORT      0x0010
+#define BIN_FLAG_MEAT1_SHORT    0x0020
+#define BIN_FLAG_MEAT2_SHORT    0x0040
+
+#define BIN_FAN_MODE_FAN_ONLY       0
+#define BIN_FAN_MODE_FAN_AND_DAMPER 1
+#define BIN_FAN_MODE_DAMPER_PRIMARY 2
+#define BIN_FAN_MODE_UNKNOWN        0xFF
+
+namespace bbq_protocol {
+
+// Fan mode string <-> BIN_FAN_MODE_* code
+uint8_t fanModeCode(const char* mode);
+const char* fanModeName(uint8_t code);  // nullptr for unknown codes
+
+// Encode a data frame. Returns BIN_DATA_FRAME_SIZE, or 0 if buf is too small.
+// Error strings are not carried, only their count.
+size_t encodeDataFrame(uint8_t* buf, size_t bufSize, const DataPayload& d);
+
+// Decode a data frame (the inverse of encodeDataFrame). Returns false if the
+// frame is short, of another type, or from a newer protocol version.
+bool decodeDataFrame(const uint8_t* buf, size_t len, DataPayload& out);
+
+// History chunk pieces. The header's count and final flag are patched with
+// finishHistoryChunk once the chunk's records are written.
+void encodeHistoryChunkHeader(uint8_t* buf, uint32_t seq, uint32_t session, bool append,
+                              float sp, float meat1Target, float meat2Target);
+void finishHistoryChunk(uint8_t* buf, uint16_t count, bool final);
+void encodeHistoryRecord(uint8_t* buf, const DataPoint& dp, float sp);
+void encodeHistoryRecord(uint8_t* buf, const HistoryPoint& p);
+
+// Header fields of a diag frame
+struct DiagFrameInfo {
+    uint8_t  seq;
+    uint8_t  count;
+    uint32_t dropped;
+    uint32_t t0;
+};
+
+// Encode count samples (at most BIN_DIAG_MAX_SAMPLES) as a diag frame.
+// Returns the frame length, or 0 if buf is too small.
+size_t encodeDiagFrame(uint8_t* buf, size_t bufSize, uint8_t seq, uint32_t dropped,
+                       const AdcSample* samples, uint8_t count);
+
+// Decode a diag frame into up to maxOut samples, rebuilding each time from
+// t0 and the deltas. Returns false if the frame is short, of another type,
+// or from a newer protocol version.
+bool decodeDiagFrame(const uint8_t* buf, size_t len, DiagFrameInfo& info,
+                     AdcSample* out, uint8_t maxOut);
+
+} // namespace bbq_protocol
@@ -0,0 +1,100 @@
+#include "broadcast_gate.h"
+#include <cmath>
+#include <stdlib.h>
+#include <string.h>
+
+BroadcastGate::BroadcastGate(float tempDeadband, uint8_t pctDeadband,
+                             uint32_t heartbeatMs, uint32_t minGapMs)
+    : _tempDeadband(tempDeadband)
+    , _pctDeadband(pctDeadband)
+    , _heartbeatMs(heartbeatMs)
+    , _minGapMs(minGapMs)
+    , _lastSentMs(0)
+    , _hasSent(false)
+    , _forced(false)
+    , _frames(0)
+{
+    memset(&_last, 0, sizeof(_last));
+    memset(_counts, 0, sizeof(_counts));
+}
+
+BroadcastGate::Shown BroadcastGate::snapshot(const bbq_protocol::DataPayload& p,
+                                             uint8_t alarmBits) {
+    Shown s;
+    memset(&s, 0, sizeof(s));
+    const float temps[3] = { p.pit, p.meat1, p.meat2 };
+    for (int i = 0; i < 3; i++) {
+        if (std::isnan(temps[i]))    s.probe[i] = 1;
+        else if (temps[i] == -1.0f)  s.probe[i] = 2;
+        else {
+            s.raw[i] = temps[i];
+            s.temp[i] = (int32_t)lroundf(temps[i]);
+        }
+    }
+    s.fan = p.fan;
+    s.damper = p.damper;
+    s.sp = (int32_t)p.sp;               // Sent as whole degrees
+    s.meat1Target = (int32_t)p.meat1Target;
+    s.meat2Target = (int32_t)p.meat2Target;
+    s.est = p.est / 60;                 // Shown to the minute
+    s.lid = p.lid;
+    s.errorCount = p.errorCount;
+    s.alarmBits = alarmBits;
+    if (p.fanMode) {
+        strncpy(s.fanMode, p.fanMode, sizeof(s.fanMode) - 1);
+    }
+    return s;
+}
+
+bool BroadcastGate::stateChanged(const Shown& s) const {
+    for (int i = 0; i < 3; i++) {
+        if (s.probe[i] != _last.probe[i]) return true;
+    }
+    return s.lid != _last.lid ||
+           s.sp != _last.sp ||
+           s.meat1Target != _last.meat1Target ||
+           s.meat2Target != _last.meat2Target ||
+           (s.est == 0) != (_last.est == 0) ||
+           s.errorCount != _last.errorCount ||
+           s.alarmBits != _last.alarmBits ||
+           strcmp(s.fanMode, _last.fanMode) != 0;
+}
+
+bool BroadcastGate::valueMoved(const Shown& s) const {
+    for (int i = 0; i < 3; i++) {
+        if (s.probe[i] != 0 || s.temp[i] == _last.temp[i]) continue;
+        if (std::fabs(s.raw[i] - _last.raw[i]) >= _tempDeadband) return true;
+    }
+    return abs((int)s.fan - (int)_last.fan) >= _pctDeadband ||
+           abs((int)s.damper - (int)_last.damper) >= _pctDeadband ||
+           labs((long)s.est - (long)_last.est) >= WS_DEADBAND_EST_MIN;
+}
+
+BroadcastGate::Reason BroadcastGate::check(const bbq_protocol::DataPayload& p,
+                                           uint8_t alarmBits, uint32_t nowMs) const {
+    if (!_hasSent) return Reason::FIRST;
+    if (_forced.load()) return Reason::FORCED;
+
+    Shown s = snapshot(p, alarmBits);
+    if (stateChanged(s)) return Reason::STATE;
+
+    uint32_t quiet = nowMs - _lastSentMs;
+    if (quiet >= _minGapMs && valueMoved(s)) return Reason::VALUE;
+    if (quiet >= _heartbeatMs) return Reason::HEARTBEAT;
+    return Reason::NONE;
+}
+
+void BroadcastGate::sent(const bbq_protocol::DataPayload& p, uint8_t alarmBits,
+                         uint32_t nowMs, Reason why) {
+    _last = snapshot(p, alarmBits);
+    _lastSentMs = nowMs;
+    _hasSent = true;
+    _forced.store(false);
+    _frames++;
+    if (why < Reason::COUNT) _counts[(uint8_t)why]++;
+}
+
+uint32_t BroadcastGate::perHour(uint32_t frames, uint32_t elapsedMs) {
+    if (elapsedMs == 0) return 0;
+    return (uint32_t)((uint64_t)frames * 3600000ULL / elapsedMs);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "config.h"
+#include "web_protocol.h"
+#include <atomic>
+#include <stdint.h>
+
+// Decides when a data broadcast is worth sending, by comparing against the
+// last frame sent. A frame goes out when a temperature moves by the temp
+// deadband and its displayed whole degree changes (so probe noise smaller
+// than the deadband never sends), fan/damper by the percent deadband or the
+// done estimate by WS_DEADBAND_EST_MIN (no sooner than minGapMs after the
+// last frame), or straight away when a discrete state flips: lid, probe
+// connected/shorted, setpoint, targets, fan mode, error count, an estimate
+// appearing or an alarm. Otherwise a heartbeat frame goes out every heartbeatMs.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class BroadcastGate {
+public:
+    enum class Reason : uint8_t {
+        NONE,       // Nothing worth sending
+        FIRST,      // No frame sent yet
+        FORCED,     // force() called (e.g. a client just went live)
+        STATE,      // A discrete state flipped
+        VALUE,      // A value crossed its deadband
+        HEARTBEAT,  // Quiet for heartbeatMs
+        COUNT
+    };
+
+    BroadcastGate(float tempDeadband = WS_DEADBAND_TEMP,
+                  uint8_t pctDeadband = WS_DEADBAND_PCT,
+                  uint32_t heartbeatMs = WS_HEARTBEAT_INTERVAL,
+                  uint32_t minGapMs = WS_MIN_SEND_GAP);
+
+    // Whether p should be broadcast now. alarmBits carries any extra
+    // discrete state (active alarms); a change in it counts as a flip.
+    Reason check(const bbq_protocol::DataPayload& p, uint8_t alarmBits, uint32_t nowMs) const;
+
+    // Record p as the frame just sent
+    void sent(const bbq_protocol::DataPayload& p, uint8_t alarmBits, uint32_t nowMs, Reason why);
+
+    // Send on the next check whatever changed (safe from another task)
+    void force() { _forced.store(true); }
+
+    uint32_t getFrames() const           { return _frames; }
+    uint32_t getCount(Reason why) const  { return _counts[(uint8_t)why]; }
+
+    // Frames per hour over elapsedMs (0 if no time has passed)
+    static uint32_t perHour(uint32_t frames, uint32_t elapsedMs);
+
+private:
+    // Display-resolution snapshot of the last frame sent
+    struct Shown {
+        float    raw[3];        // Temperatures as sent
+        int32_t  temp[3];       // Whole degrees, as displayed
+        uint8_t  probe[3];      // 0 = reading, 1 = disconnected, 2 = shorted
+        uint8_t  fan, damper;
+        int32_t  sp, meat1Target, meat2Target;
+        uint32_t est;           // Minutes
+        bool     lid;
+        uint8_t  errorCount;
+        uint8_t  alarmBits;
+        char     fanMode[20];
+    };
+
+    static Shown snapshot(const bbq_protocol::DataPayload& p, uint8_t alarmBits);
+    bool stateChanged(const Shown& now) const;
+    bool valueMoved(const Shown& now) const;
+
+    float    _tempDeadband;
+    uint8_t  _pctDeadband;
+    uint32_t _heartbeatMs;
+    uint32_t _minGapMs;
+
+    Shown    _last;
+    uint32_t _lastSentMs;
+    bool     _hasSent;
+    std::atomic<bool> _forced;
+    uint32_t _frames;
+    uint32_t _counts[(uint8_t)Reason::COUNT];
+};
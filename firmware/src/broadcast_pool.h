@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// One broadcast payload, shared by every client queue that sends it. The
+// slot is free again when the last reference is released.
+template <size_t SIZE>
+struct BroadcastBuffer {
+    uint8_t data[SIZE];
+    size_t  len;
+    std::atomic<uint8_t> refs;
+
+    // Take another reference (one per queued client message)
+    void retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+    // Drop a reference; may be called from the network task
+    void release() { refs.fetch_sub(1, std::memory_order_acq_rel); }
+};
+
+// Fixed pool of reference-counted broadcast buffers. A broadcast is
+// serialized once into a buffer, each client's queued message holds a
+// reference to it, and the buffer returns to the pool when the slowest client
+// has sent it. No heap: acquire() fails (returns nullptr) rather than grow,
+// and the caller falls back to copying.
+//
+// Exactly one thread may acquire; references may be released from any.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+template <size_t SLOTS, size_t SIZE>
+class BroadcastPool {
+    static_assert(SLOTS >= 1 && SLOTS <= 32, "BroadcastPool holds 1 to 32 buffers");
+
+public:
+    typedef BroadcastBuffer<SIZE> Buffer;
+
+    BroadcastPool() : _acquired(0), _exhausted(0), _peakInUse(0) {
+        for (size_t i = 0; i < SLOTS; i++) {
+            _slots[i].len = 0;
+            _slots[i].refs.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Claim a free buffer with one reference held by the caller, who must
+    // release() it once every client message has taken its own.
+    // Returns nullptr if every buffer is still queued somewhere.
+    Buffer* acquire() {
+        Buffer* found = nullptr;
+        for (size_t i = 0; i < SLOTS && !found; i++) {
+            if (_slots[i].refs.load(std::memory_order_acquire) == 0) {
+                found = &_slots[i];
+            }
+        }
+        if (!found) {
+            _exhausted++;
+            return nullptr;
+        }
+        found->len = 0;
+        found->refs.store(1, std::memory_order_relaxed);
+        _acquired++;
+
+        uint8_t used = inUse();
+        if (used > _peakInUse) _peakInUse = used;
+        return found;
+    }
+
+    // Buffers currently referenced
+    uint8_t inUse() const {
+        uint8_t n = 0;
+        for (size_t i = 0; i < SLOTS; i++) {
+            if (_slots[i].refs.load(std::memory_order_acquire) != 0) n++;
+        }
+        return n;
+    }
+
+    static constexpr size_t capacity()   { return SLOTS; }
+    static constexpr size_t bufferSize() { return SIZE; }
+
+    uint32_t getAcquired() const  { return _acquired; }
+    uint32_t getExhausted() const { return _exhausted; }  // acquire() calls that failed
+    uint8_t  getPeakInUse() const { return _peakInUse; }
+
+private:
+    Buffer   _slots[SLOTS];
+    uint32_t _acquired;
+    uint32_t _exhausted;
+    uint8_t  _peakInUse;
+};
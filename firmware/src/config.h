@@ -8,6 +8,14 @@
 #define PIN_BUZZER      14
 #define PIN_SPARE       21
 
+// ADS1115 ALERT/RDY (open drain, pulled up): pulses low when a conversion
+// finishes. -1 polls the ADS1115 over I2C instead. Off by default: the
+// spare pin also drives the display's DC line (TFT_DC), so set this only
+// to a GPIO that is free on the board and wired to ALERT/RDY.
+#ifndef PIN_ADC_RDY
+#define PIN_ADC_RDY     -1
+#endif
+
 // --- ADC Channels (ADS1115) ---
 #define ADC_CHANNEL_PIT   0
 #define ADC_CHANNEL_MEAT1 1
@@ -16,6 +24,8 @@
 
 // --- ADS1115 ---
 #define ADS1115_ADDR    0x48
+#define ADC_CONVERSION_US        7813    // One single-shot conversion at 128 SPS
+#define ADC_CONVERSION_TIMEOUT_US 25000  // Give up on a conversion after this
 #ifndef NATIVE_BUILD
 #define ADS1115_GAIN    GAIN_ONE    // +/- 4.096V range
 #endif
@@ -59,8 +69,16 @@
 
 // --- Temperature Reading ---
 #define TEMP_SAMPLE_INTERVAL_MS  1000   // Read probes every 1 second
-#define TEMP_AVG_SAMPLES         4      // Average 4 readings
+#define TEMP_AVG_SAMPLES         4      // Conversions per probe per interval (1-8), filtered into one reading
+#ifndef TEMP_OUTLIER_FILTER
+#define TEMP_OUTLIER_FILTER      2      // 0 = mean, 1 = median, 2 = Hampel (drop outliers, then mean)
+#endif
+#define TEMP_HAMPEL_K            3.0    // Outlier beyond this many robust std devs of the median
+#define TEMP_HAMPEL_MIN_SPREAD   8.0    // Floor on the robust std dev (counts) for quiet probes
 #define TEMP_EMA_ALPHA           0.2    // EMA smoothing factor (lower = smoother, less derivative noise)
+#define TEMP_DIAG_QUEUE_SIZE     512    // Raw-sample ring for the diagnostic stream (power of two)
+#define TEMP_DIAG_STACK          3072   // Diagnostic sampler task stack (bytes)
+#define TEMP_DIAG_PRIORITY       1      // Same as the session writer, on core 0
 
 // --- Lid-Open Detection ---
 #define LID_OPEN_DROP_PCT   6    // 6% drop below setpoint triggers lid-open
@@ -69,8 +87,44 @@
 // --- Cook Session ---
 #define SESSION_BUFFER_SIZE     600     // RAM buffer samples
 #define SESSION_SAMPLE_INTERVAL 5000    // 5 seconds between data points
+#define SESSION_FINE_INTERVAL   1000    // 1 s stream, kept only when the PSRAM arena fits it
 #define SESSION_FLUSH_INTERVAL  60000   // Flush to LittleFS every 60 seconds
+#define SESSION_BLOCK_POINTS    12      // Points per delta-encoded flash block (one flush)
+#define SESSION_INDEX_SIZE      256     // Sparse block index entries (stride doubles when full)
+#define SESSION_HISTORY_MAX_POINTS 720  // Max points in a WebSocket history replay (decimated)
+#define SESSION_ROLLUP_TIERS    3
+#define SESSION_ROLLUP_INTERVALS { 60, 300, 900 }  // Rollup bucket sizes (seconds)
+#define SESSION_ROLLUP_RING     120     // Completed buckets kept in RAM per tier
+#define SESSION_ROLLUP_PATH_FMT "/rollup%u.dat"    // Per-tier file, %u = interval
 #define SESSION_FILE_PATH       "/session.dat"
+#define SESSION_MIGRATE_PATH    "/session.tmp"
+#ifndef SESSION_WRITER_TASK
+#define SESSION_WRITER_TASK     1       // 0 = write LittleFS inline from loop() (for comparison)
+#endif
+#define SESSION_WRITE_QUEUE_DEPTH 16    // Writer queue slots (power of two)
+#define SESSION_WRITER_STACK    4096    // Writer task stack (bytes)
+#define SESSION_WRITER_PRIORITY 1       // Low priority, pinned to core 0
+#ifndef SESSION_USE_PSRAM
+#define SESSION_USE_PSRAM       1       // Hold the session in a PSRAM arena when available
+#endif
+#define SESSION_ARENA_HOURS     24      // Span the PSRAM arena is sized for
+#define SESSION_PSRAM_RESERVE   (512 * 1024)  // PSRAM left free for LVGL, web, etc.
+#define SESSION_FINE_MIN_POINTS 600     // Drop the 1 s stream if under 10 min fits
+
+// --- Control Task ---
+#ifndef CONTROL_TASK
+#define CONTROL_TASK            1       // 0 = run the control path inline from loop() (for comparison)
+#endif
+#define CONTROL_PERIOD_MS       10      // Control cycle period (100 Hz)
+#define CONTROL_TASK_STACK      4096    // Control task stack (bytes)
+#define CONTROL_TASK_PRIORITY   5       // Above loop() (1) and async_tcp (3)
+#define CONTROL_TASK_CORE       1       // App core; Wi-Fi, lwIP and the writers run on core 0
+#define CONTROL_COMMAND_QUEUE_DEPTH 16  // Web/UI commands waiting for the control cycle (power of two)
+#define CONTROL_COMMAND_TEXT_MAX 16     // Longest command string (fan mode) incl. terminator
+
+// --- Loop Timing ---
+#define LOOP_BUDGET_US          10000   // One pass of the 100 Hz loop
+#define LOOP_STATS_INTERVAL     60000   // Log worst-case loop time every 60 seconds
 
 // --- Config ---
 #define CONFIG_FILE_PATH  "/config.json"
@@ -80,6 +134,44 @@
 #define WS_PATH           "/ws"
 #define WS_MAX_CLIENTS    4
 #define WS_SEND_INTERVAL  1500   // Send data every 1.5 seconds
+#define WS_CLIENT_SLOTS   (WS_MAX_CLIENTS * 2)  // Per-client state entries (clients past the cap are dropped)
+#define WS_SYNC_TIMEOUT   500    // ms to wait for a client sync before a full JSON replay
+#define WS_HISTORY_CHUNK_SIZE 4096  // Bytes per history_chunk frame (one reusable buffer)
+#define WS_CMD_MAX_LEN    256    // Longest inbound command accepted (bytes)
+#define WS_EVENT_QUEUE_DEPTH 16  // Connects, disconnects and command pieces waiting for the loop (power of two)
+#define WS_BROADCAST_SLOTS    8      // Pooled, shared data-broadcast buffers
+#define WS_BROADCAST_BUF_SIZE 512    // Bytes per broadcast buffer (largest data message)
+#define WS_CLIENT_QUEUE_MAX   2      // Data frames queued per client before coalescing
+#define WS_PING_INTERVAL  10000  // ms between pings to each client
+#define WS_PONG_TIMEOUT   30000  // ms without any frame or pong before a client is evicted
+#define WEB_EXPORT_MAX    2      // Session downloads streamed at once (~5 KB each)
+
+// Change-driven data broadcasts (0 = a frame every WS_SEND_INTERVAL)
+#ifndef WS_ADAPTIVE_BROADCAST
+#define WS_ADAPTIVE_BROADCAST 1
+#endif
+#define WS_CHANGE_POLL_MS     100    // How often the data is checked for changes
+#define WS_DEADBAND_TEMP      2.0f   // Degrees a temp must move before it is sent; above probe noise
+#define WS_DEADBAND_PCT       5      // Fan/damper percent before a change is sent
+#define WS_DEADBAND_EST_MIN   5      // Minutes the done estimate must move
+#define WS_MIN_SEND_GAP       500    // ms between frames sent for value changes
+#define WS_HEARTBEAT_INTERVAL 10000  // ms between frames when nothing changes
+
+// Per-client subscription channels (sub/unsub commands)
+#define WS_SUB_MIN_RATE       250    // Fastest a client may take any channel (ms)
+#define WS_SUB_MAX_RATE       60000  // Slowest rate a client may ask for (ms)
+#define WS_CONTROL_RATE       1000   // Control channel rate when a sub gives none (ms)
+#define WS_DIAG_BATCH_MAX     128    // Raw ADC samples per diag frame (at most 255)
+
+// Web UI bundle (built by web_assets.py: gzipped, fingerprinted, indexed)
+#ifndef WEB_ASSETS_EMBEDDED
+#define WEB_ASSETS_EMBEDDED   1      // Serve it from a table compiled into flash (0 = from LittleFS)
+#endif
+#define WEB_ASSET_INDEX       "/web.idx"  // Asset index in the bundle root
+#define WEB_ASSET_MAX         16     // Assets the index may list
+#define WEB_ASSET_INDEX_MAX   2048   // Longest index accepted (bytes)
+#define WEB_CACHE_IMMUTABLE   "public, max-age=31536000, immutable"  // Fingerprinted assets
+#define WEB_CACHE_REVALIDATE  "no-cache"  // Everything else: revalidate by ETag
 
 // --- Alarms ---
 #define ALARM_PIT_BAND_DEFAULT  15.0    // +/- 15F
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "config.h"
+#include "mpsc_queue.h"
+#include "loop_stats.h"
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+// Commands from the web server (AsyncTCP task) and the touch UI (loop task)
+// for the control path. Producers post them; the control cycle drains the
+// queue at its start and applies each one, so only the control path ever
+// changes the setpoint, alarm settings, fan mode or units.
+enum class CommandType : uint8_t {
+    SETPOINT,       // value = pit setpoint
+    MEAT_TARGET,    // probe = 1 or 2, value = target
+    PIT_BAND,       // value = +/- band around the setpoint
+    ALARM_ACK,      // Silence the active alarms
+    FAN_MODE,       // text = "fan_only", "fan_and_damper" or "damper_primary"
+    UNITS,          // flag = Fahrenheit
+    NEW_SESSION     // End the cook and start a new one
+};
+
+struct ControlCommand {
+    CommandType type = CommandType::SETPOINT;
+    uint8_t  probe = 0;
+    bool     flag = false;
+    float    value = 0.0f;
+    char     text[CONTROL_COMMAND_TEXT_MAX] = {};
+    uint32_t postedUs = 0;     // Stamped by post()
+
+    static ControlCommand make(CommandType type, float value = 0.0f, uint8_t probe = 0) {
+        ControlCommand c;
+        c.type = type;
+        c.value = value;
+        c.probe = probe;
+        return c;
+    }
+
+    static ControlCommand withText(CommandType type, const char* text) {
+        ControlCommand c;
+        c.type = type;
+        if (!text) return c;
+        size_t len = strlen(text);
+        if (len > sizeof(c.text) - 1) len = sizeof(c.text) - 1;
+        memcpy(c.text, text, len);
+        c.text[len] = '\0';
+        return c;
+    }
+};
+
+// The queue plus its counters. Post-to-apply latency is kept in a LoopStats
+// whose budget is one control period: a command that waited longer counts
+// as an overrun.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class CommandQueue {
+public:
+    explicit CommandQueue(uint32_t budgetUs = CONTROL_PERIOD_MS * 1000UL)
+        : _latency(budgetUs)
+        , _posted(0)
+        , _dropped(0)
+        , _applied(0)
+    {}
+
+    // Any producer. Returns false (and counts a drop) if the queue is full.
+    bool post(ControlCommand cmd, uint32_t nowUs) {
+        cmd.postedUs = nowUs;
+        if (!_queue.push(cmd)) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _posted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer only: apply every queued command in order. Returns the count.
+    template <typename Apply>
+    uint16_t drain(uint32_t nowUs, Apply apply) {
+        uint16_t n = 0;
+        ControlCommand cmd;
+        while (_queue.pop(cmd)) {
+            apply(cmd);
+            _latency.record(nowUs - cmd.postedUs);
+            n++;
+        }
+        _applied += n;
+        return n;
+    }
+
+    // Post-to-apply latency: window max/avg, over-a-period count, all-time max.
+    // Consumer only, like drain(); other tasks get it from the snapshot.
+    const LoopStats& getLatency() const { return _latency; }
+    void resetLatencyWindow() { _latency.resetWindow(); }
+
+    uint32_t getPosted() const    { return _posted.load(std::memory_order_relaxed); }
+    uint32_t getDropped() const   { return _dropped.load(std::memory_order_relaxed); }
+    uint32_t getApplied() const   { return _applied; }
+    uint32_t getQueuePeak() const { return _queue.getHighWater(); }
+
+private:
+    MpscQueue<ControlCommand, CONTROL_COMMAND_QUEUE_DEPTH> _queue;
+    LoopStats _latency;
+    std::atomic<uint32_t> _posted;
+    std::atomic<uint32_t> _dropped;
+    uint32_t _applied;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+
+// Control-period jitter: a histogram of how far each interval between two
+// control cycles strays from the nominal period, plus the shortest and
+// longest interval and the number of cycles that started a whole period
+// late. Feed it the time from one cycle's start to the next in microseconds.
+//
+// Counts are kept since boot. Every counter is a single aligned word
+// written by one task, so another task can read them without a lock; a
+// read may straddle one record.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class JitterHistogram {
+public:
+    static const uint8_t BUCKETS = 8;
+
+    explicit JitterHistogram(uint32_t periodUs = 10000)
+        : _periodUs(periodUs)
+    {
+        reset();
+    }
+
+    void record(uint32_t intervalUs) {
+        uint32_t jitter = intervalUs > _periodUs ? intervalUs - _periodUs
+                                                 : _periodUs - intervalUs;
+        uint8_t b = 0;
+        while (b < BUCKETS - 1 && jitter >= bucketLimitUs(b)) b++;
+        _buckets[b]++;
+        _count++;
+        if (jitter > _maxJitterUs) _maxJitterUs = jitter;
+        if (intervalUs < _minIntervalUs) _minIntervalUs = intervalUs;
+        if (intervalUs > _maxIntervalUs) _maxIntervalUs = intervalUs;
+        if (intervalUs >= 2 * _periodUs) _late++;
+    }
+
+    void reset() {
+        for (uint8_t i = 0; i < BUCKETS; i++) _buckets[i] = 0;
+        _count = 0;
+        _maxJitterUs = 0;
+        _minIntervalUs = UINT32_MAX;
+        _maxIntervalUs = 0;
+        _late = 0;
+    }
+
+    // Jitter below this lands in bucket i (the last bucket is open-ended)
+    static uint32_t bucketLimitUs(uint8_t i) {
+        static const uint32_t LIMITS[BUCKETS] = {
+            50, 100, 250, 500, 1000, 2500, 5000, UINT32_MAX
+        };
+        return i < BUCKETS ? LIMITS[i] : UINT32_MAX;
+    }
+
+    // Upper bound of the bucket holding the pct-th percentile of jitter,
+    // or UINT32_MAX when it falls in the open-ended bucket
+    uint32_t percentileUs(uint8_t pct) const {
+        if (_count == 0) return 0;
+        uint64_t want = ((uint64_t)_count * pct + 99) / 100;
+        if (want == 0) want = 1;
+        uint64_t seen = 0;
+        for (uint8_t i = 0; i < BUCKETS; i++) {
+            seen += _buckets[i];
+            if (seen >= want) return bucketLimitUs(i);
+        }
+        return UINT32_MAX;
+    }
+
+    uint32_t getBucket(uint8_t i) const    { return i < BUCKETS ? _buckets[i] : 0; }
+    uint32_t getCount() const              { return _count; }
+    uint32_t getMaxJitterUs() const        { return _maxJitterUs; }
+    uint32_t getMinIntervalUs() const      { return _count ? _minIntervalUs : 0; }
+    uint32_t getMaxIntervalUs() const      { return _maxIntervalUs; }
+    uint32_t getLate() const               { return _late; }   // Started a period or more late
+    uint32_t getPeriodUs() const           { return _periodUs; }
+
+private:
+    uint32_t _periodUs;
+    uint32_t _buckets[BUCKETS];
+    uint32_t _count;
+    uint32_t _maxJitterUs;
+    uint32_t _minIntervalUs;
+    uint32_t _maxIntervalUs;
+    uint32_t _late;
+};
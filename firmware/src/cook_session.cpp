@@ -1,33 +1,49 @@
 #include "cook_session.h"
+#include "session_codec.h"
+#include "session_arena.h"
+#include "system_snapshot.h"
+#include <stdio.h>
 #include <string.h>
 
 #ifndef NATIVE_BUILD
 #include <Arduino.h>
+#include <esp_heap_caps.h>
 #include <time.h>
 #endif
 
 CookSession::CookSession()
-    : _head(0)
+    : _ring(_buffer)
+    , _capacity(SESSION_BUFFER_SIZE)
+    , _head(0)
     , _count(0)
     , _wrapped(false)
+    , _fine(nullptr)
+    , _fineCapacity(0)
+    , _fineHead(0)
+    , _fineCount(0)
     , _active(false)
     , _startTime(0)
     , _totalPoints(0)
     , _lastSampleMs(0)
+    , _lastFineMs(0)
     , _lastFlushMs(0)
     , _flushedToIndex(0)
-    , _getPitTemp(nullptr)
-    , _getMeat1Temp(nullptr)
-    , _getMeat2Temp(nullptr)
-    , _getFanPct(nullptr)
-    , _getDamperPct(nullptr)
-    , _getFlags(nullptr)
+    , _pendingResets(0)
+    , _snap(nullptr)
 {
     memset(_buffer, 0, sizeof(_buffer));
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) {
+        _rollups[t].begin(session_rollup::tierInterval(t));
+    }
 }
 
 void CookSession::begin() {
 #ifndef NATIVE_BUILD
+#if SESSION_USE_PSRAM
+    // Before recovery, so a recovered cook is loaded straight into the arena
+    allocateArena();
+#endif
+
     // Attempt to recover a session from flash
     if (loadFromFlash()) {
         Serial.printf("[SESSION] Recovered session from flash. %u points loaded.\n",
@@ -36,15 +52,92 @@ void CookSession::begin() {
     } else {
         Serial.println("[SESSION] No previous session found.");
     }
+
+    // Recovery writes above ran inline; from here on flushes are queued
+    _writer.begin();
 #endif
 }
 
+#ifndef NATIVE_BUILD
+void CookSession::allocateArena() {
+    if (!psramFound()) return;
+
+    SessionArenaPlan plan = planSessionArena(heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+                                             SESSION_PSRAM_RESERVE);
+    if (plan.points == 0) {
+        Serial.println("[SESSION] Not enough PSRAM for a session arena; using internal buffer.");
+        return;
+    }
+
+    DataPoint* ring = (DataPoint*)heap_caps_malloc(plan.points * sizeof(DataPoint),
+                                                   MALLOC_CAP_SPIRAM);
+    if (!ring) {
+        Serial.println("[SESSION] PSRAM arena allocation failed; using internal buffer.");
+        return;
+    }
+
+    DataPoint* fine = nullptr;
+    if (plan.finePoints > 0) {
+        fine = (DataPoint*)heap_caps_malloc(plan.finePoints * sizeof(DataPoint),
+                                            MALLOC_CAP_SPIRAM);
+        if (!fine) plan.finePoints = 0;
+    }
+
+    attachArena(ring, plan.points, fine, plan.finePoints);
+    Serial.printf("[SESSION] PSRAM arena: %u points at 5 s (%.1f h), %u at 1 s (%.1f h), %u KB.\n",
+                  plan.points, plan.points * (SESSION_SAMPLE_INTERVAL / 1000) / 3600.0f,
+                  plan.finePoints, plan.finePoints * (SESSION_FINE_INTERVAL / 1000) / 3600.0f,
+                  (unsigned)((plan.points + plan.finePoints) * sizeof(DataPoint) / 1024));
+}
+#endif
+
+void CookSession::attachArena(DataPoint* ring, uint32_t capacity,
+                              DataPoint* fine, uint32_t fineCapacity) {
+    if (ring && capacity > 0) {
+        _ring = ring;
+        _capacity = capacity;
+    } else {
+        _ring = _buffer;
+        _capacity = SESSION_BUFFER_SIZE;
+    }
+    _fine = fineCapacity > 0 ? fine : nullptr;
+    _fineCapacity = _fine ? fineCapacity : 0;
+
+    _head = 0;
+    _count = 0;
+    _wrapped = false;
+    _fineHead = 0;
+    _fineCount = 0;
+}
+
+void CookSession::samplePoint(DataPoint& dp) const {
+    memset(&dp, 0, sizeof(dp));
+
+#ifndef NATIVE_BUILD
+    // Get current epoch time
+    time_t nowEpoch;
+    time(&nowEpoch);
+    dp.timestamp = (uint32_t)nowEpoch;
+#endif
+
+    if (_snap) _snap->toDataPoint(dp);
+}
+
 void CookSession::update() {
+    collectWrites();
     if (!_active) return;
 
 #ifndef NATIVE_BUILD
     unsigned long now = millis();
 
+    // 1 s stream (PSRAM arena only)
+    if (_fine && now - _lastFineMs >= SESSION_FINE_INTERVAL) {
+        _lastFineMs = now;
+        DataPoint dp;
+        samplePoint(dp);
+        addFinePoint(dp);
+    }
+
     // Sample interval check
     if (now - _lastSampleMs < SESSION_SAMPLE_INTERVAL) {
         // Check flush interval even if no new sample
@@ -58,21 +151,7 @@ void CookSession::update() {
 
     // Build a data point from current sensor data
     DataPoint dp;
-    memset(&dp, 0, sizeof(dp));
-
-    // Get current epoch time
-    time_t nowEpoch;
-    time(&nowEpoch);
-    dp.timestamp = (uint32_t)nowEpoch;
-
-    // Fill from data sources if set
-    if (_getPitTemp)   dp.pitTemp   = (int16_t)(_getPitTemp() * 10.0f);
-    if (_getMeat1Temp) dp.meat1Temp = (int16_t)(_getMeat1Temp() * 10.0f);
-    if (_getMeat2Temp) dp.meat2Temp = (int16_t)(_getMeat2Temp() * 10.0f);
-    if (_getFanPct)    dp.fanPct    = _getFanPct();
-    if (_getDamperPct) dp.damperPct = _getDamperPct();
-    if (_getFlags)     dp.flags     = _getFlags();
-
+    samplePoint(dp);
     addPoint(dp);
 
     // Periodic flush to LittleFS
@@ -92,6 +171,7 @@ void CookSession::startSession() {
     time(&now);
     _startTime = (uint32_t)now;
     _lastSampleMs = millis();
+    _lastFineMs = millis();
     _lastFlushMs = millis();
 
     Serial.printf("[SESSION] New session started at epoch %u.\n", _startTime);
@@ -100,7 +180,16 @@ void CookSession::startSession() {
 
 void CookSession::endSession() {
     if (_active) {
-        flush();  // Final flush
+        // Final flush, including a partial last block and open rollup buckets
+        for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) _rollups[t].finish();
+        writeBlocks(true);
+        writeRollups(true);
+
+        SessionWrite req;
+        memset(&req, 0, sizeof(req));
+        req.kind = SessionWrite::Kind::CLOSE;
+        submitWrite(req, true);
+
         _active = false;
 #ifndef NATIVE_BUILD
         Serial.printf("[SESSION] Session ended. %u total points.\n", _totalPoints);
@@ -109,99 +198,234 @@ void CookSession::endSession() {
 }
 
 void CookSession::addPoint(const DataPoint& point) {
-    _buffer[_head] = point;
-    _head = (_head + 1) % SESSION_BUFFER_SIZE;
+    _ring[_head] = point;
+    _head = (_head + 1) % _capacity;
 
-    if (_count < SESSION_BUFFER_SIZE) {
+    if (_count < _capacity) {
         _count++;
     } else {
         _wrapped = true;
     }
 
     _totalPoints++;
+
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) {
+        _rollups[t].add(point);
+    }
+}
+
+void CookSession::addFinePoint(const DataPoint& point) {
+    if (!_fine) return;
+    _fine[_fineHead] = point;
+    _fineHead = (_fineHead + 1) % _fineCapacity;
+    if (_fineCount < _fineCapacity) _fineCount++;
+}
+
+RingView<DataPoint> CookSession::getRamPoints() const {
+    return RingView<DataPoint>::fromRing(_ring, _capacity, _head, _count);
+}
+
+RingView<DataPoint> CookSession::getFinePoints() const {
+    return RingView<DataPoint>::fromRing(_fine, _fineCapacity, _fineHead, _fineCount);
+}
+
+const DataPoint* CookSession::getFinePoint(uint32_t index) const {
+    if (index >= _fineCount) return nullptr;
+    uint32_t oldest = (_fineHead + _fineCapacity - _fineCount) % _fineCapacity;
+    return &_fine[(oldest + index) % _fineCapacity];
 }
 
 void CookSession::flush() {
-#ifndef NATIVE_BUILD
+    writeBlocks(false);
+    writeRollups(false);
+}
+
+void CookSession::writeBlocks(bool final) {
     if (_count == 0) return;
 
-    // Append unflushed data points to the session file
-    File file = LittleFS.open(SESSION_FILE_PATH, "a");
-    if (!file) {
-        // Try creating the file
-        file = LittleFS.open(SESSION_FILE_PATH, "w");
-        if (!file) {
-            Serial.println("[SESSION] Failed to open session file for writing!");
-            return;
-        }
-        // Write header: start time + data point size for recovery
-        file.write((uint8_t*)&_startTime, sizeof(_startTime));
+    // Determine which points to flush (those not yet queued)
+    uint32_t ramStart = _totalPoints - _count;
+    if (_flushedToIndex < ramStart) {
+        _flushedToIndex = ramStart;  // Can't flush what has already left RAM
     }
+    uint32_t pending = _totalPoints - _flushedToIndex;
+
+    while (pending >= SESSION_BLOCK_POINTS || (final && pending > 0)) {
+        uint8_t n = pending >= SESSION_BLOCK_POINTS ? SESSION_BLOCK_POINTS : (uint8_t)pending;
+
+        SessionWrite req;
+        memset(&req, 0, sizeof(req));
+        req.kind = SessionWrite::Kind::BLOCK;
+        req.count = n;
+        req.firstPoint = _flushedToIndex;
+        req.startTime = _startTime;
+        for (uint8_t i = 0; i < n; i++) {
+            req.points[i] = *getPoint(_flushedToIndex + i - ramStart);
+        }
 
-    // Determine which points to flush (those not yet written)
-    // We write from _flushedToIndex to _totalPoints
-    uint32_t pointsToFlush = _totalPoints - _flushedToIndex;
+        if (!submitWrite(req, final)) {
+            break;  // Writer is behind; the points stay in RAM until next flush
+        }
 
-    if (pointsToFlush > _count) {
-        pointsToFlush = _count;  // Can't flush more than what's in RAM
+        _flushedToIndex += n;
+        pending -= n;
     }
 
-    if (pointsToFlush > 0) {
-        // Write from the oldest unflushed point in the circular buffer
-        uint32_t startIdx;
-        if (_wrapped) {
-            // Buffer has wrapped; oldest point is at _head
-            startIdx = _head;
-        } else {
-            startIdx = 0;
-        }
+    collectWrites();
+}
 
-        // Calculate how far back we need to go for unflushed points
-        uint32_t flushStart;
-        if (pointsToFlush <= _count) {
-            // Write the most recent pointsToFlush entries
-            if (_head >= pointsToFlush) {
-                flushStart = _head - pointsToFlush;
-            } else {
-                flushStart = SESSION_BUFFER_SIZE - (pointsToFlush - _head);
-            }
-        } else {
-            flushStart = startIdx;
-        }
+void CookSession::writeRollups(bool final) {
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) {
+        RollupTier& tier = _rollups[t];
 
-        for (uint32_t i = 0; i < pointsToFlush; i++) {
-            uint32_t idx = (flushStart + i) % SESSION_BUFFER_SIZE;
-            file.write((uint8_t*)&_buffer[idx], sizeof(DataPoint));
+        if (tier.getFlushed() < tier.getRamStart()) {
+#ifndef NATIVE_BUILD
+            Serial.printf("[SESSION] Rollup tier %us lost %u buckets.\n",
+                          tier.getInterval(), tier.getRamStart() - tier.getFlushed());
+#endif
+            tier.setFlushed(tier.getRamStart());
         }
 
-        _flushedToIndex = _totalPoints;
+        for (uint32_t i = tier.getFlushed(); i < tier.getCount(); i++) {
+            SessionWrite req;
+            memset(&req, 0, sizeof(req));
+            req.kind = SessionWrite::Kind::ROLLUP;
+            req.tier = t;
+            req.rollup = *tier.get(i);
 
-        Serial.printf("[SESSION] Flushed %u points to flash.\n", pointsToFlush);
+            if (!submitWrite(req, final)) return;
+            tier.setFlushed(i + 1);
+        }
     }
+}
 
-    file.close();
+bool CookSession::submitWrite(const SessionWrite& req, bool wait) {
+    while (!_writer.submit(req)) {
+        if (!wait) return false;
+
+        // The writer may be waiting to report: take its reports so it can
+        // get back to the queue
+        collectWrites();
+#ifndef NATIVE_BUILD
+        vTaskDelay(1);
 #endif
+    }
+    collectWrites();
+    return true;
+}
+
+void CookSession::collectWrites() {
+    SessionWriteDone done;
+    while (_writer.pollDone(done)) {
+        if (done.kind == SessionWrite::Kind::REMOVE) {
+            if (_pendingResets > 0) _pendingResets--;
+        } else if (_pendingResets == 0) {
+            // Blocks written before the last clear() belong to the old session
+            _index.addBlock(done.firstPoint, done.offset);
+        }
+    }
 }
 
-bool CookSession::loadFromFlash() {
 #ifndef NATIVE_BUILD
-    File file = LittleFS.open(SESSION_FILE_PATH, "r");
-    if (!file) return false;
+static void rollupPath(char* buf, size_t size, uint16_t interval) {
+    snprintf(buf, size, SESSION_ROLLUP_PATH_FMT, (unsigned)interval);
+}
 
-    size_t fileSize = file.size();
-    if (fileSize < sizeof(uint32_t)) {
-        file.close();
+// SessionBlockReader::ReadFn over a LittleFS File (ctx = File*)
+static size_t fileReadAt(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    File* file = static_cast<File*>(ctx);
+    if (file->position() != offset && !file->seek(offset)) return 0;
+    return file->read(buf, len);
+}
+
+// Rewrite a version 1 (raw record) session file in the block format so that
+// new flushes can append to it. Rebuilds the block index as it goes.
+bool CookSession::migrateLegacyFile() {
+    File in = LittleFS.open(SESSION_FILE_PATH, "r");
+    File out = LittleFS.open(SESSION_MIGRATE_PATH, "w");
+    if (!in || !out) {
+        in.close();
+        out.close();
+        LittleFS.remove(SESSION_MIGRATE_PATH);
         return false;
     }
 
-    // Read start time header
-    file.read((uint8_t*)&_startTime, sizeof(_startTime));
+    uint8_t header[SESSION_FILE_HEADER_SIZE];
+    session_codec::writeFileHeader(header, _startTime, SESSION_BLOCK_POINTS);
+    out.write(header, sizeof(header));
+
+    _index.clear();
+    uint32_t firstPoint = 0;
+
+    // Rebuild rollups from every point (only the RAM tail was fed on load)
+    SessionWrite close;
+    memset(&close, 0, sizeof(close));
+    close.kind = SessionWrite::Kind::CLOSE;
+    submitWrite(close, true);
+
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) {
+        _rollups[t].clear();
+        char path[24];
+        rollupPath(path, sizeof(path), _rollups[t].getInterval());
+        LittleFS.remove(path);
+    }
+
+    in.seek(SESSION_V1_HEADER_SIZE);
+    DataPoint points[SESSION_BLOCK_POINTS];
+    uint8_t block[SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_POINTS)];
+    uint8_t n = 0;
+    bool more = true;
+    bool ok = true;
+
+    while (more) {
+        more = in.read((uint8_t*)&points[n], sizeof(DataPoint)) == sizeof(DataPoint);
+        if (more) n++;
+        if (n == SESSION_BLOCK_POINTS || (!more && n > 0)) {
+            size_t len = session_codec::encodeBlock(points, n, firstPoint, block, sizeof(block));
+            _index.addBlock(firstPoint, out.position());
+            if (len == 0 || out.write(block, len) != len) {
+                ok = false;
+                break;
+            }
+            for (uint8_t i = 0; i < n; i++) {
+                for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) _rollups[t].add(points[i]);
+            }
+            writeRollups(true);
+            firstPoint += n;
+            n = 0;
+        }
+    }
+
+    in.close();
+    out.close();
+    if (ok) {
+        LittleFS.remove(SESSION_FILE_PATH);
+        ok = LittleFS.rename(SESSION_MIGRATE_PATH, SESSION_FILE_PATH);
+    }
 
-    // Read data points
-    size_t dataSize = fileSize - sizeof(uint32_t);
-    uint32_t numPoints = dataSize / sizeof(DataPoint);
+    // The index points into the half-written copy: drop both. The writer
+    // will not append blocks to a file left in the old format (it starts a
+    // new one), so the file is never a mix of the two.
+    if (!ok) {
+        _index.clear();
+        LittleFS.remove(SESSION_MIGRATE_PATH);
+    }
+    return ok;
+}
+#endif
 
-    if (numPoints == 0) {
+bool CookSession::loadFromFlash() {
+#ifndef NATIVE_BUILD
+    File file = LittleFS.open(SESSION_FILE_PATH, "r");
+    if (!file) return false;
+
+    uint8_t header[SESSION_FILE_HEADER_SIZE];
+    size_t headerLen = file.read(header, sizeof(header));
+    size_t headerSize = 0;
+    session_codec::FileFormat format =
+        session_codec::parseFileHeader(header, headerLen, &_startTime, &headerSize);
+
+    if (format == session_codec::FileFormat::INVALID) {
         file.close();
         return false;
     }
@@ -211,27 +435,67 @@ bool CookSession::loadFromFlash() {
     _count = 0;
     _wrapped = false;
     _totalPoints = 0;
-
-    // Read points into circular buffer (keep only the most recent SESSION_BUFFER_SIZE)
-    if (numPoints > SESSION_BUFFER_SIZE) {
-        // Skip older points that don't fit in buffer
-        uint32_t skip = numPoints - SESSION_BUFFER_SIZE;
-        file.seek(sizeof(uint32_t) + skip * sizeof(DataPoint));
-        numPoints = SESSION_BUFFER_SIZE;
+    _index.clear();
+
+    // Rollups are recomputed from the raw points; buckets already on flash
+    // are not rewritten.
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) {
+        _rollups[t].clear();
+        char path[24];
+        rollupPath(path, sizeof(path), _rollups[t].getInterval());
+        File rf = LittleFS.open(path, "r");
+        if (rf) {
+            _rollups[t].setFlushed(rf.size() / sizeof(RollupPoint));
+            rf.close();
+        }
     }
 
-    for (uint32_t i = 0; i < numPoints; i++) {
-        DataPoint dp;
-        if (file.read((uint8_t*)&dp, sizeof(DataPoint)) == sizeof(DataPoint)) {
-            _buffer[_head] = dp;
-            _head = (_head + 1) % SESSION_BUFFER_SIZE;
-            _count++;
-            _totalPoints++;
+    if (format == session_codec::FileFormat::BLOCK_V2) {
+        // Decode every block, indexing as we go; the ring keeps the most recent
+        // _capacity points (the whole cook with a PSRAM arena) and older ones
+        // stay on flash, reachable via SessionCursor.
+        SessionBlockReader reader;
+        reader.begin(fileReadAt, &file, headerSize);
+        while (reader.nextBlock()) {
+            // Blocks lost to damage leave a gap in the numbering. The ring
+            // only holds consecutive points, so it starts again after the
+            // gap; the points before it stay on flash.
+            if (reader.getBlockFirstPoint() > _totalPoints) {
+                _head = 0;
+                _count = 0;
+                _wrapped = false;
+                _totalPoints = reader.getBlockFirstPoint();
+            }
+            _index.addBlock(reader.getBlockFirstPoint(), reader.getBlockOffset());
+            for (uint8_t i = 0; i < reader.getBlockCount(); i++) {
+                addPoint(reader.getBlock()[i]);
+            }
+            writeRollups(true);
+        }
+    } else {
+        // Version 1: bare start time + raw sizeof(DataPoint) records
+        uint32_t numPoints = (file.size() - headerSize) / sizeof(DataPoint);
+        uint32_t skip = numPoints > _capacity ? numPoints - _capacity : 0;
+        file.seek(headerSize + skip * sizeof(DataPoint));
+
+        for (uint32_t i = skip; i < numPoints; i++) {
+            DataPoint dp;
+            if (file.read((uint8_t*)&dp, sizeof(DataPoint)) != sizeof(DataPoint)) break;
+            addPoint(dp);
         }
+        _totalPoints = numPoints;
     }
 
-    _flushedToIndex = _totalPoints;
     file.close();
+    _flushedToIndex = _totalPoints;
+
+    if (format == session_codec::FileFormat::RAW_V1 && _count > 0) {
+        Serial.println("[SESSION] Migrating v1 session file to block format.");
+        if (!migrateLegacyFile()) {
+            Serial.println("[SESSION] Migration failed; older points will be unavailable.");
+        }
+    }
+
     return _count > 0;
 #else
     return false;
@@ -246,69 +510,62 @@ void CookSession::clear() {
     _flushedToIndex = 0;
     _startTime = 0;
     _active = false;
-    memset(_buffer, 0, sizeof(_buffer));
+    _fineHead = 0;
+    _fineCount = 0;
+    memset(_ring, 0, _capacity * sizeof(DataPoint));
+    _index.clear();
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) _rollups[t].clear();
+
+    // The writer deletes the files once it has finished anything queued
+    // before this; completions reported until then are ignored.
+    SessionWrite req;
+    memset(&req, 0, sizeof(req));
+    req.kind = SessionWrite::Kind::REMOVE;
+    _pendingResets++;
+    submitWrite(req, true);
 
 #ifndef NATIVE_BUILD
-    LittleFS.remove(SESSION_FILE_PATH);
     Serial.println("[SESSION] Session data cleared.");
 #endif
 }
 
-String CookSession::toCSV() const {
-    String csv;
-    csv.reserve(_count * 60);  // Rough estimate
+// Walks the RAM ring spans for toCSV()/toJSON()
+struct RamCursor {
+    RingView<DataPoint>::iterator it;
+    RingView<DataPoint>::iterator end;
+};
+
+bool CookSession::ramNext(void* ctx, DataPoint& out) {
+    RamCursor* rc = static_cast<RamCursor*>(ctx);
+    if (rc->it == rc->end) return false;
+    out = *rc->it;
+    ++rc->it;
+    return true;
+}
 
-    // Header
-    csv += "timestamp,pit,meat1,meat2,fan,damper,flags\n";
+String CookSession::exportRAM(SessionExporter::Format format) const {
+    String out;
+    out.reserve(_count * (format == SessionExporter::Format::CSV ? 40 : 90) + 64);
 
-    // Data rows
-    for (uint32_t i = 0; i < _count; i++) {
-        const DataPoint* dp = getPoint(i);
-        if (dp == nullptr) continue;
+    RingView<DataPoint> view = getRamPoints();
+    RamCursor rc = { view.begin(), view.end() };
+    SessionExporter exporter(format, ramNext, &rc);
 
-        char line[80];
-        snprintf(line, sizeof(line), "%u,%.1f,%.1f,%.1f,%u,%u,%u\n",
-                 dp->timestamp,
-                 dp->pitTemp / 10.0f,
-                 dp->meat1Temp / 10.0f,
-                 dp->meat2Temp / 10.0f,
-                 dp->fanPct,
-                 dp->damperPct,
-                 dp->flags);
-        csv += line;
+    char chunk[256];
+    size_t n;
+    while ((n = exporter.read((uint8_t*)chunk, sizeof(chunk) - 1)) > 0) {
+        chunk[n] = '\0';
+        out += chunk;
     }
+    return out;
+}
 
-    return csv;
+String CookSession::toCSV() const {
+    return exportRAM(SessionExporter::Format::CSV);
 }
 
 String CookSession::toJSON() const {
-    String json;
-    json.reserve(_count * 80);
-
-    json += "[";
-
-    for (uint32_t i = 0; i < _count; i++) {
-        const DataPoint* dp = getPoint(i);
-        if (dp == nullptr) continue;
-
-        if (i > 0) json += ",";
-
-        char entry[120];
-        snprintf(entry, sizeof(entry),
-                 "{\"ts\":%u,\"pit\":%.1f,\"meat1\":%.1f,\"meat2\":%.1f,"
-                 "\"fan\":%u,\"damper\":%u,\"flags\":%u}",
-                 dp->timestamp,
-                 dp->pitTemp / 10.0f,
-                 dp->meat1Temp / 10.0f,
-                 dp->meat2Temp / 10.0f,
-                 dp->fanPct,
-                 dp->damperPct,
-                 dp->flags);
-        json += entry;
-    }
-
-    json += "]";
-    return json;
+    return exportRAM(SessionExporter::Format::JSON);
 }
 
 uint32_t CookSession::getPointCount() const {
@@ -340,25 +597,209 @@ const DataPoint* CookSession::getPoint(uint32_t index) const {
     uint32_t actualIdx;
     if (_wrapped) {
         // When wrapped, oldest is at _head (it was overwritten next)
-        actualIdx = (_head + index) % SESSION_BUFFER_SIZE;
+        actualIdx = (_head + index) % _capacity;
     } else {
         // Not wrapped: oldest is at index 0
         actualIdx = index;
     }
 
-    return &_buffer[actualIdx];
+    return &_ring[actualIdx];
 }
 
 uint32_t CookSession::getTotalPointCount() const {
     return _totalPoints;
 }
 
-void CookSession::setDataSources(TempGetter pitFn, TempGetter meat1Fn, TempGetter meat2Fn,
-                                  PctGetter fanFn, PctGetter damperFn, FlagGetter flagFn) {
-    _getPitTemp   = pitFn;
-    _getMeat1Temp = meat1Fn;
-    _getMeat2Temp = meat2Fn;
-    _getFanPct    = fanFn;
-    _getDamperPct = damperFn;
-    _getFlags     = flagFn;
+void CookSession::openCursor(SessionCursor& cursor, uint32_t from, bool fine) const {
+    cursor.session = this;
+    cursor.index = 0;
+    cursor.fine = fine;
+    cursor.flash = false;
+    cursor.truncated = false;
+
+    // Only points older than the RAM window need to come from flash
+    if (!fine && _totalPoints > _count) {
+        uint8_t header[SESSION_FILE_HEADER_SIZE];
+        size_t headerSize = 0;
+#ifndef NATIVE_BUILD
+        cursor.file = LittleFS.open(SESSION_FILE_PATH, "r");
+        if (cursor.file) {
+            size_t headerLen = cursor.file.read(header, sizeof(header));
+            if (session_codec::parseFileHeader(header, headerLen, nullptr, &headerSize)
+                    == session_codec::FileFormat::BLOCK_V2) {
+                cursor.reader.begin(fileReadAt, &cursor.file, headerSize);
+                cursor.flash = true;
+            } else {
+                cursor.file.close();  // Unmigrated v1 file: nothing readable on flash
+            }
+        }
+#else
+        size_t headerLen = SessionWriter::imageReadAt((void*)&_writer, 0, header, sizeof(header));
+        if (session_codec::parseFileHeader(header, headerLen, nullptr, &headerSize)
+                == session_codec::FileFormat::BLOCK_V2) {
+            cursor.reader.begin(SessionWriter::imageReadAt, (void*)&_writer, headerSize);
+            cursor.flash = true;
+        }
+#endif
+    }
+
+    seek(cursor, from);
+}
+
+void CookSession::seek(SessionCursor& cursor, uint32_t index) const {
+    cursor.index = index;
+    if (!cursor.flash || index >= _totalPoints - _count) return;
+
+    // Jump via the sparse index when seeking backwards or past the next
+    // indexed block; short forward hops just keep decoding.
+    uint32_t next = cursor.reader.getNextPoint();
+    uint32_t firstPoint, offset;
+    if (_index.find(index, &firstPoint, &offset) && (index < next || firstPoint > next)) {
+        cursor.reader.seekBlock(offset, firstPoint);
+    }
+    cursor.reader.skipTo(index);
+}
+
+bool CookSession::readNext(SessionCursor& cursor, DataPoint& out) const {
+    if (cursor.fine) {
+        const DataPoint* dp = getFinePoint(cursor.index);
+        if (dp == nullptr) return false;
+        out = *dp;
+        cursor.index++;
+        return true;
+    }
+
+    if (cursor.index >= _totalPoints) return false;
+
+    uint32_t ramStart = _totalPoints - _count;
+
+    if (cursor.index < ramStart) {
+        // The reader may skip a damaged block on the way: the point must
+        // still be the one asked for
+        if (cursor.flash && cursor.reader.getNextPoint() == cursor.index &&
+            cursor.reader.next(out) && cursor.reader.getNextPoint() == cursor.index + 1) {
+            cursor.index++;
+            return true;
+        }
+        // The point has left RAM and flash cannot supply it: stop here rather
+        // than hand out a session with a silent gap in it
+        cursor.truncated = true;
+        return false;
+    }
+
+    const DataPoint* dp = getPoint(cursor.index - ramStart);
+    if (dp == nullptr) return false;
+    out = *dp;
+    cursor.index++;
+    return true;
+}
+
+uint32_t CookSession::readRange(uint32_t from, uint32_t to,
+                                DataPoint* out, uint32_t maxPoints) const {
+    SessionCursor cursor;
+    openCursor(cursor, from);
+
+    uint32_t n = 0;
+    while (n < maxPoints && cursor.index < to && readNext(cursor, out[n])) {
+        n++;
+    }
+
+    closeCursor(cursor);
+    return n;
+}
+
+uint32_t CookSession::findFirstAfter(uint32_t ts) const {
+    RingView<DataPoint> ram = getRamPoints();
+    uint32_t ramStart = _totalPoints - ram.size();
+
+    // A reconnect after a short outage resumes inside the RAM window
+    uint32_t lo, hi;
+    if (!ram.empty() && ram[0].timestamp <= ts) {
+        lo = 0;
+        hi = ram.size();
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (ram[mid].timestamp > ts) hi = mid;
+            else                         lo = mid + 1;
+        }
+        return ramStart + lo;
+    }
+
+    // Otherwise the answer is on flash (or is ramStart itself)
+    SessionCursor cursor;
+    openCursor(cursor, 0);
+    lo = 0;
+    hi = ramStart;
+    DataPoint dp;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        seek(cursor, mid);
+        if (!readNext(cursor, dp) || dp.timestamp > ts) hi = mid;
+        else                                            lo = mid + 1;
+    }
+    closeCursor(cursor);
+    return lo;
+}
+
+void CookSession::closeCursor(SessionCursor& cursor) const {
+#ifndef NATIVE_BUILD
+    if (cursor.file) cursor.file.close();
+#endif
+    cursor.flash = false;
+    cursor.index = cursor.fine ? _fineCount : _totalPoints;
+}
+
+bool CookSession::cursorNext(void* ctx, DataPoint& out) {
+    SessionCursor* cursor = static_cast<SessionCursor*>(ctx);
+    return cursor->session->readNext(*cursor, out);
+}
+
+bool CookSession::cursorTruncated(void* ctx) {
+    return static_cast<const SessionCursor*>(ctx)->truncated;
+}
+
+uint16_t CookSession::getRollupInterval(uint8_t tier) const {
+    return tier < SESSION_ROLLUP_TIERS ? _rollups[tier].getInterval() : 0;
+}
+
+uint32_t CookSession::getRollupCount(uint8_t tier) const {
+    return tier < SESSION_ROLLUP_TIERS ? _rollups[tier].getCount() : 0;
+}
+
+bool CookSession::getPartialRollup(uint8_t tier, RollupPoint& out) const {
+    return tier < SESSION_ROLLUP_TIERS && _rollups[tier].getPartial(out);
+}
+
+uint32_t CookSession::readRollups(uint8_t tier, uint32_t from, uint32_t to,
+                                  RollupPoint* out, uint32_t maxPoints) const {
+    if (tier >= SESSION_ROLLUP_TIERS) return 0;
+    const RollupTier& rt = _rollups[tier];
+    if (to > rt.getCount()) to = rt.getCount();
+
+    uint32_t n = 0;
+    uint32_t index = from;
+
+#ifndef NATIVE_BUILD
+    // Buckets that have left the RAM ring come from the tier file
+    if (index < rt.getRamStart()) {
+        char path[24];
+        rollupPath(path, sizeof(path), rt.getInterval());
+        File file = LittleFS.open(path, "r");
+        if (file && file.seek(index * sizeof(RollupPoint))) {
+            while (n < maxPoints && index < to && index < rt.getRamStart() &&
+                   file.read((uint8_t*)&out[n], sizeof(RollupPoint)) == sizeof(RollupPoint)) {
+                n++;
+                index++;
+            }
+        }
+        file.close();
+    }
+#endif
+
+    // Skip anything unavailable, then serve the RAM ring
+    if (index < rt.getRamStart()) index = rt.getRamStart();
+    while (n < maxPoints && index < to) {
+        out[n++] = *rt.get(index++);
+    }
+    return n;
 }
@@ -1,42 +1,53 @@
 #pragma once
 
 #include "config.h"
+#include "data_point.h"
+#include "session_export.h"
+#include "session_index.h"
+#include "session_rollup.h"
+#include "session_writer.h"
+#include "ring_view.h"
 #include <stdint.h>
 
+struct SystemSnapshot;
+
 #ifndef NATIVE_BUILD
 #include <LittleFS.h>
 #include <ArduinoJson.h>
 #endif
 
-// Compact data point struct (13 bytes) for RAM and flash storage
-struct DataPoint {
-    uint32_t timestamp;     // Unix epoch seconds
-    int16_t  pitTemp;       // Pit temperature * 10 (e.g., 2255 = 225.5F)
-    int16_t  meat1Temp;     // Meat 1 temperature * 10
-    int16_t  meat2Temp;     // Meat 2 temperature * 10
-    uint8_t  fanPct;        // Fan speed 0-100%
-    uint8_t  damperPct;     // Damper position 0-100%
-    uint8_t  flags;         // Bit flags (lid-open, alarms, errors)
-};
+class CookSession;
 
-// Flag bits for DataPoint.flags
-#define DP_FLAG_LID_OPEN      0x01
-#define DP_FLAG_ALARM_PIT     0x02
-#define DP_FLAG_ALARM_MEAT1   0x04
-#define DP_FLAG_ALARM_MEAT2   0x08
-#define DP_FLAG_ERROR_FIREOUT 0x10
-#define DP_FLAG_PIT_DISC      0x20
-#define DP_FLAG_MEAT1_DISC    0x40
-#define DP_FLAG_MEAT2_DISC    0x80
+// Sequential read position over the whole session: points already flushed to
+// LittleFS followed by the unflushed tail still held in RAM.
+struct SessionCursor {
+    const CookSession* session;
+    uint32_t index;         // Next point index (0 = first point of the session)
+    bool     fine;          // Reading the 1 s stream (index 0 = oldest retained)
+    bool     flash;         // Flushed points can be read through reader
+    bool     truncated;     // Stopped at a flushed point that could not be read
+    SessionBlockReader reader;  // Decodes flushed blocks from file
+#ifndef NATIVE_BUILD
+    File     file;          // Open handle on SESSION_FILE_PATH while reading flushed points
+#endif
+};
 
 class CookSession {
 public:
     CookSession();
 
-    // Initialize buffer and attempt to recover a session from LittleFS.
+    // Move the point ring into a PSRAM arena if one is available, attempt to
+    // recover a session from LittleFS, then start the background writer.
     // Call once from setup().
     void begin();
 
+    // Use external storage for the 5 s ring (and optionally a 1 s ring) in
+    // place of the internal SESSION_BUFFER_SIZE buffer. Discards buffered
+    // points. begin() calls this with a PSRAM arena; the caller keeps
+    // ownership of the memory.
+    void attachArena(DataPoint* ring, uint32_t capacity,
+                     DataPoint* fine, uint32_t fineCapacity);
+
     // Sample a data point if the interval has elapsed. Call every loop().
     void update();
 
@@ -49,7 +60,13 @@ public:
     // Add a data point to the circular buffer
     void addPoint(const DataPoint& point);
 
-    // Force-flush the RAM buffer to LittleFS now
+    // Add a point to the 1 s stream (ignored without an arena for it).
+    // The 1 s stream lives in RAM only; flash keeps the 5 s stream.
+    void addFinePoint(const DataPoint& point);
+
+    // Hand all complete blocks of unflushed points to the session writer.
+    // A trailing partial block stays in RAM until it fills or the session ends.
+    // Never blocks: if the writer queue is full the points wait for the next flush.
     void flush();
 
     // Load/recover session data from LittleFS on boot (power-loss recovery)
@@ -58,16 +75,27 @@ public:
     // Clear all session data (RAM + file)
     void clear();
 
-    // Generate CSV string of all data points
-    // WARNING: This can be large. Caller should use chunked transfer or stream.
+    // Generate CSV string of the data points held in RAM
+    // WARNING: This can be large. For the full session use a SessionCursor
+    // with SessionExporter and a chunked transfer instead.
     String toCSV() const;
 
-    // Generate JSON array of all data points
+    // Generate JSON array of the data points held in RAM
     String toJSON() const;
 
-    // Number of stored data points
+    // Number of data points held in RAM (see getTotalPointCount for the session)
     uint32_t getPointCount() const;
 
+    // Points the RAM ring can hold (SESSION_BUFFER_SIZE, or the arena size)
+    uint32_t getCapacity() const { return _capacity; }
+
+    // 1 s stream: retained points (0 when there is no arena for it)
+    uint32_t getFinePointCount() const { return _fineCount; }
+    uint32_t getFineCapacity() const { return _fineCapacity; }
+
+    // 1 s point by index (0 = oldest retained), or nullptr
+    const DataPoint* getFinePoint(uint32_t index) const;
+
     // Whether a session is currently being recorded
     bool isActive() const;
 
@@ -77,28 +105,130 @@ public:
     // Get the session start timestamp (epoch)
     uint32_t getStartTime() const { return _startTime; }
 
-    // Access a specific data point by index (0 = oldest)
+    // Access a data point held in RAM by index (0 = oldest in RAM).
+    // Use a SessionCursor or readRange() to reach points already on flash.
     const DataPoint* getPoint(uint32_t index) const;
 
+    // Points held in RAM, oldest first, as at most two contiguous spans.
+    // Point i of the view is session point getTotalPointCount() - getPointCount() + i.
+    // Prefer this to getPoint() in loops; the view is invalidated by addPoint().
+    RingView<DataPoint> getRamPoints() const;
+
+    // The 1 s stream in the same form (empty without an arena for it)
+    RingView<DataPoint> getFinePoints() const;
+
     // Get total number of points (including those on flash)
     uint32_t getTotalPointCount() const;
 
-    // Set function pointers for getting current sensor data
-    // (called by update() to auto-fill data points)
-    typedef float (*TempGetter)();
-    typedef uint8_t (*PctGetter)();
-    typedef uint8_t (*FlagGetter)();
+    // Position a cursor at point index from (0 = first point of the session).
+    // Cursors read the flushed file followed by the unflushed RAM tail; when
+    // the arena holds the whole cook they never touch flash. With fine set
+    // the cursor walks the 1 s stream instead.
+    void openCursor(SessionCursor& cursor, uint32_t from = 0, bool fine = false) const;
+
+    // Move an open cursor to any point index. Uses the sparse block index, so
+    // a seek decodes at most a few blocks regardless of session length.
+    void seek(SessionCursor& cursor, uint32_t index) const;
+
+    // Read the point at the cursor and advance. Returns false at end of session,
+    // or with cursor.truncated set at a point that left RAM but cannot be read
+    // from flash (missing or damaged file, or never flushed). The cursor stays
+    // there; seek past it to carry on.
+    bool readNext(SessionCursor& cursor, DataPoint& out) const;
+
+    // Read points [from, to) into out, at most maxPoints. Returns points read.
+    uint32_t readRange(uint32_t from, uint32_t to, DataPoint* out, uint32_t maxPoints) const;
+
+    // Index of the first point recorded after ts (getTotalPointCount() if
+    // none). Binary search over the RAM ring, falling back to cursor seeks
+    // when ts is older than anything still in RAM.
+    uint32_t findFirstAfter(uint32_t ts) const;
+
+    // Release any file handle held by the cursor
+    void closeCursor(SessionCursor& cursor) const;
+
+    // Rollup tiers (min/max/mean per SESSION_ROLLUP_INTERVALS bucket), kept
+    // incrementally and appended to flash alongside the raw blocks. Pick a
+    // tier for a span and point budget with session_rollup::selectTier().
+    uint16_t getRollupInterval(uint8_t tier) const;
+
+    // Number of completed buckets in a tier
+    uint32_t getRollupCount(uint8_t tier) const;
+
+    // Summary of the bucket in progress. Returns false if it is empty.
+    bool getPartialRollup(uint8_t tier, RollupPoint& out) const;
+
+    // Read completed buckets [from, to) of a tier, at most maxPoints.
+    // Returns buckets read.
+    uint32_t readRollups(uint8_t tier, uint32_t from, uint32_t to,
+                         RollupPoint* out, uint32_t maxPoints) const;
 
-    void setDataSources(TempGetter pitFn, TempGetter meat1Fn, TempGetter meat2Fn,
-                        PctGetter fanFn, PctGetter damperFn, FlagGetter flagFn);
+    // Background writer (queue depth, write timings) for diagnostics
+    const SessionWriter& getWriter() const { return _writer; }
+
+    // Sparse block index (blocks the writer has reported) for diagnostics
+    const SessionIndex& getIndex() const { return _index; }
+
+    // SessionExporter::PointSource adapter (ctx = SessionCursor*)
+    static bool cursorNext(void* ctx, DataPoint& out);
+
+    // SessionExporter::SourceCheck adapter: whether the cursor was truncated
+    static bool cursorTruncated(void* ctx);
+
+    // Snapshot that update() fills data points from. The caller owns it and
+    // refreshes it on the same task before each update().
+    void setSnapshot(const SystemSnapshot* snap) { _snap = snap; }
 
 private:
-    // Circular buffer
+    // Fill a data point from the snapshot at the current time
+    void samplePoint(DataPoint& dp) const;
+
+#ifndef NATIVE_BUILD
+    // Size and allocate the PSRAM arena, if any
+    void allocateArena();
+#endif
+
+    // Build a String from the RAM buffer using SessionExporter
+    String exportRAM(SessionExporter::Format format) const;
+
+    // SessionExporter::PointSource over the RAM buffer (ctx = RamCursor*)
+    static bool ramNext(void* ctx, DataPoint& out);
+
+    // Queue unflushed points for the writer in blocks. With final set, also
+    // queues a trailing partial block and waits for queue space if needed.
+    void writeBlocks(bool final);
+
+    // Queue completed, unflushed rollup buckets for the per-tier files
+    void writeRollups(bool final);
+
+    // Hand a request to the writer and index whatever it has finished. With
+    // wait set, retries until there is room, collecting reports meanwhile so
+    // the writer never stalls on a full report queue. Returns false only
+    // without wait, if the queue is full.
+    bool submitWrite(const SessionWrite& req, bool wait);
+
+    // Index blocks the writer has finished appending
+    void collectWrites();
+
+#ifndef NATIVE_BUILD
+    // Rewrite a version 1 session file in the block format
+    bool migrateLegacyFile();
+#endif
+
+    // Circular buffer: _ring is _buffer or the PSRAM arena
     DataPoint _buffer[SESSION_BUFFER_SIZE];
+    DataPoint* _ring;
+    uint32_t  _capacity;
     uint32_t  _head;          // Next write position
     uint32_t  _count;         // Number of valid entries in buffer
     bool      _wrapped;       // Buffer has wrapped around
 
+    // 1 s stream (arena only)
+    DataPoint* _fine;
+    uint32_t  _fineCapacity;
+    uint32_t  _fineHead;
+    uint32_t  _fineCount;
+
     // Session state
     bool      _active;
     uint32_t  _startTime;     // Session start epoch
@@ -106,16 +236,22 @@ private:
 
     // Timing
     unsigned long _lastSampleMs;
+    unsigned long _lastFineMs;
     unsigned long _lastFlushMs;
 
     // Number of points written to flash (for flush tracking)
     uint32_t _flushedToIndex;
 
-    // Data source callbacks
-    TempGetter _getPitTemp;
-    TempGetter _getMeat1Temp;
-    TempGetter _getMeat2Temp;
-    PctGetter  _getFanPct;
-    PctGetter  _getDamperPct;
-    FlagGetter _getFlags;
+    // Sparse index of block offsets in the session file
+    SessionIndex _index;
+
+    // Multi-resolution rollups (1 / 5 / 15 min)
+    RollupTier _rollups[SESSION_ROLLUP_TIERS];
+
+    // Owns the session and rollup files; appends them off the control loop
+    SessionWriter _writer;
+    uint8_t _pendingResets;     // REMOVE requests not yet acknowledged by the writer
+
+    // Current readings for new data points
+    const SystemSnapshot* _snap;
 };
@@ -0,0 +1,139 @@
+#include "web_protocol.h"
+#include "json_writer.h"
+#include <cmath>
+#include <cstring>
+
+// Outgoing JSON messages, written straight into the caller's buffer with
+// JsonWriter (no JsonDocument, no heap). The output is byte-for-byte what the
+// previous ArduinoJson builders produced; test_data_message checks this.
+
+namespace bbq_protocol {
+
+// Probe temperature: NAN → null, -1 → -1 (shorted), else value with 1 decimal
+static void probeField(JsonWriter& w, const char* key, float v) {
+    if (std::isnan(v))   w.field(key, JsonNull());
+    else if (v == -1.0f) w.field(key, -1);
+    else                 w.field(key, JsonTenths{v});
+}
+
+// ---------------------------------------------------------------------------
+// buildDataMessage — periodic data broadcast
+// ---------------------------------------------------------------------------
+size_t buildDataMessage(char* buf, size_t bufSize, const DataPayload& d) {
+    JsonWriter w(buf, bufSize);
+    w.beginObject();
+    w.field("type", "data");
+    w.field("ts", d.ts);
+
+    probeField(w, "pit", d.pit);
+    probeField(w, "meat1", d.meat1);
+    probeField(w, "meat2", d.meat2);
+
+    w.field("fan", (int)d.fan);
+    w.field("damper", (int)d.damper);
+    w.field("sp", (int)d.sp);
+    w.field("lid", d.lid);
+    if (d.fanMode) w.field("fanMode", d.fanMode);
+
+    // Meat targets: 0 → null
+    if (d.meat1Target > 0)  w.field("meat1Target", (int)d.meat1Target);
+    else                    w.field("meat1Target", JsonNull());
+
+    if (d.meat2Target > 0)  w.field("meat2Target", (int)d.meat2Target);
+    else                    w.field("meat2Target", JsonNull());
+
+    // Estimated done time
+    if (d.est > 0)  w.field("est", d.est);
+    else            w.field("est", JsonNull());
+
+    // Errors array
+    w.beginArray("errors");
+    for (uint8_t i = 0; i < d.errorCount && i < 8; i++) {
+        w.element(d.errors[i]);
+    }
+    w.endArray();
+
+    w.endObject();
+    return w.finish();
+}
+
+// ---------------------------------------------------------------------------
+// buildSessionReset — server confirms new session
+// ---------------------------------------------------------------------------
+size_t buildSessionReset(char* buf, size_t bufSize, float setpoint) {
+    JsonWriter w(buf, bufSize);
+    w.beginObject();
+    w.field("type", "session");
+    w.field("action", "reset");
+    w.field("sp", (int)setpoint);
+    w.endObject();
+    return w.finish();
+}
+
+// ---------------------------------------------------------------------------
+// buildSessionDownload — where to fetch the session export
+// ---------------------------------------------------------------------------
+size_t buildSessionDownload(char* buf, size_t bufSize, const char* format) {
+    bool json = format && strcmp(format, "json") == 0;
+    JsonWriter w(buf, bufSize);
+    w.beginObject();
+    w.field("type", "session");
+    w.field("action", "download");
+    w.field("format", json ? "json" : "csv");
+    w.field("url", json ? "/api/session.json" : "/api/session.csv");
+    w.endObject();
+    return w.finish();
+}
+
+// ---------------------------------------------------------------------------
+// buildHelloAck — server confirms the negotiated frame format
+// ---------------------------------------------------------------------------
+size_t buildHelloAck(char* buf, size_t bufSize, uint8_t binVersion) {
+    JsonWriter w(buf, bufSize);
+    w.beginObject();
+    w.field("type", "hello");
+    w.field("bin", (int)binVersion);
+    w.endObject();
+    return w.finish();
+}
+
+// ---------------------------------------------------------------------------
+// buildControlMessage — control-channel telemetry (PID tuning)
+// ---------------------------------------------------------------------------
+size_t buildControlMessage(char* buf, size_t bufSize, const ControlPayload& c) {
+    JsonWriter w(buf, bufSize);
+    w.beginObject();
+    w.field("type", "control");
+    w.field("ms", c.ms);
+    probeField(w, "pit", c.pit);
+    w.field("sp", JsonTenths{c.sp});
+    w.field("out", JsonTenths{c.out});
+    w.field("p", JsonTenths{c.p});
+    w.field("i", JsonTenths{c.i});
+    w.field("d", JsonTenths{c.d});
+    w.field("fan", JsonTenths{c.fan});
+    w.field("damper", JsonTenths{c.damper});
+    w.field("lid", c.lid);
+    w.endObject();
+    return w.finish();
+}
+
+// ---------------------------------------------------------------------------
+// buildSubscriptionAck — the client's channels after a sub/unsub
+// ---------------------------------------------------------------------------
+size_t buildSubscriptionAck(char* buf, size_t bufSize, uint8_t channels, const uint16_t* rateMs) {
+    JsonWriter w(buf, bufSize);
+    w.beginObject();
+    w.field("type", "sub");
+    w.beginObject("channels");
+    for (uint8_t ch = 0; ch < (uint8_t)Channel::COUNT; ch++) {
+        if (channels & channelBit((Channel)ch)) {
+            w.field(channelName((Channel)ch), (unsigned int)rateMs[ch]);
+        }
+    }
+    w.endObject();
+    w.endObject();
+    return w.finish();
+}
+
+} // namespace bbq_protocol
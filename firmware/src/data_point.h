@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Compact data point struct for RAM storage (13 bytes of fields, padded to 16).
+// On flash, points are delta/RLE-encoded in blocks by session_codec.
+struct DataPoint {
+    uint32_t timestamp;     // Unix epoch seconds
+    int16_t  pitTemp;       // Pit temperature * 10 (e.g., 2255 = 225.5F)
+    int16_t  meat1Temp;     // Meat 1 temperature * 10
+    int16_t  meat2Temp;     // Meat 2 temperature * 10
+    uint8_t  fanPct;        // Fan speed 0-100%
+    uint8_t  damperPct;     // Damper position 0-100%
+    uint8_t  flags;         // Bit flags (lid-open, alarms, errors)
+};
+
+// Flag bits for DataPoint.flags
+#define DP_FLAG_LID_OPEN      0x01
+#define DP_FLAG_ALARM_PIT     0x02
+#define DP_FLAG_ALARM_MEAT1   0x04
+#define DP_FLAG_ALARM_MEAT2   0x08
+#define DP_FLAG_ERROR_FIREOUT 0x10
+#define DP_FLAG_PIT_DISC      0x20
+#define DP_FLAG_MEAT1_DISC    0x40
+#define DP_FLAG_MEAT2_DISC    0x80
@@ -115,6 +115,14 @@ std::vector<ErrorEntry> ErrorManager::getErrors() const {
 }
 #endif
 
+uint8_t ErrorManager::copyErrors(ErrorEntry* out, uint8_t max) const {
+    uint8_t n = _errorCount < max ? _errorCount : max;
+    for (uint8_t i = 0; i < n; i++) {
+        out[i] = _errors[i];
+    }
+    return n;
+}
+
 uint8_t ErrorManager::getErrorCount() const {
     return _errorCount;
 }
@@ -54,6 +54,9 @@ public:
     std::vector<ErrorEntry> getErrors() const;
 #endif
 
+    // Copy up to max active errors into out (no allocation). Returns the count.
+    uint8_t copyErrors(ErrorEntry* out, uint8_t max) const;
+
     // Get error count
     uint8_t getErrorCount() const;
 
@@ -0,0 +1,291 @@
+#include "history_message.h"
+#include "binary_frame.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace bbq_protocol {
+
+// Worst case for one formatted point (plus separator)
+static const size_t HISTORY_POINT_MAX = 160;
+
+// ---------------------------------------------------------------------------
+// Point formatting, shared by the whole-message builder and the chunk writer.
+// Each writes one {"ts":...} object at out, which must have HISTORY_POINT_MAX
+// bytes free, and returns its length.
+// ---------------------------------------------------------------------------
+static size_t putStr(char* out, const char* s) {
+    size_t n = strlen(s);
+    memcpy(out, s, n);
+    return n;
+}
+
+static size_t putUint(char* out, uint32_t v) {
+    char tmp[10];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    size_t len = n;
+    while (n > 0) *out++ = tmp[--n];
+    return len;
+}
+
+static size_t putInt(char* out, int32_t v) {
+    if (v < 0) {
+        *out = '-';
+        return 1 + putUint(out + 1, (uint32_t)(-(int64_t)v));
+    }
+    return putUint(out, (uint32_t)v);
+}
+
+// tenths of a degree as "123.4"
+static size_t putTenths(char* out, int16_t v) {
+    size_t pos = 0;
+    int32_t x = v;
+    if (x < 0) {
+        out[pos++] = '-';
+        x = -x;
+    }
+    pos += putUint(out + pos, (uint32_t)(x / 10));
+    out[pos++] = '.';
+    out[pos++] = (char)('0' + x % 10);
+    return pos;
+}
+
+static size_t putTemp(char* out, const char* key, int16_t tenths, bool disconnected) {
+    size_t pos = putStr(out, key);
+    if (disconnected) pos += putStr(out + pos, "null");
+    else              pos += putTenths(out + pos, tenths);
+    return pos;
+}
+
+static size_t formatPoint(char* out, const HistoryPoint& p) {
+    size_t pos = 0;
+    pos += snprintf(out + pos, HISTORY_POINT_MAX - pos, "{\"ts\":%u", (unsigned)p.ts);
+
+    // Temperatures: NAN → null
+    if (std::isnan(p.pit))   pos += snprintf(out + pos, HISTORY_POINT_MAX - pos, ",\"pit\":null");
+    else                     pos += snprintf(out + pos, HISTORY_POINT_MAX - pos, ",\"pit\":%.1f", p.pit);
+
+    if (std::isnan(p.meat1)) pos += snprintf(out + pos, HISTORY_POINT_MAX - pos, ",\"meat1\":null");
+    else                     pos += snprintf(out + pos, HISTORY_POINT_MAX - pos, ",\"meat1\":%.1f", p.meat1);
+
+    if (std::isnan(p.meat2)) pos += snprintf(out + pos, HISTORY_POINT_MAX - pos, ",\"meat2\":null");
+    else                     pos += snprintf(out + pos, HISTORY_POINT_MAX - pos, ",\"meat2\":%.1f", p.meat2);
+
+    pos += snprintf(out + pos, HISTORY_POINT_MAX - pos,
+        ",\"fan\":%u,\"damper\":%u,\"sp\":%d,\"lid\":%s}",
+        (unsigned)p.fan, (unsigned)p.damper, (int)p.sp,
+        p.lid ? "true" : "false");
+    return pos;
+}
+
+// Raw session record: formats the integers directly (no float)
+static size_t formatPoint(char* out, const DataPoint& dp, float sp) {
+    size_t pos = 0;
+    pos += putStr(out + pos, "{\"ts\":");
+    pos += putUint(out + pos, dp.timestamp);
+    pos += putTemp(out + pos, ",\"pit\":",   dp.pitTemp,   (dp.flags & DP_FLAG_PIT_DISC) != 0);
+    pos += putTemp(out + pos, ",\"meat1\":", dp.meat1Temp, (dp.flags & DP_FLAG_MEAT1_DISC) != 0);
+    pos += putTemp(out + pos, ",\"meat2\":", dp.meat2Temp, (dp.flags & DP_FLAG_MEAT2_DISC) != 0);
+    pos += putStr(out + pos, ",\"fan\":");
+    pos += putUint(out + pos, dp.fanPct);
+    pos += putStr(out + pos, ",\"damper\":");
+    pos += putUint(out + pos, dp.damperPct);
+    pos += putStr(out + pos, ",\"sp\":");
+    pos += putInt(out + pos, (int32_t)sp);
+    pos += putStr(out + pos, (dp.flags & DP_FLAG_LID_OPEN) ? ",\"lid\":true}" : ",\"lid\":false}");
+    return pos;
+}
+
+// ,"sp":N,"meat1Target":N|null,"meat2Target":N|null,"data":[
+static size_t formatTargets(char* out, size_t size, float sp, float meat1Target, float meat2Target) {
+    size_t pos = 0;
+    pos += snprintf(out + pos, size - pos, ",\"sp\":%d", (int)sp);
+
+    if (meat1Target > 0)
+        pos += snprintf(out + pos, size - pos, ",\"meat1Target\":%d", (int)meat1Target);
+    else
+        pos += snprintf(out + pos, size - pos, ",\"meat1Target\":null");
+
+    if (meat2Target > 0)
+        pos += snprintf(out + pos, size - pos, ",\"meat2Target\":%d", (int)meat2Target);
+    else
+        pos += snprintf(out + pos, size - pos, ",\"meat2Target\":null");
+
+    pos += snprintf(out + pos, size - pos, ",\"data\":[");
+    return pos;
+}
+
+// ---------------------------------------------------------------------------
+// HistoryMessageBuilder
+// ---------------------------------------------------------------------------
+HistoryMessageBuilder::HistoryMessageBuilder()
+    : _buf(nullptr)
+    , _size(0)
+    , _pos(0)
+    , _count(0)
+    , _failed(false)
+{
+}
+
+HistoryMessageBuilder::~HistoryMessageBuilder() {
+    free(_buf);
+}
+
+bool HistoryMessageBuilder::reserve(size_t extra) {
+    if (_failed) return false;
+    if (_pos + extra <= _size) return true;
+
+    size_t newSize = _size * 2;
+    if (newSize < _pos + extra) newSize = _pos + extra;
+    char* newBuf = (char*)realloc(_buf, newSize);
+    if (!newBuf) {
+        _failed = true;
+        return false;
+    }
+    _buf = newBuf;
+    _size = newSize;
+    return true;
+}
+
+bool HistoryMessageBuilder::begin(size_t expectedPoints, float sp,
+                                  float meat1Target, float meat2Target) {
+    free(_buf);
+    _size = 256 + expectedPoints * 130;
+    _buf = (char*)malloc(_size);
+    _pos = 0;
+    _count = 0;
+    _failed = (_buf == nullptr);
+    if (_failed) return false;
+
+    _pos += snprintf(_buf + _pos, _size - _pos, "{\"type\":\"history\"");
+    _pos += formatTargets(_buf + _pos, _size - _pos, sp, meat1Target, meat2Target);
+    return true;
+}
+
+bool HistoryMessageBuilder::add(const HistoryPoint& p) {
+    if (!reserve(HISTORY_POINT_MAX + 1)) return false;
+    if (_count++ > 0) _buf[_pos++] = ',';
+    _pos += formatPoint(_buf + _pos, p);
+    return true;
+}
+
+bool HistoryMessageBuilder::add(const DataPoint& dp, float sp) {
+    if (!reserve(HISTORY_POINT_MAX + 1)) return false;
+    if (_count++ > 0) _buf[_pos++] = ',';
+    _pos += formatPoint(_buf + _pos, dp, sp);
+    return true;
+}
+
+char* HistoryMessageBuilder::finish(size_t* outLen) {
+    if (!reserve(3)) {
+        if (outLen) *outLen = 0;
+        return nullptr;
+    }
+    _buf[_pos++] = ']';
+    _buf[_pos++] = '}';
+    _buf[_pos] = '\0';
+
+    char* out = _buf;
+    if (outLen) *outLen = _pos;
+    _buf = nullptr;
+    _size = 0;
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// HistoryChunkWriter
+// ---------------------------------------------------------------------------
+
+// Room kept free for the JSON tail: ],"final":false}
+static const size_t CHUNK_JSON_TAIL = 24;
+
+HistoryChunkWriter::HistoryChunkWriter(uint8_t* buf, size_t size, bool binary)
+    : _buf(buf)
+    , _size(size)
+    , _pos(0)
+    , _count(0)
+    , _binary(binary)
+{
+}
+
+void HistoryChunkWriter::begin(const HistoryChunkHeader& h) {
+    _count = 0;
+    if (_binary) {
+        encodeHistoryChunkHeader(_buf, h.seq, h.session, h.append,
+                                 h.sp, h.meat1Target, h.meat2Target);
+        _pos = BIN_HISTORY_HEADER_SIZE;
+        return;
+    }
+
+    char* out = (char*)_buf;
+    _pos = snprintf(out, _size,
+        "{\"type\":\"history_chunk\",\"seq\":%u,\"session\":%u,\"append\":%s",
+        (unsigned)h.seq, (unsigned)h.session, h.append ? "true" : "false");
+    _pos += formatTargets(out + _pos, _size - _pos, h.sp, h.meat1Target, h.meat2Target);
+}
+
+bool HistoryChunkWriter::hasRoom(size_t n) const {
+    size_t perPoint = _binary ? BIN_HISTORY_RECORD_SIZE : HISTORY_POINT_MAX + 1;
+    size_t tail = _binary ? 0 : CHUNK_JSON_TAIL;
+    return _pos + n * perPoint + tail <= _size;
+}
+
+bool HistoryChunkWriter::add(const DataPoint& dp, float sp) {
+    if (!hasRoom(1)) return false;
+    if (_binary) {
+        encodeHistoryRecord(_buf + _pos, dp, sp);
+        _pos += BIN_HISTORY_RECORD_SIZE;
+    } else {
+        char* out = (char*)_buf;
+        if (_count > 0) out[_pos++] = ',';
+        _pos += formatPoint(out + _pos, dp, sp);
+    }
+    _count++;
+    return true;
+}
+
+bool HistoryChunkWriter::add(const HistoryPoint& p) {
+    if (!hasRoom(1)) return false;
+    if (_binary) {
+        encodeHistoryRecord(_buf + _pos, p);
+        _pos += BIN_HISTORY_RECORD_SIZE;
+    } else {
+        char* out = (char*)_buf;
+        if (_count > 0) out[_pos++] = ',';
+        _pos += formatPoint(out + _pos, p);
+    }
+    _count++;
+    return true;
+}
+
+size_t HistoryChunkWriter::finish(bool final) {
+    if (_binary) {
+        finishHistoryChunk(_buf, (uint16_t)_count, final);
+        return _pos;
+    }
+    _pos += putStr((char*)_buf + _pos, final ? "],\"final\":true}" : "],\"final\":false}");
+    return _pos;
+}
+
+// ---------------------------------------------------------------------------
+// buildHistoryMessage — the whole history as one message, for callers that
+// already hold HistoryPoint arrays
+// ---------------------------------------------------------------------------
+char* buildHistoryMessage(const HistoryPoint* points, size_t count,
+                          float sp, float meat1Target, float meat2Target,
+                          size_t* outLen) {
+    HistoryMessageBuilder builder;
+    if (!builder.begin(count, sp, meat1Target, meat2Target)) {
+        if (outLen) *outLen = 0;
+        return nullptr;
+    }
+    for (size_t i = 0; i < count; i++) builder.add(points[i]);
+    return builder.finish(outLen);
+}
+
+} // namespace bbq_protocol
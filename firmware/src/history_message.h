@@ -0,0 +1,95 @@
+#pragma once
+
+#include "web_protocol.h"
+#include "data_point.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace bbq_protocol {
+
+// Builds a {"type":"history",...} message one point at a time, so callers
+// can format straight from session records (or rollup buckets) without
+// staging a HistoryPoint array first. The output buffer is sized once from
+// the expected point count and grows only if that estimate was short.
+// Replays to WebSocket clients use HistoryChunkWriter instead.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class HistoryMessageBuilder {
+public:
+    HistoryMessageBuilder();
+    ~HistoryMessageBuilder();
+
+    // Start a message. Returns false if the buffer cannot be allocated.
+    bool begin(size_t expectedPoints, float sp, float meat1Target, float meat2Target);
+
+    // Append a point. Returns false (and the message fails) on allocation failure.
+    bool add(const HistoryPoint& p);
+
+    // Append a raw session record: temps x10, DP_FLAG_*_DISC as null,
+    // DP_FLAG_LID_OPEN as lid. Formats the integers directly (no float).
+    bool add(const DataPoint& dp, float sp);
+
+    // Close the message and hand over the buffer (caller must free()).
+    // Returns nullptr if any step failed.
+    char* finish(size_t* outLen);
+
+    size_t getCount() const { return _count; }
+
+private:
+    // Make room for extra more bytes
+    bool reserve(size_t extra);
+
+    char*  _buf;
+    size_t _size;
+    size_t _pos;
+    size_t _count;
+    bool   _failed;
+};
+
+// Header fields carried by every chunk of a history replay
+struct HistoryChunkHeader {
+    uint32_t seq;          // 0 for the first chunk of a replay
+    uint32_t session;      // Cook start time, 0 = unknown
+    bool     append;       // Points follow on from what the client holds
+    float    sp;
+    float    meat1Target;  // 0 = not set
+    float    meat2Target;
+};
+
+// Formats one history_chunk frame into a fixed, caller-owned buffer, as JSON
+// ({"type":"history_chunk",...,"data":[...],"final":bool}) or as a binary
+// BIN_FRAME_HISTORY frame (see binary_frame.h). A replay is a run of chunks
+// with increasing seq; the client applies the header on seq 0 and redraws on
+// the final one. Points are added until the buffer is full, so memory per
+// replay is the buffer, whatever the session length.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class HistoryChunkWriter {
+public:
+    HistoryChunkWriter(uint8_t* buf, size_t size, bool binary);
+
+    // Start a chunk, discarding anything written before
+    void begin(const HistoryChunkHeader& header);
+
+    // Whether n more points are guaranteed to fit
+    bool hasRoom(size_t n) const;
+
+    // Append a point. Returns false (and adds nothing) if it does not fit.
+    bool add(const DataPoint& dp, float sp);
+    bool add(const HistoryPoint& p);
+
+    // Close the chunk. Returns its length in bytes (JSON is not terminated).
+    size_t finish(bool final);
+
+    size_t getCount() const { return _count; }
+    bool isBinary() const   { return _binary; }
+
+private:
+    uint8_t* _buf;
+    size_t   _size;
+    size_t   _pos;
+    size_t   _count;
+    bool     _binary;
+};
+
+} // namespace bbq_protocol
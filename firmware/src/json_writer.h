@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace bbq_protocol {
+
+// JSON null
+struct JsonNull {};
+
+// Number with one decimal, formatted byte-for-byte like printf("%.1f")
+struct JsonTenths {
+    float value;
+};
+
+// Streaming JSON writer over a caller-owned buffer. Emits compact JSON in the
+// same form ArduinoJson's serializeJson() does (field order as written, same
+// string escapes), with no dynamic allocation. field() and element() pick the
+// value encoding from the argument type; floats must be wrapped in JsonTenths
+// so no message formats a float by accident.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class JsonWriter {
+public:
+    JsonWriter(char* buf, size_t size)
+        : _buf(buf), _size(size), _pos(0), _first(true), _overflow(size == 0) {}
+
+    void beginObject() {
+        separator();
+        put('{');
+        _first = true;
+    }
+
+    // "key":{
+    void beginObject(const char* key) {
+        writeKey(key);
+        put('{');
+        _first = true;
+    }
+
+    void endObject() {
+        put('}');
+        _first = false;
+    }
+
+    void beginArray(const char* key) {
+        writeKey(key);
+        put('[');
+        _first = true;
+    }
+
+    void endArray() {
+        put(']');
+        _first = false;
+    }
+
+    // "key":value
+    template <typename T>
+    void field(const char* key, T value) {
+        writeKey(key);
+        writeValue(value);
+    }
+
+    // Array element
+    template <typename T>
+    void element(T value) {
+        separator();
+        writeValue(value);
+    }
+
+    // NUL-terminate and return the length, or 0 if the message did not fit
+    size_t finish() {
+        if (_overflow || _pos >= _size) {
+            if (_size > 0) _buf[0] = '\0';
+            return 0;
+        }
+        _buf[_pos] = '\0';
+        return _pos;
+    }
+
+private:
+    void put(char c) {
+        // Keep one byte for the terminator
+        if (_pos + 1 < _size) _buf[_pos++] = c;
+        else                  _overflow = true;
+    }
+
+    void putRaw(const char* s, size_t n) {
+        if (_pos + n < _size) {
+            memcpy(_buf + _pos, s, n);
+            _pos += n;
+        } else {
+            _overflow = true;
+        }
+    }
+
+    void separator() {
+        if (!_first) put(',');
+        _first = false;
+    }
+
+    void writeKey(const char* key) {
+        separator();
+        put('"');
+        putRaw(key, strlen(key));
+        put('"');
+        put(':');
+    }
+
+    void writeUnsigned(unsigned long long v) {
+        char tmp[20];
+        size_t n = 0;
+        do {
+            tmp[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v > 0);
+        while (n > 0) put(tmp[--n]);
+    }
+
+    void writeSigned(long long v) {
+        if (v < 0) {
+            put('-');
+            writeUnsigned(0ULL - (unsigned long long)v);
+        } else {
+            writeUnsigned((unsigned long long)v);
+        }
+    }
+
+    void writeValue(int v)           { writeSigned(v); }
+    void writeValue(long v)          { writeSigned(v); }
+    void writeValue(unsigned int v)  { writeUnsigned(v); }
+    void writeValue(unsigned long v) { writeUnsigned(v); }
+    void writeValue(bool v)          { v ? putRaw("true", 4) : putRaw("false", 5); }
+    void writeValue(JsonNull)        { putRaw("null", 4); }
+
+    // nullptr as null; escapes as ArduinoJson does
+    void writeValue(const char* s) {
+        if (!s) {
+            putRaw("null", 4);
+            return;
+        }
+        put('"');
+        for (; *s; s++) {
+            char c = *s;
+            switch (c) {
+                case '"':  put('\\'); put('"');  break;
+                case '\\': put('\\'); put('\\'); break;
+                case '\b': put('\\'); put('b');  break;
+                case '\f': put('\\'); put('f');  break;
+                case '\n': put('\\'); put('n');  break;
+                case '\r': put('\\'); put('r');  break;
+                case '\t': put('\\'); put('t');  break;
+                default:   put(c);               break;
+            }
+        }
+        put('"');
+    }
+
+    // The float widened to double and scaled by 10 is exact, so rounding it
+    // half-to-even (the default FP mode) matches printf's rounding of the
+    // exact binary value. Out-of-range values fall back to snprintf.
+    void writeValue(JsonTenths t) {
+        double scaled = (double)t.value * 10.0;
+        if (!(std::fabs(scaled) < 1e15)) {
+            char tmp[48];
+            int n = snprintf(tmp, sizeof(tmp), "%.1f", t.value);
+            if (n > 0) putRaw(tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+            return;
+        }
+        long long tenths = (long long)std::nearbyint(scaled);
+        if (tenths < 0 || (tenths == 0 && std::signbit(t.value))) {
+            put('-');
+            if (tenths < 0) tenths = -tenths;
+        }
+        writeUnsigned((unsigned long long)(tenths / 10));
+        put('.');
+        put((char)('0' + tenths % 10));
+    }
+
+    char*  _buf;
+    size_t _size;
+    size_t _pos;
+    bool   _first;
+    bool   _overflow;
+};
+
+} // namespace bbq_protocol
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+// Loop-iteration timing: worst case and average over a reporting window,
+// plus the all-time worst case since boot. Feed it the duration of each
+// loop() pass in microseconds.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class LoopStats {
+public:
+    explicit LoopStats(uint32_t budgetUs = 10000)
+        : _budgetUs(budgetUs)
+        , _allTimeMaxUs(0)
+    {
+        resetWindow();
+    }
+
+    void record(uint32_t us) {
+        _count++;
+        _sumUs += us;
+        if (us > _maxUs) _maxUs = us;
+        if (us > _allTimeMaxUs) _allTimeMaxUs = us;
+        if (us > _budgetUs) _overruns++;
+    }
+
+    // Start a new reporting window (all-time max is kept)
+    void resetWindow() {
+        _count = 0;
+        _sumUs = 0;
+        _maxUs = 0;
+        _overruns = 0;
+    }
+
+    uint32_t getCount() const       { return _count; }
+    uint32_t getMaxUs() const       { return _maxUs; }
+    uint32_t getAvgUs() const       { return _count ? (uint32_t)(_sumUs / _count) : 0; }
+    uint32_t getOverruns() const    { return _overruns; }   // Passes over budget
+    uint32_t getAllTimeMaxUs() const { return _allTimeMaxUs; }
+    uint32_t getBudgetUs() const    { return _budgetUs; }
+
+private:
+    uint32_t _budgetUs;
+    uint32_t _allTimeMaxUs;
+    uint32_t _count;
+    uint64_t _sumUs;
+    uint32_t _maxUs;
+    uint32_t _overruns;
+};
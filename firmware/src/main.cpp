@@ -3,6 +3,12 @@
 #include <Arduino.h>
 #include "config.h"
 #include "split_range.h"
+#include "loop_stats.h"
+#include "control_jitter.h"
+#include "seqlock.h"
+#include "system_snapshot.h"
+#include "control_command.h"
+#include <atomic>
 
 // --- Module headers ---
 #include "temp_manager.h"
@@ -35,75 +41,93 @@ BBQWebServer    webServer;
 OtaManager      otaManager;
 
 // --- Control state ---
+// Owned by the control path once it runs: the web server and the touch UI
+// change it by posting to g_commands, and everyone else reads the snapshot.
 static float    g_setpoint       = 225.0f;   // Default pit setpoint (degrees F)
 static float    g_prevSetpoint   = 225.0f;   // Previous setpoint for change detection
 static bool     g_pitReached     = false;     // Has pit ever reached setpoint?
+static uint32_t g_settingsVersion = 0;        // Bumped when units or fan mode change
 static uint32_t g_cookStartTime  = 0;         // Epoch when cook timer started
 static unsigned long g_lastPidMs = 0;         // Last PID computation timestamp
+static volatile bool g_newSessionRequested = false;  // Set by the control path, handled in loop()
 
-// --- Boot phase state machine ---
-enum class BootPhase { SPLASH, WIZARD, RUNNING };
-static BootPhase    g_bootPhase    = BootPhase::SPLASH;
-static unsigned long g_wizardDoneMs = 0;
+// --- Commands for the control path (web + touch UI -> control cycle) ---
+static CommandQueue g_commands;
 
-// --- CookSession data-source callbacks ---
-// These free functions bridge the global module instances into the function-pointer
-// interface that CookSession::setDataSources() expects.
+static void postCommand(const ControlCommand& cmd) {
+    if (!g_commands.post(cmd, micros())) {
+        Serial.printf("[CTRL] Command queue full, dropped command %u\n", (unsigned)cmd.type);
+    }
+}
 
-static float cb_getPitTemp()   { return tempManager.getPitTemp(); }
-static float cb_getMeat1Temp() { return tempManager.getMeat1Temp(); }
-static float cb_getMeat2Temp() { return tempManager.getMeat2Temp(); }
+// --- Loop timing (normal running phase) ---
+static LoopStats     g_loopStats(LOOP_BUDGET_US);
+static unsigned long g_lastLoopStatsMs = 0;
 
-static uint8_t cb_getFanPct() {
-    return static_cast<uint8_t>(fanController.getCurrentSpeedPct());
-}
+// --- Control timing: run time per cycle and period jitter ---
+static LoopStats       g_controlStats(CONTROL_PERIOD_MS * 1000UL);
+static JitterHistogram g_controlJitter(CONTROL_PERIOD_MS * 1000UL);
+static uint32_t        g_lastControlUs = 0;
+static TaskHandle_t    g_controlTask   = nullptr;
+// Set by loop() once it has logged a window; the control path, which alone
+// records into g_controlStats and the command latency, starts the new one
+static std::atomic<bool> g_controlWindowReset(false);
 
-static uint8_t cb_getDamperPct() {
-    return static_cast<uint8_t>(servoController.getCurrentPositionPct());
-}
+// --- Boot phase state machine ---
+enum class BootPhase { SPLASH, WIZARD, RUNNING };
+static BootPhase    g_bootPhase    = BootPhase::SPLASH;
+static unsigned long g_wizardDoneMs = 0;
 
-static uint8_t cb_getFlags() {
-    uint8_t flags = 0;
-    if (pidController.isLidOpen())                    flags |= DP_FLAG_LID_OPEN;
-    if (!tempManager.isConnected(PROBE_PIT))          flags |= DP_FLAG_PIT_DISC;
-    if (!tempManager.isConnected(PROBE_MEAT1))        flags |= DP_FLAG_MEAT1_DISC;
-    if (!tempManager.isConnected(PROBE_MEAT2))        flags |= DP_FLAG_MEAT2_DISC;
-    if (errorManager.isFireOut())                     flags |= DP_FLAG_ERROR_FIREOUT;
-
-    AlarmType activeAlarms[MAX_ACTIVE_ALARMS];
-    uint8_t count = alarmManager.getActiveAlarms(activeAlarms, MAX_ACTIVE_ALARMS);
-    for (uint8_t i = 0; i < count; i++) {
-        if (activeAlarms[i] == AlarmType::PIT_HIGH ||
-            activeAlarms[i] == AlarmType::PIT_LOW)    flags |= DP_FLAG_ALARM_PIT;
-        if (activeAlarms[i] == AlarmType::MEAT1_DONE) flags |= DP_FLAG_ALARM_MEAT1;
-        if (activeAlarms[i] == AlarmType::MEAT2_DONE) flags |= DP_FLAG_ALARM_MEAT2;
-    }
-    return flags;
+// --- System snapshot ---
+// Published by the control path at the end of every cycle. loop() copies it
+// into g_view once per pass; the session, web server and display read that.
+static Seqlock<SystemSnapshot> g_snapshot;
+static SystemSnapshot          g_view;
+
+// Plot a recorded session point on the dashboard graph
+static void graphAddPoint(const DataPoint& dp) {
+    ui_graph_add_point(
+        dp.pitTemp / 10.0f,
+        dp.meat1Temp / 10.0f,
+        dp.meat2Temp / 10.0f,
+        g_view.setpoint,
+        (dp.flags & DP_FLAG_PIT_DISC) != 0,
+        (dp.flags & DP_FLAG_MEAT1_DISC) != 0,
+        (dp.flags & DP_FLAG_MEAT2_DISC) != 0
+    );
 }
 
-// --- WebSocket command callbacks ---
+// --- WebSocket command callbacks (AsyncTCP task: post only) ---
 static void ws_onSetpoint(float sp) {
-    g_setpoint = sp;
+    postCommand(ControlCommand::make(CommandType::SETPOINT, sp));
 }
 
 static void ws_onAlarm(const char* probe, float target) {
-    if (strcmp(probe, "meat1") == 0)      alarmManager.setMeat1Target(target);
-    else if (strcmp(probe, "meat2") == 0) alarmManager.setMeat2Target(target);
-    else if (strcmp(probe, "pitBand") == 0) alarmManager.setPitBand(target);
+    if (strcmp(probe, "meat1") == 0)
+        postCommand(ControlCommand::make(CommandType::MEAT_TARGET, target, 1));
+    else if (strcmp(probe, "meat2") == 0)
+        postCommand(ControlCommand::make(CommandType::MEAT_TARGET, target, 2));
+    else if (strcmp(probe, "pitBand") == 0)
+        postCommand(ControlCommand::make(CommandType::PIT_BAND, target));
 }
 
 static void ws_onFanMode(const char* mode) {
-    configManager.setFanMode(mode);
-    ui_update_settings_state(configManager.isFahrenheit(), configManager.getFanMode());
+    postCommand(ControlCommand::withText(CommandType::FAN_MODE, mode));
+}
+
+// End the current cook and start a new one. Runs on the loop task only:
+// CookSession is the single producer for the session writer queue.
+static void startNewSession() {
+    cookSession.endSession();
+    cookSession.startSession();
+    g_cookStartTime = 0;
+    ui_graph_clear();
+    webServer.broadcastSessionReset(g_view.setpoint);
 }
 
 static void ws_onSession(const char* action, const char* format) {
     if (strcmp(action, "new") == 0) {
-        cookSession.endSession();
-        cookSession.startSession();
-        g_cookStartTime = 0;
-        g_pitReached = false;
-        ui_graph_clear();
+        postCommand(ControlCommand::make(CommandType::NEW_SESSION));
     }
 }
 
@@ -111,35 +135,43 @@ static void ws_onSession(const char* action, const char* format) {
 static unsigned long g_lastDisplayMs = 0;
 static unsigned long g_lastGraphMs   = 0;
 
-// --- UI callbacks ---
+// --- UI callbacks (loop task: post only, except during the setup wizard) ---
 static void ui_cb_setpoint(float sp) {
-    g_setpoint = sp;
+    postCommand(ControlCommand::make(CommandType::SETPOINT, sp));
 }
 
 static void ui_cb_meat_target(uint8_t probe, float target) {
-    if (probe == 1) alarmManager.setMeat1Target(target);
-    if (probe == 2) alarmManager.setMeat2Target(target);
+    if (probe == 1 || probe == 2) {
+        postCommand(ControlCommand::make(CommandType::MEAT_TARGET, target, probe));
+    }
 }
 
 static void ui_cb_alarm_ack() {
-    alarmManager.acknowledge();
+    postCommand(ControlCommand::make(CommandType::ALARM_ACK));
 }
 
-static void ui_cb_units(bool isFahrenheit) {
+static void applyUnits(bool isFahrenheit) {
     configManager.setUnits(isFahrenheit ? "F" : "C");
     tempManager.setUseFahrenheit(isFahrenheit);
 }
 
+static void ui_cb_units(bool isFahrenheit) {
+    // The wizard runs before the control path takes over
+    if (g_bootPhase != BootPhase::RUNNING) {
+        applyUnits(isFahrenheit);
+        return;
+    }
+    ControlCommand cmd = ControlCommand::make(CommandType::UNITS);
+    cmd.flag = isFahrenheit;
+    postCommand(cmd);
+}
+
 static void ui_cb_fan_mode(const char* mode) {
-    configManager.setFanMode(mode);
+    postCommand(ControlCommand::withText(CommandType::FAN_MODE, mode));
 }
 
 static void ui_cb_new_session() {
-    cookSession.endSession();
-    cookSession.startSession();
-    g_cookStartTime = 0;
-    g_pitReached = false;
-    ui_graph_clear();
+    postCommand(ControlCommand::make(CommandType::NEW_SESSION));
 }
 
 static void ui_cb_factory_reset() {
@@ -187,6 +219,188 @@ static void ui_cb_wifi_action(const char* action) {
     }
 }
 
+// ---------------------------------------------------------------------------
+// Control path: probes -> PID -> split-range -> fan + damper, then alarms,
+// errors and the SystemSnapshot everything else reads. Runs every
+// CONTROL_PERIOD_MS in a task of its own, pinned to CONTROL_TASK_CORE above
+// loop() and the network tasks, so an LVGL redraw, a Wi-Fi reconnect or a
+// slow web request can't hold it up. Only this path drives the outputs once
+// the boot phases are over; loop() feeds the session, the web server and
+// the display from the published snapshot. With CONTROL_TASK=0 (or if
+// the task can't be created) loop() calls it inline on every pass.
+// ---------------------------------------------------------------------------
+static void applyCommand(const ControlCommand& cmd) {
+    switch (cmd.type) {
+        case CommandType::SETPOINT:
+            g_setpoint = cmd.value;
+            break;
+        case CommandType::MEAT_TARGET:
+            if (cmd.probe == 1) alarmManager.setMeat1Target(cmd.value);
+            else                alarmManager.setMeat2Target(cmd.value);
+            break;
+        case CommandType::PIT_BAND:
+            alarmManager.setPitBand(cmd.value);
+            break;
+        case CommandType::ALARM_ACK:
+            alarmManager.acknowledge();
+            break;
+        case CommandType::FAN_MODE:
+            configManager.setFanMode(cmd.text);
+            g_settingsVersion++;
+            break;
+        case CommandType::UNITS:
+            applyUnits(cmd.flag);
+            g_settingsVersion++;
+            break;
+        case CommandType::NEW_SESSION:
+            g_pitReached = false;
+            g_newSessionRequested = true;  // The session itself is reset by loop()
+            break;
+    }
+}
+
+static void controlStep() {
+    uint32_t startUs = micros();
+    if (g_lastControlUs != 0) {
+        g_controlJitter.record(startUs - g_lastControlUs);
+    }
+    g_lastControlUs = startUs;
+
+    if (g_controlWindowReset.exchange(false)) {
+        g_controlStats.resetWindow();
+        g_commands.resetLatencyWindow();
+    }
+
+    // 0. Commands posted by the web server and the touch UI since last cycle
+    g_commands.drain(startUs, applyCommand);
+
+    // 1. Read temperatures from all probes (internally gated at TEMP_SAMPLE_INTERVAL_MS)
+    tempManager.update();
+
+    // 2. PID computation (every PID_SAMPLE_MS)
+    unsigned long now = millis();
+    float setpoint = g_setpoint;
+    if (now - g_lastPidMs >= PID_SAMPLE_MS) {
+        g_lastPidMs = now;
+
+        // Reset integrator on setpoint change for bumpless transfer
+        if (setpoint != g_prevSetpoint) {
+            pidController.resetIntegrator();
+            g_pitReached = false;  // Suppress pit-band alarms during ramp to new setpoint
+            g_prevSetpoint = setpoint;
+        }
+
+        // Only compute PID when pit probe is connected. When disconnected,
+        // _pidOutput retains its last value to maintain current fire management.
+        if (tempManager.isConnected(PROBE_PIT)) {
+            float pitTemp = tempManager.getPitTemp();
+            pidController.compute(pitTemp, setpoint);
+
+            // Track whether pit has ever reached setpoint (within 5 degrees F).
+            if (!g_pitReached) {
+                if (fabsf(pitTemp - setpoint) <= 5.0f) {
+                    g_pitReached = true;
+                }
+            }
+        }
+    }
+
+    // 3. Mode-aware fan + damper from PID output (split-range coordination)
+    {
+        SplitRangeOutput sr = splitRange(pidController.getOutput(),
+                                         configManager.getFanMode(),
+                                         configManager.getFanOnThreshold());
+        servoController.setPosition(sr.damperPercent);
+        fanController.setSpeed(sr.fanPercent);
+    }
+
+    // 4. Fan controller update (kick-start timing, long-pulse cycling)
+    fanController.update();
+
+    // 5. This cycle's snapshot: probes first, as alarms and errors use them
+    SystemSnapshot snap;
+    snap.cycle = g_snapshot.getVersion() + 1;
+    snap.ms = (uint32_t)now;
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        snap.temp[i]      = tempManager.getTemp(i);
+        snap.status[i]    = tempManager.getStatus(i);
+        snap.connected[i] = tempManager.isConnected(i);
+    }
+    snap.setpoint   = setpoint;
+    snap.pitReached = g_pitReached;
+    snap.fanPct     = fanController.getCurrentSpeedPct();
+    snap.damperPct  = servoController.getCurrentPositionPct();
+    snap.fahrenheit = configManager.isFahrenheit();
+    strncpy(snap.fanMode, configManager.getFanMode(), sizeof(snap.fanMode) - 1);
+    snap.settingsVersion = g_settingsVersion;
+
+    // 6. Alarm manager
+    alarmManager.update(snap.temp[PROBE_PIT], snap.temp[PROBE_MEAT1], snap.temp[PROBE_MEAT2],
+                        snap.setpoint, snap.pitReached);
+
+    // 7. Error manager
+    {
+        ProbeState probeStates[NUM_PROBES];
+        for (uint8_t i = 0; i < NUM_PROBES; i++) {
+            probeStates[i].connected    = snap.connected[i];
+            probeStates[i].openCircuit  = (snap.status[i] == ProbeStatus::OPEN_CIRCUIT);
+            probeStates[i].shortCircuit = (snap.status[i] == ProbeStatus::SHORT_CIRCUIT);
+            probeStates[i].temperature  = snap.temp[i];
+        }
+        errorManager.update(snap.temp[PROBE_PIT], snap.fanPct, probeStates);
+    }
+
+    // 8. Publish for loop(), the web server and the display
+    snap.pidOutput   = pidController.getOutput();
+    snap.pTerm       = pidController.getPterm();
+    snap.iTerm       = pidController.getIterm();
+    snap.dTerm       = pidController.getDterm();
+    snap.lidOpen     = pidController.isLidOpen();
+    snap.meat1Target = alarmManager.getMeat1Target();
+    snap.meat2Target = alarmManager.getMeat2Target();
+    snap.alarmCount  = alarmManager.getActiveAlarms(snap.alarms, MAX_ACTIVE_ALARMS);
+    snap.errorCount  = errorManager.copyErrors(snap.errors, MAX_ERRORS);
+    snap.fireOut     = errorManager.isFireOut();
+    {
+        const LoopStats& lat = g_commands.getLatency();
+        snap.runMaxUs            = g_controlStats.getMaxUs();
+        snap.runAvgUs            = g_controlStats.getAvgUs();
+        snap.runAllTimeMaxUs     = g_controlStats.getAllTimeMaxUs();
+        snap.latencyMaxUs        = lat.getMaxUs();
+        snap.latencyAvgUs        = lat.getAvgUs();
+        snap.latencyAllTimeMaxUs = lat.getAllTimeMaxUs();
+        snap.latencyOverPeriod   = lat.getOverruns();
+    }
+    g_snapshot.write(snap);
+
+    g_controlStats.record(micros() - startUs);
+}
+
+static void controlTaskMain(void* arg) {
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        controlStep();
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+    }
+}
+
+// Hand the outputs to the control path once the boot phases are done
+static void startControl() {
+    g_lastPidMs = millis();
+#if CONTROL_TASK
+    BaseType_t ok = xTaskCreatePinnedToCore(controlTaskMain, "control", CONTROL_TASK_STACK,
+                                            nullptr, CONTROL_TASK_PRIORITY, &g_controlTask,
+                                            CONTROL_TASK_CORE);
+    if (ok != pdPASS) {
+        g_controlTask = nullptr;
+        Serial.println("[CTRL] Task create failed, control runs from loop()");
+        return;
+    }
+    Serial.printf("[CTRL] Control task on core %d, %u ms period\n",
+                  CONTROL_TASK_CORE, (unsigned)CONTROL_PERIOD_MS);
+#endif
+}
+
 // ---------------------------------------------------------------------------
 // setup()
 // ---------------------------------------------------------------------------
@@ -245,21 +459,22 @@ void setup() {
 
     // 11. Start HTTP server and WebSocket, pass module references
     webServer.begin();
-    webServer.setModules(&tempManager, &pidController, &fanController,
-                         &servoController, &configManager, &cookSession,
-                         &alarmManager, &errorManager);
+    webServer.setModules(&tempManager, &cookSession);
+    webServer.setSnapshot(&g_snapshot);
     webServer.onSetpoint(ws_onSetpoint);
     webServer.onAlarm(ws_onAlarm);
     webServer.onSession(ws_onSession);
     webServer.onFanMode(ws_onFanMode);
+    webServer.setLoopStats(&g_loopStats);
+    webServer.setControlStats(&g_controlJitter);
+    webServer.setCommandQueue(&g_commands);
 
     // 12. Initialize OTA updates (needs the AsyncWebServer to register /update route)
     otaManager.begin(webServer.getAsyncServer());
 
     // 13. Recover any existing cook session from flash
     cookSession.begin();
-    cookSession.setDataSources(cb_getPitTemp, cb_getMeat1Temp, cb_getMeat2Temp,
-                               cb_getFanPct, cb_getDamperPct, cb_getFlags);
+    cookSession.setSnapshot(&g_view);
 
     // 14. Wire up dashboard callbacks and set initial state
     ui_set_callbacks(ui_cb_setpoint, ui_cb_meat_target, ui_cb_alarm_ack);
@@ -272,22 +487,23 @@ void setup() {
     ui_update_meat2_target(alarmManager.getMeat2Target());
     ui_update_settings_state(configManager.isFahrenheit(), configManager.getFanMode());
 
-    // Pre-populate graph from recovered session data
+    // Pre-populate graph from recovered session data (whole cook): anything
+    // older than the RAM ring through a cursor, then the ring spans in place
     {
-        uint32_t sessionPoints = cookSession.getTotalPointCount();
-        for (uint32_t i = 0; i < sessionPoints; i++) {
-            const DataPoint* dp = cookSession.getPoint(i);
-            if (dp) {
-                ui_graph_add_point(
-                    dp->pitTemp / 10.0f,
-                    dp->meat1Temp / 10.0f,
-                    dp->meat2Temp / 10.0f,
-                    g_setpoint,
-                    (dp->flags & DP_FLAG_PIT_DISC) != 0,
-                    (dp->flags & DP_FLAG_MEAT1_DISC) != 0,
-                    (dp->flags & DP_FLAG_MEAT2_DISC) != 0
-                );
+        RingView<DataPoint> ram = cookSession.getRamPoints();
+        uint32_t ramStart = cookSession.getTotalPointCount() - ram.size();
+        DataPoint dp;
+
+        if (ramStart > 0) {
+            SessionCursor cursor;
+            cookSession.openCursor(cursor);
+            while (cursor.index < ramStart && cookSession.readNext(cursor, dp)) {
+                graphAddPoint(dp);
             }
+            cookSession.closeCursor(cursor);
+        }
+        for (const DataPoint& p : ram) {
+            graphAddPoint(p);
         }
     }
 
@@ -328,6 +544,7 @@ void loop() {
                 ui_switch_screen(Screen::DASHBOARD);
                 g_bootPhase = BootPhase::RUNNING;
                 Serial.println("[BOOT] Entering normal operation");
+                startControl();
             }
         }
         ui_tick(10);
@@ -388,6 +605,7 @@ void loop() {
                 ui_switch_screen(Screen::DASHBOARD);
                 g_bootPhase = BootPhase::RUNNING;
                 Serial.println("[BOOT] Entering normal operation");
+                startControl();
             }
         }
         ui_tick(10);
@@ -397,100 +615,58 @@ void loop() {
     }
 
     // --- Normal running phase ---
-    // 1. Read temperatures from all probes (internally gated at TEMP_SAMPLE_INTERVAL_MS)
-    tempManager.update();
-
-    // 2. PID computation (every PID_SAMPLE_MS)
-    if (now - g_lastPidMs >= PID_SAMPLE_MS) {
-        g_lastPidMs = now;
+    uint32_t loopStartUs = micros();
 
-        // Reset integrator on setpoint change for bumpless transfer
-        if (g_setpoint != g_prevSetpoint) {
-            pidController.resetIntegrator();
-            g_pitReached = false;  // Suppress pit-band alarms during ramp to new setpoint
-            g_prevSetpoint = g_setpoint;
-        }
-
-        // Only compute PID when pit probe is connected. When disconnected,
-        // _pidOutput retains its last value to maintain current fire management.
-        if (tempManager.isConnected(PROBE_PIT)) {
-            float pitTemp = tempManager.getPitTemp();
-            pidController.compute(pitTemp, g_setpoint);
-
-            // Track whether pit has ever reached setpoint (within 5 degrees F).
-            if (!g_pitReached) {
-                if (fabsf(pitTemp - g_setpoint) <= 5.0f) {
-                    g_pitReached = true;
-                }
-            }
-        }
+    // 1-4. Control path: probes, PID, fan + damper (unless the control task runs it)
+    if (!g_controlTask) {
+        controlStep();
     }
 
-    // 3. Mode-aware fan + damper from PID output (split-range coordination)
+    // 5. One copy of the control cycle's snapshot for everything below
+    g_snapshot.read(g_view);
     {
-        SplitRangeOutput sr = splitRange(pidController.getOutput(),
-                                         configManager.getFanMode(),
-                                         configManager.getFanOnThreshold());
-        servoController.setPosition(sr.damperPercent);
-        fanController.setSpeed(sr.fanPercent);
-    }
-
-    // 4. Fan controller update (kick-start timing, long-pulse cycling)
-    fanController.update();
-
-    // 5. Alarm manager
-    alarmManager.update(tempManager.getPitTemp(),
-                        tempManager.getMeat1Temp(),
-                        tempManager.getMeat2Temp(),
-                        g_setpoint,
-                        g_pitReached);
-
-    // 6. Error manager
-    {
-        ProbeState probeStates[NUM_PROBES];
-        for (uint8_t i = 0; i < NUM_PROBES; i++) {
-            ProbeStatus st = tempManager.getStatus(i);
-            probeStates[i].connected    = tempManager.isConnected(i);
-            probeStates[i].openCircuit  = (st == ProbeStatus::OPEN_CIRCUIT);
-            probeStates[i].shortCircuit = (st == ProbeStatus::SHORT_CIRCUIT);
-            probeStates[i].temperature  = tempManager.getTemp(i);
+        static uint32_t shownSettings = 0;
+        if (g_view.settingsVersion != shownSettings) {
+            shownSettings = g_view.settingsVersion;
+            ui_update_settings_state(g_view.fahrenheit, g_view.fanMode);
         }
-        errorManager.update(tempManager.getPitTemp(),
-                            fanController.getCurrentSpeedPct(),
-                            probeStates);
     }
 
-    // 7. Cook session update (auto-samples and flushes on its own timers)
+    // 6. Cook session update (auto-samples on its own timer; flushes are
+    //    queued for the background writer task)
+    if (g_newSessionRequested) {
+        g_newSessionRequested = false;
+        startNewSession();
+    }
     cookSession.update();
 
-    // 8. Web server update (broadcasts to WebSocket clients at WS_SEND_INTERVAL)
-    webServer.setSetpoint(g_setpoint);
+    // 7. Web server update (broadcasts to WebSocket clients at WS_SEND_INTERVAL)
+    webServer.setSetpoint(g_view.setpoint);
     webServer.update();
 
-    // 9. WiFi manager (handles reconnection)
+    // 8. WiFi manager (handles reconnection)
     wifiManager.update();
 
-    // 10. OTA manager (handles OTA progress)
+    // 9. OTA manager (handles OTA progress)
     otaManager.update();
 
-    // 11. LVGL display update (~1 Hz for data, ~5s for graph)
+    // 10. LVGL display update (~1 Hz for data, ~5s for graph)
     if (now - g_lastDisplayMs >= 1000) {
         g_lastDisplayMs = now;
 
-        ui_update_temps(tempManager.getPitTemp(),
-                        tempManager.getMeat1Temp(),
-                        tempManager.getMeat2Temp(),
-                        tempManager.isConnected(PROBE_PIT),
-                        tempManager.isConnected(PROBE_MEAT1),
-                        tempManager.isConnected(PROBE_MEAT2));
+        ui_update_temps(g_view.temp[PROBE_PIT],
+                        g_view.temp[PROBE_MEAT1],
+                        g_view.temp[PROBE_MEAT2],
+                        g_view.connected[PROBE_PIT],
+                        g_view.connected[PROBE_MEAT1],
+                        g_view.connected[PROBE_MEAT2]);
 
-        ui_update_setpoint(g_setpoint);
-        ui_update_output_bars(fanController.getCurrentSpeedPct(),
-                              servoController.getCurrentPositionPct());
+        ui_update_setpoint(g_view.setpoint);
+        ui_update_output_bars(g_view.fanPct, g_view.damperPct);
 
         // Cook timer — starts when first meat probe connects
         if (g_cookStartTime == 0) {
-            if (tempManager.isConnected(PROBE_MEAT1) || tempManager.isConnected(PROBE_MEAT2)) {
+            if (g_view.connected[PROBE_MEAT1] || g_view.connected[PROBE_MEAT2]) {
                 g_cookStartTime = (uint32_t)(millis() / 1000);
             }
         }
@@ -518,41 +694,56 @@ void loop() {
             ui_update_wifi_info(winfo);
         }
 
-        // Alerts
-        AlarmType activeAlarms[MAX_ACTIVE_ALARMS];
-        uint8_t alarmCount = alarmManager.getActiveAlarms(activeAlarms, MAX_ACTIVE_ALARMS);
-        uint8_t topAlarm = 0;
-        for (uint8_t i = 0; i < alarmCount; i++) {
-            topAlarm = (uint8_t)activeAlarms[i];
-            break; // Take the first active alarm
-        }
-        uint8_t probeErrors = 0;
-        if (tempManager.getStatus(PROBE_PIT) != ProbeStatus::OK)   probeErrors |= 0x01;
-        if (tempManager.getStatus(PROBE_MEAT1) != ProbeStatus::OK) probeErrors |= 0x02;
-        if (tempManager.getStatus(PROBE_MEAT2) != ProbeStatus::OK) probeErrors |= 0x04;
-        ui_update_alerts(topAlarm, pidController.isLidOpen(), errorManager.isFireOut(), probeErrors);
+        // Alerts (the first active alarm is shown)
+        uint8_t topAlarm = g_view.alarmCount > 0 ? (uint8_t)g_view.alarms[0] : 0;
+        ui_update_alerts(topAlarm, g_view.lidOpen, g_view.fireOut, g_view.probeErrorBits());
 
         // Meat targets
-        ui_update_meat1_target(alarmManager.getMeat1Target());
-        ui_update_meat2_target(alarmManager.getMeat2Target());
+        ui_update_meat1_target(g_view.meat1Target);
+        ui_update_meat2_target(g_view.meat2Target);
     }
 
     // Graph update (every 5 seconds)
     if (now - g_lastGraphMs >= 5000) {
         g_lastGraphMs = now;
-        ui_graph_add_point(tempManager.getPitTemp(),
-                           tempManager.getMeat1Temp(),
-                           tempManager.getMeat2Temp(),
-                           g_setpoint,
-                           !tempManager.isConnected(PROBE_PIT),
-                           !tempManager.isConnected(PROBE_MEAT1),
-                           !tempManager.isConnected(PROBE_MEAT2));
+        ui_graph_add_point(g_view.temp[PROBE_PIT],
+                           g_view.temp[PROBE_MEAT1],
+                           g_view.temp[PROBE_MEAT2],
+                           g_view.setpoint,
+                           !g_view.connected[PROBE_PIT],
+                           !g_view.connected[PROBE_MEAT1],
+                           !g_view.connected[PROBE_MEAT2]);
     }
 
-    // 12. LVGL tick and task handler
+    // 11. LVGL tick and task handler
     ui_tick(10);
     ui_handler();
 
+    // 12. Loop timing: worst-case pass per window (excludes the delay below)
+    g_loopStats.record(micros() - loopStartUs);
+    if (now - g_lastLoopStatsMs >= LOOP_STATS_INTERVAL) {
+        g_lastLoopStatsMs = now;
+        const SessionWriter& writer = cookSession.getWriter();
+        Serial.printf("[LOOP] max %u us, avg %u us, %u over budget; all-time max %u us. "
+                      "Writer: max %u us, queue peak %u\n",
+                      g_loopStats.getMaxUs(), g_loopStats.getAvgUs(),
+                      g_loopStats.getOverruns(), g_loopStats.getAllTimeMaxUs(),
+                      writer.getMaxWriteUs(), writer.getQueueHighWater());
+        Serial.printf("[CTRL] %s: run max %u us, avg %u us; jitter max %u us, "
+                      "p99 < %u us, %u late of %u\n",
+                      g_controlTask ? "task" : "inline",
+                      g_view.runMaxUs, g_view.runAvgUs,
+                      g_controlJitter.getMaxJitterUs(), g_controlJitter.percentileUs(99),
+                      g_controlJitter.getLate(), g_controlJitter.getCount());
+        Serial.printf("[CTRL] Commands: %u applied, %u dropped; latency max %u us, "
+                      "avg %u us, all-time max %u us\n",
+                      g_commands.getApplied(), g_commands.getDropped(),
+                      g_view.latencyMaxUs, g_view.latencyAvgUs,
+                      g_view.latencyAllTimeMaxUs);
+        g_loopStats.resetWindow();
+        g_controlWindowReset.store(true);
+    }
+
     // Yield to FreeRTOS / keep loop at ~100 Hz
     delay(10);
 }
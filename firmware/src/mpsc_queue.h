@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded lock-free multi-producer / single-consumer ring of fixed-size
+// items. Any number of threads (or tasks) may push; exactly one may pop.
+// Holds up to N items; N must be a power of two. No heap, no locks.
+//
+// Each slot carries a sequence number. A producer claims a slot by moving
+// _enqueue forward with a compare-and-swap, copies its item in, then
+// releases the slot by advancing its sequence; the consumer takes a slot
+// only once its sequence says it is full. A producer preempted between
+// claiming and releasing holds back the items queued after it until it
+// runs again; it never blocks the other producers.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+template <typename T, size_t N>
+class MpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscQueue size must be a power of two");
+
+public:
+    MpscQueue() : _enqueue(0), _dequeue(0), _highWater(0) {
+        for (uint32_t i = 0; i < N; i++) _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Any producer: copy item in. Returns false if the queue is full.
+    bool push(const T& item) {
+        uint32_t pos = _enqueue.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &_cells[pos & MASK];
+            uint32_t seq = cell->seq.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0) {
+                if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;   // Slot still holds an item from a lap ago
+            } else {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item = item;
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        // Approximate under contention; exact with one producer
+        uint32_t used = pos + 1 - _dequeue.load(std::memory_order_relaxed);
+        uint32_t peak = _highWater.load(std::memory_order_relaxed);
+        while (used > peak &&
+               !_highWater.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {}
+        return true;
+    }
+
+    // Consumer: copy the oldest item out. Returns false if the queue is empty.
+    bool pop(T& out) {
+        uint32_t pos = _dequeue.load(std::memory_order_relaxed);
+        Cell& cell = _cells[pos & MASK];
+        uint32_t seq = cell.seq.load(std::memory_order_acquire);
+        if ((int32_t)(seq - (pos + 1)) < 0) return false;
+
+        out = cell.item;
+        cell.seq.store(pos + N, std::memory_order_release);
+        _dequeue.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Approximate when called from a producer; exact from the consumer
+    bool empty() const {
+        return _enqueue.load(std::memory_order_acquire) == _dequeue.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return _enqueue.load(std::memory_order_acquire) - _dequeue.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+    // Most items ever queued at once
+    uint32_t getHighWater() const { return _highWater.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint32_t MASK = N - 1;
+
+    struct Cell {
+        std::atomic<uint32_t> seq;
+        T item;
+    };
+
+    Cell _cells[N];
+    std::atomic<uint32_t> _enqueue;
+    std::atomic<uint32_t> _dequeue;
+    std::atomic<uint32_t> _highWater;
+};
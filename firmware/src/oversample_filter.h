@@ -0,0 +1,136 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+#define OVERSAMPLE_MAX_SAMPLES 8   // Conversions reduced at once (fixed-size windows)
+
+// How the conversions of one probe in one sample interval become a reading
+enum class OutlierFilter : uint8_t {
+    MEAN   = 0,    // Plain average, nothing rejected
+    MEDIAN = 1,    // Median (mean of the middle two for an even count)
+    HAMPEL = 2     // Drop samples more than k scaled MADs from the median, average the rest
+};
+
+struct OversampleResult {
+    int16_t value = 0;      // Filtered raw count
+    uint8_t used = 0;       // Samples the value came from
+    uint8_t rejected = 0;   // Samples dropped as outliers
+    float   spread = 0.0f;  // Standard deviation of the samples used (counts)
+};
+
+// Median of n counts (n <= OVERSAMPLE_MAX_SAMPLES; mean of the middle two
+// for even n). The input is left as it is.
+inline float oversampleMedian(const int16_t* samples, uint8_t n) {
+    if (n == 0) return 0.0f;
+    if (n > OVERSAMPLE_MAX_SAMPLES) n = OVERSAMPLE_MAX_SAMPLES;
+
+    // Insertion sort of a copy: at most eight values
+    int16_t sorted[OVERSAMPLE_MAX_SAMPLES];
+    for (uint8_t i = 0; i < n; i++) {
+        int16_t v = samples[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    if (n & 1) return sorted[n / 2];
+    return 0.5f * ((float)sorted[n / 2 - 1] + (float)sorted[n / 2]);
+}
+
+// Reduce one probe's conversions to one reading. HAMPEL takes the median,
+// then the median absolute deviation (MAD) as a robust spread; a sample
+// further than k * 1.4826 * MAD from the median is an outlier (1.4826 makes
+// the MAD estimate a standard deviation for Gaussian noise). minSpread keeps
+// a quiet probe, whose MAD can be zero, from rejecting its normal noise.
+// The inliers are averaged. Always at least half the samples are kept.
+inline OversampleResult oversampleReduce(const int16_t* samples, uint8_t n, OutlierFilter mode,
+                                         float k, float minSpread) {
+    OversampleResult r;
+    if (n == 0) return r;
+    if (n > OVERSAMPLE_MAX_SAMPLES) n = OVERSAMPLE_MAX_SAMPLES;
+
+    bool keep[OVERSAMPLE_MAX_SAMPLES];
+    for (uint8_t i = 0; i < n; i++) keep[i] = true;
+
+    float median = mode == OutlierFilter::MEAN ? 0.0f : oversampleMedian(samples, n);
+    if (mode == OutlierFilter::HAMPEL) {
+        int16_t dev[OVERSAMPLE_MAX_SAMPLES];
+        for (uint8_t i = 0; i < n; i++) {
+            float d = fabsf((float)samples[i] - median);
+            dev[i] = d > 32767.0f ? 32767 : (int16_t)(d + 0.5f);
+        }
+        float scale = 1.4826f * oversampleMedian(dev, n);
+        if (scale < minSpread) scale = minSpread;
+        float limit = k * scale;
+        for (uint8_t i = 0; i < n; i++) {
+            if (fabsf((float)samples[i] - median) > limit) {
+                keep[i] = false;
+                r.rejected++;
+            }
+        }
+    }
+
+    // Mean and spread of the samples kept
+    float sum = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        if (keep[i]) {
+            sum += samples[i];
+            r.used++;
+        }
+    }
+    float mean = sum / r.used;
+    float sq = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        if (keep[i]) sq += ((float)samples[i] - mean) * ((float)samples[i] - mean);
+    }
+    r.spread = sqrtf(sq / r.used);
+
+    r.value = (int16_t)lroundf(mode == OutlierFilter::MEDIAN ? median : mean);
+    return r;
+}
+
+// Noise statistics for one probe's oversampled readings: how many samples
+// were rejected as outliers, and how widely the kept samples spread.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class ProbeNoise {
+public:
+    ProbeNoise() { reset(); }
+
+    void record(const OversampleResult& r) {
+        if (r.used == 0) return;
+        _readings++;
+        _samples += r.used + r.rejected;
+        _rejected += r.rejected;
+        _spread = r.spread;
+        _spreadSum += r.spread;
+        if (r.spread > _maxSpread) _maxSpread = r.spread;
+    }
+
+    void reset() {
+        _readings = 0;
+        _samples = 0;
+        _rejected = 0;
+        _spread = 0.0f;
+        _spreadSum = 0.0f;
+        _maxSpread = 0.0f;
+    }
+
+    uint32_t getReadings() const  { return _readings; }
+    uint32_t getSamples() const   { return _samples; }
+    uint32_t getRejected() const  { return _rejected; }
+    float    getSpread() const    { return _spread; }        // Last reading (counts)
+    float    getAvgSpread() const { return _readings ? _spreadSum / _readings : 0.0f; }
+    float    getMaxSpread() const { return _maxSpread; }
+
+private:
+    uint32_t _readings;
+    uint32_t _samples;
+    uint32_t _rejected;
+    float    _spread;
+    float    _spreadSum;
+    float    _maxSpread;
+};
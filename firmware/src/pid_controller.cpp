@@ -94,6 +94,27 @@ float PidController::getOutput() const {
     return _pidOutput;
 }
 
+float PidController::getPterm() const {
+#ifndef NATIVE_BUILD
+    if (_pid != nullptr) return _pid->GetPterm();
+#endif
+    return 0.0f;
+}
+
+float PidController::getIterm() const {
+#ifndef NATIVE_BUILD
+    if (_pid != nullptr) return _pid->GetIterm();
+#endif
+    return 0.0f;
+}
+
+float PidController::getDterm() const {
+#ifndef NATIVE_BUILD
+    if (_pid != nullptr) return _pid->GetDterm();
+#endif
+    return 0.0f;
+}
+
 void PidController::setTunings(float kp, float ki, float kd) {
     _kp = kp;
     _ki = ki;
@@ -30,6 +30,12 @@ public:
     // PID output in the range [0..100] percent
     float getOutput() const;
 
+    // Proportional, integral and derivative parts of the last output (%),
+    // for the web server's control channel
+    float getPterm() const;
+    float getIterm() const;
+    float getDterm() const;
+
     // Update tuning parameters at runtime
     void setTunings(float kp, float ki, float kd);
 
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Contiguous run of records
+template <typename T>
+struct Span {
+    const T* data;
+    uint32_t size;
+
+    const T* begin() const { return data; }
+    const T* end() const   { return data + size; }
+    bool empty() const     { return size == 0; }
+};
+
+// Read-only view of a circular buffer's contents, oldest first, as at most
+// two contiguous spans. Iterating it walks plain pointers: no modulo and no
+// copy per element. A view is invalidated by the next write to the ring.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+template <typename T>
+class RingView {
+public:
+    class iterator {
+    public:
+        iterator(const T* p, const T* end, const T* next, uint32_t remaining)
+            : _p(p), _end(end), _next(next), _remaining(remaining) {}
+
+        const T& operator*() const  { return *_p; }
+        const T* operator->() const { return _p; }
+
+        iterator& operator++() {
+            --_remaining;
+            if (++_p == _end && _next) {
+                _p = _next;
+                _next = nullptr;
+            }
+            return *this;
+        }
+
+        // Compared by position in the view: with a full wrapped ring the
+        // second span ends exactly where the first begins.
+        bool operator==(const iterator& o) const { return _remaining == o._remaining; }
+        bool operator!=(const iterator& o) const { return _remaining != o._remaining; }
+
+    private:
+        const T* _p;
+        const T* _end;        // End of the current span
+        const T* _next;       // Start of the second span, until we reach it
+        uint32_t _remaining;  // Elements left, including *_p
+    };
+
+    RingView() : _first{nullptr, 0}, _second{nullptr, 0} {}
+    RingView(Span<T> first, Span<T> second) : _first(first), _second(second) {
+        if (_first.empty()) {
+            _first = _second;
+            _second = Span<T>{nullptr, 0};
+        }
+    }
+
+    // View of a ring of capacity slots holding count items, with the next
+    // write going to head
+    static RingView fromRing(const T* buf, uint32_t capacity, uint32_t head, uint32_t count) {
+        if (count == 0 || capacity == 0) return RingView();
+        uint32_t oldest = (head + capacity - count) % capacity;
+        if (oldest + count <= capacity) {
+            return RingView(Span<T>{buf + oldest, count}, Span<T>{nullptr, 0});
+        }
+        uint32_t firstLen = capacity - oldest;
+        return RingView(Span<T>{buf + oldest, firstLen}, Span<T>{buf, count - firstLen});
+    }
+
+    // The spans, oldest first; second is empty unless the data wraps
+    const Span<T>& first() const  { return _first; }
+    const Span<T>& second() const { return _second; }
+
+    uint32_t size() const { return _first.size + _second.size; }
+    bool empty() const    { return size() == 0; }
+
+    // Element i (0 = oldest); i must be < size()
+    const T& operator[](uint32_t i) const {
+        return i < _first.size ? _first.data[i] : _second.data[i - _first.size];
+    }
+
+    // Sub-view of count elements starting at from (clamped to the view)
+    RingView slice(uint32_t from, uint32_t count) const {
+        uint32_t n = size();
+        if (from >= n) return RingView();
+        if (count > n - from) count = n - from;
+
+        if (from >= _first.size) {
+            return RingView(Span<T>{_second.data + (from - _first.size), count}, Span<T>{nullptr, 0});
+        }
+        uint32_t inFirst = _first.size - from;
+        if (count <= inFirst) {
+            return RingView(Span<T>{_first.data + from, count}, Span<T>{nullptr, 0});
+        }
+        return RingView(Span<T>{_first.data + from, inFirst},
+                        Span<T>{_second.data, count - inFirst});
+    }
+
+    iterator begin() const {
+        return iterator(_first.data, _first.end(),
+                        _second.empty() ? nullptr : _second.data, size());
+    }
+
+    iterator end() const { return iterator(nullptr, nullptr, nullptr, 0); }
+
+private:
+    Span<T> _first;
+    Span<T> _second;
+};
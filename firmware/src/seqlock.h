@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+// Single-writer, many-reader published value: a seqlock over two slots.
+// The writer fills the slot readers are not pointed at, bumping that slot's
+// sequence to odd while it writes and back to even after, then publishes
+// the new version. Readers copy the published slot and retry if its
+// sequence moved under them. Neither side takes a lock or blocks.
+//
+// With two slots a reader that preempts the writer mid-write (same core,
+// higher priority) still finds the other slot whole, so it never spins on
+// a writer that can't run. A retry needs the writer to finish two whole
+// writes during one copy.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+template <typename T>
+class Seqlock {
+public:
+    Seqlock() : _version(0), _retries(0) {
+        _seq[0].store(0, std::memory_order_relaxed);
+        _seq[1].store(0, std::memory_order_relaxed);
+    }
+
+    // Writer only: publish a new value
+    void write(const T& value) {
+        uint32_t next = _version.load(std::memory_order_relaxed) + 1;
+        uint8_t slot = next & 1;
+        uint32_t seq = _seq[slot].load(std::memory_order_relaxed);
+
+        _seq[slot].store(seq + 1, std::memory_order_relaxed);   // Odd: being written
+        std::atomic_thread_fence(std::memory_order_release);
+        _slots[slot] = value;
+        _seq[slot].store(seq + 2, std::memory_order_release);   // Even: whole
+        _version.store(next, std::memory_order_release);
+    }
+
+    // Any task: copy the newest published value out. Before the first
+    // write() this is a default-constructed T.
+    void read(T& out) const {
+        for (;;) {
+            uint32_t version = _version.load(std::memory_order_acquire);
+            uint8_t slot = version & 1;
+            uint32_t before = _seq[slot].load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                out = _slots[slot];
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (_seq[slot].load(std::memory_order_relaxed) == before) return;
+            }
+            _retries.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Number of values published so far
+    uint32_t getVersion() const { return _version.load(std::memory_order_acquire); }
+
+    // Reads that had to copy again (writer lapped the reader)
+    uint32_t getRetries() const { return _retries.load(std::memory_order_relaxed); }
+
+private:
+    T _slots[2];
+    std::atomic<uint32_t> _seq[2];
+    std::atomic<uint32_t> _version;
+    mutable std::atomic<uint32_t> _retries;
+};
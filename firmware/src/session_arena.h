@@ -0,0 +1,38 @@
+#pragma once
+
+#include "config.h"
+#include "data_point.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// How much of the session to keep in an external-RAM (PSRAM) arena.
+// points:     capacity of the main 5 s ring (replaces the internal 600-entry buffer)
+// finePoints: capacity of the 1 s ring (0 = no fine stream)
+struct SessionArenaPlan {
+    uint32_t points;
+    uint32_t finePoints;
+};
+
+// Size the arena from the free PSRAM, leaving reserveBytes for everything
+// else that allocates there. The 5 s stream gets SESSION_ARENA_HOURS first;
+// the 1 s stream gets what is left, up to the same span. Returns {0, 0} when
+// the arena would not hold more than the internal buffer.
+inline SessionArenaPlan planSessionArena(size_t freeBytes, size_t reserveBytes) {
+    SessionArenaPlan plan = { 0, 0 };
+    if (freeBytes <= reserveBytes) return plan;
+    size_t avail = (freeBytes - reserveBytes) / sizeof(DataPoint);
+
+    const uint32_t spanSec = SESSION_ARENA_HOURS * 3600UL;
+    uint32_t points = spanSec / (SESSION_SAMPLE_INTERVAL / 1000);
+    if (avail < points) points = (uint32_t)avail;
+    if (points <= SESSION_BUFFER_SIZE) return plan;
+    avail -= points;
+
+    uint32_t finePoints = spanSec / (SESSION_FINE_INTERVAL / 1000);
+    if (avail < finePoints) finePoints = (uint32_t)avail;
+    if (finePoints < SESSION_FINE_MIN_POINTS) finePoints = 0;
+
+    plan.points = points;
+    plan.finePoints = finePoints;
+    return plan;
+}
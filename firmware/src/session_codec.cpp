@@ -0,0 +1,291 @@
+#include "session_codec.h"
+#include <string.h>
+
+namespace session_codec {
+
+// ---------------------------------------------------------------------------
+// Little-endian helpers
+// ---------------------------------------------------------------------------
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ---------------------------------------------------------------------------
+// crc32 — bitwise, table-free (blocks are small; flash writes dominate)
+// ---------------------------------------------------------------------------
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+// ---------------------------------------------------------------------------
+// Varints
+// ---------------------------------------------------------------------------
+size_t putVarint(uint8_t* out, size_t outSize, uint32_t value) {
+    size_t n = 0;
+    do {
+        if (n >= outSize) return 0;
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out[n++] = value ? (byte | 0x80) : byte;
+    } while (value);
+    return n;
+}
+
+size_t getVarint(const uint8_t* in, size_t inSize, uint32_t* value) {
+    uint32_t result = 0;
+    for (size_t n = 0; n < inSize && n < 5; n++) {
+        result |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if ((in[n] & 0x80) == 0) {
+            *value = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// File header
+// ---------------------------------------------------------------------------
+size_t writeFileHeader(uint8_t* out, uint32_t startTime, uint8_t pointsPerBlock) {
+    putU32(out, SESSION_FILE_MAGIC);
+    out[4] = pointsPerBlock;
+    out[5] = 0;
+    putU16(out + 6, 0);
+    putU32(out + 8, startTime);
+    return SESSION_FILE_HEADER_SIZE;
+}
+
+FileFormat parseFileHeader(const uint8_t* data, size_t len,
+                           uint32_t* startTime, size_t* headerSize) {
+    if (len >= SESSION_FILE_HEADER_SIZE && getU32(data) == SESSION_FILE_MAGIC) {
+        if (startTime)  *startTime = getU32(data + 8);
+        if (headerSize) *headerSize = SESSION_FILE_HEADER_SIZE;
+        return FileFormat::BLOCK_V2;
+    }
+    if (len >= SESSION_V1_HEADER_SIZE) {
+        if (startTime)  *startTime = getU32(data);
+        if (headerSize) *headerSize = SESSION_V1_HEADER_SIZE;
+        return FileFormat::RAW_V1;
+    }
+    return FileFormat::INVALID;
+}
+
+// ---------------------------------------------------------------------------
+// Block encoding
+// ---------------------------------------------------------------------------
+
+// Append (value, run) pairs for a byte column. Returns false on overflow.
+static bool encodeRLE(const DataPoint* pts, uint8_t count, uint8_t DataPoint::*field,
+                      uint8_t* out, size_t outSize, size_t& pos) {
+    uint8_t i = 0;
+    while (i < count) {
+        uint8_t value = pts[i].*field;
+        uint8_t run = 1;
+        while (i + run < count && pts[i + run].*field == value) run++;
+
+        if (pos >= outSize) return false;
+        out[pos++] = value;
+        size_t n = putVarint(out + pos, outSize - pos, run);
+        if (n == 0) return false;
+        pos += n;
+        i += run;
+    }
+    return true;
+}
+
+// Append first value + deltas for a temperature column. Returns false on overflow.
+static bool encodeDeltas(const DataPoint* pts, uint8_t count, int16_t DataPoint::*field,
+                         uint8_t* out, size_t outSize, size_t& pos) {
+    int32_t prev = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        int32_t v = pts[i].*field;
+        size_t n = putVarint(out + pos, outSize - pos, zigzag(v - prev));
+        if (n == 0) return false;
+        pos += n;
+        prev = v;
+    }
+    return true;
+}
+
+size_t encodeBlock(const DataPoint* points, uint8_t count, uint32_t firstPoint,
+                   uint8_t* out, size_t outSize) {
+    if (count == 0 || count > SESSION_BLOCK_MAX_POINTS) return 0;
+    if (outSize < SESSION_BLOCK_HEADER_SIZE) return 0;
+
+    uint8_t* payload = out + SESSION_BLOCK_HEADER_SIZE;
+    size_t cap = outSize - SESSION_BLOCK_HEADER_SIZE;
+    size_t pos = 0;
+    size_t n;
+
+    // Where the block sits in the session, so a reader that had to skip a
+    // damaged block still numbers the ones after it correctly
+    n = putVarint(payload + pos, cap - pos, firstPoint);
+    if (n == 0) return 0;
+    pos += n;
+
+    // Timestamps: absolute first value, then run-length encoded zigzag deltas.
+    // A steady 5 s sample interval collapses to a single (delta, run) pair.
+    // Epoch times take 5 bytes as a varint, so the first one is a plain u32.
+    if (cap - pos < 4) return 0;
+    putU32(payload + pos, points[0].timestamp);
+    pos += 4;
+
+    uint8_t i = 1;
+    while (i < count) {
+        int32_t delta = (int32_t)(points[i].timestamp - points[i - 1].timestamp);
+        uint8_t run = 1;
+        while (i + run < count &&
+               (int32_t)(points[i + run].timestamp - points[i + run - 1].timestamp) == delta) {
+            run++;
+        }
+        n = putVarint(payload + pos, cap - pos, zigzag(delta));
+        if (n == 0) return 0;
+        pos += n;
+        n = putVarint(payload + pos, cap - pos, run);
+        if (n == 0) return 0;
+        pos += n;
+        i += run;
+    }
+
+    // Temperatures: zigzag varint deltas (steady cook → 1 byte per sample)
+    if (!encodeDeltas(points, count, &DataPoint::pitTemp,   payload, cap, pos)) return 0;
+    if (!encodeDeltas(points, count, &DataPoint::meat1Temp, payload, cap, pos)) return 0;
+    if (!encodeDeltas(points, count, &DataPoint::meat2Temp, payload, cap, pos)) return 0;
+
+    // Outputs and flags: run-length encoded
+    if (!encodeRLE(points, count, &DataPoint::fanPct,    payload, cap, pos)) return 0;
+    if (!encodeRLE(points, count, &DataPoint::damperPct, payload, cap, pos)) return 0;
+    if (!encodeRLE(points, count, &DataPoint::flags,     payload, cap, pos)) return 0;
+
+    // Header
+    out[0] = SESSION_BLOCK_SYNC;
+    out[1] = count;
+    putU16(out + 2, (uint16_t)pos);
+    putU32(out + 4, crc32(payload, pos));
+
+    return SESSION_BLOCK_HEADER_SIZE + pos;
+}
+
+// ---------------------------------------------------------------------------
+// Block decoding
+// ---------------------------------------------------------------------------
+
+size_t blockSize(const uint8_t* header) {
+    if (header[0] != SESSION_BLOCK_SYNC) return 0;
+    if (header[1] == 0 || header[1] > SESSION_BLOCK_MAX_POINTS) return 0;
+    uint16_t payloadLen = getU16(header + 2);
+    if (payloadLen > SESSION_BLOCK_MAX_SIZE(header[1]) - SESSION_BLOCK_HEADER_SIZE) return 0;
+    return SESSION_BLOCK_HEADER_SIZE + payloadLen;
+}
+
+static bool decodeRLE(const uint8_t* in, size_t len, size_t& pos,
+                      DataPoint* pts, uint8_t count, uint8_t DataPoint::*field) {
+    uint8_t i = 0;
+    while (i < count) {
+        if (pos >= len) return false;
+        uint8_t value = in[pos++];
+        uint32_t run;
+        size_t n = getVarint(in + pos, len - pos, &run);
+        if (n == 0 || run == 0 || run > (uint32_t)(count - i)) return false;
+        pos += n;
+        for (uint32_t r = 0; r < run; r++) pts[i++].*field = value;
+    }
+    return true;
+}
+
+static bool decodeDeltas(const uint8_t* in, size_t len, size_t& pos,
+                         DataPoint* pts, uint8_t count, int16_t DataPoint::*field) {
+    int32_t prev = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t zz;
+        size_t n = getVarint(in + pos, len - pos, &zz);
+        if (n == 0) return false;
+        pos += n;
+        prev += unzigzag(zz);
+        pts[i].*field = (int16_t)prev;
+    }
+    return true;
+}
+
+size_t decodeBlock(const uint8_t* data, size_t len,
+                   DataPoint* out, uint8_t maxPoints, uint8_t* count,
+                   uint32_t* firstPoint) {
+    if (len < SESSION_BLOCK_HEADER_SIZE) return 0;
+    size_t total = blockSize(data);
+    if (total == 0 || total > len) return 0;
+
+    uint8_t n = data[1];
+    if (n > maxPoints) return 0;
+
+    const uint8_t* payload = data + SESSION_BLOCK_HEADER_SIZE;
+    size_t payloadLen = total - SESSION_BLOCK_HEADER_SIZE;
+    if (crc32(payload, payloadLen) != getU32(data + 4)) return 0;
+
+    size_t pos = 0;
+    size_t used;
+    uint32_t first;
+
+    used = getVarint(payload, payloadLen, &first);
+    if (used == 0) return 0;
+    pos += used;
+
+    // Timestamps
+    if (payloadLen - pos < 4) return 0;
+    out[0].timestamp = getU32(payload + pos);
+    pos += 4;
+
+    uint8_t i = 1;
+    while (i < n) {
+        uint32_t zz, run;
+        used = getVarint(payload + pos, payloadLen - pos, &zz);
+        if (used == 0) return 0;
+        pos += used;
+        used = getVarint(payload + pos, payloadLen - pos, &run);
+        if (used == 0 || run == 0 || run > (uint32_t)(n - i)) return 0;
+        pos += used;
+        int32_t delta = unzigzag(zz);
+        for (uint32_t r = 0; r < run; r++, i++) {
+            out[i].timestamp = out[i - 1].timestamp + (uint32_t)delta;
+        }
+    }
+
+    if (!decodeDeltas(payload, payloadLen, pos, out, n, &DataPoint::pitTemp))   return 0;
+    if (!decodeDeltas(payload, payloadLen, pos, out, n, &DataPoint::meat1Temp)) return 0;
+    if (!decodeDeltas(payload, payloadLen, pos, out, n, &DataPoint::meat2Temp)) return 0;
+
+    if (!decodeRLE(payload, payloadLen, pos, out, n, &DataPoint::fanPct))    return 0;
+    if (!decodeRLE(payload, payloadLen, pos, out, n, &DataPoint::damperPct)) return 0;
+    if (!decodeRLE(payload, payloadLen, pos, out, n, &DataPoint::flags))     return 0;
+
+    if (pos != payloadLen) return 0;
+
+    if (count) *count = n;
+    if (firstPoint) *firstPoint = first;
+    return total;
+}
+
+} // namespace session_codec
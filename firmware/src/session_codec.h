@@ -0,0 +1,78 @@
+#pragma once
+
+#include "data_point.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// On-flash session file format (version 2).
+//
+// File layout:
+//   [file header, 12 bytes]
+//     u32 magic ("PCS" + version byte), u8 points-per-block, u8 reserved,
+//     u16 reserved, u32 session start epoch
+//   [block]*
+//     u8 sync marker, u8 point count, u16 payload length, u32 CRC-32 of payload
+//     payload: varint session index of the block's first point, then the
+//     columns (see encodeBlock), the first timestamp as a u32
+//
+// Version 1 files (pre-block format) are a bare u32 start epoch followed by
+// raw sizeof(DataPoint) records. They are detected by the missing magic and
+// remain readable for power-loss recovery.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+
+#define SESSION_FILE_MAGIC        0x02534350UL  // "PCS\x02" little-endian
+#define SESSION_FILE_VERSION      2
+#define SESSION_FILE_HEADER_SIZE  12
+#define SESSION_V1_HEADER_SIZE    4
+
+#define SESSION_BLOCK_SYNC        0xB1
+#define SESSION_BLOCK_HEADER_SIZE 8
+#define SESSION_BLOCK_MAX_POINTS  64
+
+// Worst-case encoded size of a block holding n points: first point (5) +
+// ts (4 + 6/delta) + temps (3 * 3/point) + fan/damper/flags RLE (3 * 2/point)
+#define SESSION_BLOCK_MAX_SIZE(n) (SESSION_BLOCK_HEADER_SIZE + 9 + (n) * 21)
+
+namespace session_codec {
+
+enum class FileFormat : uint8_t { INVALID, RAW_V1, BLOCK_V2 };
+
+// CRC-32 (IEEE 802.3, reflected). Pass the previous result to continue a running CRC.
+uint32_t crc32(const uint8_t* data, size_t len, uint32_t crc = 0);
+
+// Zigzag + LEB128 varint primitives. put* return bytes written (0 if no room);
+// get* return bytes consumed (0 if truncated/overlong).
+size_t putVarint(uint8_t* out, size_t outSize, uint32_t value);
+size_t getVarint(const uint8_t* in, size_t inSize, uint32_t* value);
+inline uint32_t zigzag(int32_t v)    { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t  unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// Write a version 2 file header. Returns SESSION_FILE_HEADER_SIZE.
+size_t writeFileHeader(uint8_t* out, uint32_t startTime, uint8_t pointsPerBlock);
+
+// Identify a session file from its first bytes (at least SESSION_FILE_HEADER_SIZE
+// if available). Fills startTime and the header size to skip.
+FileFormat parseFileHeader(const uint8_t* data, size_t len,
+                           uint32_t* startTime, size_t* headerSize);
+
+// Encode count points, the first of which is session point firstPoint, into
+// one self-checking block. Timestamps and temperatures are zigzag-varint
+// deltas against the previous point (timestamp deltas are additionally
+// run-length encoded); fan, damper and flags are run-length encoded as
+// (value, run) pairs. Returns total block size, or 0 if out is too small.
+size_t encodeBlock(const DataPoint* points, uint8_t count, uint32_t firstPoint,
+                   uint8_t* out, size_t outSize);
+
+// Total size (header + payload) of the block starting at header, or 0 if the
+// sync marker / count is invalid. Needs SESSION_BLOCK_HEADER_SIZE bytes.
+size_t blockSize(const uint8_t* header);
+
+// Decode one block. Verifies the CRC. Returns bytes consumed, or 0 if the block
+// is truncated, corrupt, or holds more than maxPoints points. firstPoint, if
+// given, is set to the session index of the block's first point.
+size_t decodeBlock(const uint8_t* data, size_t len,
+                   DataPoint* out, uint8_t maxPoints, uint8_t* count,
+                   uint32_t* firstPoint = nullptr);
+
+} // namespace session_codec
@@ -0,0 +1,180 @@
+#include "session_export.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char CSV_HEADER[] = "timestamp,pit,meat1,meat2,fan,damper,flags\n";
+static const char CSV_TRUNCATED[] = "# truncated\n";
+
+SessionExporter::SessionExporter(Format format, PointSource source, void* ctx,
+                                 SourceCheck truncated)
+    : _format(format)
+    , _source(source)
+    , _ctx(ctx)
+    , _truncatedCheck(truncated)
+    , _stage(Stage::HEADER)
+    , _points(0)
+    , _truncated(false)
+    , _lineLen(0)
+    , _linePos(0)
+{
+    _line[0] = '\0';
+}
+
+size_t SessionExporter::read(uint8_t* buf, size_t maxLen) {
+    size_t written = 0;
+
+    while (written < maxLen) {
+        // Drain whatever is left of the current line first
+        if (_linePos >= _lineLen) {
+            if (!nextLine()) break;
+        }
+
+        size_t avail = _lineLen - _linePos;
+        size_t n = (avail < maxLen - written) ? avail : (maxLen - written);
+        memcpy(buf + written, _line + _linePos, n);
+        _linePos += n;
+        written += n;
+    }
+
+    return written;
+}
+
+bool SessionExporter::nextLine() {
+    _lineLen = 0;
+    _linePos = 0;
+
+    switch (_stage) {
+        case Stage::HEADER:
+            if (_format == Format::CSV) {
+                memcpy(_line, CSV_HEADER, sizeof(CSV_HEADER) - 1);
+                _lineLen = sizeof(CSV_HEADER) - 1;
+            } else {
+                _line[0] = '[';
+                _lineLen = 1;
+            }
+            _stage = Stage::POINTS;
+            return true;
+
+        case Stage::POINTS: {
+            DataPoint dp;
+            if (_source && _source(_ctx, dp)) {
+                size_t n;
+                if (_format == Format::CSV) {
+                    n = formatCSVRow(_line, sizeof(_line), dp);
+                } else {
+                    // Comma separator goes in front of every object but the first
+                    size_t sep = 0;
+                    if (_points > 0) _line[sep++] = ',';
+                    n = sep + formatJSONObject(_line + sep, sizeof(_line) - sep, dp);
+                }
+                if (n >= sizeof(_line)) n = sizeof(_line) - 1;
+                _lineLen = (uint16_t)n;
+                _points++;
+                return true;
+            }
+            _stage = Stage::FOOTER;
+            _truncated = _truncatedCheck && _truncatedCheck(_ctx);
+        }
+        // fall through
+
+        case Stage::FOOTER:
+            _stage = Stage::DONE;
+            if (_truncated) {
+                if (_format == Format::JSON) return false;
+                memcpy(_line, CSV_TRUNCATED, sizeof(CSV_TRUNCATED) - 1);
+                _lineLen = sizeof(CSV_TRUNCATED) - 1;
+                return true;
+            }
+            if (_format == Format::JSON) {
+                _line[0] = ']';
+                _lineLen = 1;
+                return true;
+            }
+            return false;
+
+        case Stage::DONE:
+        default:
+            return false;
+    }
+}
+
+const char* SessionExporter::getContentType() const {
+    return _format == Format::CSV ? "text/csv" : "application/json";
+}
+
+const char* SessionExporter::getFileName() const {
+    return _format == Format::CSV ? "cook-session.csv" : "cook-session.json";
+}
+
+size_t SessionExporter::formatCSVRow(char* out, size_t outSize, const DataPoint& dp) {
+    int n = snprintf(out, outSize, "%u,%.1f,%.1f,%.1f,%u,%u,%u\n",
+                     (unsigned)dp.timestamp,
+                     dp.pitTemp / 10.0f,
+                     dp.meat1Temp / 10.0f,
+                     dp.meat2Temp / 10.0f,
+                     (unsigned)dp.fanPct,
+                     (unsigned)dp.damperPct,
+                     (unsigned)dp.flags);
+    return n > 0 ? (size_t)n : 0;
+}
+
+size_t SessionExporter::formatJSONObject(char* out, size_t outSize, const DataPoint& dp) {
+    int n = snprintf(out, outSize,
+                     "{\"ts\":%u,\"pit\":%.1f,\"meat1\":%.1f,\"meat2\":%.1f,"
+                     "\"fan\":%u,\"damper\":%u,\"flags\":%u}",
+                     (unsigned)dp.timestamp,
+                     dp.pitTemp / 10.0f,
+                     dp.meat1Temp / 10.0f,
+                     dp.meat2Temp / 10.0f,
+                     (unsigned)dp.fanPct,
+                     (unsigned)dp.damperPct,
+                     (unsigned)dp.flags);
+    return n > 0 ? (size_t)n : 0;
+}
+
+// ---------------------------------------------------------------------------
+// SessionExportPipe
+// ---------------------------------------------------------------------------
+
+SessionExportPipe::SessionExportPipe()
+    : _pos(0)
+    , _ended(false)
+{
+    _fill.len = 0;
+    _current.len = 0;
+}
+
+size_t SessionExportPipe::pump(SessionExporter& exporter) {
+    size_t queued = 0;
+    while (!isEnded() && _chunks.size() < _chunks.capacity()) {
+        _fill.len = (uint16_t)exporter.read(_fill.data, sizeof(_fill.data));
+        if (_fill.len == 0) {
+            end();
+            break;
+        }
+        _chunks.push(_fill);
+        queued += _fill.len;
+    }
+    return queued;
+}
+
+size_t SessionExportPipe::read(uint8_t* buf, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (_pos >= _current.len) {
+            if (!_chunks.pop(_current)) break;
+            _pos = 0;
+        }
+        size_t avail = _current.len - _pos;
+        size_t n = (avail < maxLen - written) ? avail : (maxLen - written);
+        memcpy(buf + written, _current.data + _pos, n);
+        _pos += n;
+        written += n;
+    }
+    return written;
+}
+
+bool SessionExportPipe::isDone() const {
+    // Ended first: every chunk pushed before end() is then visible
+    return _ended.load(std::memory_order_acquire) && _chunks.empty() && _pos >= _current.len;
+}
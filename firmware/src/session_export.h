@@ -0,0 +1,123 @@
+#pragma once
+
+#include "data_point.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+// Size of the single formatted-record scratch line. One CSV or JSON record
+// is at most ~110 bytes; the header/footer are shorter.
+#define SESSION_EXPORT_LINE_SIZE 128
+
+// SessionExportPipe: formatted output waiting for the sending task, in
+// SESSION_EXPORT_CHUNKS - 1 chunks of SESSION_EXPORT_CHUNK_SIZE bytes
+#define SESSION_EXPORT_CHUNK_SIZE 512
+#define SESSION_EXPORT_CHUNKS     8     // Power of two; one slot stays free
+
+// Streaming CSV/JSON formatter for cook session data.
+//
+// Pulls one DataPoint at a time from a caller-supplied source and formats it
+// directly into whatever buffer the transport hands over (e.g. an
+// AsyncWebServer chunked-response callback). Uses no heap: the only state is
+// one formatted record that may straddle two output chunks, so memory use is
+// flat regardless of session length.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class SessionExporter {
+public:
+    enum class Format : uint8_t { CSV, JSON };
+
+    // Fetch the next data point. Return false when the source is exhausted.
+    typedef bool (*PointSource)(void* ctx, DataPoint& out);
+
+    // Asked once the source returns false: true if it stopped short because
+    // data it should have had could not be read
+    typedef bool (*SourceCheck)(void* ctx);
+
+    // With a truncated check, an export that stops short ends without its
+    // normal footer: a JSON array is left unclosed and CSV gets a final
+    // "# truncated" line, so the client cannot take it for the whole session.
+    SessionExporter(Format format, PointSource source, void* ctx,
+                    SourceCheck truncated = nullptr);
+
+    // Fill up to maxLen bytes of output. Returns the number of bytes written;
+    // 0 means the export is complete.
+    size_t read(uint8_t* buf, size_t maxLen);
+
+    // True once header, all points, and footer have been emitted
+    bool isDone() const { return _stage == Stage::DONE && _linePos >= _lineLen; }
+
+    // Number of data points formatted so far
+    uint32_t getPointsWritten() const { return _points; }
+
+    // True if the source stopped short and the export was ended as truncated
+    bool isTruncated() const { return _truncated; }
+
+    // MIME type and download filename for the chosen format
+    const char* getContentType() const;
+    const char* getFileName() const;
+
+    // Format a single data point as a CSV row / JSON object (no separator).
+    // Returns the number of characters written (excluding null terminator).
+    static size_t formatCSVRow(char* out, size_t outSize, const DataPoint& dp);
+    static size_t formatJSONObject(char* out, size_t outSize, const DataPoint& dp);
+
+private:
+    enum class Stage : uint8_t { HEADER, POINTS, FOOTER, DONE };
+
+    // Format the next chunk of output into _line. Returns false when finished.
+    bool nextLine();
+
+    Format      _format;
+    PointSource _source;
+    void*       _ctx;
+    SourceCheck _truncatedCheck;
+    Stage       _stage;
+    uint32_t    _points;
+    bool        _truncated;
+
+    char     _line[SESSION_EXPORT_LINE_SIZE];
+    uint16_t _lineLen;
+    uint16_t _linePos;
+};
+
+// An export formatted on one task and sent from another. The producer pumps
+// a SessionExporter into the free chunks, so it alone reads the session and
+// decides how much to format per step; the consumer only copies finished
+// bytes out. One producer, one consumer, no locks and no heap.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class SessionExportPipe {
+public:
+    SessionExportPipe();
+
+    // Producer: format into every free chunk. Returns bytes queued. Once the
+    // exporter is complete the pipe is ended.
+    size_t pump(SessionExporter& exporter);
+
+    // Producer: end the stream after what is already queued
+    void end() { _ended.store(true, std::memory_order_release); }
+
+    // Producer: whether the stream has ended (nothing more will be queued)
+    bool isEnded() const { return _ended.load(std::memory_order_relaxed); }
+
+    // Consumer: copy up to maxLen queued bytes. Returns 0 with isDone() false
+    // when nothing is ready yet.
+    size_t read(uint8_t* buf, size_t maxLen);
+
+    // Consumer: ended, and every queued byte has been read
+    bool isDone() const;
+
+private:
+    struct Chunk {
+        uint16_t len;
+        uint8_t  data[SESSION_EXPORT_CHUNK_SIZE];
+    };
+
+    SpscQueue<Chunk, SESSION_EXPORT_CHUNKS> _chunks;
+    Chunk    _fill;         // Producer: chunk being formatted
+    Chunk    _current;      // Consumer: chunk being read
+    uint16_t _pos;          // Consumer: bytes of _current already read
+    std::atomic<bool> _ended;
+};
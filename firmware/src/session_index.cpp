@@ -0,0 +1,170 @@
+#include "session_index.h"
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// SessionIndex
+// ---------------------------------------------------------------------------
+
+SessionIndex::SessionIndex()
+    : _count(0)
+    , _stride(1)
+    , _blocks(0)
+{
+    memset(_entries, 0, sizeof(_entries));
+}
+
+void SessionIndex::clear() {
+    _count = 0;
+    _stride = 1;
+    _blocks = 0;
+}
+
+void SessionIndex::addBlock(uint32_t firstPoint, uint32_t offset) {
+    // Entries sit on multiples of the stride, so condensing keeps them aligned
+    if (_blocks++ % _stride != 0) return;
+
+    if (_count >= SESSION_INDEX_SIZE) {
+        condense();
+        if ((_blocks - 1) % _stride != 0) return;
+    }
+
+    _entries[_count].firstPoint = firstPoint;
+    _entries[_count].offset = offset;
+    _count++;
+}
+
+void SessionIndex::condense() {
+    uint16_t kept = 0;
+    for (uint16_t i = 0; i < _count; i += 2) {
+        _entries[kept++] = _entries[i];
+    }
+    _count = kept;
+    _stride *= 2;
+}
+
+bool SessionIndex::find(uint32_t point, uint32_t* firstPoint, uint32_t* offset) const {
+    if (_count == 0) return false;
+
+    // Binary search for the last entry with firstPoint <= point
+    uint16_t lo = 0;
+    uint16_t hi = _count;
+    while (hi - lo > 1) {
+        uint16_t mid = (lo + hi) / 2;
+        if (_entries[mid].firstPoint <= point) lo = mid;
+        else                                   hi = mid;
+    }
+
+    if (firstPoint) *firstPoint = _entries[lo].firstPoint;
+    if (offset)     *offset = _entries[lo].offset;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// SessionBlockReader
+// ---------------------------------------------------------------------------
+
+SessionBlockReader::SessionBlockReader()
+    : _read(nullptr)
+    , _ctx(nullptr)
+    , _pos(0)
+    , _blockOffset(0)
+    , _blockFirst(0)
+    , _blockCount(0)
+    , _blockPos(0)
+    , _winStart(0)
+    , _winLen(0)
+{
+}
+
+void SessionBlockReader::begin(ReadFn read, void* ctx, uint32_t dataStart) {
+    _read = read;
+    _ctx = ctx;
+    _winStart = 0;
+    _winLen = 0;
+    seekBlock(dataStart, 0);
+}
+
+void SessionBlockReader::seekBlock(uint32_t offset, uint32_t firstPoint) {
+    _pos = offset;
+    _blockOffset = offset;
+    _blockFirst = firstPoint;
+    _blockCount = 0;
+    _blockPos = 0;
+}
+
+size_t SessionBlockReader::fill(uint32_t offset) {
+    // Keep the part of the window at or after offset; the file only grows,
+    // so bytes already read stay valid
+    if (offset >= _winStart && offset < _winStart + _winLen) {
+        uint16_t keep = (uint16_t)(_winStart + _winLen - offset);
+        memmove(_win, _win + (offset - _winStart), keep);
+        _winLen = keep;
+    } else {
+        _winLen = 0;
+    }
+    _winStart = offset;
+
+    if (_winLen < sizeof(_win)) {
+        _winLen += (uint16_t)_read(_ctx, offset + _winLen, _win + _winLen,
+                                   sizeof(_win) - _winLen);
+    }
+    return _winLen;
+}
+
+bool SessionBlockReader::nextBlock() {
+    if (!_read) return false;
+
+    for (;;) {
+        size_t got = fill(_pos);
+        if (got < SESSION_BLOCK_HEADER_SIZE) return false;
+
+        // Look for a block at each sync marker in the window. By default the
+        // next window starts just past the last header position scanned.
+        size_t skip = got - SESSION_BLOCK_HEADER_SIZE + 1;
+        for (size_t i = 0; i + SESSION_BLOCK_HEADER_SIZE <= got; i++) {
+            size_t total = session_codec::blockSize(_win + i);
+            if (total == 0) continue;
+            if (i + total > got) {
+                // Runs past the window: read again with it at the front.
+                // At the front already, it is torn by the end of file.
+                if (i > 0) {
+                    skip = i;
+                    break;
+                }
+                continue;
+            }
+
+            uint8_t count = 0;
+            uint32_t first = 0;
+            if (session_codec::decodeBlock(_win + i, total, _block,
+                                           SESSION_BLOCK_POINTS, &count, &first)) {
+                _blockOffset = _pos + i;
+                _blockFirst = first;
+                _blockCount = count;
+                _blockPos = 0;
+                _pos += i + total;
+                return true;
+            }
+        }
+
+        _pos += skip;
+    }
+}
+
+bool SessionBlockReader::next(DataPoint& out) {
+    if (_blockPos >= _blockCount && !nextBlock()) return false;
+    out = _block[_blockPos++];
+    return true;
+}
+
+bool SessionBlockReader::skipTo(uint32_t point) {
+    if (point < getNextPoint()) return false;
+
+    // Whole blocks first, then points within the target block
+    while (point >= _blockFirst + _blockCount) {
+        if (!nextBlock()) return false;
+    }
+    if (point < _blockFirst) return false;  // Lost in a gap left by damaged blocks
+    _blockPos = (uint8_t)(point - _blockFirst);
+    return true;
+}
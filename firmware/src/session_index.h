@@ -0,0 +1,111 @@
+#pragma once
+
+#include "config.h"
+#include "data_point.h"
+#include "session_codec.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// One sparse index entry: a block's file offset and the session index of its
+// first point.
+struct SessionIndexEntry {
+    uint32_t firstPoint;
+    uint32_t offset;
+};
+
+// Sparse in-RAM index over the blocks of the session file.
+// Records every Nth block. When the table is full, every other entry is
+// dropped and N doubles, so memory stays fixed for any session length and a
+// seek decodes at most N blocks (N = 8 for a 24-hour cook).
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class SessionIndex {
+public:
+    SessionIndex();
+
+    // Forget all entries and reset the stride to one block
+    void clear();
+
+    // Note a block appended at offset whose first point is firstPoint.
+    // Blocks must be added in file order.
+    void addBlock(uint32_t firstPoint, uint32_t offset);
+
+    // Find the last indexed block starting at or before point.
+    // Returns false if the index is empty.
+    bool find(uint32_t point, uint32_t* firstPoint, uint32_t* offset) const;
+
+    uint16_t getCount() const { return _count; }
+    uint16_t getStride() const { return _stride; }
+
+private:
+    // Keep every other entry and double the stride
+    void condense();
+
+    SessionIndexEntry _entries[SESSION_INDEX_SIZE];
+    uint16_t _count;
+    uint16_t _stride;       // Blocks per index entry
+    uint32_t _blocks;       // Blocks seen since clear()
+};
+
+// Sequential block decoder over the session file with random-access seeks.
+// File access goes through a read callback so the same code runs against a
+// LittleFS File on device and a memory buffer on native. The file is read a
+// window at a time, and consecutive blocks reuse what the last read brought
+// in. Torn or corrupt blocks are skipped by scanning the window for the next
+// block whose CRC checks out; that block's first point comes from the block
+// itself, so the points after a gap keep their session index.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class SessionBlockReader {
+public:
+    // Read up to len bytes at offset. Returns bytes read (short at end of file).
+    typedef size_t (*ReadFn)(void* ctx, uint32_t offset, uint8_t* buf, size_t len);
+
+    SessionBlockReader();
+
+    // Attach to a file whose first block starts at dataStart
+    void begin(ReadFn read, void* ctx, uint32_t dataStart);
+
+    // Position at a block boundary whose first point is firstPoint
+    void seekBlock(uint32_t offset, uint32_t firstPoint);
+
+    // Decode the next valid block. Returns false at end of file.
+    bool nextBlock();
+
+    // Return the next point, decoding blocks as needed. False at end of file.
+    bool next(DataPoint& out);
+
+    // Advance until the next point is point (no-op if already there).
+    // Returns false if the file ends first, point is already behind, or it
+    // was in a damaged block (the reader then stands just past the gap).
+    bool skipTo(uint32_t point);
+
+    // Session index of the point next() will return
+    uint32_t getNextPoint() const { return _blockFirst + _blockPos; }
+
+    // Most recently decoded block
+    uint32_t getBlockOffset() const { return _blockOffset; }
+    uint32_t getBlockFirstPoint() const { return _blockFirst; }
+    uint8_t  getBlockCount() const { return _blockCount; }
+    const DataPoint* getBlock() const { return _block; }
+
+private:
+    // Have _win hold the file from offset on, reading only what it lacks.
+    // Returns the bytes available (short at end of file).
+    size_t fill(uint32_t offset);
+
+    ReadFn   _read;
+    void*    _ctx;
+    uint32_t _pos;          // File offset of the next block to decode
+    uint32_t _blockOffset;
+    uint32_t _blockFirst;
+    uint8_t  _blockCount;
+    uint8_t  _blockPos;
+
+    DataPoint _block[SESSION_BLOCK_POINTS];
+
+    // File bytes [_winStart, _winStart + _winLen); holds the largest block
+    uint8_t   _win[SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_POINTS)];
+    uint32_t  _winStart;
+    uint16_t  _winLen;
+};
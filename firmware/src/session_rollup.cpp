@@ -0,0 +1,171 @@
+#include "session_rollup.h"
+#include <string.h>
+
+static const uint16_t TIER_INTERVALS[SESSION_ROLLUP_TIERS] = SESSION_ROLLUP_INTERVALS;
+
+// ---------------------------------------------------------------------------
+// RollupAccumulator
+// ---------------------------------------------------------------------------
+
+RollupAccumulator::RollupAccumulator()
+    : _interval(60)
+{
+    reset();
+}
+
+void RollupAccumulator::reset() {
+    _bucket = 0;
+    _count = 0;
+    _flags = 0;
+    _fanSum = 0;
+    _damperSum = 0;
+    memset(&_pit, 0, sizeof(_pit));
+    memset(&_meat1, 0, sizeof(_meat1));
+    memset(&_meat2, 0, sizeof(_meat2));
+}
+
+void RollupAccumulator::addChannel(Channel& ch, int16_t value) {
+    if (ch.valid == 0) {
+        ch.min = value;
+        ch.max = value;
+        ch.minFirst = false;
+    } else if (value < ch.min) {
+        ch.min = value;
+        ch.minFirst = false;  // New min comes after the current max
+    } else if (value > ch.max) {
+        ch.max = value;
+        ch.minFirst = true;
+    }
+    ch.sum += value;
+    ch.valid++;
+}
+
+bool RollupAccumulator::summarize(const Channel& ch, int16_t& min, int16_t& max, int16_t& avg) {
+    if (ch.valid == 0) return false;
+    min = ch.min;
+    max = ch.max;
+    avg = (int16_t)(ch.sum / (int32_t)ch.valid);
+    return true;
+}
+
+bool RollupAccumulator::add(const DataPoint& dp, RollupPoint& done) {
+    uint32_t bucket = dp.timestamp - dp.timestamp % _interval;
+    bool completed = false;
+
+    if (_count > 0 && bucket != _bucket) {
+        completed = getPartial(done);
+        reset();
+    }
+    if (_count == 0) _bucket = bucket;
+    if (_count == 255) return completed;  // Clock stall: bucket is full
+
+    _count++;
+    _fanSum += dp.fanPct;
+    _damperSum += dp.damperPct;
+    _flags |= dp.flags & ~(DP_FLAG_PIT_DISC | DP_FLAG_MEAT1_DISC | DP_FLAG_MEAT2_DISC);
+
+    if (!(dp.flags & DP_FLAG_PIT_DISC))   addChannel(_pit, dp.pitTemp);
+    if (!(dp.flags & DP_FLAG_MEAT1_DISC)) addChannel(_meat1, dp.meat1Temp);
+    if (!(dp.flags & DP_FLAG_MEAT2_DISC)) addChannel(_meat2, dp.meat2Temp);
+
+    return completed;
+}
+
+bool RollupAccumulator::getPartial(RollupPoint& out) const {
+    if (_count == 0) return false;
+
+    memset(&out, 0, sizeof(out));
+    out.timestamp = _bucket;
+    out.count = _count;
+    out.fanAvg = (uint8_t)((_fanSum + _count / 2) / _count);
+    out.damperAvg = (uint8_t)((_damperSum + _count / 2) / _count);
+    out.flags = _flags;
+
+    if (!summarize(_pit, out.pitMin, out.pitMax, out.pitAvg))       out.flags |= DP_FLAG_PIT_DISC;
+    if (!summarize(_meat1, out.meat1Min, out.meat1Max, out.meat1Avg)) out.flags |= DP_FLAG_MEAT1_DISC;
+    if (!summarize(_meat2, out.meat2Min, out.meat2Max, out.meat2Avg)) out.flags |= DP_FLAG_MEAT2_DISC;
+
+    if (_pit.minFirst)   out.minFirst |= ROLLUP_MIN_FIRST_PIT;
+    if (_meat1.minFirst) out.minFirst |= ROLLUP_MIN_FIRST_MEAT1;
+    if (_meat2.minFirst) out.minFirst |= ROLLUP_MIN_FIRST_MEAT2;
+
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// RollupTier
+// ---------------------------------------------------------------------------
+
+RollupTier::RollupTier()
+    : _head(0)
+    , _count(0)
+    , _total(0)
+    , _flushed(0)
+{
+    memset(_ring, 0, sizeof(_ring));
+}
+
+void RollupTier::begin(uint16_t intervalSec) {
+    _acc.setInterval(intervalSec);
+    clear();
+}
+
+void RollupTier::clear() {
+    _acc.reset();
+    _head = 0;
+    _count = 0;
+    _total = 0;
+    _flushed = 0;
+}
+
+void RollupTier::push(const RollupPoint& rp) {
+    _ring[_head] = rp;
+    _head = (_head + 1) % SESSION_ROLLUP_RING;
+    if (_count < SESSION_ROLLUP_RING) _count++;
+    _total++;
+}
+
+bool RollupTier::add(const DataPoint& dp) {
+    RollupPoint done;
+    if (!_acc.add(dp, done)) return false;
+    push(done);
+    return true;
+}
+
+bool RollupTier::finish() {
+    RollupPoint done;
+    if (!_acc.getPartial(done)) return false;
+    _acc.reset();
+    push(done);
+    return true;
+}
+
+const RollupPoint* RollupTier::get(uint32_t index) const {
+    if (index < getRamStart() || index >= _total) return nullptr;
+    uint32_t age = _total - 1 - index;  // 0 = newest
+    uint32_t slot = (_head + SESSION_ROLLUP_RING - 1 - age) % SESSION_ROLLUP_RING;
+    return &_ring[slot];
+}
+
+// ---------------------------------------------------------------------------
+// Tier selection
+// ---------------------------------------------------------------------------
+
+namespace session_rollup {
+
+uint16_t tierInterval(uint8_t tier) {
+    return tier < SESSION_ROLLUP_TIERS ? TIER_INTERVALS[tier] : 0;
+}
+
+int8_t selectTier(uint32_t spanSec, uint32_t maxPoints) {
+    if (maxPoints == 0) return SESSION_ROLLUP_TIERS - 1;
+
+    if (spanSec / (SESSION_SAMPLE_INTERVAL / 1000) <= maxPoints) return -1;
+
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) {
+        if (spanSec / TIER_INTERVALS[t] <= maxPoints) return (int8_t)t;
+    }
+    return SESSION_ROLLUP_TIERS - 1;
+}
+
+} // namespace session_rollup
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "config.h"
+#include "data_point.h"
+#include <stdint.h>
+
+// Min/max/mean summary of one fixed time bucket (28 bytes, no padding).
+// Stored as raw records in the per-tier rollup files, so record i lives at
+// offset i * sizeof(RollupPoint).
+struct RollupPoint {
+    uint32_t timestamp;     // Bucket start (epoch, aligned to the tier interval)
+    int16_t  pitMin;        // Temperatures * 10, as in DataPoint
+    int16_t  pitMax;
+    int16_t  pitAvg;
+    int16_t  meat1Min;
+    int16_t  meat1Max;
+    int16_t  meat1Avg;
+    int16_t  meat2Min;
+    int16_t  meat2Max;
+    int16_t  meat2Avg;
+    uint8_t  fanAvg;
+    uint8_t  damperAvg;
+    uint8_t  flags;         // OR of sample flags; *_DISC only if no valid sample
+    uint8_t  count;         // Raw samples in the bucket
+    uint8_t  minFirst;      // ROLLUP_MIN_FIRST_* bits: min occurred before max
+    uint8_t  reserved;
+};
+
+#define ROLLUP_MIN_FIRST_PIT    0x01
+#define ROLLUP_MIN_FIRST_MEAT1  0x02
+#define ROLLUP_MIN_FIRST_MEAT2  0x04
+
+// Incrementally maintained min/max/mean over epoch-aligned buckets.
+// Disconnected-probe samples are left out of that channel's statistics.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class RollupAccumulator {
+public:
+    RollupAccumulator();
+
+    void setInterval(uint16_t intervalSec) { _interval = intervalSec; }
+    uint16_t getInterval() const { return _interval; }
+
+    // Discard the bucket in progress
+    void reset();
+
+    // Feed a sample. When the sample falls in a later bucket, the previous
+    // bucket is written to done and true is returned.
+    bool add(const DataPoint& dp, RollupPoint& done);
+
+    // Summarize the bucket in progress. Returns false if it is empty.
+    bool getPartial(RollupPoint& out) const;
+
+private:
+    struct Channel {
+        int16_t min;
+        int16_t max;
+        int32_t sum;
+        uint8_t valid;
+        bool    minFirst;
+    };
+
+    static void addChannel(Channel& ch, int16_t value);
+
+    // Fill min/max/avg for a channel. Returns false if it had no valid sample.
+    static bool summarize(const Channel& ch, int16_t& min, int16_t& max, int16_t& avg);
+
+    uint16_t _interval;
+    uint32_t _bucket;       // Start of the bucket in progress
+    uint8_t  _count;
+    uint8_t  _flags;
+    uint16_t _fanSum;
+    uint16_t _damperSum;
+    Channel  _pit;
+    Channel  _meat1;
+    Channel  _meat2;
+};
+
+// One rollup tier: an accumulator plus a ring of the most recent completed
+// buckets. Older buckets live only in the tier's flash file.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class RollupTier {
+public:
+    RollupTier();
+
+    void begin(uint16_t intervalSec);
+    void clear();
+
+    // Feed a raw sample. Returns true if a bucket was completed.
+    bool add(const DataPoint& dp);
+
+    // Complete the bucket in progress (end of session). Returns true if one
+    // was pending.
+    bool finish();
+
+    // Completed bucket by tier index (0 = first of the session), or nullptr
+    // if it has already left the RAM ring.
+    const RollupPoint* get(uint32_t index) const;
+
+    bool getPartial(RollupPoint& out) const { return _acc.getPartial(out); }
+
+    uint16_t getInterval() const { return _acc.getInterval(); }
+    uint32_t getCount() const { return _total; }
+    uint32_t getRamStart() const { return _total - _count; }
+
+    // Buckets already appended to the tier's flash file
+    uint32_t getFlushed() const { return _flushed; }
+    void setFlushed(uint32_t count) { _flushed = count; }
+
+private:
+    void push(const RollupPoint& rp);
+
+    RollupAccumulator _acc;
+    RollupPoint _ring[SESSION_ROLLUP_RING];
+    uint16_t _head;
+    uint16_t _count;
+    uint32_t _total;
+    uint32_t _flushed;
+};
+
+namespace session_rollup {
+
+// Interval of rollup tier t in seconds
+uint16_t tierInterval(uint8_t tier);
+
+// Pick the finest resolution whose bucket count for spanSec fits maxPoints:
+// -1 for raw samples, otherwise a tier index. Falls back to the coarsest tier
+// when nothing fits.
+int8_t selectTier(uint32_t spanSec, uint32_t maxPoints);
+
+} // namespace session_rollup
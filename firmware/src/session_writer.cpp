@@ -0,0 +1,265 @@
+#include "session_writer.h"
+#include "session_codec.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifndef NATIVE_BUILD
+#include <Arduino.h>
+#endif
+
+SessionWriter::SessionWriter()
+    :
+#ifndef NATIVE_BUILD
+      _task(nullptr)
+    ,
+#endif
+      _fileSize(0)
+    , _blocksWritten(0)
+    , _bytesWritten(0)
+    , _writeErrors(0)
+    , _maxWriteUs(0)
+    , _queueFull(0)
+{
+}
+
+void SessionWriter::begin() {
+#if !defined(NATIVE_BUILD) && SESSION_WRITER_TASK
+    if (_task) return;
+
+    // Core 0 alongside WiFi, below the Arduino loop task (core 1) so a slow
+    // LittleFS commit only ever delays other background work.
+    BaseType_t ok = xTaskCreatePinnedToCore(taskMain, "session_wr",
+                                            SESSION_WRITER_STACK, this,
+                                            SESSION_WRITER_PRIORITY, &_task, 0);
+    if (ok != pdPASS) {
+        _task = nullptr;
+        Serial.println("[SESSION] Writer task failed to start; writing inline.");
+        return;
+    }
+    Serial.println("[SESSION] Writer task started on core 0.");
+#endif
+}
+
+bool SessionWriter::isRunning() const {
+#ifndef NATIVE_BUILD
+    return _task != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool SessionWriter::submit(const SessionWrite& req) {
+    if (!_queue.push(req)) {
+        _queueFull++;
+        return false;
+    }
+
+#ifndef NATIVE_BUILD
+    if (_task) {
+        xTaskNotifyGive(_task);
+        return true;
+    }
+#endif
+    drain();
+    return true;
+}
+
+bool SessionWriter::pollDone(SessionWriteDone& out) {
+    return _done.pop(out);
+}
+
+void SessionWriter::drain() {
+    SessionWrite req;
+    while (_queue.pop(req)) {
+#ifndef NATIVE_BUILD
+        uint32_t t0 = micros();
+        process(req);
+        uint32_t us = micros() - t0;
+        if (us > _maxWriteUs) _maxWriteUs = us;
+#else
+        process(req);
+#endif
+    }
+}
+
+#ifndef NATIVE_BUILD
+void SessionWriter::taskMain(void* arg) {
+    SessionWriter* self = static_cast<SessionWriter*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->drain();
+    }
+}
+#endif
+
+void SessionWriter::report(const SessionWriteDone& done) {
+    while (!_done.push(done)) {
+#ifndef NATIVE_BUILD
+        if (!_task) return;  // Inline: nobody can drain it meanwhile
+        vTaskDelay(1);
+#else
+        return;
+#endif
+    }
+}
+
+void SessionWriter::process(const SessionWrite& req) {
+    switch (req.kind) {
+        case SessionWrite::Kind::BLOCK:
+            if (!writeBlock(req)) _writeErrors++;
+            break;
+        case SessionWrite::Kind::ROLLUP:
+            if (!writeRollup(req)) _writeErrors++;
+            break;
+        case SessionWrite::Kind::CLOSE:
+            closeFiles();
+            break;
+        case SessionWrite::Kind::REMOVE: {
+            removeFiles();
+            SessionWriteDone done = { req.kind, 0, 0 };
+            report(done);
+            break;
+        }
+    }
+}
+
+bool SessionWriter::writeBlock(const SessionWrite& req) {
+    uint8_t block[SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_POINTS)];
+    size_t len = session_codec::encodeBlock(req.points, req.count, req.firstPoint,
+                                            block, sizeof(block));
+    if (len == 0) return false;
+
+#ifndef NATIVE_BUILD
+    if (!openForAppend(req.startTime)) return false;
+
+    uint32_t offset = _file.size();
+    if (_file.write(block, len) != len) {
+        Serial.println("[SESSION] Failed to write session block!");
+        return false;
+    }
+    _file.flush();
+    _fileSize = offset + len;
+#else
+    if (_image.empty()) {
+        uint8_t header[SESSION_FILE_HEADER_SIZE];
+        session_codec::writeFileHeader(header, req.startTime, SESSION_BLOCK_POINTS);
+        _image.assign(header, header + sizeof(header));
+    }
+    uint32_t offset = _image.size();
+    _image.insert(_image.end(), block, block + len);
+    _fileSize = _image.size();
+#endif
+
+    _blocksWritten++;
+    _bytesWritten += len;
+
+    SessionWriteDone done = { req.kind, req.firstPoint, offset };
+    report(done);
+    return true;
+}
+
+#ifndef NATIVE_BUILD
+static void rollupPath(char* buf, size_t size, uint16_t interval) {
+    snprintf(buf, size, SESSION_ROLLUP_PATH_FMT, (unsigned)interval);
+}
+#endif
+
+bool SessionWriter::writeRollup(const SessionWrite& req) {
+    if (req.tier >= SESSION_ROLLUP_TIERS) return false;
+
+#ifndef NATIVE_BUILD
+    File& file = _rollupFile[req.tier];
+    if (!file) {
+        char path[24];
+        rollupPath(path, sizeof(path), session_rollup::tierInterval(req.tier));
+        file = LittleFS.open(path, LittleFS.exists(path) ? "a" : "w");
+        if (!file) return false;
+    }
+
+    // Fixed-size records: bucket i lives at i * sizeof(RollupPoint)
+    if (file.write((const uint8_t*)&req.rollup, sizeof(RollupPoint)) != sizeof(RollupPoint)) {
+        return false;
+    }
+    file.flush();
+#endif
+
+    _bytesWritten += sizeof(RollupPoint);
+    return true;
+}
+
+void SessionWriter::closeFiles() {
+#ifndef NATIVE_BUILD
+    _file.close();
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) _rollupFile[t].close();
+#endif
+}
+
+void SessionWriter::removeFiles() {
+    closeFiles();
+    _fileSize = 0;
+
+#ifndef NATIVE_BUILD
+    LittleFS.remove(SESSION_FILE_PATH);
+    for (uint8_t t = 0; t < SESSION_ROLLUP_TIERS; t++) {
+        char path[24];
+        rollupPath(path, sizeof(path), session_rollup::tierInterval(t));
+        LittleFS.remove(path);
+    }
+#else
+    _image.clear();
+#endif
+}
+
+#ifdef NATIVE_BUILD
+size_t SessionWriter::imageReadAt(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    const std::vector<uint8_t>& image = static_cast<const SessionWriter*>(ctx)->_image;
+    if (offset >= image.size()) return 0;
+    if (len > image.size() - offset) len = image.size() - offset;
+    memcpy(buf, image.data() + offset, len);
+    return len;
+}
+#endif
+
+#ifndef NATIVE_BUILD
+// Whether blocks can be appended to the file at path: it is empty (the
+// header is written first) or starts with a version 2 header
+static bool isAppendable(const char* path) {
+    File file = LittleFS.open(path, "r");
+    if (!file) return false;
+    uint8_t header[SESSION_FILE_HEADER_SIZE];
+    size_t len = file.read(header, sizeof(header));
+    file.close();
+    if (len == 0) return true;
+
+    uint32_t startTime;
+    size_t headerSize;
+    return session_codec::parseFileHeader(header, len, &startTime, &headerSize) ==
+           session_codec::FileFormat::BLOCK_V2;
+}
+
+bool SessionWriter::openForAppend(uint32_t startTime) {
+    if (_file) return true;
+
+    // Blocks appended after version 1 records would leave a file neither
+    // format can read (a failed migration leaves one behind): start over
+    bool exists = LittleFS.exists(SESSION_FILE_PATH);
+    if (exists && !isAppendable(SESSION_FILE_PATH)) {
+        Serial.println("[SESSION] Session file is not in block format; starting a new one.");
+        LittleFS.remove(SESSION_FILE_PATH);
+        exists = false;
+    }
+    _file = LittleFS.open(SESSION_FILE_PATH, exists ? "a" : "w");
+    if (!_file) {
+        Serial.println("[SESSION] Failed to open session file for writing!");
+        return false;
+    }
+
+    if (_file.size() == 0) {
+        uint8_t header[SESSION_FILE_HEADER_SIZE];
+        session_codec::writeFileHeader(header, startTime, SESSION_BLOCK_POINTS);
+        _file.write(header, sizeof(header));
+    }
+    _fileSize = _file.size();
+    return true;
+}
+#endif
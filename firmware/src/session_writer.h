@@ -0,0 +1,129 @@
+#pragma once
+
+#include "config.h"
+#include "data_point.h"
+#include "session_rollup.h"
+#include "spsc_queue.h"
+#include <stdint.h>
+
+#ifndef NATIVE_BUILD
+#include <LittleFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <vector>
+#endif
+
+// One unit of work for the session writer. The control side fills a slot
+// with a batch of points (or a rollup bucket) while the writer drains the
+// slots queued before it, so neither side ever waits on the other.
+struct SessionWrite {
+    enum class Kind : uint8_t {
+        BLOCK,      // Encode points[0..count) and append to the session file
+        ROLLUP,     // Append rollup to the file of tier
+        CLOSE,      // Close all open files (end of session)
+        REMOVE      // Close and delete all session files (new session)
+    };
+
+    Kind     kind;
+    uint8_t  count;         // BLOCK: points in the batch
+    uint8_t  tier;          // ROLLUP: tier index
+    uint32_t firstPoint;    // BLOCK: session index of points[0]
+    uint32_t startTime;     // BLOCK: written to the header of a new file
+    union {
+        DataPoint   points[SESSION_BLOCK_POINTS];
+        RollupPoint rollup;
+    };
+};
+
+// Reported back to the control side once a request has been carried out
+struct SessionWriteDone {
+    SessionWrite::Kind kind;
+    uint32_t firstPoint;    // BLOCK: first point of the block
+    uint32_t offset;        // BLOCK: file offset the block was written at
+};
+
+// Moves session persistence off the control loop. CookSession submits
+// batches through a lock-free SPSC queue; a low-priority task pinned to
+// core 0 encodes them and does the LittleFS appends, then reports each
+// block's file offset back through a second queue so the control side can
+// index it.
+//
+// Until begin() starts the task (and always on native or with
+// SESSION_WRITER_TASK 0) submissions are carried out inline.
+//
+// Single producer: submit() and pollDone() must be called from one task.
+class SessionWriter {
+public:
+    SessionWriter();
+
+    // Start the writer task. Files are not touched until the first request.
+    void begin();
+
+    // Whether requests are handed to the writer task
+    bool isRunning() const;
+
+    // Queue a request without blocking. Returns false if the queue is full;
+    // the caller keeps the data and retries on its next flush.
+    bool submit(const SessionWrite& req);
+
+    // Fetch the next completion report. Returns false if there is none.
+    // The writer waits for room to report, and stops taking requests while
+    // it does, so a caller that waits for queue space must poll meanwhile.
+    bool pollDone(SessionWriteDone& out);
+
+    // Carry out every queued request (writer side)
+    void drain();
+
+    // Statistics
+    uint32_t getBlocksWritten() const   { return _blocksWritten; }
+    uint32_t getBytesWritten() const    { return _bytesWritten; }
+    uint32_t getWriteErrors() const     { return _writeErrors; }
+    uint32_t getMaxWriteUs() const      { return _maxWriteUs; }     // Slowest request
+    uint32_t getQueueHighWater() const  { return _queue.getHighWater(); }
+    uint32_t getQueueFullCount() const  { return _queueFull; }      // Rejected submits
+
+    // Current size of the session file as seen by the writer
+    uint32_t getFileSize() const { return _fileSize; }
+
+#ifdef NATIVE_BUILD
+    // Native stand-in for the session file, so cursors can read flushed blocks
+    const std::vector<uint8_t>& getFileImage() const { return _image; }
+    std::vector<uint8_t>& getFileImage() { return _image; }
+
+    // SessionBlockReader::ReadFn over the file image (ctx = const SessionWriter*)
+    static size_t imageReadAt(void* ctx, uint32_t offset, uint8_t* buf, size_t len);
+#endif
+
+private:
+    void process(const SessionWrite& req);
+    bool writeBlock(const SessionWrite& req);
+    bool writeRollup(const SessionWrite& req);
+    void closeFiles();
+    void removeFiles();
+    void report(const SessionWriteDone& done);
+
+#ifndef NATIVE_BUILD
+    static void taskMain(void* arg);
+
+    // Open (and if new, create with a header) the session file for appending
+    bool openForAppend(uint32_t startTime);
+
+    TaskHandle_t _task;
+    File _file;
+    File _rollupFile[SESSION_ROLLUP_TIERS];
+#else
+    std::vector<uint8_t> _image;
+#endif
+
+    SpscQueue<SessionWrite, SESSION_WRITE_QUEUE_DEPTH> _queue;
+    SpscQueue<SessionWriteDone, SESSION_WRITE_QUEUE_DEPTH> _done;
+
+    uint32_t _fileSize;
+
+    uint32_t _blocksWritten;
+    uint32_t _bytesWritten;
+    uint32_t _writeErrors;
+    uint32_t _maxWriteUs;
+    uint32_t _queueFull;
+};
@@ -0,0 +1,93 @@
+#ifdef SIMULATOR_BUILD
+
+#include "sim_adc_noise.h"
+#include "../units.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+SimAdcNoise::SimAdcNoise(uint32_t sampleRate, float noiseCounts)
+    : _sampleRate(sampleRate ? sampleRate : SIM_ADC_RATE_SPS)
+    , _noiseCounts(noiseCounts)
+    , _running(false)
+    , _startPushed(0)
+{
+    for (int i = 0; i < 3; i++) _tempF[i].store(NAN);
+}
+
+SimAdcNoise::~SimAdcNoise() {
+    stop();
+}
+
+void SimAdcNoise::setTemps(float pitF, float meat1F, float meat2F) {
+    _tempF[0].store(pitF);
+    _tempF[1].store(meat1F);
+    _tempF[2].store(meat2F);
+}
+
+void SimAdcNoise::start() {
+    if (_running.load()) return;
+    _running.store(true);
+    _startedAt = std::chrono::steady_clock::now();
+    _startPushed = _ring.getPushed();
+    _thread = std::thread(&SimAdcNoise::run, this);
+    printf("[SIM] ADC diagnostic stream on: %u samples/s, noise %.1f counts\n",
+           _sampleRate, _noiseCounts);
+}
+
+void SimAdcNoise::stop() {
+    if (!_running.load()) return;
+    _running.store(false);
+    if (_thread.joinable()) _thread.join();
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startedAt).count();
+    uint32_t samples = _ring.getPushed() - _startPushed;
+    printf("[SIM] ADC diagnostic stream off: %u samples in %.1f s (%.0f/s), %u dropped, ring peak %u/%u\n",
+           samples, secs, secs > 0 ? samples / secs : 0.0, _ring.getDropped(),
+           _ring.getHighWater(), (unsigned)AdcDiagRing::capacity());
+}
+
+int16_t SimAdcNoise::countsForTempF(float tempF) {
+    if (std::isnan(tempF)) return ADC_MAX_VALUE;  // Open probe: divider reads full scale
+
+    // Inverse Steinhart-Hart: ln R = cbrt(y - x/2) - cbrt(y + x/2), with
+    // x = (A - 1/T) / C and y = sqrt((B / 3C)^3 + x^2 / 4)
+    double t = fahrenheitToCelsius(tempF) + 273.15;
+    double x = (THERM_A - 1.0 / t) / THERM_C;
+    double y = std::sqrt(std::pow(THERM_B / (3.0 * THERM_C), 3) + x * x / 4.0);
+    double r = std::exp(std::cbrt(y - x / 2.0) - std::cbrt(y + x / 2.0));
+    return (int16_t)std::lround(ADC_MAX_VALUE * REFERENCE_RESISTANCE / (REFERENCE_RESISTANCE + r));
+}
+
+void SimAdcNoise::run() {
+    using clock = std::chrono::steady_clock;
+    std::mt19937 rng(12345);
+    std::normal_distribution<float> noise(0.0f, _noiseCounts);
+    std::uniform_int_distribution<uint32_t> spike(0, SIM_ADC_SPIKE_ODDS - 1);
+
+    // Paced against the start time, so a late wakeup is caught up rather
+    // than stretching the rate
+    const clock::duration period = std::chrono::nanoseconds(1000000000ull / _sampleRate);
+    clock::time_point next = _startedAt;
+    uint8_t probe = 0;
+    while (_running.load()) {
+        next += period;
+        std::this_thread::sleep_until(next);
+
+        float counts = countsForTempF(_tempF[probe].load()) + noise(rng);
+        if (spike(rng) == 0) counts += (rng() & 1) ? 2000.0f : -2000.0f;
+        if (counts > ADC_MAX_VALUE) counts = ADC_MAX_VALUE;
+        if (counts < 0) counts = 0;
+
+        AdcSample s;
+        s.us = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                   next.time_since_epoch()).count();
+        s.probe = probe;
+        s.raw = (int16_t)counts;
+        s.ohms = adcCountsToOhms(s.raw);
+        _ring.push(s);
+        probe = (probe + 1) % 3;
+    }
+}
+
+#endif // SIMULATOR_BUILD
@@ -0,0 +1,53 @@
+#pragma once
+
+#ifdef SIMULATOR_BUILD
+
+#include "../adc_diag.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#define SIM_ADC_RATE_SPS      860     // Samples per second, all probes together
+#define SIM_ADC_NOISE_COUNTS  6.0f    // Gaussian noise (1 sigma, ADC counts)
+#define SIM_ADC_SPIKE_ODDS    2000    // One sample in this many is a connector spike
+
+// Synthetic stand-in for the device's ADC diagnostic task. A thread turns the
+// model's probe temperatures into the counts an ADS1115 would read through the
+// reference divider, adds Gaussian noise and the odd single-sample spike, and
+// pushes them round-robin over the probes into an AdcDiagRing at a fixed rate,
+// so the ring, framing and WebSocket path can be benchmarked on Linux.
+class SimAdcNoise {
+public:
+    explicit SimAdcNoise(uint32_t sampleRate = SIM_ADC_RATE_SPS,
+                         float noiseCounts = SIM_ADC_NOISE_COUNTS);
+    ~SimAdcNoise();
+
+    // Probe temperatures (F) to sample around; NAN reads as an open probe
+    void setTemps(float pitF, float meat1F, float meat2F);
+
+    // Start or stop the sampling thread. stop() prints the achieved rate.
+    void start();
+    void stop();
+    bool isRunning() const { return _running.load(); }
+
+    // Consumer side of the stream
+    AdcDiagRing& ring() { return _ring; }
+
+private:
+    void run();
+
+    // Counts the divider gives for a temperature (Steinhart-Hart inverted)
+    static int16_t countsForTempF(float tempF);
+
+    uint32_t _sampleRate;
+    float    _noiseCounts;
+    AdcDiagRing _ring;
+    std::atomic<float> _tempF[3];
+    std::atomic<bool> _running;
+    std::thread _thread;
+    std::chrono::steady_clock::time_point _startedAt;
+    uint32_t _startPushed;
+};
+
+#endif // SIMULATOR_BUILD
@@ -254,6 +254,15 @@ static void web_on_new_session() {
     printf("[WEB] New session started via web UI\n");
 }
 
+// Where to serve the web UI from without a compiled-in bundle (or with
+// --web-dir unset): the bundle the build step writes, else the plain sources
+static const char* default_web_dir() {
+    FILE* index = fopen(SIM_WEB_BUNDLE_DIR WEB_ASSET_INDEX, "rb");
+    if (!index) return "data";
+    fclose(index);
+    return SIM_WEB_BUNDLE_DIR;
+}
+
 static void print_usage(const char* prog) {
     printf("Pit Claw LVGL Simulator\n\n");
     printf("Usage: %s [options]\n\n", prog);
@@ -261,6 +270,10 @@ static void print_usage(const char* prog) {
     printf("  --speed N      Time acceleration factor (default: 5)\n");
     printf("  --profile NAME Cook profile (default: normal)\n");
     printf("  --port N       Web server port (default: 3000)\n");
+    printf("  --broadcast M  Data broadcasts: adaptive (on change) or fixed (default: adaptive)\n");
+    printf("  --diag-rate N  Raw ADC samples/s streamed to diag subscribers (default: %d)\n",
+           SIM_ADC_RATE_SPS);
+    printf("  --web-dir DIR  Serve the web UI from DIR (default: the bundle built into the program)\n");
     printf("  --wizard       Force setup wizard (resets saved setup state)\n");
     printf("\nAvailable profiles:\n");
     for (int i = 0; i < sim_profile_count; i++) {
@@ -302,6 +315,9 @@ int main(int argc, char* argv[]) {
     int webPort = 3000;
     const char* profileName = "normal";
     bool forceWizard = false;
+    bool adaptiveBroadcast = WS_ADAPTIVE_BROADCAST;
+    int diagRate = SIM_ADC_RATE_SPS;
+    const char* webDir = nullptr;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -313,6 +329,13 @@ int main(int argc, char* argv[]) {
         } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
             webPort = atoi(argv[++i]);
             if (webPort < 1 || webPort > 65535) webPort = 3000;
+        } else if (strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+            adaptiveBroadcast = strcmp(argv[++i], "fixed") != 0;
+        } else if (strcmp(argv[i], "--diag-rate") == 0 && i + 1 < argc) {
+            diagRate = atoi(argv[++i]);
+            if (diagRate < 1) diagRate = SIM_ADC_RATE_SPS;
+        } else if (strcmp(argv[i], "--web-dir") == 0 && i + 1 < argc) {
+            webDir = argv[++i];
         } else if (strcmp(argv[i], "--wizard") == 0) {
             forceWizard = true;
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
@@ -364,7 +387,12 @@ int main(int argc, char* argv[]) {
     // Initialize web server for browser-based UI
     SimWebServer webServer;
     g_webServer = &webServer;
-    webServer.begin(webPort, "data");
+    // The web UI compiled into the program, like the device; --web-dir
+    // serves one from disk instead
+    webServer.begin(webPort, webDir ? webDir : default_web_dir(), webDir == nullptr);
+    webServer.setAdaptiveBroadcast(adaptiveBroadcast);
+    SimAdcNoise adcNoise((uint32_t)diagRate);
+    webServer.setDiagSource(&adcNoise);
     webServer.onSetpoint(web_on_setpoint);
     webServer.onAlarm(web_on_alarm);
     webServer.onNewSession(web_on_new_session);
@@ -384,6 +412,7 @@ int main(int argc, char* argv[]) {
     g_simStartTs = (uint32_t)time(nullptr); // real clock at sim start
     uint32_t lastUpdate = SDL_GetTicks();
     uint32_t lastGraph = SDL_GetTicks();
+    uint32_t lastBroadcastReportHour = 0;
     bool running = true;
 
     while (running) {
@@ -507,7 +536,32 @@ int main(int argc, char* argv[]) {
                     payload.est   = 0;
                     payload.fanMode = g_fan_mode;
                     payload.errorCount = 0;
-                    webServer.broadcastData(payload);
+                    uint32_t simMs = (uint32_t)(model.simTime * 1000.0f);
+                    webServer.publishData(payload, g_alarm_active ? (uint8_t)(1u << g_alarm_type) : 0,
+                                          simMs);
+
+                    // PID loop state for control-channel subscribers
+                    bbq_protocol::ControlPayload control;
+                    memset(&control, 0, sizeof(control));
+                    control.pit    = result.pitTemp;
+                    control.sp     = model.setpoint;
+                    control.out    = model.pidOutput;
+                    control.p      = model.pidP;
+                    control.i      = model.pidI;
+                    control.d      = model.pidD;
+                    control.fan    = result.fanPercent;
+                    control.damper = result.damperPercent;
+                    control.lid    = result.lidOpen;
+                    webServer.publishControl(control);
+
+                    // Raw ADC stream follows the model (if anyone subscribes)
+                    adcNoise.setTemps(result.pitTemp, payload.meat1, payload.meat2);
+
+                    // Broadcast rate for both modes, once per simulated hour
+                    if (simMs / 3600000u != lastBroadcastReportHour) {
+                        lastBroadcastReportHour = simMs / 3600000u;
+                        webServer.printBroadcastStats();
+                    }
 
                     // Accumulate for history replay
                     bbq_protocol::HistoryPoint hp;
@@ -551,6 +605,7 @@ int main(int argc, char* argv[]) {
         SDL_Delay(5);
     }
 
+    webServer.printBroadcastStats();
     g_model = nullptr;
     g_webServer = nullptr;
     printf("Simulator exited.\n");
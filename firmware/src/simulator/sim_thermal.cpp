@@ -47,6 +47,7 @@ void SimThermalModel::init(const SimProfile& profile) {
 
     pidIntegral_ = 0;
     pidPrevError_ = 0;
+    pidOutput = pidP = pidI = pidD = 0;
     hasReachedSetpoint_ = false;
     overshootRemaining_ = 0;
     noisePhase_ = (float)(rand() % 1000) / 1000.0f * 6.283f;
@@ -143,14 +144,18 @@ float SimThermalModel::computePID(float dt) {
     float derivative = (dt > 0) ? (error - pidPrevError_) / dt : 0;
     pidPrevError_ = error;
 
-    float output = Kp * error + Ki * pidIntegral_ + Kd * derivative;
+    pidP = Kp * error;
+    pidI = Ki * pidIntegral_;
+    pidD = Kd * derivative;
+    float output = pidP + pidI + pidD;
 
     // If lid is open, back off
     if (lidOpen) {
         output = 0;
     }
 
-    return fmaxf(0, fminf(100, output));
+    pidOutput = fmaxf(0, fminf(100, output));
+    return pidOutput;
 }
 
 void SimThermalModel::updatePitTemp(float dt) {
@@ -37,6 +37,10 @@ public:
     bool meat2Connected;
     float simTime;
 
+    // Last PID output and its terms (for the web control channel)
+    float pidOutput;
+    float pidP, pidI, pidD;
+
     // Fan mode configuration
     char fanMode[20];
     float fanOnThreshold;
@@ -3,6 +3,8 @@
 #include "sim_web_server.h"
 #include "mongoose.h"
 #include "../config.h"
+#include "../binary_frame.h"
+#include "../history_message.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -14,6 +16,16 @@ SimWebServer* g_simWebServer = nullptr;
 SimWebServer::SimWebServer()
     : _mgr(nullptr)
     , _port(3000)
+    , _lastPingMs(0)
+    , _adaptive(WS_ADAPTIVE_BROADCAST)
+    , _framesSent(0)
+    , _firstPublishMs(0)
+    , _lastPublishMs(0)
+    , _hasData(false)
+    , _diag(nullptr)
+    , _diagSeq(0)
+    , _lastDiagMs(0)
+    , _sessionId(0)
     , _setpoint(225)
     , _meat1Target(0)
     , _meat2Target(0)
@@ -24,6 +36,8 @@ SimWebServer::SimWebServer()
     , _onFanMode(nullptr)
 {
     memset(_staticDir, 0, sizeof(_staticDir));
+    memset(&_data, 0, sizeof(_data));
+    memset(&_control, 0, sizeof(_control));
 }
 
 SimWebServer::~SimWebServer() {
@@ -35,10 +49,28 @@ SimWebServer::~SimWebServer() {
     if (g_simWebServer == this) g_simWebServer = nullptr;
 }
 
-void SimWebServer::begin(int port, const char* staticDir) {
+void SimWebServer::begin(int port, const char* staticDir, bool embedded) {
     _port = port;
     strncpy(_staticDir, staticDir, sizeof(_staticDir) - 1);
 
+    // Web UI bundle: compiled in, or the index of a web_assets.py build
+    uint8_t packedCount;
+    const WebAsset* packed = embedded ? packedWebAssets(&packedCount) : nullptr;
+    std::string indexPath = std::string(_staticDir) + WEB_ASSET_INDEX;
+    FILE* index = nullptr;
+    if (packed && _assets.loadPacked(packed, packedCount) > 0) {
+        printf("[WEB] Serving %u embedded web UI assets\n", _assets.size());
+    } else if ((index = fopen(indexPath.c_str(), "rb")) != nullptr) {
+        char text[WEB_ASSET_INDEX_MAX];
+        size_t len = fread(text, 1, sizeof(text), index);
+        fclose(index);
+        if (_assets.load(text, len) > 0) {
+            printf("[WEB] Serving %u web UI assets from %s\n", _assets.size(), indexPath.c_str());
+        } else {
+            printf("[WEB] Unusable %s, serving files as stored\n", indexPath.c_str());
+        }
+    }
+
     g_simWebServer = this;
 
     _mgr = (struct mg_mgr*)malloc(sizeof(struct mg_mgr));
@@ -53,29 +85,185 @@ void SimWebServer::begin(int port, const char* staticDir) {
 void SimWebServer::tick() {
     if (_mgr) {
         mg_mgr_poll(_mgr, 0);
+
+        // Clients that never sent a sync get a full replay
+        WsClient* late;
+        while ((late = _clients.nextSyncTimeout((uint32_t)mg_millis())) != nullptr) {
+            struct mg_connection* c = findConnection(late->id);
+            if (c) sendInitial(c, *late);
+            else   _clients.remove(late->id);
+        }
+
+        // Ping every client; close the ones that stopped answering
+        uint64_t now = mg_millis();
+        if (now - _lastPingMs >= WS_PING_INTERVAL) {
+            _lastPingMs = now;
+            for (uint8_t i = 0; i < _clients.size(); i++) {
+                struct mg_connection* c = findConnection(_clients[i].id);
+                if (c) mg_ws_send(c, nullptr, 0, WEBSOCKET_OP_PING);
+            }
+        }
+        WsClient* stale;
+        while ((stale = _clients.nextStale((uint32_t)now)) != nullptr) {
+            printf("[WEB] WebSocket client silent, evicting\n");
+            struct mg_connection* c = findConnection(stale->id);
+            if (c) c->is_closing = 1;
+            _clients.remove(stale->id);
+        }
+
+        // History replays: the next chunk once the previous one has left
+        for (uint8_t i = 0; i < _clients.size(); i++) {
+            WsClient& client = _clients[i];
+            if (!client.replay.active) continue;
+            struct mg_connection* c = findConnection(client.id);
+            if (c && c->send.len < WS_HISTORY_CHUNK_SIZE) sendHistoryChunk(c, client);
+        }
+
+        // Subscription channels, each at its subscribers' own rates
+        if (_hasData) sendData((uint32_t)now);
+        _clients.produced(bbq_protocol::Channel::CONTROL);
+        sendControl((uint32_t)now);
+
+        // Raw ADC batches, drained at the device's poll interval
+        if (now - _lastDiagMs >= WS_CHANGE_POLL_MS) {
+            _lastDiagMs = now;
+            sendDiag((uint32_t)now);
+        }
+    }
+}
+
+struct mg_connection* SimWebServer::findConnection(uint32_t id) const {
+    for (struct mg_connection* c = _mgr->conns; c != nullptr; c = c->next) {
+        if (c->is_websocket && (uint32_t)c->id == id) return c;
     }
+    return nullptr;
 }
 
-void SimWebServer::broadcastData(const bbq_protocol::DataPayload& data) {
-    if (!_mgr) return;
+void SimWebServer::sendData(uint32_t nowMs) {
+    using bbq_protocol::Channel;
+    if (!_mgr || _clients.countDue(Channel::DATA, nowMs) == 0) return;
 
+    uint8_t bin[BIN_DATA_FRAME_SIZE];
+    size_t binLen = _clients.countDue(Channel::DATA, nowMs, 1) > 0
+        ? bbq_protocol::encodeDataFrame(bin, sizeof(bin), _data) : 0;
     char buf[512];
-    size_t len = bbq_protocol::buildDataMessage(buf, sizeof(buf), data);
+    size_t len = _clients.countDue(Channel::DATA, nowMs, 0) > 0
+        ? bbq_protocol::buildDataMessage(buf, sizeof(buf), _data) : 0;
 
-    // Iterate all connections, send to WebSocket ones
+    // Iterate all connections, send to WebSocket ones in their own format
     for (struct mg_connection* c = _mgr->conns; c != nullptr; c = c->next) {
-        if (c->is_websocket) {
-            mg_ws_send(c, buf, len, WEBSOCKET_OP_TEXT);
+        if (!c->is_websocket) continue;
+        WsClient* client = _clients.find((uint32_t)c->id);
+        if (!client || !WsClientTable::isLive(*client) || !client->sub.due(Channel::DATA, nowMs)) {
+            continue;
+        }
+        client->sub.delivered(Channel::DATA, nowMs);
+
+        // A client still holding older frames in its send buffer skips this
+        // one and gets the next, newer snapshot instead
+        if (c->send.len >= (size_t)WS_BROADCAST_BUF_SIZE * WS_CLIENT_QUEUE_MAX) {
+            client->flow.coalesced++;
+            continue;
         }
+        if (client->binVersion > 0) mg_ws_send(c, bin, binLen, WEBSOCKET_OP_BINARY);
+        else                        mg_ws_send(c, buf, len, WEBSOCKET_OP_TEXT);
+        client->flow.frames++;
     }
 }
 
+void SimWebServer::sendControl(uint32_t nowMs) {
+    using bbq_protocol::Channel;
+    if (!_mgr || _clients.countDue(Channel::CONTROL, nowMs) == 0) return;
+
+    // The model steps once a second, so faster subscribers see repeats
+    _control.ms = nowMs;
+    char buf[WS_BROADCAST_BUF_SIZE];
+    size_t len = bbq_protocol::buildControlMessage(buf, sizeof(buf), _control);
+
+    for (uint8_t i = 0; i < _clients.size(); i++) {
+        WsClient& client = _clients[i];
+        if (!WsClientTable::isLive(client) || !client.sub.due(Channel::CONTROL, nowMs)) continue;
+        client.sub.delivered(Channel::CONTROL, nowMs);
+        struct mg_connection* c = findConnection(client.id);
+        if (!c || len == 0) continue;
+        if (c->send.len >= (size_t)WS_BROADCAST_BUF_SIZE * WS_CLIENT_QUEUE_MAX) {
+            client.flow.dropped++;
+            continue;
+        }
+        mg_ws_send(c, buf, len, WEBSOCKET_OP_TEXT);
+        client.flow.frames++;
+    }
+}
+
+void SimWebServer::sendDiag(uint32_t nowMs) {
+    using bbq_protocol::Channel;
+    if (!_diag) return;
+
+    bool wanted = _clients.countSubscribed(Channel::DIAG) > 0;
+    if (wanted && !_diag->isRunning()) _diag->start();
+    if (!wanted && _diag->isRunning()) _diag->stop();
+
+    AdcSample batch[WS_DIAG_BATCH_MAX];
+    uint8_t frame[BIN_DIAG_HEADER_SIZE + WS_DIAG_BATCH_MAX * BIN_DIAG_RECORD_SIZE];
+    uint16_t n;
+    while ((n = _diag->ring().drain(batch, WS_DIAG_BATCH_MAX)) > 0) {
+        if (!wanted) continue;  // Leftovers of a finished stream
+        size_t len = bbq_protocol::encodeDiagFrame(frame, sizeof(frame), _diagSeq++,
+                                                   _diag->ring().getDropped(), batch, (uint8_t)n);
+        _clients.produced(Channel::DIAG);
+
+        for (uint8_t i = 0; i < _clients.size(); i++) {
+            WsClient& client = _clients[i];
+            if (!WsClientTable::isLive(client) || !client.sub.due(Channel::DIAG, nowMs)) continue;
+            client.sub.delivered(Channel::DIAG, nowMs);
+            struct mg_connection* c = findConnection(client.id);
+            if (!c) continue;
+            if (c->send.len >= WS_HISTORY_CHUNK_SIZE) {
+                client.flow.dropped++;
+                continue;
+            }
+            mg_ws_send(c, frame, len, WEBSOCKET_OP_BINARY);
+            client.flow.frames++;
+        }
+    }
+}
+
+void SimWebServer::publishData(const bbq_protocol::DataPayload& data, uint8_t alarmBits,
+                               uint32_t nowMs) {
+    if (_framesSent == 0 && _gate.getFrames() == 0) _firstPublishMs = nowMs;
+    _lastPublishMs = nowMs;
+
+    BroadcastGate::Reason why = _gate.check(data, alarmBits, nowMs);
+    if (why != BroadcastGate::Reason::NONE) _gate.sent(data, alarmBits, nowMs, why);
+
+    _data = data;
+    _hasData = true;
+    if (_adaptive && why == BroadcastGate::Reason::NONE) return;
+    _clients.produced(bbq_protocol::Channel::DATA);
+    _framesSent++;
+    sendData((uint32_t)mg_millis());
+}
+
+void SimWebServer::printBroadcastStats() const {
+    uint32_t elapsed = _lastPublishMs - _firstPublishMs;
+    printf("[SIM] Broadcast frames/hour: adaptive %u (state %u, value %u, heartbeat %u), "
+           "fixed %u ms %u; sending %s\n",
+           BroadcastGate::perHour(_gate.getFrames(), elapsed),
+           BroadcastGate::perHour(_gate.getCount(BroadcastGate::Reason::STATE), elapsed),
+           BroadcastGate::perHour(_gate.getCount(BroadcastGate::Reason::VALUE), elapsed),
+           BroadcastGate::perHour(_gate.getCount(BroadcastGate::Reason::HEARTBEAT), elapsed),
+           (unsigned)WS_SEND_INTERVAL, BroadcastGate::perHour(1, WS_SEND_INTERVAL),
+           _adaptive ? "adaptive" : "fixed");
+}
+
 void SimWebServer::addHistoryPoint(const bbq_protocol::HistoryPoint& point) {
+    if (_history.empty()) _sessionId = point.ts;
     _history.push_back(point);
 }
 
 void SimWebServer::clearHistory() {
     _history.clear();
+    _sessionId = 0;
 }
 
 void SimWebServer::resetSession() {
@@ -110,52 +298,173 @@ int SimWebServer::getClientCount() const {
     return count;
 }
 
-void SimWebServer::sendHistory(struct mg_connection* c) {
-    if (_history.empty()) return;
+void SimWebServer::startReplay(WsClient& client, uint32_t from, bool append) {
+    HistoryReplay& r = client.replay;
+    r.active = true;
+    r.append = append;
+    r.tier = -1;
+    r.seq = 0;
+    r.session = _sessionId;
+    r.next = from;
+    r.end = (uint32_t)_history.size();
+    r.step = 1;
+}
 
-    size_t msgLen = 0;
-    char* msg = bbq_protocol::buildHistoryMessage(
-        _history.data(), _history.size(),
-        _setpoint, _meat1Target, _meat2Target, &msgLen);
+void SimWebServer::sendHistoryChunk(struct mg_connection* c, WsClient& client) {
+    HistoryReplay& r = client.replay;
 
-    if (msg) {
-        mg_ws_send(c, msg, msgLen, WEBSOCKET_OP_TEXT);
-        free(msg);
+    // New session under the replay: start again with the new one
+    if (r.session != _sessionId) {
+        r.active = false;
+        sendInitial(c, client);
+        return;
     }
-}
 
-void SimWebServer::sendCSVDownload(struct mg_connection* c) {
-    // Build CSV from history data
-    // Header
-    std::string csv = "timestamp,pit,meat1,meat2,fan,damper,setpoint,lid\n";
-    char line[256];
+    bool binary = client.binVersion > 0;
+    bbq_protocol::HistoryChunkHeader header;
+    header.seq = r.seq;
+    header.session = r.session;
+    header.append = r.append;
+    header.sp = _setpoint;
+    header.meat1Target = _meat1Target;
+    header.meat2Target = _meat2Target;
+
+    // Points recorded during the replay go out with it
+    bbq_protocol::HistoryChunkWriter writer(_chunkBuf, sizeof(_chunkBuf), binary);
+    writer.begin(header);
+    r.end = (uint32_t)_history.size();
+    while (r.next < r.end && writer.add(_history[r.next])) r.next++;
+
+    bool final = r.next >= r.end;
+    size_t len = writer.finish(final);
+    mg_ws_send(c, _chunkBuf, len, binary ? WEBSOCKET_OP_BINARY : WEBSOCKET_OP_TEXT);
+
+    r.seq++;
+    if (final) {
+        r.active = false;
+        _gate.force();  // Live data resumes with the next publish
+    }
+}
 
-    for (size_t i = 0; i < _history.size(); i++) {
-        const bbq_protocol::HistoryPoint& p = _history[i];
-        int pos = snprintf(line, sizeof(line), "%u,", (unsigned)p.ts);
+void SimWebServer::sendInitial(struct mg_connection* c, WsClient& client) {
+    (void)c;
+    client.historyPending = false;
+    if (!_history.empty()) startReplay(client, 0, false);
+}
 
-        if (std::isnan(p.pit))   pos += snprintf(line + pos, sizeof(line) - pos, ",");
-        else                     pos += snprintf(line + pos, sizeof(line) - pos, "%.1f,", p.pit);
+void SimWebServer::syncClient(struct mg_connection* c, WsClient& client,
+                              uint32_t session, uint32_t since) {
+    if (session != 0 && session == _sessionId) {
+        // First point after since (history timestamps are increasing)
+        size_t lo = 0, hi = _history.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (_history[mid].ts > since) hi = mid;
+            else                          lo = mid + 1;
+        }
+        client.historyPending = false;
+        startReplay(client, (uint32_t)lo, true);
+        printf("[WEB] Client resyncing: %u missed points\n", (unsigned)(_history.size() - lo));
+        return;
+    }
 
-        if (std::isnan(p.meat1)) pos += snprintf(line + pos, sizeof(line) - pos, ",");
-        else                     pos += snprintf(line + pos, sizeof(line) - pos, "%.1f,", p.meat1);
+    // The client's cook is gone and there is nothing to replace it with yet
+    if (session != 0 && _history.empty()) {
+        char buf[128];
+        size_t n = bbq_protocol::buildSessionReset(buf, sizeof(buf), _setpoint);
+        mg_ws_send(c, buf, n, WEBSOCKET_OP_TEXT);
+    }
+    sendInitial(c, client);
+}
 
-        if (std::isnan(p.meat2)) pos += snprintf(line + pos, sizeof(line) - pos, ",");
-        else                     pos += snprintf(line + pos, sizeof(line) - pos, "%.1f,", p.meat2);
+// SessionExporter::PointSource over the simulator's HistoryPoint vector
+struct SimHistoryCursor {
+    const std::vector<bbq_protocol::HistoryPoint>* history;
+    size_t index;
+};
+
+static bool simHistoryNext(void* ctx, DataPoint& out) {
+    SimHistoryCursor* cur = static_cast<SimHistoryCursor*>(ctx);
+    if (cur->index >= cur->history->size()) return false;
+
+    const bbq_protocol::HistoryPoint& p = (*cur->history)[cur->index++];
+    memset(&out, 0, sizeof(out));
+    out.timestamp = p.ts;
+    out.fanPct    = p.fan;
+    out.damperPct = p.damper;
+    if (p.lid) out.flags |= DP_FLAG_LID_OPEN;
+
+    if (std::isnan(p.pit))   out.flags |= DP_FLAG_PIT_DISC;
+    else                     out.pitTemp = (int16_t)(p.pit * 10.0f);
+    if (std::isnan(p.meat1)) out.flags |= DP_FLAG_MEAT1_DISC;
+    else                     out.meat1Temp = (int16_t)(p.meat1 * 10.0f);
+    if (std::isnan(p.meat2)) out.flags |= DP_FLAG_MEAT2_DISC;
+    else                     out.meat2Temp = (int16_t)(p.meat2 * 10.0f);
+    return true;
+}
 
-        pos += snprintf(line + pos, sizeof(line) - pos, "%u,%u,%d,%s\n",
-            (unsigned)p.fan, (unsigned)p.damper, (int)p.sp,
-            p.lid ? "true" : "false");
+void SimWebServer::sendSessionExport(struct mg_connection* c, SessionExporter::Format format) {
+    SimHistoryCursor cursor = { &_history, 0 };
+    SessionExporter exporter(format, simHistoryNext, &cursor);
+
+    mg_printf(c,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: %s\r\n"
+              "Content-Disposition: attachment; filename=\"%s\"\r\n"
+              "Transfer-Encoding: chunked\r\n\r\n",
+              exporter.getContentType(), exporter.getFileName());
+
+    char chunk[1024];
+    size_t n;
+    while ((n = exporter.read((uint8_t*)chunk, sizeof(chunk))) > 0) {
+        mg_http_write_chunk(c, chunk, n);
+    }
+    mg_http_write_chunk(c, "", 0);  // Terminating zero-length chunk
+}
 
-        csv += line;
+void SimWebServer::sendAsset(struct mg_connection* c, struct mg_http_message* hm, const WebAsset& asset) {
+    struct mg_str* inm = mg_http_get_header(hm, "If-None-Match");
+    WebAssetReply reply = inm ? WebAssetTable::reply(asset, inm->buf, inm->len)
+                              : WebAssetTable::reply(asset, nullptr, 0);
+    if (reply.status == 304) {
+        mg_printf(c,
+                  "HTTP/1.1 304 Not Modified\r\n"
+                  "ETag: %s\r\n"
+                  "Cache-Control: %s\r\n"
+                  "Content-Length: 0\r\n\r\n",
+                  asset.etag, reply.cacheControl);
+        return;
     }
 
-    size_t envLen = 0;
-    char* envelope = bbq_protocol::buildCSVDownloadEnvelope(csv.c_str(), csv.length(), &envLen);
-    if (envelope) {
-        mg_ws_send(c, envelope, envLen, WEBSOCKET_OP_TEXT);
-        free(envelope);
+    // Compiled-in assets are sent from the table; the bundle on disk is read
+    std::string file;
+    const void* body = asset.data;
+    size_t len = asset.size;
+    if (!body) {
+        std::string path = std::string(_staticDir) + asset.file;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) {
+            mg_http_reply(c, 404, "", "Not Found\n");
+            return;
+        }
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) file.append(buf, n);
+        fclose(f);
+        body = file.data();
+        len = file.size();
     }
+
+    mg_printf(c,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: %s\r\n"
+              "%s"
+              "ETag: %s\r\n"
+              "Cache-Control: %s\r\n"
+              "Content-Length: %lu\r\n\r\n",
+              asset.type, asset.gzip ? "Content-Encoding: gzip\r\n" : "",
+              asset.etag, reply.cacheControl, (unsigned long)len);
+    mg_send(c, body, len);
 }
 
 void SimWebServer::handleMessage(struct mg_connection* c, const char* data, size_t len) {
@@ -191,8 +500,57 @@ void SimWebServer::handleMessage(struct mg_connection* c, const char* data, size
             break;
 
         case bbq_protocol::CmdType::SESSION_DOWNLOAD:
-            printf("[WEB] CSV download requested\n");
-            sendCSVDownload(c);
+            printf("[WEB] %s download requested\n", cmd.format);
+            {
+                char buf[128];
+                size_t n = bbq_protocol::buildSessionDownload(buf, sizeof(buf), cmd.format);
+                if (n > 0) mg_ws_send(c, buf, n, WEBSOCKET_OP_TEXT);
+            }
+            break;
+
+        case bbq_protocol::CmdType::HELLO:
+            {
+                WsClient* client = _clients.find((uint32_t)c->id);
+                if (!client) break;
+                client->binVersion = cmd.binVersion < BIN_PROTOCOL_VERSION
+                                   ? cmd.binVersion : BIN_PROTOCOL_VERSION;
+                char buf[48];
+                size_t n = bbq_protocol::buildHelloAck(buf, sizeof(buf), client->binVersion);
+                mg_ws_send(c, buf, n, WEBSOCKET_OP_TEXT);
+                printf("[WEB] Client negotiated %s frames\n",
+                       client->binVersion > 0 ? "binary" : "JSON");
+            }
+            break;
+
+        case bbq_protocol::CmdType::SYNC:
+            {
+                WsClient* client = _clients.find((uint32_t)c->id);
+                if (client) syncClient(c, *client, cmd.session, cmd.since);
+            }
+            break;
+
+        case bbq_protocol::CmdType::SUBSCRIBE:
+        case bbq_protocol::CmdType::UNSUBSCRIBE:
+            {
+                WsClient* client = _clients.find((uint32_t)c->id);
+                if (!client) break;
+                if (cmd.type == bbq_protocol::CmdType::SUBSCRIBE) {
+                    // Diag batches only exist as binary frames
+                    uint8_t channels = cmd.channels;
+                    if (client->binVersion == 0) {
+                        channels &= (uint8_t)~bbq_protocol::channelBit(bbq_protocol::Channel::DIAG);
+                    }
+                    client->sub.subscribe(channels, cmd.rateMs);
+                } else {
+                    client->sub.unsubscribe(cmd.channels);
+                }
+                char buf[96];
+                size_t n = bbq_protocol::buildSubscriptionAck(buf, sizeof(buf),
+                                                              client->sub.channels,
+                                                              client->sub.rateMs);
+                mg_ws_send(c, buf, n, WEBSOCKET_OP_TEXT);
+                printf("[WEB] Client channels now 0x%02x\n", client->sub.channels);
+            }
             break;
 
         case bbq_protocol::CmdType::SET_FAN_MODE:
@@ -226,7 +584,22 @@ void SimWebServer::eventHandler(struct mg_connection* c, int ev, void* ev_data)
             return;
         }
 
-        // Serve static files from firmware/data/
+        // Full-session export (same streaming formatter as the firmware)
+        if (mg_match(hm->uri, mg_str("/api/session.csv"), nullptr)) {
+            self->sendSessionExport(c, SessionExporter::Format::CSV);
+            return;
+        }
+        if (mg_match(hm->uri, mg_str("/api/session.json"), nullptr)) {
+            self->sendSessionExport(c, SessionExporter::Format::JSON);
+            return;
+        }
+
+        // Web UI bundle assets, then any other file in the static dir
+        const WebAsset* asset = self->_assets.find(hm->uri.buf, hm->uri.len);
+        if (asset && mg_match(hm->method, mg_str("GET"), nullptr)) {
+            self->sendAsset(c, hm, *asset);
+            return;
+        }
         struct mg_http_serve_opts opts;
         memset(&opts, 0, sizeof(opts));
         opts.root_dir = self->_staticDir;
@@ -235,11 +608,16 @@ void SimWebServer::eventHandler(struct mg_connection* c, int ev, void* ev_data)
     }
     else if (ev == MG_EV_WS_OPEN) {
         printf("[WEB] WebSocket client connected\n");
-        // Send history on connect
-        self->sendHistory(c);
+        // History follows the client's sync (or the sync timeout)
+        if (!self->_clients.add((uint32_t)c->id, (uint32_t)mg_millis())) {
+            printf("[WEB] No slot for WebSocket client, closing\n");
+            c->is_closing = 1;
+        }
     }
-    else if (ev == MG_EV_WS_MSG) {
+    else if (ev == MG_EV_WS_MSG || ev == MG_EV_WS_CTL) {
         struct mg_ws_message* wm = (struct mg_ws_message*)ev_data;
+        WsClient* client = self->_clients.find((uint32_t)c->id);
+        if (client) client->lastSeenMs = (uint32_t)mg_millis();
         // Only handle text frames
         if ((wm->flags & 0x0F) == WEBSOCKET_OP_TEXT) {
             self->handleMessage(c, wm->data.buf, wm->data.len);
@@ -248,6 +626,7 @@ void SimWebServer::eventHandler(struct mg_connection* c, int ev, void* ev_data)
     else if (ev == MG_EV_CLOSE) {
         if (c->is_websocket) {
             printf("[WEB] WebSocket client disconnected\n");
+            self->_clients.remove((uint32_t)c->id);
         }
     }
 }
@@ -3,9 +3,16 @@
 #ifdef SIMULATOR_BUILD
 
 #include "../web_protocol.h"
+#include "../session_export.h"
+#include "../ws_clients.h"
+#include "../broadcast_gate.h"
+#include "../web_assets.h"
+#include "sim_adc_noise.h"
 #include <vector>
 #include <cstdint>
 
+#define SIM_WEB_BUNDLE_DIR  ".pio/web"   // web_assets.py output, relative to firmware/
+
 // Forward declare mongoose struct
 struct mg_mgr;
 
@@ -15,14 +22,34 @@ public:
     ~SimWebServer();
 
     // Initialize HTTP server + WebSocket on given port.
-    // staticDir: path to firmware/data/ for serving web UI files.
-    void begin(int port, const char* staticDir);
+    // staticDir: the web UI to serve: the bundle web_assets.py builds (with
+    // its WEB_ASSET_INDEX, served like the device does) or plain files such
+    // as firmware/data/. embedded: serve the bundle compiled into the
+    // program instead, when there is one (staticDir then only serves files
+    // it doesn't list).
+    void begin(int port, const char* staticDir, bool embedded = false);
 
     // Non-blocking tick — call from main loop
     void tick();
 
-    // Broadcast a data message to all connected WebSocket clients
-    void broadcastData(const bbq_protocol::DataPayload& data);
+    // Offer the latest data (nowMs in simulated time). Adaptive mode sends
+    // it only when the broadcast gate says it changed enough, fixed mode on
+    // every call; the gate is run either way so both rates can be reported.
+    // Clients subscribed at a slower rate get the newest frame from tick().
+    void publishData(const bbq_protocol::DataPayload& data, uint8_t alarmBits, uint32_t nowMs);
+
+    // Offer the PID loop's latest state; tick() sends it to control-channel
+    // subscribers at their own rates
+    void publishControl(const bbq_protocol::ControlPayload& control) { _control = control; }
+    void setAdaptiveBroadcast(bool adaptive) { _adaptive = adaptive; }
+
+    // Synthetic raw ADC source for "diag" subscribers; run only while one is
+    // subscribed
+    void setDiagSource(SimAdcNoise* source) { _diag = source; }
+
+    // Print frames per simulated hour for the adaptive gate and for the
+    // device's fixed WS_SEND_INTERVAL
+    void printBroadcastStats() const;
 
     // Accumulate a history point (called each sim update)
     void addHistoryPoint(const bbq_protocol::HistoryPoint& point);
@@ -52,10 +79,32 @@ public:
 private:
     struct mg_mgr* _mgr;
     char _staticDir[256];
+    WebAssetTable _assets;   // Empty when there is no bundle (plain files)
     int _port;
 
+    // Connected clients and their negotiated frame format
+    WsClientTable _clients;
+    uint8_t _chunkBuf[WS_HISTORY_CHUNK_SIZE];
+    uint64_t _lastPingMs;
+
+    // Change-driven broadcast
+    BroadcastGate _gate;
+    bool     _adaptive;
+    uint32_t _framesSent;
+    uint32_t _firstPublishMs;
+    uint32_t _lastPublishMs;
+
+    // Newest frame of each subscription channel
+    bbq_protocol::DataPayload _data;
+    bool _hasData;
+    bbq_protocol::ControlPayload _control;
+    SimAdcNoise* _diag;
+    uint8_t  _diagSeq;
+    uint64_t _lastDiagMs;
+
     // Session history for replay
     std::vector<bbq_protocol::HistoryPoint> _history;
+    uint32_t _sessionId;    // Timestamp of the session's first point, 0 = none
     float _setpoint;
     float _meat1Target;
     float _meat2Target;
@@ -67,14 +116,44 @@ private:
     void (*_onSessionDownload)();
     void (*_onFanMode)(const char*);
 
+    // Send the newest data frame to every live client it is due (real ms)
+    void sendData(uint32_t nowMs);
+
+    // Send the control state to every subscriber it is due (real ms)
+    void sendControl(uint32_t nowMs);
+
+    // Start or stop the diag source to match its subscribers, and send
+    // what it sampled since the last call as diag frames
+    void sendDiag(uint32_t nowMs);
+
     // Handle incoming WS message
     void handleMessage(struct mg_connection* c, const char* data, size_t len);
 
-    // Send history to a newly connected client
-    void sendHistory(struct mg_connection* c);
+    // Start a chunked replay of the history from index from onwards (an
+    // append when the client already holds the points before it). Chunks go
+    // out from tick() as the connection's send buffer drains.
+    void startReplay(WsClient& client, uint32_t from, bool append);
+
+    // Format the client's next history chunk into _chunkBuf and send it
+    void sendHistoryChunk(struct mg_connection* c, WsClient& client);
+
+    // History once the client's sync arrives (or times out)
+    void sendInitial(struct mg_connection* c, WsClient& client);
+
+    // Answer a client sync: the points it missed if it holds this session,
+    // otherwise the full replay
+    void syncClient(struct mg_connection* c, WsClient& client, uint32_t session, uint32_t since);
+
+    // Connection for a client id, or nullptr if it has gone
+    struct mg_connection* findConnection(uint32_t id) const;
+
+    // Stream the session history as a chunked HTTP download (/api/session.*)
+    void sendSessionExport(struct mg_connection* c, SessionExporter::Format format);
 
-    // Build and send CSV download to a client
-    void sendCSVDownload(struct mg_connection* c);
+    // Send a bundle asset the way the device does: the stored (gzipped) bytes,
+    // sent from the compiled-in table or read from staticDir, with its ETag
+    // and Cache-Control, or an empty 304 if the client has it
+    void sendAsset(struct mg_connection* c, struct mg_http_message* hm, const WebAsset& asset);
 };
 
 // Global pointer for mongoose static callback to access instance
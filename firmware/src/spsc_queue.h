@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Lock-free single-producer / single-consumer ring of fixed-size items.
+// Exactly one thread (or task) may push and exactly one may pop. Holds up to
+// N - 1 items; N must be a power of two. No heap, no locks: the producer
+// publishes with a release store of _head, the consumer with _tail.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    SpscQueue() : _head(0), _tail(0), _highWater(0) {}
+
+    // Producer: copy item in. Returns false if the queue is full.
+    bool push(const T& item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (((head + 1) & MASK) == tail) return false;
+
+        _items[head] = item;
+        _head.store((head + 1) & MASK, std::memory_order_release);
+
+        uint32_t used = (head + 1 - tail) & MASK;
+        if (used > _highWater) _highWater = used;
+        return true;
+    }
+
+    // Consumer: copy the oldest item out. Returns false if the queue is empty.
+    bool pop(T& out) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t head = _head.load(std::memory_order_acquire);
+        if (tail == head) return false;
+
+        out = _items[tail];
+        _tail.store((tail + 1) & MASK, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: oldest item without removing it, or nullptr if empty
+    const T* peek() const {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return nullptr;
+        return &_items[tail];
+    }
+
+    // Approximate when called from a third thread; exact from either end
+    bool empty() const {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire)) & MASK;
+    }
+
+    static constexpr size_t capacity() { return N - 1; }
+
+    // Most items ever queued at once (producer side)
+    uint32_t getHighWater() const { return _highWater; }
+
+private:
+    static constexpr uint32_t MASK = N - 1;
+
+    T _items[N];
+    std::atomic<uint32_t> _head;    // Next slot to write (producer)
+    std::atomic<uint32_t> _tail;    // Next slot to read (consumer)
+    uint32_t _highWater;
+};
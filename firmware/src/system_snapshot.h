@@ -0,0 +1,111 @@
+#pragma once
+
+#include "temp_manager.h"
+#include "alarm_manager.h"
+#include "error_manager.h"
+#include "data_point.h"
+#include "config.h"
+#include <stdint.h>
+
+// Everything the UI, the web server and the cook session show about the
+// smoker, captured in one place at the end of each control cycle and
+// published through a Seqlock. Consumers copy it once and read the copy,
+// instead of calling module getters (and converting units) one value at a
+// time from another task.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+struct SystemSnapshot {
+    uint32_t cycle = 0;                 // Control cycle that published it
+    uint32_t ms = 0;                    // millis() when it was published
+
+    // Probes (temperatures in the configured units)
+    float       temp[NUM_PROBES] = {};
+    ProbeStatus status[NUM_PROBES] = {};
+    bool        connected[NUM_PROBES] = {};
+
+    // Control
+    float setpoint = 0.0f;
+    bool  pitReached = false;
+    float pidOutput = 0.0f;
+    float pTerm = 0.0f;
+    float iTerm = 0.0f;
+    float dTerm = 0.0f;
+    bool  lidOpen = false;
+    float fanPct = 0.0f;
+    float damperPct = 0.0f;
+
+    // Settings changed through commands; settingsVersion moves on each change
+    bool     fahrenheit = true;
+    char     fanMode[CONTROL_COMMAND_TEXT_MAX] = {};
+    uint32_t settingsVersion = 0;
+
+    // Alarms
+    float     meat1Target = 0.0f;
+    float     meat2Target = 0.0f;
+    AlarmType alarms[MAX_ACTIVE_ALARMS] = {};
+    uint8_t   alarmCount = 0;
+
+    // Errors
+    ErrorEntry errors[MAX_ERRORS] = {};
+    uint8_t    errorCount = 0;
+    bool       fireOut = false;
+
+    // Control timing over the current stats window: cycle run time (as of
+    // the previous cycle) and command post-to-apply latency. Only the control
+    // path touches those counters; everyone else reads them here.
+    uint32_t runMaxUs = 0;
+    uint32_t runAvgUs = 0;
+    uint32_t runAllTimeMaxUs = 0;
+    uint32_t latencyMaxUs = 0;
+    uint32_t latencyAvgUs = 0;
+    uint32_t latencyAllTimeMaxUs = 0;
+    uint32_t latencyOverPeriod = 0;     // Commands that waited over one period
+
+    bool hasAlarm(AlarmType type) const {
+        for (uint8_t i = 0; i < alarmCount; i++) {
+            if (alarms[i] == type) return true;
+        }
+        return false;
+    }
+
+    // Bit (1 << AlarmType) per active alarm
+    uint8_t alarmBits() const {
+        uint8_t bits = 0;
+        for (uint8_t i = 0; i < alarmCount; i++) bits |= (uint8_t)(1u << (uint8_t)alarms[i]);
+        return bits;
+    }
+
+    // Bit per probe (pit = 0x01) whose status is not OK
+    uint8_t probeErrorBits() const {
+        uint8_t bits = 0;
+        for (uint8_t i = 0; i < NUM_PROBES; i++) {
+            if (status[i] != ProbeStatus::OK) bits |= (uint8_t)(1u << i);
+        }
+        return bits;
+    }
+
+    // DP_FLAG_* bits for a session record
+    uint8_t dataPointFlags() const {
+        uint8_t flags = 0;
+        if (lidOpen)                   flags |= DP_FLAG_LID_OPEN;
+        if (!connected[PROBE_PIT])     flags |= DP_FLAG_PIT_DISC;
+        if (!connected[PROBE_MEAT1])   flags |= DP_FLAG_MEAT1_DISC;
+        if (!connected[PROBE_MEAT2])   flags |= DP_FLAG_MEAT2_DISC;
+        if (fireOut)                   flags |= DP_FLAG_ERROR_FIREOUT;
+        if (hasAlarm(AlarmType::PIT_HIGH) ||
+            hasAlarm(AlarmType::PIT_LOW))    flags |= DP_FLAG_ALARM_PIT;
+        if (hasAlarm(AlarmType::MEAT1_DONE)) flags |= DP_FLAG_ALARM_MEAT1;
+        if (hasAlarm(AlarmType::MEAT2_DONE)) flags |= DP_FLAG_ALARM_MEAT2;
+        return flags;
+    }
+
+    // Session record for the current moment (timestamp left to the caller)
+    void toDataPoint(DataPoint& dp) const {
+        dp.pitTemp   = (int16_t)(temp[PROBE_PIT] * 10.0f);
+        dp.meat1Temp = (int16_t)(temp[PROBE_MEAT1] * 10.0f);
+        dp.meat2Temp = (int16_t)(temp[PROBE_MEAT2] * 10.0f);
+        dp.fanPct    = (uint8_t)fanPct;
+        dp.damperPct = (uint8_t)damperPct;
+        dp.flags     = dataPointFlags();
+    }
+};
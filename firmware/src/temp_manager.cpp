@@ -4,6 +4,9 @@
 #include <Arduino.h>
 #endif
 
+static_assert(TEMP_AVG_SAMPLES >= 1 && TEMP_AVG_SAMPLES <= OVERSAMPLE_MAX_SAMPLES,
+              "TEMP_AVG_SAMPLES must be 1 to OVERSAMPLE_MAX_SAMPLES");
+
 // ADC channel mapping: probe index -> ADS1115 channel
 const uint8_t TempManager::_adcChannels[NUM_PROBES] = {
     ADC_CHANNEL_PIT,
@@ -11,12 +14,31 @@ const uint8_t TempManager::_adcChannels[NUM_PROBES] = {
     ADC_CHANNEL_MEAT2
 };
 
+const uint8_t TempManager::_scanChannels[NUM_PROBES + 1] = {
+    ADC_CHANNEL_PIT,
+    ADC_CHANNEL_MEAT1,
+    ADC_CHANNEL_MEAT2,
+    ADC_CHANNEL_SPARE
+};
+
 TempManager::TempManager()
-    : _emaAlpha(TEMP_EMA_ALPHA)
+    :
+#ifndef NATIVE_BUILD
+      _adc(_ads)
+    , _scanner(_adc, _scanChannels, NUM_PROBES + 1, ADC_CONVERSION_TIMEOUT_US, TEMP_AVG_SAMPLES)
+    , _busLock(nullptr)
+    , _diagTask(nullptr)
+    , _busTaken(false)
+    ,
+#endif
+      _diagOn(false)
+    , _spareRaw(0)
+    , _emaAlpha(TEMP_EMA_ALPHA)
     , _useFahrenheit(true)
     , _lastSampleMs(0)
 {
     for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        _diagLatest[i].store(DIAG_NONE);
         _rawADC[i] = 0;
         _filteredTempC[i] = 0.0f;
         _status[i] = ProbeStatus::OPEN_CIRCUIT;
@@ -27,6 +49,7 @@ TempManager::TempManager()
 
 bool TempManager::begin() {
 #ifndef NATIVE_BUILD
+    if (!_busLock) _busLock = xSemaphoreCreateMutex();
     Wire.begin(PIN_SDA, PIN_SCL);
 
     if (!_ads.begin(ADS1115_ADDR, &Wire)) {
@@ -36,8 +59,11 @@ bool TempManager::begin() {
 
     // Set gain to GAIN_ONE (+/- 4.096V range)
     _ads.setGain(GAIN_ONE);
+    _ads.setDataRate(RATE_ADS1115_128SPS);
+    _adc.begin();
 
-    Serial.println("[TEMP] ADS1115 initialized OK.");
+    Serial.printf("[TEMP] ADS1115 initialized OK (%s).\n",
+                  PIN_ADC_RDY >= 0 ? "ALERT/RDY interrupt" : "polled");
 #endif
     _lastSampleMs = 0;
     return true;
@@ -46,55 +72,244 @@ bool TempManager::begin() {
 void TempManager::update() {
 #ifndef NATIVE_BUILD
     unsigned long now = millis();
-    if (now - _lastSampleMs < TEMP_SAMPLE_INTERVAL_MS) {
-        return;  // Not time to sample yet
+    bool due = now - _lastSampleMs >= TEMP_SAMPLE_INTERVAL_MS;
+    if (!due && !_scanner.busy()) {
+        return;  // Nothing to start or collect
     }
-    _lastSampleMs = now;
 
-    for (uint8_t i = 0; i < NUM_PROBES; i++) {
-        // Read raw ADC value from ADS1115 single-ended
-        int16_t raw = _ads.readADC_SingleEnded(_adcChannels[i]);
-        _rawADC[i] = raw;
-
-        // Check for probe errors
-        if (raw >= ERROR_PROBE_OPEN_THRESHOLD) {
-            _status[i] = ProbeStatus::OPEN_CIRCUIT;
-            _firstReading[i] = true;  // Reset EMA on reconnect
-            continue;
-        }
-        if (raw <= ERROR_PROBE_SHORT_THRESHOLD) {
-            _status[i] = ProbeStatus::SHORT_CIRCUIT;
-            _firstReading[i] = true;
-            continue;
+    // The diagnostic task holds the bus while it streams: take its newest
+    // sample of each probe rather than wait for it
+    if (_busLock && xSemaphoreTake(_busLock, 0) != pdTRUE) {
+        _scanner.abort();
+        if (due) {
+            _lastSampleMs = now;
+            for (uint8_t i = 0; i < NUM_PROBES; i++) {
+                int16_t raw = _diagLatest[i].load();
+                if (raw != DIAG_NONE) applyReading(i, raw);
+            }
         }
+        return;
+    }
 
-        // Convert ADC to resistance
-        float resistance = adcToResistance(raw);
-        if (resistance <= 0.0f) {
-            _status[i] = ProbeStatus::SHORT_CIRCUIT;
-            _firstReading[i] = true;
-            continue;
-        }
+    // A diagnostic stream that ran since the last call started conversions
+    // of its own; the one this sweep is waiting on is gone
+    if (_busTaken.exchange(false)) _scanner.abort();
 
-        // Convert resistance to temperature in Celsius
-        float tempC = resistanceToTempC(resistance, _probeConfig[i]);
+    uint32_t us = micros();
+    if (due) {
+        _lastSampleMs = now;
+        _scanner.requestSweep(us);
+    }
+    if (_scanner.poll(us)) applySweep();
+    if (_busLock) xSemaphoreGive(_busLock);
+#endif
+}
 
-        // Apply calibration offset
-        tempC += _probeConfig[i].offset;
+void TempManager::applySweep() {
+#ifndef NATIVE_BUILD
+    for (uint8_t i = 0; i < NUM_PROBES; i++) {
+        if (!_scanner.isValid(i)) continue;
+        OversampleResult r = oversampleReduce(_scanner.getSamples(i), _scanner.getSampleCount(i),
+                                              (OutlierFilter)TEMP_OUTLIER_FILTER,
+                                              TEMP_HAMPEL_K, TEMP_HAMPEL_MIN_SPREAD);
+        _noise[i].record(r);
+        applyReading(i, r.value);
+    }
+    if (_scanner.isValid(NUM_PROBES)) _spareRaw = _scanner.getRaw(NUM_PROBES);
+#endif
+}
 
-        // Apply EMA filter
-        if (_firstReading[i]) {
-            _filteredTempC[i] = tempC;
-            _firstReading[i] = false;
-        } else {
-            _filteredTempC[i] = _emaAlpha * tempC + (1.0f - _emaAlpha) * _filteredTempC[i];
-        }
+const AdcScanStats& TempManager::getScanStats() const {
+#ifndef NATIVE_BUILD
+    return _scanner.getStats();
+#else
+    static const AdcScanStats none;
+    return none;
+#endif
+}
+
+const ProbeNoise& TempManager::getNoise(uint8_t probe) const {
+    return _noise[probe < NUM_PROBES ? probe : 0];
+}
+
+uint32_t TempManager::getRdyMissed() const {
+#ifndef NATIVE_BUILD
+    return _adc.getRdyMissed();
+#else
+    return 0;
+#endif
+}
+
+uint32_t TempManager::getRdySpurious() const {
+#ifndef NATIVE_BUILD
+    return _adc.getRdySpurious();
+#else
+    return 0;
+#endif
+}
+
+void TempManager::applyReading(uint8_t i, int16_t raw) {
+    _rawADC[i] = raw;
+
+    // Check for probe errors
+    if (raw >= ERROR_PROBE_OPEN_THRESHOLD) {
+        _status[i] = ProbeStatus::OPEN_CIRCUIT;
+        _firstReading[i] = true;  // Reset EMA on reconnect
+        return;
+    }
+    if (raw <= ERROR_PROBE_SHORT_THRESHOLD) {
+        _status[i] = ProbeStatus::SHORT_CIRCUIT;
+        _firstReading[i] = true;
+        return;
+    }
 
-        _status[i] = ProbeStatus::OK;
+    // Convert ADC to resistance
+    float resistance = adcToResistance(raw);
+    if (resistance <= 0.0f) {
+        _status[i] = ProbeStatus::SHORT_CIRCUIT;
+        _firstReading[i] = true;
+        return;
+    }
+
+    // Convert resistance to temperature in Celsius
+    float tempC = resistanceToTempC(resistance, _probeConfig[i]);
+
+    // Apply calibration offset
+    tempC += _probeConfig[i].offset;
+
+    // Apply EMA filter
+    if (_firstReading[i]) {
+        _filteredTempC[i] = tempC;
+        _firstReading[i] = false;
+    } else {
+        _filteredTempC[i] = _emaAlpha * tempC + (1.0f - _emaAlpha) * _filteredTempC[i];
+    }
+
+    _status[i] = ProbeStatus::OK;
+}
+
+// ---------------------------------------------------------------------------
+// Diagnostic stream
+// ---------------------------------------------------------------------------
+void TempManager::setDiagnostic(bool on) {
+    if (on == _diagOn.load()) return;
+    for (uint8_t i = 0; i < NUM_PROBES; i++) _diagLatest[i].store(DIAG_NONE);
+
+#ifndef NATIVE_BUILD
+    if (on) {
+        if (!_busLock) return;  // begin() not run
+        if (!_diagTask) {
+            // Core 0 with the session writer, so the control path on core 1
+            // (the control task, or loop() with CONTROL_TASK=0) only ever
+            // sees the bus lock taken, never a conversion
+            BaseType_t ok = xTaskCreatePinnedToCore(diagTaskMain, "adc_diag",
+                                                    TEMP_DIAG_STACK, this,
+                                                    TEMP_DIAG_PRIORITY, &_diagTask, 0);
+            if (ok != pdPASS) {
+                _diagTask = nullptr;
+                Serial.println("[TEMP] Diagnostic task failed to start.");
+                return;
+            }
+        }
+        _diagOn.store(true);
+        xTaskNotifyGive(_diagTask);
+        Serial.println("[TEMP] Diagnostic stream on.");
+        return;
     }
+    _diagOn.store(false);
+    Serial.printf("[TEMP] Diagnostic stream off: %u samples, %u dropped.\n",
+                  _diagRing.getPushed(), _diagRing.getDropped());
+#else
+    _diagOn.store(on);
 #endif
 }
 
+#ifndef NATIVE_BUILD
+void TempManager::diagTaskMain(void* arg) {
+    TempManager* self = static_cast<TempManager*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (self->_diagOn.load()) self->runDiagnostic();
+    }
+}
+
+void TempManager::runDiagnostic() {
+    // Waits for update() to let go of the bus (it never holds it across a
+    // conversion), then keeps it until the stream is switched off
+    xSemaphoreTake(_busLock, portMAX_DELAY);
+    _busTaken.store(true);
+    _ads.setDataRate(RATE_ADS1115_860SPS);
+
+    uint8_t i = 0;
+    while (_diagOn.load()) {
+        // Sleep through each ~1.2 ms conversion rather than poll the bus for
+        // it, leaving core 0 to WiFi and the session writer
+        _ads.startADCReading(MUX_BY_CHANNEL[_adcChannels[i]], false);
+        do {
+            vTaskDelay(1);
+        } while (!_ads.conversionComplete());
+
+        AdcSample s;
+        s.us = micros();
+        s.probe = i;
+        s.raw = _ads.getLastConversionResults();
+        s.ohms = adcToResistance(s.raw);
+        _diagLatest[i].store(s.raw);
+        _diagRing.push(s);
+        i = (i + 1) % NUM_PROBES;
+    }
+
+    _ads.setDataRate(RATE_ADS1115_128SPS);
+    xSemaphoreGive(_busLock);
+}
+
+// ---------------------------------------------------------------------------
+// ADS1115 single-shot conversions for the scanner
+// ---------------------------------------------------------------------------
+void IRAM_ATTR Ads1115Adc::onReady(void* arg) {
+    static_cast<Ads1115Adc*>(arg)->_rdy = true;
+}
+
+void Ads1115Adc::begin() {
+    if (PIN_ADC_RDY < 0) return;
+    // startADCReading() sets the comparator thresholds that turn ALERT/RDY
+    // into a conversion-ready output
+    pinMode(PIN_ADC_RDY, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(PIN_ADC_RDY), onReady, this, FALLING);
+}
+
+bool Ads1115Adc::start(uint8_t channel) {
+    if (channel > 3) return false;
+    _rdy = false;
+    _startUs = micros();
+    _ads.startADCReading(MUX_BY_CHANNEL[channel], false);
+    return true;
+}
+
+bool Ads1115Adc::ready() {
+    if (PIN_ADC_RDY < 0) return _ads.conversionComplete();
+
+    // An edge says to look; the OS bit says the conversion is done. One
+    // config-register read per conversion, where polling takes one per tick.
+    if (_rdy) {
+        _rdy = false;
+        if (_ads.conversionComplete()) return true;
+        _rdySpurious++;
+        return false;
+    }
+
+    // No edge yet: still converting, or ALERT/RDY isn't wired
+    if (micros() - _startUs < ADC_CONVERSION_US + ADC_CONVERSION_US / 4) return false;
+    if (!_ads.conversionComplete()) return false;
+    _rdyMissed++;
+    return true;
+}
+
+int16_t Ads1115Adc::read() {
+    return _ads.getLastConversionResults();
+}
+#endif
+
 float TempManager::getTemp(uint8_t probe) const {
     if (probe >= NUM_PROBES) return 0.0f;
     if (_status[probe] != ProbeStatus::OK) return 0.0f;
@@ -159,8 +374,8 @@ float TempManager::adcToResistance(int16_t raw) const {
     //   Vout = Vcc * R_ref / (R_ref + R_therm)
     //   raw / ADC_MAX = R_ref / (R_ref + R_therm)
     //   R_therm = R_ref * (ADC_MAX / raw - 1)
-    if (raw <= 0) return 0.0f;
-    return REFERENCE_RESISTANCE * ((float)ADC_MAX_VALUE / (float)raw - 1.0f);
+    // (shared with the diagnostic stream and the simulator, see adc_diag.h)
+    return adcCountsToOhms(raw);
 }
 
 float TempManager::resistanceToTempC(float resistance, const ProbeConfig& cfg) const {
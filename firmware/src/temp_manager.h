@@ -2,12 +2,19 @@
 
 #include "config.h"
 #include "units.h"
+#include "adc_diag.h"
+#include "adc_scanner.h"
+#include "oversample_filter.h"
+#include <atomic>
 #include <stdint.h>
 #include <math.h>
 
 #ifndef NATIVE_BUILD
 #include <Wire.h>
 #include <Adafruit_ADS1X15.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #endif
 
 // Number of probe channels
@@ -27,6 +34,41 @@ enum class ProbeStatus : uint8_t {
     SHORT_CIRCUIT    // ADC reads very low (probe shorted)
 };
 
+#ifndef NATIVE_BUILD
+// ADS1115 single-shot conversions for the AdcScanner. ready() takes the
+// ALERT/RDY edge when PIN_ADC_RDY is wired, confirmed by the conversion's
+// OS bit so noise on the pin never returns an unfinished (previous
+// channel's) result; with no edge by the time a conversion is overdue it
+// asks the ADS1115 over I2C and counts the miss.
+class Ads1115Adc {
+public:
+    explicit Ads1115Adc(Adafruit_ADS1115& ads)
+        : _ads(ads), _rdy(false), _startUs(0), _rdyMissed(0), _rdySpurious(0) {}
+
+    // Attach the ALERT/RDY interrupt. Call after the ADS1115 is found.
+    void begin();
+
+    bool    start(uint8_t channel);
+    bool    ready();
+    int16_t read();
+
+    // Conversions that finished without an ALERT/RDY edge
+    uint32_t getRdyMissed() const { return _rdyMissed; }
+
+    // Edges that came while the conversion was still running
+    uint32_t getRdySpurious() const { return _rdySpurious; }
+
+private:
+    static void onReady(void* arg);   // ALERT/RDY falling edge (ISR)
+
+    Adafruit_ADS1115& _ads;
+    volatile bool _rdy;
+    uint32_t _startUs;
+    uint32_t _rdyMissed;
+    uint32_t _rdySpurious;
+};
+#endif
+
 // Per-probe calibration and Steinhart-Hart coefficients
 struct ProbeConfig {
     float a      = THERM_A;
@@ -42,7 +84,13 @@ public:
     // Initialize ADS1115 on I2C bus. Call once from setup().
     bool begin();
 
-    // Poll probes if the sample interval has elapsed. Call every loop().
+    // Acquire the probes without waiting on the ADC. Every
+    // TEMP_SAMPLE_INTERVAL_MS a sweep over the probes and the spare input
+    // starts, going round them TEMP_AVG_SAMPLES times; each call then
+    // collects at most one finished conversion and starts the next. When the
+    // sweep is done each probe's conversions are filtered into one reading
+    // (TEMP_OUTLIER_FILTER) and applied. Call every control cycle: with a
+    // 10 ms cycle and four samples one sweep takes sixteen.
     void update();
 
     // Latest smoothed temperature for a given probe (in configured units: F or C)
@@ -65,6 +113,33 @@ public:
     // Raw ADC value (useful for diagnostics)
     int16_t getRawADC(uint8_t probe) const;
 
+    // Raw count on the spare input (ADC_CHANNEL_SPARE) from the last sweep
+    int16_t getSpareRaw() const { return _spareRaw; }
+
+    // Acquisition counters (sweeps, conversions, timeouts, conversion time)
+    const AdcScanStats& getScanStats() const;
+
+    // Oversampling noise for a probe: outliers rejected, spread of the rest
+    const ProbeNoise& getNoise(uint8_t probe) const;
+
+    // Conversions collected without an ALERT/RDY edge (0 when it is wired),
+    // and edges ignored because the conversion had not finished
+    uint32_t getRdyMissed() const;
+    uint32_t getRdySpurious() const;
+
+    // Diagnostic stream. While on, a task on core 0 owns the ADS1115 and
+    // converts the probes round-robin at its 860 SPS data rate (several
+    // hundred samples a second in all), pushing every raw count and its
+    // resistance into a ring; update() keeps its once-per-interval
+    // cadence but takes each probe's newest sample instead of reading the
+    // bus, so the control loop never waits on a conversion.
+    void setDiagnostic(bool on);
+    bool isDiagnostic() const { return _diagOn.load(); }
+
+    // Move up to max queued samples into out (loop side). Returns the count.
+    uint16_t readDiagnostic(AdcSample* out, uint16_t max) { return _diagRing.drain(out, max); }
+    const AdcDiagRing& getDiagRing() const { return _diagRing; }
+
     // Set EMA alpha (smoothing factor, 0-1, higher = less smoothing)
     void setEMAAlpha(float alpha);
 
@@ -87,15 +162,39 @@ private:
     // Convert resistance to temperature in Celsius using Steinhart-Hart
     float resistanceToTempC(float resistance, const ProbeConfig& cfg) const;
 
+    // Classify a raw reading, then convert and filter it into the probe's state
+    void applyReading(uint8_t probe, int16_t raw);
+
+    // Apply every valid reading of the sweep just completed
+    void applySweep();
+
 #ifndef NATIVE_BUILD
+    static void diagTaskMain(void* arg);
+
+    // Sample until the diagnostic stream is switched off (diagnostic task)
+    void runDiagnostic();
+
     Adafruit_ADS1115 _ads;
+    Ads1115Adc _adc;
+    AdcScanner<Ads1115Adc> _scanner;
+    SemaphoreHandle_t _busLock;     // Held by whoever talks to the ADS1115
+    TaskHandle_t _diagTask;
+    std::atomic<bool> _busTaken;    // The diagnostic stream has used the ADS1115
 #endif
 
+    // Diagnostic stream
+    AdcDiagRing _diagRing;
+    std::atomic<bool> _diagOn;
+    std::atomic<int16_t> _diagLatest[NUM_PROBES];   // Newest sample, DIAG_NONE until one lands
+    static const int16_t DIAG_NONE = INT16_MIN;
+
     // Per-probe state
     int16_t     _rawADC[NUM_PROBES];
     float       _filteredTempC[NUM_PROBES];
     ProbeStatus _status[NUM_PROBES];
     ProbeConfig _probeConfig[NUM_PROBES];
+    ProbeNoise  _noise[NUM_PROBES];
+    int16_t     _spareRaw;
 
     // EMA smoothing factor
     float _emaAlpha;
@@ -111,4 +210,7 @@ private:
 
     // ADC channel mapping
     static const uint8_t _adcChannels[NUM_PROBES];
+
+    // Channels a sweep converts, in order: the probes, then the spare input
+    static const uint8_t _scanChannels[NUM_PROBES + 1];
 };
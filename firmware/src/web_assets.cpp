@@ -0,0 +1,130 @@
+#include "web_assets.h"
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Split the next whitespace-separated field off *p (bounded by end) and
+// NUL-terminate it in place. Returns nullptr at the end of the line.
+static char* nextField(char** p, char* end) {
+    char* s = *p;
+    while (s < end && isSpace(*s)) s++;
+    if (s >= end || *s == '\n' || *s == '\0') {
+        *p = s;
+        return nullptr;
+    }
+    char* e = s;
+    while (e < end && !isSpace(*e) && *e != '\n' && *e != '\0') e++;
+    bool eol = e >= end || *e == '\n' || *e == '\0';
+    if (e < end) *e = '\0';
+    *p = eol ? e : e + 1;
+    return s;
+}
+
+// ---------------------------------------------------------------------------
+// WebAssetTable
+// ---------------------------------------------------------------------------
+
+WebAssetTable::WebAssetTable()
+    : _count(0)
+{
+    memset(_text, 0, sizeof(_text));
+}
+
+uint8_t WebAssetTable::load(const char* text, size_t len) {
+    _count = 0;
+    if (!text || len == 0 || len >= sizeof(_text)) return 0;
+
+    memcpy(_text, text, len);
+    _text[len] = '\0';
+
+    char* p = _text;
+    char* end = _text + len;
+    while (p < end) {
+        char* line = p;
+        char* eol = (char*)memchr(line, '\n', end - line);
+        if (!eol) eol = end;
+        p = eol + 1;
+        *eol = '\0';
+        if (*line == '#') continue;
+
+        char* f = line;
+        char* url   = nextField(&f, eol);
+        char* file  = nextField(&f, eol);
+        char* etag  = nextField(&f, eol);
+        char* type  = nextField(&f, eol);
+        char* flags = nextField(&f, eol);
+        if (!flags || url[0] != '/' || file[0] != '/' || etag[0] != '"') continue;
+
+        if (_count >= WEB_ASSET_MAX) {
+            _count = 0;
+            return 0;
+        }
+        WebAsset& a = _assets[_count++];
+        a.url = url;
+        a.file = file;
+        a.etag = etag;
+        a.type = type;
+        a.gzip = strchr(flags, 'g') != nullptr;
+        a.immutable = strchr(flags, 'i') != nullptr;
+        a.data = nullptr;
+        a.size = 0;
+    }
+    return _count;
+}
+
+uint8_t WebAssetTable::loadPacked(const WebAsset* assets, uint8_t count) {
+    _count = 0;
+    if (!assets || count > WEB_ASSET_MAX) return 0;
+    for (uint8_t i = 0; i < count; i++) _assets[i] = assets[i];
+    _count = count;
+    return _count;
+}
+
+const WebAsset* WebAssetTable::find(const char* path, size_t len) const {
+    if (len == 1 && path[0] == '/') {
+        path = "/index.html";
+        len = strlen(path);
+    }
+    for (uint8_t i = 0; i < _count; i++) {
+        const char* url = _assets[i].url;
+        if (strlen(url) == len && memcmp(url, path, len) == 0) return &_assets[i];
+    }
+    return nullptr;
+}
+
+WebAssetReply WebAssetTable::reply(const WebAsset& asset, const char* ifNoneMatch, size_t len) {
+    WebAssetReply r;
+    r.status = (ifNoneMatch && etagMatches(ifNoneMatch, len, asset.etag)) ? 304 : 200;
+    r.cacheControl = asset.immutable ? WEB_CACHE_IMMUTABLE : WEB_CACHE_REVALIDATE;
+    return r;
+}
+
+bool WebAssetTable::etagMatches(const char* header, size_t len, const char* etag) {
+    size_t etagLen = strlen(etag);
+    size_t i = 0;
+    while (i < len) {
+        // One comma-separated entry, trimmed
+        while (i < len && (header[i] == ' ' || header[i] == '\t' || header[i] == ',')) i++;
+        size_t start = i;
+        while (i < len && header[i] != ',') i++;
+        size_t stop = i;
+        while (stop > start && (header[stop - 1] == ' ' || header[stop - 1] == '\t')) stop--;
+        if (stop == start) continue;
+
+        const char* tag = header + start;
+        size_t tagLen = stop - start;
+        if (tagLen == 1 && tag[0] == '*') return true;
+        if (tagLen > 2 && tag[0] == 'W' && tag[1] == '/') {
+            tag += 2;
+            tagLen -= 2;
+        }
+        if (tagLen == etagLen && memcmp(tag, etag, etagLen) == 0) return true;
+    }
+    return false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "config.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// One file of the web UI bundle, as listed in the bundle's index
+struct WebAsset {
+    const char* url;        // Request path, e.g. "/app.5558ca3b79.js"
+    const char* file;       // Stored file, e.g. "/app.5558ca3b79.js.gz"
+    const char* etag;       // Strong validator, quoted
+    const char* type;       // Content-Type
+    bool gzip;              // Stored gzipped (send Content-Encoding: gzip)
+    bool immutable;         // Fingerprinted: the content never changes under this URL
+    const uint8_t* data;    // Stored bytes when compiled into the image, else nullptr
+    uint32_t size;          // Length of data
+};
+
+// What to answer a GET for an asset
+struct WebAssetReply {
+    int status;                 // 200, or 304 when the client's copy is current
+    const char* cacheControl;   // Cache-Control value for either status
+};
+
+// The web UI bundle's asset table, loaded from the index web_assets.py writes
+// next to the assets (WEB_ASSET_INDEX). Each line is
+//   <url> <file> <etag> <type> <flags>
+// with flags g (gzip) and i (immutable), or "-"; lines starting with # are
+// comments. Or, with WEB_ASSETS_EMBEDDED, the same assets compiled into the
+// image as a const table (see packedWebAssets()). Both the device and the
+// simulator serve the bundle through it, so they send the same encoding,
+// validators and caching policy.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class WebAssetTable {
+public:
+    WebAssetTable();
+
+    // Replace the table with the assets listed in text. Malformed lines are
+    // skipped. Returns the number of assets loaded; 0 if none, or if the
+    // index is longer than WEB_ASSET_INDEX_MAX or lists more than WEB_ASSET_MAX
+    // assets (a partial table would hide files the bundle does have).
+    uint8_t load(const char* text, size_t len);
+
+    // Replace the table with count assets held in memory (data set). Returns
+    // the number loaded; 0 if count exceeds WEB_ASSET_MAX.
+    uint8_t loadPacked(const WebAsset* assets, uint8_t count);
+
+    // Asset for a request path ("/" serves /index.html), or nullptr
+    const WebAsset* find(const char* path, size_t len) const;
+
+    uint8_t size() const { return _count; }
+    const WebAsset& at(uint8_t i) const { return _assets[i]; }
+
+    // Status and caching for a request carrying the given If-None-Match
+    // header (nullptr/0 if none)
+    static WebAssetReply reply(const WebAsset& asset, const char* ifNoneMatch, size_t len);
+
+    // Whether an If-None-Match header value matches etag: "*", or any entry
+    // of its list, compared weakly (a W/ prefix is ignored)
+    static bool etagMatches(const char* header, size_t len, const char* etag);
+
+private:
+    char     _text[WEB_ASSET_INDEX_MAX];   // Index text, split in place
+    WebAsset _assets[WEB_ASSET_MAX];
+    uint8_t  _count;
+};
+
+// The web UI bundle compiled into the image by web_assets.py (rodata: read in
+// place from flash on the device). Sets count; nullptr and 0 when the build
+// has WEB_ASSETS_EMBEDDED=0 or no generated table.
+const WebAsset* packedWebAssets(uint8_t* count);
@@ -0,0 +1,18 @@
+#include "web_assets.h"
+
+// web_assets.py generates the table into .pio/web_packed/ (on the include
+// path) before each build. Without it the web UI is served from the
+// filesystem as with WEB_ASSETS_EMBEDDED=0.
+#if WEB_ASSETS_EMBEDDED && __has_include("web_assets_packed.h")
+#include "web_assets_packed.h"
+
+const WebAsset* packedWebAssets(uint8_t* count) {
+    *count = (uint8_t)(sizeof(WEB_ASSETS_PACKED) / sizeof(WEB_ASSETS_PACKED[0]));
+    return WEB_ASSETS_PACKED;
+}
+#else
+const WebAsset* packedWebAssets(uint8_t* count) {
+    *count = 0;
+    return nullptr;
+}
+#endif
@@ -1,5 +1,4 @@
 #include "web_protocol.h"
-#include <ArduinoJson.h>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -8,242 +7,360 @@
 namespace bbq_protocol {
 
 // ---------------------------------------------------------------------------
-// buildDataMessage — periodic data broadcast
+// parseCommand — single-pass scan of an incoming command
 // ---------------------------------------------------------------------------
-// Helper: format float with 1 decimal place into a small buffer
-static void fmtTemp(char* out, size_t sz, float val) {
-    snprintf(out, sz, "%.1f", val);
-}
-
-size_t buildDataMessage(char* buf, size_t bufSize, const DataPayload& d) {
-    JsonDocument doc;
-    doc["type"] = "data";
-    doc["ts"] = d.ts;
-
-    // Temperatures: NAN → null, -1 → -1 (shorted), else value with 1 decimal
-    // Use separate buffers since serialized() stores a pointer until serializeJson
-    char pitStr[16], m1Str[16], m2Str[16];
-
-    if (std::isnan(d.pit))    doc["pit"] = (const char*)nullptr;
-    else if (d.pit == -1.0f)  doc["pit"] = -1;
-    else { fmtTemp(pitStr, sizeof(pitStr), d.pit); doc["pit"] = serialized(pitStr); }
-
-    if (std::isnan(d.meat1))   doc["meat1"] = (const char*)nullptr;
-    else if (d.meat1 == -1.0f) doc["meat1"] = -1;
-    else { fmtTemp(m1Str, sizeof(m1Str), d.meat1); doc["meat1"] = serialized(m1Str); }
-
-    if (std::isnan(d.meat2))   doc["meat2"] = (const char*)nullptr;
-    else if (d.meat2 == -1.0f) doc["meat2"] = -1;
-    else { fmtTemp(m2Str, sizeof(m2Str), d.meat2); doc["meat2"] = serialized(m2Str); }
-
-    doc["fan"] = (int)d.fan;
-    doc["damper"] = (int)d.damper;
-    doc["sp"] = (int)d.sp;
-    doc["lid"] = d.lid;
-    if (d.fanMode) doc["fanMode"] = d.fanMode;
-
-    // Meat targets: 0 → null
-    if (d.meat1Target > 0)  doc["meat1Target"] = (int)d.meat1Target;
-    else                    doc["meat1Target"] = (const char*)nullptr;
-
-    if (d.meat2Target > 0)  doc["meat2Target"] = (int)d.meat2Target;
-    else                    doc["meat2Target"] = (const char*)nullptr;
-
-    // Estimated done time
-    if (d.est > 0)  doc["est"] = d.est;
-    else            doc["est"] = (const char*)nullptr;
-
-    // Errors array
-    JsonArray errors = doc["errors"].to<JsonArray>();
-    for (uint8_t i = 0; i < d.errorCount && i < 8; i++) {
-        errors.add(d.errors[i]);
-    }
-
-    return serializeJson(doc, buf, bufSize);
-}
-
-// ---------------------------------------------------------------------------
-// buildSessionReset — server confirms new session
-// ---------------------------------------------------------------------------
-size_t buildSessionReset(char* buf, size_t bufSize, float setpoint) {
-    JsonDocument doc;
-    doc["type"] = "session";
-    doc["action"] = "reset";
-    doc["sp"] = (int)setpoint;
-    return serializeJson(doc, buf, bufSize);
-}
-
-// ---------------------------------------------------------------------------
-// buildHistoryMessage — replay session data on connect
-//
-// Builds JSON incrementally with snprintf to avoid ArduinoJson overhead
-// for potentially hundreds of data points (~110 bytes per point).
-// ---------------------------------------------------------------------------
-char* buildHistoryMessage(const HistoryPoint* points, size_t count,
-                          float sp, float meat1Target, float meat2Target,
-                          size_t* outLen) {
-    // Estimate buffer size: envelope ~128 bytes, ~120 bytes per point
-    size_t estSize = 256 + count * 130;
-    char* buf = (char*)malloc(estSize);
-    if (!buf) {
-        if (outLen) *outLen = 0;
+// Commands are one flat object with a handful of known keys, so rather than
+// building a document the scanner walks the frame once, keeps the values of
+// the keys it knows and skips everything else (nested values included). It
+// works on the caller's bytes (no NUL needed) and never allocates. Frames over
+// WS_CMD_MAX_LEN, malformed JSON and nesting deeper than CMD_MAX_DEPTH parse
+// as UNKNOWN.
+
+static const uint8_t CMD_MAX_DEPTH = 8;
+
+namespace {
+
+enum class ValueKind : uint8_t { ABSENT, NUMBER, STRING, NUL, LIST, OTHER };
+
+struct ScannedValue {
+    ValueKind kind;
+    double    number;
+    bool      integral;
+    char      str[20];      // Longer strings are truncated
+    uint8_t   channels;     // LIST: bit per Channel named by its strings
+};
+
+// Values of the keys parseCommand looks at
+struct CommandFields {
+    ScannedValue type, sp, meat1Target, meat2Target, pitBand, fanMode;
+    ScannedValue bin, session, since, action, format, channels, rateMs;
+
+    ScannedValue* find(const char* key) {
+        if (strcmp(key, "type") == 0)        return &type;
+        if (strcmp(key, "sp") == 0)          return &sp;
+        if (strcmp(key, "meat1Target") == 0) return &meat1Target;
+        if (strcmp(key, "meat2Target") == 0) return &meat2Target;
+        if (strcmp(key, "pitBand") == 0)     return &pitBand;
+        if (strcmp(key, "fanMode") == 0)     return &fanMode;
+        if (strcmp(key, "bin") == 0)         return &bin;
+        if (strcmp(key, "session") == 0)     return &session;
+        if (strcmp(key, "since") == 0)       return &since;
+        if (strcmp(key, "action") == 0)      return &action;
+        if (strcmp(key, "format") == 0)      return &format;
+        if (strcmp(key, "channels") == 0)    return &channels;
+        if (strcmp(key, "rateMs") == 0)      return &rateMs;
         return nullptr;
     }
+};
+
+class CommandScanner {
+public:
+    CommandScanner(const char* data, size_t len) : _p(data), _end(data + len) {}
+
+    // Scan the top-level object into f. Returns false if it is malformed.
+    bool scan(CommandFields& f) {
+        skipSpace();
+        if (!consume('{')) return false;
+        skipSpace();
+        if (consume('}')) return true;
+
+        for (;;) {
+            char key[16];
+            size_t keyLen = 0;
+            skipSpace();
+            if (!parseString(key, sizeof(key), keyLen)) return false;
+            skipSpace();
+            if (!consume(':')) return false;
+            skipSpace();
+
+            ScannedValue* v = keyLen < sizeof(key) ? f.find(key) : nullptr;
+            if (!parseValue(v, 1)) return false;
+
+            skipSpace();
+            if (consume('}')) return true;
+            if (!consume(',')) return false;
+        }
+    }
 
-    size_t pos = 0;
-
-    // Header
-    pos += snprintf(buf + pos, estSize - pos,
-        "{\"type\":\"history\",\"sp\":%d", (int)sp);
-
-    if (meat1Target > 0)
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat1Target\":%d", (int)meat1Target);
-    else
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat1Target\":null");
-
-    if (meat2Target > 0)
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat2Target\":%d", (int)meat2Target);
-    else
-        pos += snprintf(buf + pos, estSize - pos, ",\"meat2Target\":null");
+private:
+    void skipSpace() {
+        while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) _p++;
+    }
 
-    pos += snprintf(buf + pos, estSize - pos, ",\"data\":[");
+    bool consume(char c) {
+        if (_p < _end && *_p == c) {
+            _p++;
+            return true;
+        }
+        return false;
+    }
 
-    // Data points
-    for (size_t i = 0; i < count; i++) {
-        const HistoryPoint& p = points[i];
-        if (i > 0) buf[pos++] = ',';
+    bool literal(const char* lit) {
+        size_t n = strlen(lit);
+        if ((size_t)(_end - _p) < n || memcmp(_p, lit, n) != 0) return false;
+        _p += n;
+        return true;
+    }
 
-        // Ensure buffer space (realloc if needed)
-        if (pos + 200 > estSize) {
-            estSize *= 2;
-            char* newBuf = (char*)realloc(buf, estSize);
-            if (!newBuf) { free(buf); if (outLen) *outLen = 0; return nullptr; }
-            buf = newBuf;
+    // Quoted string into out (truncated to outSize - 1, may be nullptr to
+    // skip). len is the full decoded length.
+    bool parseString(char* out, size_t outSize, size_t& len) {
+        len = 0;
+        if (!consume('"')) return false;
+        while (_p < _end) {
+            char c = *_p++;
+            if (c == '"') {
+                if (out) out[len < outSize ? len : outSize - 1] = '\0';
+                return true;
+            }
+            if ((unsigned char)c < 0x20) return false;
+            if (c == '\\') {
+                if (_p >= _end) return false;
+                char e = *_p++;
+                switch (e) {
+                    case '"': case '\\': case '/': c = e; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'n': c = '\n'; break;
+                    case 'r': c = '\r'; break;
+                    case 't': c = '\t'; break;
+                    case 'u': {
+                        // Commands are ASCII; anything wider becomes '?'
+                        if (_end - _p < 4) return false;
+                        unsigned cp = 0;
+                        for (int i = 0; i < 4; i++) {
+                            char h = *_p++;
+                            cp <<= 4;
+                            if (h >= '0' && h <= '9')      cp |= (unsigned)(h - '0');
+                            else if (h >= 'a' && h <= 'f') cp |= (unsigned)(h - 'a' + 10);
+                            else if (h >= 'A' && h <= 'F') cp |= (unsigned)(h - 'A' + 10);
+                            else return false;
+                        }
+                        c = cp < 0x80 ? (char)cp : '?';
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+            if (out && len + 1 < outSize) out[len] = c;
+            len++;
         }
+        return false;
+    }
 
-        pos += snprintf(buf + pos, estSize - pos, "{\"ts\":%u", (unsigned)p.ts);
+    bool parseNumber(double& out, bool& integral) {
+        const char* start = _p;
+        integral = true;
+        consume('-');
+        if (_p >= _end || *_p < '0' || *_p > '9') return false;
+        while (_p < _end && *_p >= '0' && *_p <= '9') _p++;
+        if (consume('.')) {
+            integral = false;
+            if (_p >= _end || *_p < '0' || *_p > '9') return false;
+            while (_p < _end && *_p >= '0' && *_p <= '9') _p++;
+        }
+        if (_p < _end && (*_p == 'e' || *_p == 'E')) {
+            integral = false;
+            _p++;
+            if (!consume('+')) consume('-');
+            if (_p >= _end || *_p < '0' || *_p > '9') return false;
+            while (_p < _end && *_p >= '0' && *_p <= '9') _p++;
+        }
 
-        // Temperatures: NAN → null
-        if (std::isnan(p.pit))   pos += snprintf(buf + pos, estSize - pos, ",\"pit\":null");
-        else                     pos += snprintf(buf + pos, estSize - pos, ",\"pit\":%.1f", p.pit);
+        // strtod needs a terminated copy; longer numbers are rejected
+        char tmp[32];
+        size_t n = (size_t)(_p - start);
+        if (n >= sizeof(tmp)) return false;
+        memcpy(tmp, start, n);
+        tmp[n] = '\0';
+        out = strtod(tmp, nullptr);
+        return true;
+    }
 
-        if (std::isnan(p.meat1)) pos += snprintf(buf + pos, estSize - pos, ",\"meat1\":null");
-        else                     pos += snprintf(buf + pos, estSize - pos, ",\"meat1\":%.1f", p.meat1);
+    // Parse one value, storing it in v if the key is wanted
+    bool parseValue(ScannedValue* v, uint8_t depth) {
+        if (_p >= _end) return false;
+        char c = *_p;
+
+        if (c == '"') {
+            size_t len;
+            if (v) {
+                v->kind = ValueKind::STRING;
+                return parseString(v->str, sizeof(v->str), len);
+            }
+            return parseString(nullptr, 0, len);
+        }
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            double num;
+            bool integral;
+            if (!parseNumber(num, integral)) return false;
+            if (v) {
+                v->kind = ValueKind::NUMBER;
+                v->number = num;
+                v->integral = integral;
+            }
+            return true;
+        }
+        if (c == 'n') {
+            if (v) v->kind = ValueKind::NUL;
+            return literal("null");
+        }
+        if (c == 't' || c == 'f') {
+            if (v) v->kind = ValueKind::OTHER;
+            return literal(c == 't' ? "true" : "false");
+        }
+        if (c == '[' && v) {
+            v->kind = ValueKind::LIST;
+            return parseList(v, depth + 1);
+        }
+        if (c == '{' || c == '[') {
+            if (v) v->kind = ValueKind::OTHER;
+            return skipContainer(depth + 1);
+        }
+        return false;
+    }
 
-        if (std::isnan(p.meat2)) pos += snprintf(buf + pos, estSize - pos, ",\"meat2\":null");
-        else                     pos += snprintf(buf + pos, estSize - pos, ",\"meat2\":%.1f", p.meat2);
+    // Array of a wanted key: strings that name a channel set its bit in v,
+    // anything else is skipped
+    bool parseList(ScannedValue* v, uint8_t depth) {
+        if (depth > CMD_MAX_DEPTH) return false;
+        _p++;
+        skipSpace();
+        if (consume(']')) return true;
+
+        for (;;) {
+            skipSpace();
+            if (_p < _end && *_p == '"') {
+                char name[20];
+                size_t len;
+                if (!parseString(name, sizeof(name), len)) return false;
+                for (uint8_t ch = 0; len < sizeof(name) && ch < (uint8_t)Channel::COUNT; ch++) {
+                    if (strcmp(name, channelName((Channel)ch)) == 0) {
+                        v->channels |= channelBit((Channel)ch);
+                    }
+                }
+            } else if (!parseValue(nullptr, depth)) {
+                return false;
+            }
+            skipSpace();
+            if (consume(']')) return true;
+            if (!consume(',')) return false;
+        }
+    }
 
-        pos += snprintf(buf + pos, estSize - pos,
-            ",\"fan\":%u,\"damper\":%u,\"sp\":%d,\"lid\":%s}",
-            (unsigned)p.fan, (unsigned)p.damper, (int)p.sp,
-            p.lid ? "true" : "false");
+    bool skipContainer(uint8_t depth) {
+        if (depth > CMD_MAX_DEPTH) return false;
+        char close = *_p == '{' ? '}' : ']';
+        bool object = close == '}';
+        _p++;
+        skipSpace();
+        if (consume(close)) return true;
+
+        for (;;) {
+            skipSpace();
+            if (object) {
+                size_t len;
+                if (!parseString(nullptr, 0, len)) return false;
+                skipSpace();
+                if (!consume(':')) return false;
+                skipSpace();
+            }
+            if (!parseValue(nullptr, depth)) return false;
+            skipSpace();
+            if (consume(close)) return true;
+            if (!consume(',')) return false;
+        }
     }
 
-    pos += snprintf(buf + pos, estSize - pos, "]}");
+    const char* _p;
+    const char* _end;
+};
 
-    if (outLen) *outLen = pos;
-    return buf;
+// Field accessors with the defaults the protocol has always used
+const char* stringOr(const ScannedValue& v, const char* fallback) {
+    return v.kind == ValueKind::STRING ? v.str : fallback;
 }
 
-// ---------------------------------------------------------------------------
-// buildCSVDownloadEnvelope — wrap CSV data in JSON for WebSocket delivery
-// ---------------------------------------------------------------------------
-char* buildCSVDownloadEnvelope(const char* csvData, size_t csvLen, size_t* outLen) {
-    // Worst case: every char needs escaping (unlikely), plus envelope
-    size_t estSize = 128 + csvLen * 2;
-    char* buf = (char*)malloc(estSize);
-    if (!buf) {
-        if (outLen) *outLen = 0;
-        return nullptr;
-    }
-
-    size_t pos = 0;
-    pos += snprintf(buf + pos, estSize - pos,
-        "{\"type\":\"session\",\"action\":\"download\",\"format\":\"csv\",\"data\":\"");
+float floatOr0(const ScannedValue& v) {
+    return v.kind == ValueKind::NUMBER ? (float)v.number : 0.0f;
+}
 
-    // Escape the CSV data for JSON string
-    for (size_t i = 0; i < csvLen; i++) {
-        if (pos + 10 > estSize) {
-            estSize *= 2;
-            char* newBuf = (char*)realloc(buf, estSize);
-            if (!newBuf) { free(buf); if (outLen) *outLen = 0; return nullptr; }
-            buf = newBuf;
-        }
+uint32_t uintOr0(const ScannedValue& v) {
+    if (v.kind != ValueKind::NUMBER || !v.integral) return 0;
+    if (v.number < 0 || v.number > 4294967295.0) return 0;
+    return (uint32_t)v.number;
+}
 
-        char c = csvData[i];
-        switch (c) {
-            case '"':  buf[pos++] = '\\'; buf[pos++] = '"';  break;
-            case '\\': buf[pos++] = '\\'; buf[pos++] = '\\'; break;
-            case '\n': buf[pos++] = '\\'; buf[pos++] = 'n';  break;
-            case '\r': buf[pos++] = '\\'; buf[pos++] = 'r';  break;
-            case '\t': buf[pos++] = '\\'; buf[pos++] = 't';  break;
-            default:   buf[pos++] = c;                        break;
-        }
+// Alarm targets: a number sets it; null (or no key) clears it
+void alarmTarget(const ScannedValue& v, bool& has, float& target) {
+    if (v.kind == ValueKind::NUMBER) {
+        has = true;
+        target = (float)v.number;
+    } else if (v.kind == ValueKind::NUL || v.kind == ValueKind::ABSENT) {
+        has = true;
+        target = 0;
     }
-
-    pos += snprintf(buf + pos, estSize - pos, "\"}");
-
-    if (outLen) *outLen = pos;
-    return buf;
 }
 
-// ---------------------------------------------------------------------------
-// parseCommand — parse incoming JSON command from client
-// ---------------------------------------------------------------------------
+} // namespace
+
 ParsedCommand parseCommand(const char* data, size_t len) {
     ParsedCommand cmd;
     memset(&cmd, 0, sizeof(cmd));
     cmd.type = CmdType::UNKNOWN;
+    if (!data || len == 0 || len > WS_CMD_MAX_LEN) return cmd;
 
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, data, len);
-    if (err) return cmd;
+    CommandFields f;
+    memset(&f, 0, sizeof(f));
+    CommandScanner scanner(data, len);
+    if (!scanner.scan(f)) return cmd;
 
-    const char* type = doc["type"] | "";
+    const char* type = stringOr(f.type, "");
 
     if (strcmp(type, "set") == 0) {
         cmd.type = CmdType::SET_SP;
-        cmd.setpoint = doc["sp"].as<float>();
+        cmd.setpoint = floatOr0(f.sp);
     }
     else if (strcmp(type, "alarm") == 0) {
         cmd.type = CmdType::ALARM;
+        alarmTarget(f.meat1Target, cmd.hasMeat1Target, cmd.meat1Target);
+        alarmTarget(f.meat2Target, cmd.hasMeat2Target, cmd.meat2Target);
 
-        if (doc["meat1Target"].is<float>()) {
-            cmd.hasMeat1Target = true;
-            cmd.meat1Target = doc["meat1Target"].as<float>();
-        } else if (doc["meat1Target"].isNull()) {
-            cmd.hasMeat1Target = true;
-            cmd.meat1Target = 0;
-        }
-
-        if (doc["meat2Target"].is<float>()) {
-            cmd.hasMeat2Target = true;
-            cmd.meat2Target = doc["meat2Target"].as<float>();
-        } else if (doc["meat2Target"].isNull()) {
-            cmd.hasMeat2Target = true;
-            cmd.meat2Target = 0;
-        }
-
-        if (doc["pitBand"].is<float>()) {
+        if (f.pitBand.kind == ValueKind::NUMBER) {
             cmd.hasPitBand = true;
-            cmd.pitBand = doc["pitBand"].as<float>();
+            cmd.pitBand = (float)f.pitBand.number;
         }
     }
     else if (strcmp(type, "config") == 0) {
-        const char* fm = doc["fanMode"] | "";
+        const char* fm = stringOr(f.fanMode, "");
         if (fm[0] != '\0') {
             cmd.type = CmdType::SET_FAN_MODE;
             strncpy(cmd.fanMode, fm, sizeof(cmd.fanMode) - 1);
             cmd.fanMode[sizeof(cmd.fanMode) - 1] = '\0';
         }
     }
+    else if (strcmp(type, "hello") == 0) {
+        cmd.type = CmdType::HELLO;
+        uint32_t bin = uintOr0(f.bin);
+        cmd.binVersion = bin > 255 ? 255 : (uint8_t)bin;
+    }
+    else if (strcmp(type, "sync") == 0) {
+        cmd.type = CmdType::SYNC;
+        cmd.session = uintOr0(f.session);
+        cmd.since = uintOr0(f.since);
+    }
+    else if (strcmp(type, "sub") == 0 || strcmp(type, "unsub") == 0) {
+        cmd.type = type[0] == 's' ? CmdType::SUBSCRIBE : CmdType::UNSUBSCRIBE;
+        cmd.channels = f.channels.kind == ValueKind::LIST ? f.channels.channels : 0;
+        cmd.rateMs = uintOr0(f.rateMs);
+    }
     else if (strcmp(type, "session") == 0) {
-        const char* action = doc["action"] | "";
+        const char* action = stringOr(f.action, "");
         if (strcmp(action, "new") == 0) {
             cmd.type = CmdType::SESSION_NEW;
         } else if (strcmp(action, "download") == 0) {
             cmd.type = CmdType::SESSION_DOWNLOAD;
-            const char* fmt = doc["format"] | "csv";
+            const char* fmt = stringOr(f.format, "csv");
             strncpy(cmd.format, fmt, sizeof(cmd.format) - 1);
             cmd.format[sizeof(cmd.format) - 1] = '\0';
         }
@@ -252,4 +369,32 @@ ParsedCommand parseCommand(const char* data, size_t len) {
     return cmd;
 }
 
+// ---------------------------------------------------------------------------
+// CommandAssembler — reassemble fragmented command frames
+// ---------------------------------------------------------------------------
+CommandAssembler::Result CommandAssembler::feed(const char* data, size_t len,
+                                                bool start, bool end) {
+    if (start) {
+        _len = 0;
+        _active = true;
+        _dropped = false;
+    }
+    if (!_active) return Result::PENDING;  // Tail of a message we never saw begin
+
+    if (!_dropped) {
+        if (_len + len > WS_CMD_MAX_LEN) {
+            _dropped = true;  // Too long to be a command; ignore the rest of it
+        } else {
+            memcpy(_buf + _len, data, len);
+            _len += (uint16_t)len;
+        }
+    }
+
+    if (!end) return Result::PENDING;
+    _active = false;
+    if (_dropped) return Result::DROPPED;
+    _buf[_len] = '\0';
+    return Result::COMPLETE;
+}
+
 } // namespace bbq_protocol
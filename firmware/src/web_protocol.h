@@ -1,5 +1,6 @@
 #pragma once
 
+#include "config.h"
 #include <cstdint>
 #include <cstddef>
 
@@ -19,6 +20,37 @@ struct DataPayload {
     uint8_t errorCount;
 };
 
+// Data for a control-channel message: the PID loop as it runs
+struct ControlPayload {
+    uint32_t ms;                    // Uptime (ms), as frames can come faster than 1/s
+    float pit, sp;
+    float out;                      // PID output (%)
+    float p, i, d;                  // PID terms (%)
+    float fan, damper;              // %
+    bool lid;
+};
+
+// Streams a client can subscribe to, each at its own rate. Every client
+// starts with DATA only.
+enum class Channel : uint8_t {
+    DATA,       // "data": data messages (binary frames if negotiated)
+    CONTROL,    // "control": control messages, for PID tuning
+    DIAG,       // "diag": raw ADC sample batches (binary clients only)
+    COUNT
+};
+
+inline uint8_t channelBit(Channel ch) { return (uint8_t)(1u << (uint8_t)ch); }
+
+// Name of a channel in sub/unsub commands and their replies
+inline const char* channelName(Channel ch) {
+    switch (ch) {
+        case Channel::DATA:    return "data";
+        case Channel::CONTROL: return "control";
+        case Channel::DIAG:    return "diag";
+        default:               return "";
+    }
+}
+
 // Single point for history replay
 struct HistoryPoint {
     uint32_t ts;
@@ -29,7 +61,8 @@ struct HistoryPoint {
 };
 
 // Parsed incoming command
-enum class CmdType { SET_SP, ALARM, SESSION_NEW, SESSION_DOWNLOAD, SET_FAN_MODE, UNKNOWN };
+enum class CmdType { SET_SP, ALARM, SESSION_NEW, SESSION_DOWNLOAD, SET_FAN_MODE, HELLO, SYNC,
+                     SUBSCRIBE, UNSUBSCRIBE, UNKNOWN };
 struct ParsedCommand {
     CmdType type;
     float setpoint;
@@ -37,19 +70,66 @@ struct ParsedCommand {
     bool hasMeat1Target, hasMeat2Target, hasPitBand;
     char format[8]; // "csv" or "json"
     char fanMode[20]; // "fan_only", "fan_and_damper", "damper_primary"
+    uint8_t binVersion; // HELLO: highest binary frame version the client decodes (0 = JSON only)
+    uint32_t session;   // SYNC: session (start time) the client holds, 0 = none
+    uint32_t since;     // SYNC: timestamp of the last point the client holds
+    uint8_t channels;   // SUB/UNSUB: bit per Channel named (unknown names ignored)
+    uint32_t rateMs;    // SUB: ms between frames, 0 = the channel's default
 };
 
-// Returns bytes written to buf (excluding null terminator)
+// Returns bytes written to buf (excluding null terminator), or 0 if the
+// message does not fit. Defined in data_message.cpp; no heap allocation.
 size_t buildDataMessage(char* buf, size_t bufSize, const DataPayload& d);
 size_t buildSessionReset(char* buf, size_t bufSize, float setpoint);
 
-// Dynamic allocation — caller must free() returned pointer
+// Reply to a session download request: where to fetch the export in the
+// requested format ("json", anything else is CSV). The file is streamed over
+// HTTP, never through the socket.
+size_t buildSessionDownload(char* buf, size_t bufSize, const char* format);
+
+// Reply to a client hello with the frame format the server will use
+// (binVersion 0 = JSON). Binary frames are built by binary_frame.h.
+size_t buildHelloAck(char* buf, size_t bufSize, uint8_t binVersion);
+
+// Control-channel message
+size_t buildControlMessage(char* buf, size_t bufSize, const ControlPayload& c);
+
+// Reply to sub/unsub with the client's channels and the rate each is sent
+// at (rateMs indexed by Channel; 0 = as it changes)
+size_t buildSubscriptionAck(char* buf, size_t bufSize, uint8_t channels, const uint16_t* rateMs);
+
+// Dynamic allocation — caller must free() returned pointer.
+// Defined in history_message.cpp; see HistoryMessageBuilder to format
+// session records directly and HistoryChunkWriter for bounded-size replays.
 char* buildHistoryMessage(const HistoryPoint* points, size_t count,
                           float sp, float meat1Target, float meat2Target,
                           size_t* outLen);
-char* buildCSVDownloadEnvelope(const char* csvData, size_t csvLen, size_t* outLen);
 
-// Parse an incoming JSON command
+// Parse an incoming JSON command. Single pass over data (no NUL needed, no
+// heap); frames over WS_CMD_MAX_LEN or malformed JSON give CmdType::UNKNOWN.
 ParsedCommand parseCommand(const char* data, size_t len);
 
+// Reassembles a text command that arrives in pieces (WebSocket continuation
+// frames, or one frame split across TCP reads) into a bounded buffer. A
+// message that outgrows WS_CMD_MAX_LEN is dropped as soon as it does.
+class CommandAssembler {
+public:
+    enum class Result { PENDING, COMPLETE, DROPPED };
+
+    CommandAssembler() : _len(0), _active(false), _dropped(false) {}
+
+    // Add the next piece. start marks the first byte of a message, end its
+    // last. COMPLETE means data()/length() hold the whole command.
+    Result feed(const char* data, size_t len, bool start, bool end);
+
+    const char* data() const { return _buf; }
+    size_t length() const    { return _len; }
+
+private:
+    char     _buf[WS_CMD_MAX_LEN + 1];
+    uint16_t _len;
+    bool     _active;
+    bool     _dropped;
+};
+
 } // namespace bbq_protocol
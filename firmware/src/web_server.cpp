@@ -4,15 +4,195 @@
 #include <Arduino.h>
 #include <time.h>
 #include <cmath>
+#include <memory>
+#include <string.h>
 
 #include "temp_manager.h"
-#include "pid_controller.h"
-#include "fan_controller.h"
-#include "servo_controller.h"
-#include "config_manager.h"
+#include "control_command.h"
 #include "cook_session.h"
-#include "alarm_manager.h"
-#include "error_manager.h"
+#include "seqlock.h"
+#include "system_snapshot.h"
+#include "loop_stats.h"
+#include "control_jitter.h"
+
+// ---------------------------------------------------------------------------
+// PooledWsMessage — a queued WebSocket message that sends a shared broadcast
+// buffer in place. AsyncWebSocket's own text()/binary() copy the payload into
+// every client's queue; this holds a reference instead and drops it when the
+// queue deletes the message. The frame goes out whole once the TCP window can
+// take it (data messages are at most WS_BROADCAST_BUF_SIZE bytes), and the
+// client's WsFlow is told when it leaves the queue.
+// ---------------------------------------------------------------------------
+class PooledWsMessage : public AsyncWebSocketMessage {
+public:
+    PooledWsMessage(WsBroadcastPool::Buffer* buf, uint8_t opcode, WsFlow* flow)
+        : _buf(buf), _flow(flow), _sent(false), _ack(0), _acked(0) {
+        _opcode = opcode;
+        _mask = false;
+        _status = WS_MSG_SENDING;
+        _buf->retain();
+        _flow->onQueued();
+    }
+
+    ~PooledWsMessage() override {
+        _buf->release();
+        _flow->sent();
+    }
+
+    void ack(size_t len, uint32_t time) override {
+        (void)time;
+        _acked += len;
+        if (_sent && _acked >= _ack) _status = WS_MSG_SENT;
+    }
+
+    bool betweenFrames() const override { return _acked == _ack; }
+
+    size_t send(AsyncClient* client) override {
+        if (_status != WS_MSG_SENDING || _sent) return 0;
+
+        // Unmasked server frame, FIN set, 7- or 16-bit length
+        size_t len = _buf->len;
+        uint8_t head[4];
+        size_t headLen = 2;
+        head[0] = 0x80 | _opcode;
+        if (len < 126) {
+            head[1] = (uint8_t)len;
+        } else {
+            head[1] = 126;
+            head[2] = (uint8_t)(len >> 8);
+            head[3] = (uint8_t)len;
+            headLen = 4;
+        }
+        if (!client->canSend() || client->space() < headLen + len) return 0;
+
+        client->add((const char*)head, headLen);
+        client->add((const char*)_buf->data, len);
+        client->send();
+        _sent = true;
+        _ack = headLen + len;
+        return len;
+    }
+
+private:
+    WsBroadcastPool::Buffer* _buf;
+    WsFlow* _flow;
+    bool   _sent;
+    size_t _ack;      // Bytes the frame put on the wire
+    size_t _acked;
+};
+
+// ---------------------------------------------------------------------------
+// PackedAssetResponse — sends an asset compiled into the image straight from
+// flash. The head is copied into the TCP buffer as usual, but the body is
+// handed to lwIP by reference (no ASYNC_WRITE_FLAG_COPY): rodata outlives any
+// segment, so nothing is staged through RAM and there is nothing to free.
+// ---------------------------------------------------------------------------
+class PackedAssetResponse : public AsyncWebServerResponse {
+public:
+    PackedAssetResponse(const WebAsset& asset)
+        : _data(asset.data), _headSent(0) {
+        _code = 200;
+        _contentType = asset.type;
+        _contentLength = asset.size;
+    }
+
+    bool _sourceValid() const override { return _data != nullptr; }
+
+    void _respond(AsyncWebServerRequest* request) override {
+        _head = _assembleHead(request->version());
+        _state = RESPONSE_CONTENT;
+        _ack(request, 0, 0);
+    }
+
+    size_t _ack(AsyncWebServerRequest* request, size_t len, uint32_t time) override {
+        (void)time;
+        _ackedLength += len;
+        AsyncClient* client = request->client();
+        size_t written = 0;
+
+        if (_state == RESPONSE_CONTENT) {
+            if (_headSent < _head.length()) {
+                size_t n = _head.length() - _headSent;
+                if (n > client->space()) n = client->space();
+                n = client->add(_head.c_str() + _headSent, n);
+                _headSent += n;
+                written += n;
+            }
+            if (_headSent == _head.length() && _sentLength < _contentLength) {
+                size_t n = _contentLength - _sentLength;
+                if (n > client->space()) n = client->space();
+                n = client->add((const char*)_data + _sentLength, n, 0);
+                _sentLength += n;
+                written += n;
+            }
+            if (written) client->send();
+            _writtenLength += written;
+            if (_headSent == _head.length() && _sentLength == _contentLength) {
+                _head = String();
+                _headSent = 0;
+                _state = RESPONSE_WAIT_ACK;
+            }
+        }
+        if (_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength) _state = RESPONSE_END;
+        return written;
+    }
+
+private:
+    const uint8_t* _data;
+    String _head;
+    size_t _headSent;
+};
+
+// ---------------------------------------------------------------------------
+// WebAssetHandler — serves the web UI bundle, from the table compiled into
+// the image or from the files listed in WEB_ASSET_INDEX. The stored bytes go
+// out as they are (gzipped, sent with Content-Encoding), with the asset's
+// strong ETag and its Cache-Control; a request whose If-None-Match carries the
+// ETag gets an empty 304.
+// ---------------------------------------------------------------------------
+class WebAssetHandler : public AsyncWebHandler {
+public:
+    explicit WebAssetHandler(const WebAssetTable* table) : _table(table) {}
+
+    bool canHandle(AsyncWebServerRequest* request) override {
+        if (request->method() != HTTP_GET) return false;
+        const String& url = request->url();
+        if (!_table->find(url.c_str(), url.length())) return false;
+        // Headers are parsed after the handler is chosen; keep this one
+        request->addInterestingHeader("If-None-Match");
+        return true;
+    }
+
+    void handleRequest(AsyncWebServerRequest* request) override {
+        const String& url = request->url();
+        const WebAsset* asset = _table->find(url.c_str(), url.length());
+        if (!asset) {
+            request->send(404);
+            return;
+        }
+
+        AsyncWebHeader* inm = request->getHeader("If-None-Match");
+        WebAssetReply reply = inm
+            ? WebAssetTable::reply(*asset, inm->value().c_str(), inm->value().length())
+            : WebAssetTable::reply(*asset, nullptr, 0);
+
+        AsyncWebServerResponse* response;
+        if (reply.status == 304) {
+            response = request->beginResponse(304);
+        } else {
+            response = asset->data
+                ? new PackedAssetResponse(*asset)
+                : request->beginResponse(LittleFS, asset->file, asset->type);
+            if (asset->gzip) response->addHeader("Content-Encoding", "gzip");
+        }
+        response->addHeader("ETag", asset->etag);
+        response->addHeader("Cache-Control", reply.cacheControl);
+        request->send(response);
+    }
+
+private:
+    const WebAssetTable* _table;
+};
 #endif
 
 BBQWebServer::BBQWebServer()
@@ -23,16 +203,24 @@ BBQWebServer::BBQWebServer()
     ,
 #endif
       _temp(nullptr)
-    , _pid(nullptr)
-    , _fan(nullptr)
-    , _servo(nullptr)
-    , _config(nullptr)
     , _session(nullptr)
-    , _alarm(nullptr)
-    , _error(nullptr)
+    , _snapshot(nullptr)
+    , _loopStats(nullptr)
+    , _controlJitter(nullptr)
+    , _commands(nullptr)
+    , _diagSeq(0)
     , _setpoint(225.0f)
     , _estimatedTime(0)
+    , _lastPollMs(0)
     , _lastBroadcastMs(0)
+    , _broadcasts(0)
+    , _sharedSends(0)
+    , _copiedSends(0)
+    , _copiedBytes(0)
+    , _controlFrames(0)
+    , _diagFrames(0)
+    , _evictions(0)
+    , _lastPingMs(0)
     , _onSetpoint(nullptr)
     , _onAlarm(nullptr)
     , _onSession(nullptr)
@@ -61,7 +249,173 @@ void BBQWebServer::begin() {
         request->send(200, "application/json", json);
     });
 
-    // Serve static files from LittleFS (web UI)
+    // Loop and control timing and session writer statistics
+    _server->on("/api/stats", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        char json[3072];
+        int n = snprintf(json, sizeof(json), "{");
+        SystemSnapshot snap;
+        readSnapshot(snap);
+        if (_loopStats) {
+            n += snprintf(json + n, sizeof(json) - n,
+                          "\"loop\":{\"maxUs\":%u,\"avgUs\":%u,\"overruns\":%u,"
+                          "\"allTimeMaxUs\":%u,\"budgetUs\":%u},",
+                          _loopStats->getMaxUs(), _loopStats->getAvgUs(),
+                          _loopStats->getOverruns(), _loopStats->getAllTimeMaxUs(),
+                          _loopStats->getBudgetUs());
+        }
+        if (_controlJitter) {
+            // Jitter histogram: hist[i] counts cycles whose interval strayed
+            // from periodUs by less than bucketsUs[i]; the last bucket is open
+            const JitterHistogram& j = *_controlJitter;
+            n += snprintf(json + n, sizeof(json) - n,
+                          "\"control\":{\"task\":%s,\"periodUs\":%u,\"cycles\":%u,"
+                          "\"maxRunUs\":%u,\"avgRunUs\":%u,\"allTimeMaxRunUs\":%u,"
+                          "\"maxJitterUs\":%u,\"minPeriodUs\":%u,\"maxPeriodUs\":%u,"
+                          "\"late\":%u,\"bucketsUs\":[",
+                          CONTROL_TASK ? "true" : "false", j.getPeriodUs(), j.getCount(),
+                          snap.runMaxUs, snap.runAvgUs,
+                          snap.runAllTimeMaxUs, j.getMaxJitterUs(),
+                          j.getMinIntervalUs(), j.getMaxIntervalUs(), j.getLate());
+            for (uint8_t i = 0; i + 1 < JitterHistogram::BUCKETS; i++) {
+                n += snprintf(json + n, sizeof(json) - n, "%s%u", i ? "," : "",
+                              JitterHistogram::bucketLimitUs(i));
+            }
+            n += snprintf(json + n, sizeof(json) - n, "],\"hist\":[");
+            for (uint8_t i = 0; i < JitterHistogram::BUCKETS; i++) {
+                n += snprintf(json + n, sizeof(json) - n, "%s%u", i ? "," : "",
+                              j.getBucket(i));
+            }
+            n += snprintf(json + n, sizeof(json) - n, "]},");
+        }
+        if (_commands) {
+            // Post-to-apply latency; overPeriod counts commands that waited
+            // longer than one control period
+            n += snprintf(json + n, sizeof(json) - n,
+                          "\"commands\":{\"posted\":%u,\"dropped\":%u,\"applied\":%u,"
+                          "\"queuePeak\":%u,\"maxLatencyUs\":%u,\"avgLatencyUs\":%u,"
+                          "\"allTimeMaxLatencyUs\":%u,\"overPeriod\":%u},",
+                          _commands->getPosted(), _commands->getDropped(),
+                          _commands->getApplied(), _commands->getQueuePeak(),
+                          snap.latencyMaxUs, snap.latencyAvgUs, snap.latencyAllTimeMaxUs,
+                          snap.latencyOverPeriod);
+        }
+        if (_snapshot) {
+            n += snprintf(json + n, sizeof(json) - n,
+                          "\"snapshot\":{\"published\":%u,\"retries\":%u},",
+                          _snapshot->getVersion(), _snapshot->getRetries());
+        }
+        if (_session) {
+            const SessionWriter& w = _session->getWriter();
+            n += snprintf(json + n, sizeof(json) - n,
+                          "\"writer\":{\"task\":%s,\"blocks\":%u,\"bytes\":%u,"
+                          "\"errors\":%u,\"maxWriteUs\":%u,\"queuePeak\":%u,\"queueFull\":%u},",
+                          w.isRunning() ? "true" : "false",
+                          w.getBlocksWritten(), w.getBytesWritten(), w.getWriteErrors(),
+                          w.getMaxWriteUs(), w.getQueueHighWater(), w.getQueueFullCount());
+        }
+        n += snprintf(json + n, sizeof(json) - n,
+                      "\"broadcast\":{\"count\":%u,\"shared\":%u,\"copied\":%u,"
+                      "\"copiedBytes\":%u,\"poolSize\":%u,\"poolPeak\":%u,\"poolExhausted\":%u,"
+                      "\"adaptive\":%s,\"perHour\":%u,\"state\":%u,\"value\":%u,\"heartbeat\":%u,"
+                      "\"control\":%u},",
+                      _broadcasts, _sharedSends, _copiedSends, _copiedBytes,
+                      (unsigned)WsBroadcastPool::capacity(), _broadcastPool.getPeakInUse(),
+                      _broadcastPool.getExhausted(),
+                      WS_ADAPTIVE_BROADCAST ? "true" : "false",
+                      BroadcastGate::perHour(_broadcasts, millis()),
+                      _gate.getCount(BroadcastGate::Reason::STATE),
+                      _gate.getCount(BroadcastGate::Reason::VALUE),
+                      _gate.getCount(BroadcastGate::Reason::HEARTBEAT), _controlFrames);
+        if (_temp) {
+            const AdcDiagRing& ring = _temp->getDiagRing();
+            n += snprintf(json + n, sizeof(json) - n,
+                          "\"diag\":{\"on\":%s,\"samples\":%u,\"dropped\":%u,"
+                          "\"ringPeak\":%u,\"frames\":%u},",
+                          _temp->isDiagnostic() ? "true" : "false", ring.getPushed(),
+                          ring.getDropped(), ring.getHighWater(), _diagFrames);
+
+            // Probe acquisition: conversions are collected by the control
+            // cycle without waiting; lastSweepUs covers every conversion of a sweep
+            const AdcScanStats& a = _temp->getScanStats();
+            n += snprintf(json + n, sizeof(json) - n,
+                          "\"adc\":{\"rdyPin\":%d,\"sweeps\":%u,\"conversions\":%u,"
+                          "\"timeouts\":%u,\"aborted\":%u,\"skipped\":%u,\"rdyMissed\":%u,"
+                          "\"rdySpurious\":%u,\"maxConversionUs\":%u,\"lastSweepUs\":%u,"
+                          "\"spareRaw\":%d,\"samples\":%u,\"filter\":%u,\"noise\":[",
+                          (int)PIN_ADC_RDY, a.sweeps, a.conversions, a.timeouts, a.aborted,
+                          a.skipped, _temp->getRdyMissed(), _temp->getRdySpurious(),
+                          a.maxConversionUs, a.lastSweepUs,
+                          (int)_temp->getSpareRaw(), (unsigned)TEMP_AVG_SAMPLES,
+                          (unsigned)TEMP_OUTLIER_FILTER);
+
+            // Per probe: conversions filtered, outliers dropped, and the
+            // standard deviation (counts) of the rest, last / average / max
+            for (uint8_t i = 0; i < NUM_PROBES; i++) {
+                const ProbeNoise& pn = _temp->getNoise(i);
+                n += snprintf(json + n, sizeof(json) - n,
+                              "%s{\"samples\":%u,\"rejected\":%u,\"spread\":%.1f,"
+                              "\"avgSpread\":%.1f,\"maxSpread\":%.1f}",
+                              i ? "," : "", pn.getSamples(), pn.getRejected(),
+                              pn.getSpread(), pn.getAvgSpread(), pn.getMaxSpread());
+            }
+            n += snprintf(json + n, sizeof(json) - n, "]},");
+        }
+
+        // Per-client data queues: depth now and at peak, coalesced and dropped
+        // snapshots. Read here on the network task while the loop owns the
+        // table; slots are fixed storage, so at worst a client that just left
+        // is still listed.
+        n += snprintf(json + n, sizeof(json) - n,
+                      "\"clients\":{\"evicted\":%u,\"events\":%u,\"eventsDropped\":%u,"
+                      "\"eventQueuePeak\":%u,\"queues\":[",
+                      _evictions, _events.getPosted(), _events.getDropped(),
+                      _events.getQueuePeak());
+        for (uint8_t i = 0; i < _clients.size() && n < (int)sizeof(json) - 160; i++) {
+            WsClient& c = _clients[i];
+            n += snprintf(json + n, sizeof(json) - n,
+                          "%s{\"id\":%u,\"queued\":%u,\"peak\":%u,\"frames\":%u,"
+                          "\"coalesced\":%u,\"dropped\":%u,\"held\":%s,\"channels\":%u}",
+                          i ? "," : "", c.id, c.flow.queued.load(), c.flow.peak,
+                          c.flow.frames, c.flow.coalesced, c.flow.dropped,
+                          c.flow.pending.load() ? "true" : "false", c.sub.channels);
+        }
+        n += snprintf(json + n, sizeof(json) - n, "]},");
+        if (n > 1) n--;  // Drop the trailing comma
+        snprintf(json + n, sizeof(json) - n, "}");
+        request->send(200, "application/json", json);
+    });
+
+    // Full-session export, streamed record-by-record from LittleFS
+    _server->on("/api/session.csv", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        sendSessionExport(request, SessionExporter::Format::CSV);
+    });
+    _server->on("/api/session.json", HTTP_GET, [this](AsyncWebServerRequest* request) {
+        sendSessionExport(request, SessionExporter::Format::JSON);
+    });
+
+    // Web UI bundle (web_assets.py): gzipped, ETag-validated, fingerprinted
+    // files cached for good. Served from the table compiled into the image
+    // when there is one, so the UI always matches the firmware; otherwise
+    // from LittleFS. Files the bundle doesn't list, or a filesystem image
+    // without an index, fall through to plain static serving.
+    uint8_t packedCount;
+    const WebAsset* packed = packedWebAssets(&packedCount);
+    if (packed && _assets.loadPacked(packed, packedCount) > 0) {
+        _server->addHandler(new WebAssetHandler(&_assets));
+        Serial.printf("[WEB] Serving %u embedded web UI assets\n", _assets.size());
+    } else {
+        File index = LittleFS.open(WEB_ASSET_INDEX, "r");
+        if (index) {
+            String text = index.readString();
+            index.close();
+            if (_assets.load(text.c_str(), text.length()) > 0) {
+                _server->addHandler(new WebAssetHandler(&_assets));
+                Serial.printf("[WEB] Serving %u web UI assets from %s\n", _assets.size(), WEB_ASSET_INDEX);
+            } else {
+                Serial.printf("[WEB] Unusable %s, serving files as stored\n", WEB_ASSET_INDEX);
+            }
+        }
+    }
     _server->serveStatic("/", LittleFS, "/").setDefaultFile("index.html");
 
     // Fallback 404
@@ -70,7 +424,7 @@ void BBQWebServer::begin() {
     });
 
     _server->begin();
-    _lastBroadcastMs = millis();
+    _lastPollMs = _lastBroadcastMs = millis();
 
     Serial.printf("[WEB] Server started on port %d, WebSocket at %s\n", WEB_PORT, WS_PATH);
 #endif
@@ -80,18 +434,56 @@ void BBQWebServer::update() {
 #ifndef NATIVE_BUILD
     unsigned long now = millis();
 
-    // Periodic broadcast to all connected clients
-    if (now - _lastBroadcastMs >= WS_SEND_INTERVAL) {
-        _lastBroadcastMs = now;
+    // Connects, disconnects and commands from the network task
+    _events.drain([this](const WsEvent& e) { handleWsEvent(e); });
 
-        if (_ws && _ws->count() > 0) {
-            bbq_protocol::DataPayload payload = buildDataPayload();
-            char buf[512];
-            size_t len = bbq_protocol::buildDataMessage(buf, sizeof(buf), payload);
-            _ws->textAll(buf, len);
+    // Subscription channels: each is built at most once per poll and sent
+    // to the subscribers whose rate says they are due. Diag runs even with
+    // no clients, so the stream stops when its last subscriber goes.
+    if (now - _lastPollMs >= WS_CHANGE_POLL_MS) {
+        _lastPollMs = now;
+        if (_clients.size() > 0) {
+            SystemSnapshot snap;
+            readSnapshot(snap);
+            pollData(snap, (uint32_t)now);
+            pollControl(snap, (uint32_t)now);
         }
+        pollDiag((uint32_t)now);
+    }
+
+    // Snapshots held back for slow clients, once their queue has drained
+    flushHeldData();
+
+    // Ping every client and evict the ones that stopped answering
+    checkClientLiveness((uint32_t)now);
+
+    // Syncs received since the last pass: what each client missed
+    WsClient* syncing;
+    while ((syncing = _clients.nextSyncRequest()) != nullptr) {
+        syncing->syncPending = false;
+        syncClient(*syncing, syncing->syncSession, syncing->syncSince);
+    }
+
+    // Clients that never sent a sync get a full replay
+    WsClient* late;
+    while ((late = _clients.nextSyncTimeout((uint32_t)now)) != nullptr) {
+        sendInitial(*late);
+    }
+
+    // History replays: one chunk per client per pass, and only once its queue
+    // and TCP send buffer can take a whole chunk, so at most one chunk per
+    // client is ever buffered
+    for (uint8_t i = 0; _ws && i < _clients.size(); i++) {
+        WsClient& c = _clients[i];
+        if (!c.replay.active) continue;
+        AsyncWebSocketClient* ac = _ws->client(c.id);
+        if (!ac || !ac->canSend() || ac->client()->space() < WS_HISTORY_CHUNK_SIZE) continue;
+        sendHistoryChunk(c);
     }
 
+    // Session downloads: at most one pipe's worth of each per pass
+    pumpExports();
+
     // Clean up disconnected clients
     if (_ws) {
         _ws->cleanupClients(WS_MAX_CLIENTS);
@@ -99,26 +491,258 @@ void BBQWebServer::update() {
 #endif
 }
 
-void BBQWebServer::setModules(TempManager* temp, PidController* pid, FanController* fan,
-                            ServoController* servo, ConfigManager* config, CookSession* session,
-                            AlarmManager* alarm, ErrorManager* error) {
-    _temp   = temp;
-    _pid    = pid;
-    _fan    = fan;
-    _servo  = servo;
-    _config = config;
+void BBQWebServer::setModules(TempManager* temp, CookSession* session) {
+    _temp    = temp;
     _session = session;
-    _alarm  = alarm;
-    _error  = error;
+}
+
+void BBQWebServer::readSnapshot(SystemSnapshot& out) const {
+    if (_snapshot) _snapshot->read(out);
+    else           out = SystemSnapshot();
 }
 
 void BBQWebServer::broadcastNow() {
+    // Goes out from update(), on the loop task, within WS_CHANGE_POLL_MS
+#if WS_ADAPTIVE_BROADCAST
+    _gate.force();
+#else
+    _lastBroadcastMs = millis() - WS_SEND_INTERVAL;
+#endif
+}
+
+void BBQWebServer::broadcastSessionReset(float setpoint) {
 #ifndef NATIVE_BUILD
-    if (_ws && _ws->count() > 0) {
-        bbq_protocol::DataPayload payload = buildDataPayload();
-        char buf[512];
-        size_t len = bbq_protocol::buildDataMessage(buf, sizeof(buf), payload);
-        _ws->textAll(buf, len);
+    if (!_ws) return;
+    char buf[128];
+    size_t n = bbq_protocol::buildSessionReset(buf, sizeof(buf), setpoint);
+    if (n > 0) _ws->textAll(buf, n);
+#endif
+}
+
+void BBQWebServer::pollData(const SystemSnapshot& snap, uint32_t nowMs) {
+#ifndef NATIVE_BUILD
+#if WS_ADAPTIVE_BROADCAST
+    // Change-driven: a frame only when something visible changed, or as a
+    // heartbeat. Clients on a slower rate still get the newest one later.
+    bbq_protocol::DataPayload payload = buildDataPayload(snap);
+    uint8_t alarms = snap.alarmBits();
+    BroadcastGate::Reason why = _gate.check(payload, alarms, nowMs);
+    if (why != BroadcastGate::Reason::NONE) {
+        _gate.sent(payload, alarms, nowMs, why);
+        _clients.produced(bbq_protocol::Channel::DATA);
+    }
+    if (_clients.countDue(bbq_protocol::Channel::DATA, nowMs) > 0) {
+        broadcastData(payload, nowMs);
+    }
+#else
+    if (nowMs - _lastBroadcastMs >= WS_SEND_INTERVAL) {
+        _lastBroadcastMs = nowMs;
+        _clients.produced(bbq_protocol::Channel::DATA);
+    }
+    if (_clients.countDue(bbq_protocol::Channel::DATA, nowMs) > 0) {
+        broadcastData(buildDataPayload(snap), nowMs);
+    }
+#endif
+#endif
+}
+
+void BBQWebServer::pollControl(const SystemSnapshot& snap, uint32_t nowMs) {
+#ifndef NATIVE_BUILD
+    _clients.produced(bbq_protocol::Channel::CONTROL);
+    if (!_ws || _clients.countDue(bbq_protocol::Channel::CONTROL, nowMs) == 0) return;
+
+    // One JSON message for every subscriber, shared like data broadcasts
+    bbq_protocol::ControlPayload payload = buildControlPayload(snap, nowMs);
+    WsBroadcastPool::Buffer* shared = _broadcastPool.acquire();
+    char copy[WS_BROADCAST_BUF_SIZE];
+    char* json = shared ? (char*)shared->data : copy;
+    size_t len = bbq_protocol::buildControlMessage(json, WS_BROADCAST_BUF_SIZE, payload);
+    if (shared) shared->len = len;
+    _controlFrames++;
+
+    for (uint8_t i = 0; i < _clients.size(); i++) {
+        WsClient& c = _clients[i];
+        if (!WsClientTable::isLive(c) || !c.sub.due(bbq_protocol::Channel::CONTROL, nowMs)) continue;
+        c.sub.delivered(bbq_protocol::Channel::CONTROL, nowMs);
+        AsyncWebSocketClient* ac = _ws->client(c.id);
+        if (!ac || len == 0) continue;
+
+        // Not held for a client that is behind: the next one is a rate away
+        if (c.flow.behind() || ac->queueIsFull()) {
+            c.flow.dropped++;
+            continue;
+        }
+        if (shared) {
+            queueShared(c, ac, shared, false);
+            _sharedSends++;
+        } else {
+            ac->text(json, len);
+            _copiedSends++;
+            _copiedBytes += len;
+        }
+    }
+    if (shared) shared->release();
+#endif
+}
+
+void BBQWebServer::pollDiag(uint32_t nowMs) {
+#ifndef NATIVE_BUILD
+    if (!_temp) return;
+
+    // Sample only while someone is watching; leftovers from a finished
+    // stream are thrown away
+    bool wanted = _ws && _clients.countSubscribed(bbq_protocol::Channel::DIAG) > 0;
+    if (wanted != _temp->isDiagnostic()) _temp->setDiagnostic(wanted);
+    if (!wanted) {
+        while (_temp->readDiagnostic(_diagBatch, WS_DIAG_BATCH_MAX) > 0) {}
+        return;
+    }
+
+    // Every sample goes out once: a subscriber whose queue is full loses
+    // the batch (the seq gap shows it) rather than stalling the others
+    uint16_t n;
+    while ((n = _temp->readDiagnostic(_diagBatch, WS_DIAG_BATCH_MAX)) > 0) {
+        size_t len = bbq_protocol::encodeDiagFrame(_diagFrame, sizeof(_diagFrame), _diagSeq++,
+                                                   _temp->getDiagRing().getDropped(),
+                                                   _diagBatch, (uint8_t)n);
+        _diagFrames++;
+        _clients.produced(bbq_protocol::Channel::DIAG);
+
+        for (uint8_t i = 0; i < _clients.size(); i++) {
+            WsClient& c = _clients[i];
+            if (!WsClientTable::isLive(c) || !c.sub.due(bbq_protocol::Channel::DIAG, nowMs)) continue;
+            c.sub.delivered(bbq_protocol::Channel::DIAG, nowMs);
+            AsyncWebSocketClient* ac = _ws->client(c.id);
+            if (!ac) continue;
+            if (ac->queueIsFull()) {
+                c.flow.dropped++;
+                continue;
+            }
+            ac->binary(_diagFrame, len);
+        }
+    }
+#endif
+}
+
+void BBQWebServer::broadcastData(const bbq_protocol::DataPayload& payload, uint32_t nowMs) {
+#ifndef NATIVE_BUILD
+    if (!_ws || _clients.size() == 0) return;
+
+    // Encode each format once, and only if a client due a frame needs it.
+    // Both go into pooled buffers that every client queue shares; if slow
+    // clients still hold every buffer, encode on the stack and let
+    // AsyncWebSocket copy per client as before.
+    bool wantBin = _clients.countDue(bbq_protocol::Channel::DATA, nowMs, 1) > 0;
+    bool wantJson = _clients.countDue(bbq_protocol::Channel::DATA, nowMs, 0) > 0;
+    WsBroadcastPool::Buffer* sharedBin = wantBin ? _broadcastPool.acquire() : nullptr;
+    WsBroadcastPool::Buffer* sharedJson = wantJson ? _broadcastPool.acquire() : nullptr;
+
+    uint8_t binCopy[BIN_DATA_FRAME_SIZE];
+    char jsonCopy[WS_BROADCAST_BUF_SIZE];
+    uint8_t* bin = sharedBin ? sharedBin->data : binCopy;
+    char* json = sharedJson ? (char*)sharedJson->data : jsonCopy;
+    size_t binLen = wantBin
+        ? bbq_protocol::encodeDataFrame(bin, BIN_DATA_FRAME_SIZE, payload) : 0;
+    size_t jsonLen = wantJson
+        ? bbq_protocol::buildDataMessage(json, WS_BROADCAST_BUF_SIZE, payload) : 0;
+    if (sharedBin)  sharedBin->len = binLen;
+    if (sharedJson) sharedJson->len = jsonLen;
+    _broadcasts++;
+
+    for (uint8_t i = 0; i < _clients.size(); i++) {
+        WsClient& c = _clients[i];
+        if (!WsClientTable::isLive(c) || !c.sub.due(bbq_protocol::Channel::DATA, nowMs)) continue;
+        c.sub.delivered(bbq_protocol::Channel::DATA, nowMs);
+        bool binary = c.binVersion > 0;
+        size_t len = binary ? binLen : jsonLen;
+        AsyncWebSocketClient* ac = _ws->client(c.id);
+        if (!ac || len == 0) continue;
+
+        // A client that is behind gets only the newest snapshot once it
+        // catches up (see flushHeldData()); nothing more piles up for it
+        WsBroadcastPool::Buffer* shared = binary ? sharedBin : sharedJson;
+        if (c.flow.behind() || ac->queueIsFull()) {
+            if (shared) c.flow.hold(shared);
+            else        c.flow.dropped++;
+            continue;
+        }
+
+        if (shared) {
+            queueShared(c, ac, shared, binary);
+            _sharedSends++;
+        } else {
+            if (binary) ac->binary(bin, len);
+            else        ac->text(json, len);
+            _copiedSends++;
+            _copiedBytes += len;
+        }
+    }
+
+    // Queued messages hold their own references now
+    if (sharedBin)  sharedBin->release();
+    if (sharedJson) sharedJson->release();
+#endif
+}
+
+void BBQWebServer::queueShared(WsClient& client, AsyncWebSocketClient* ac,
+                               WsBroadcastPool::Buffer* buf, bool binary) {
+#ifndef NATIVE_BUILD
+    ac->message(new PooledWsMessage(buf, binary ? WS_BINARY : WS_TEXT, &client.flow));
+#endif
+}
+
+void BBQWebServer::flushHeldData() {
+#ifndef NATIVE_BUILD
+    for (uint8_t i = 0; _ws && i < _clients.size(); i++) {
+        WsClient& c = _clients[i];
+        if (c.flow.behind() || c.replay.active) continue;
+        WsBroadcastPool::Buffer* held = c.flow.takePending();
+        if (!held) continue;
+
+        AsyncWebSocketClient* ac = _ws->client(c.id);
+        if (ac && !ac->queueIsFull()) {
+            queueShared(c, ac, held, c.binVersion > 0);
+            _sharedSends++;
+        } else {
+            c.flow.dropped++;
+        }
+        held->release();
+    }
+#endif
+}
+
+void BBQWebServer::checkClientLiveness(uint32_t nowMs) {
+#ifndef NATIVE_BUILD
+    if (!_ws) return;
+
+    // Any frame or pong counts as alive; a dead link answers nothing, and
+    // AsyncWebSocket would keep queueing for it until TCP gives up
+    if (nowMs - _lastPingMs >= WS_PING_INTERVAL) {
+        _lastPingMs = nowMs;
+        uint8_t i = 0;
+        while (i < _clients.size()) {
+            AsyncWebSocketClient* ac = _ws->client(_clients[i].id);
+            if (!ac) {
+                // Gone without a disconnect event (the event queue was full)
+                _clients.remove(_clients[i].id);
+                continue;
+            }
+            if (ac->status() == WS_CONNECTED) ac->ping();
+            i++;
+        }
+    }
+
+    // Abort the TCP connection outright: a close handshake would queue behind
+    // everything the client is not reading. The slot is freed by the
+    // disconnect event, after AsyncWebSocket has discarded the queue.
+    WsClient* stale;
+    while ((stale = _clients.nextStale(nowMs)) != nullptr) {
+        Serial.printf("[WS] Client #%u silent for %u ms, evicting\n",
+                      stale->id, (unsigned)(nowMs - stale->lastSeenMs));
+        stale->lastSeenMs = nowMs;  // Not again until another timeout
+        _evictions++;
+        AsyncWebSocketClient* ac = _ws->client(stale->id);
+        if (ac && ac->client()) ac->client()->close(true);
     }
 #endif
 }
@@ -130,7 +754,7 @@ uint8_t BBQWebServer::getClientCount() const {
     return 0;
 }
 
-bbq_protocol::DataPayload BBQWebServer::buildDataPayload() {
+bbq_protocol::DataPayload BBQWebServer::buildDataPayload(const SystemSnapshot& snap) {
     bbq_protocol::DataPayload payload;
     memset(&payload, 0, sizeof(payload));
 
@@ -141,102 +765,425 @@ bbq_protocol::DataPayload BBQWebServer::buildDataPayload() {
     payload.ts = (uint32_t)now;
 
     // Temperatures
-    if (_temp) {
-        payload.pit   = _temp->isConnected(PROBE_PIT)   ? _temp->getPitTemp()   : NAN;
-        payload.meat1 = _temp->isConnected(PROBE_MEAT1)  ? _temp->getMeat1Temp() : NAN;
-        payload.meat2 = _temp->isConnected(PROBE_MEAT2)  ? _temp->getMeat2Temp() : NAN;
-    } else {
-        payload.pit = payload.meat1 = payload.meat2 = NAN;
-    }
+    payload.pit   = snap.connected[PROBE_PIT]   ? snap.temp[PROBE_PIT]   : NAN;
+    payload.meat1 = snap.connected[PROBE_MEAT1] ? snap.temp[PROBE_MEAT1] : NAN;
+    payload.meat2 = snap.connected[PROBE_MEAT2] ? snap.temp[PROBE_MEAT2] : NAN;
 
     // Fan and damper
-    payload.fan    = _fan    ? (uint8_t)_fan->getCurrentSpeedPct()        : 0;
-    payload.damper = _servo  ? (uint8_t)_servo->getCurrentPositionPct()   : 0;
+    payload.fan    = (uint8_t)snap.fanPct;
+    payload.damper = (uint8_t)snap.damperPct;
 
     // Setpoint
-    payload.sp = _setpoint;
+    payload.sp = snap.setpoint;
 
     // Lid-open
-    payload.lid = _pid ? _pid->isLidOpen() : false;
+    payload.lid = snap.lidOpen;
 
     // Meat targets from alarm manager
-    payload.meat1Target = _alarm ? _alarm->getMeat1Target() : 0;
-    payload.meat2Target = _alarm ? _alarm->getMeat2Target() : 0;
+    payload.meat1Target = snap.meat1Target;
+    payload.meat2Target = snap.meat2Target;
 
     // Fan mode
-    payload.fanMode = _config ? _config->getFanMode() : "fan_and_damper";
+    payload.fanMode = snap.fanMode[0] ? snap.fanMode : "fan_and_damper";
 
     // Estimated done time
     payload.est = _estimatedTime;
 
-    // Errors
+    // Errors (the texts stay in the snapshot)
     payload.errorCount = 0;
-    if (_error) {
-        auto activeErrors = _error->getErrors();
-        for (size_t i = 0; i < activeErrors.size() && payload.errorCount < 8; i++) {
-            payload.errors[payload.errorCount++] = activeErrors[i].message;
-        }
+    for (uint8_t i = 0; i < snap.errorCount && payload.errorCount < 8; i++) {
+        payload.errors[payload.errorCount++] = snap.errors[i].message;
     }
 #endif
 
     return payload;
 }
 
-void BBQWebServer::sendHistory(uint8_t clientId) {
+bbq_protocol::ControlPayload BBQWebServer::buildControlPayload(const SystemSnapshot& snap,
+                                                              uint32_t nowMs) {
+    bbq_protocol::ControlPayload payload;
+    memset(&payload, 0, sizeof(payload));
+    payload.ms = nowMs;
+    payload.sp = snap.setpoint;
+
+#ifndef NATIVE_BUILD
+    payload.pit = snap.connected[PROBE_PIT] ? snap.temp[PROBE_PIT] : NAN;
+    payload.out = snap.pidOutput;
+    payload.p   = snap.pTerm;
+    payload.i   = snap.iTerm;
+    payload.d   = snap.dTerm;
+    payload.lid = snap.lidOpen;
+    payload.fan    = snap.fanPct;
+    payload.damper = snap.damperPct;
+#endif
+
+    return payload;
+}
+
+#ifndef NATIVE_BUILD
+// Expand a rollup bucket into two session records carrying its min and max in
+// the order they occurred, so short spikes (lid opens) survive downsampling.
+static void rollupToPoints(const RollupPoint& rp, uint16_t interval, DataPoint dp[2]) {
+    memset(dp, 0, 2 * sizeof(DataPoint));
+
+    bool pitMinFirst   = rp.minFirst & ROLLUP_MIN_FIRST_PIT;
+    bool meat1MinFirst = rp.minFirst & ROLLUP_MIN_FIRST_MEAT1;
+    bool meat2MinFirst = rp.minFirst & ROLLUP_MIN_FIRST_MEAT2;
+
+    dp[0].timestamp = rp.timestamp;
+    dp[1].timestamp = rp.timestamp + interval / 2;
+    dp[0].pitTemp   = pitMinFirst   ? rp.pitMin   : rp.pitMax;
+    dp[1].pitTemp   = pitMinFirst   ? rp.pitMax   : rp.pitMin;
+    dp[0].meat1Temp = meat1MinFirst ? rp.meat1Min : rp.meat1Max;
+    dp[1].meat1Temp = meat1MinFirst ? rp.meat1Max : rp.meat1Min;
+    dp[0].meat2Temp = meat2MinFirst ? rp.meat2Min : rp.meat2Max;
+    dp[1].meat2Temp = meat2MinFirst ? rp.meat2Max : rp.meat2Min;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        dp[i].fanPct    = rp.fanAvg;
+        dp[i].damperPct = rp.damperAvg;
+        dp[i].flags     = rp.flags;
+    }
+}
+#endif
+
+void BBQWebServer::startReplay(WsClient& client) {
+#ifndef NATIVE_BUILD
+    HistoryReplay& r = client.replay;
+    uint32_t total = _session->getTotalPointCount();
+    const uint32_t maxPoints = SESSION_HISTORY_MAX_POINTS;
+
+    r.active = true;
+    r.append = false;
+    r.seq = 0;
+    r.session = _session->getStartTime();
+
+    // Replay at the finest resolution that fits the point budget: raw samples
+    // for short cooks, otherwise a rollup tier (two points per bucket), so the
+    // cost scales with screen width rather than cook length. Decimation is
+    // aligned so the most recent point (or bucket) is always included.
+    uint32_t spanSec = total * (SESSION_SAMPLE_INTERVAL / 1000);
+    int8_t tier = session_rollup::selectTier(spanSec, maxPoints / 2);
+    if (tier < 0 || _session->getRollupCount(tier) == 0) {
+        r.tier = -1;
+        r.step = (total + maxPoints - 1) / maxPoints;
+        r.next = (total - 1) % r.step;
+        r.end = total;
+        return;
+    }
+
+    // The bucket still filling sits at index getRollupCount()
+    RollupPoint partial;
+    uint32_t buckets = _session->getRollupCount(tier) +
+                       (_session->getPartialRollup(tier, partial) ? 1 : 0);
+    uint32_t maxBuckets = maxPoints / 2;
+    r.tier = tier;
+    r.step = (buckets + maxBuckets - 1) / maxBuckets;
+    r.next = (buckets - 1) % r.step;
+    r.end = buckets;
+#endif
+}
+
+bool BBQWebServer::startReplaySince(WsClient& client, uint32_t since) {
+#ifndef NATIVE_BUILD
+    // Cost is proportional to the outage: a binary search for the resume
+    // point, then only the missing records
+    uint32_t total = _session->getTotalPointCount();
+    uint32_t from = _session->findFirstAfter(since);
+    uint32_t missing = total - from;
+    if (missing > SESSION_HISTORY_MAX_POINTS) return false;
+
+    HistoryReplay& r = client.replay;
+    r.active = true;
+    r.append = true;
+    r.tier = -1;
+    r.seq = 0;
+    r.session = _session->getStartTime();
+    r.next = from;
+    r.end = total;
+    r.step = 1;
+
+    Serial.printf("[WS] Client %u resyncing: %u missed points\n", client.id, missing);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BBQWebServer::fillRawChunk(HistoryReplay& r, bbq_protocol::HistoryChunkWriter& out) {
 #ifndef NATIVE_BUILD
-    if (!_session || !_ws) return;
+    uint32_t total = _session->getTotalPointCount();
+    RingView<DataPoint> ram = _session->getRamPoints();
+    uint32_t ramStart = total - ram.size();
 
-    uint32_t count = _session->getPointCount();
-    if (count == 0) return;
+    // Undecimated replays also pick up points recorded since they started,
+    // as the client gets no data broadcasts until the last chunk
+    if (r.step == 1) r.end = total;
 
-    // Build array of HistoryPoints from session data
-    bbq_protocol::HistoryPoint* points =
-        (bbq_protocol::HistoryPoint*)malloc(count * sizeof(bbq_protocol::HistoryPoint));
-    if (!points) return;
+    // Points that have left RAM come through a cursor (flash)
+    if (r.next < ramStart) {
+        SessionCursor cursor;
+        _session->openCursor(cursor, r.next);
+        DataPoint dp;
+        while (r.next < ramStart && out.hasRoom(1)) {
+            if (r.step > 1) _session->seek(cursor, r.next);
+            if (!_session->readNext(cursor, dp)) {
+                r.next += ((ramStart - r.next + r.step - 1) / r.step) * r.step;
+                break;
+            }
+            out.add(dp, _setpoint);
+            r.next += r.step;
+        }
+        _session->closeCursor(cursor);
+        if (r.next < ramStart) return;
+    }
 
-    for (uint32_t i = 0; i < count; i++) {
-        const DataPoint* dp = _session->getPoint(i);
-        if (!dp) continue;
+    // The rest straight from the ring spans
+    for (; r.next < r.end && out.hasRoom(1); r.next += r.step) {
+        out.add(ram[r.next - ramStart], _setpoint);
+    }
+#endif
+}
 
-        points[i].ts = dp->timestamp;
+void BBQWebServer::fillRollupChunk(HistoryReplay& r, bbq_protocol::HistoryChunkWriter& out) {
+#ifndef NATIVE_BUILD
+    uint8_t tier = (uint8_t)r.tier;
+    uint16_t interval = _session->getRollupInterval(tier);
+    uint32_t completed = _session->getRollupCount(tier);
 
-        // Convert int16 temps (x10) back to float, check disconnect flags
-        if (dp->flags & DP_FLAG_PIT_DISC)   points[i].pit = NAN;
-        else                                 points[i].pit = dp->pitTemp / 10.0f;
+    RollupPoint page[16];
+    DataPoint dp[2];
+    while (r.next < r.end && out.hasRoom(2)) {
+        // The bucket that was still filling when the replay started
+        if (r.next >= completed) {
+            RollupPoint partial;
+            if (_session->getPartialRollup(tier, partial)) {
+                rollupToPoints(partial, interval, dp);
+                out.add(dp[0], _setpoint);
+                out.add(dp[1], _setpoint);
+            }
+            r.next = r.end;
+            break;
+        }
 
-        if (dp->flags & DP_FLAG_MEAT1_DISC) points[i].meat1 = NAN;
-        else                                 points[i].meat1 = dp->meat1Temp / 10.0f;
+        uint32_t got = _session->readRollups(tier, r.next, r.next + 16, page, 16);
+        if (got == 0) {
+            r.next = r.end;
+            break;
+        }
+        for (uint32_t i = 0; i < got && out.hasRoom(2); i += r.step) {
+            rollupToPoints(page[i], interval, dp);
+            out.add(dp[0], _setpoint);
+            out.add(dp[1], _setpoint);
+            r.next += r.step;
+        }
+    }
+#endif
+}
 
-        if (dp->flags & DP_FLAG_MEAT2_DISC) points[i].meat2 = NAN;
-        else                                 points[i].meat2 = dp->meat2Temp / 10.0f;
+void BBQWebServer::sendHistoryChunk(WsClient& client) {
+#ifndef NATIVE_BUILD
+    HistoryReplay& r = client.replay;
 
-        points[i].fan    = dp->fanPct;
-        points[i].damper = dp->damperPct;
-        points[i].sp     = _setpoint; // current setpoint (per-point sp not stored)
-        points[i].lid    = (dp->flags & DP_FLAG_LID_OPEN) != 0;
+    // The cook changed under the replay: start again with the new one
+    if (!_session || _session->getStartTime() != r.session) {
+        r.active = false;
+        sendInitial(client);
+        return;
     }
 
-    float m1t = _alarm ? _alarm->getMeat1Target() : 0;
-    float m2t = _alarm ? _alarm->getMeat2Target() : 0;
+    bool binary = client.binVersion > 0;
+    bbq_protocol::HistoryChunkHeader header;
+    header.seq = r.seq;
+    header.session = r.session;
+    header.append = r.append;
+    header.sp = _setpoint;
+    SystemSnapshot snap;
+    readSnapshot(snap);
+    header.meat1Target = snap.meat1Target;
+    header.meat2Target = snap.meat2Target;
+
+    bbq_protocol::HistoryChunkWriter writer(_chunkBuf, sizeof(_chunkBuf), binary);
+    writer.begin(header);
+    if (r.tier < 0) fillRawChunk(r, writer);
+    else            fillRollupChunk(r, writer);
 
-    size_t msgLen = 0;
-    char* msg = bbq_protocol::buildHistoryMessage(points, count, _setpoint, m1t, m2t, &msgLen);
-    free(points);
+    bool final = r.next >= r.end;
+    size_t len = writer.finish(final);
+    if (binary) _ws->binary(client.id, _chunkBuf, len);
+    else        _ws->text(client.id, (const char*)_chunkBuf, len);
 
-    if (msg) {
-        _ws->text(clientId, msg, msgLen);
-        free(msg);
+    r.seq++;
+    if (final) {
+        // Live data resumes now, so the client gets a frame straight away
+        // rather than at the next change or heartbeat
+        r.active = false;
+        _gate.force();
     }
 #endif
 }
 
-void BBQWebServer::handleWebSocketMessage(uint8_t clientId, const char* data, size_t len) {
+void BBQWebServer::syncClient(WsClient& client, uint32_t session, uint32_t since) {
+#ifndef NATIVE_BUILD
+    // Same cook as the client holds: send just what it missed
+    if (_session && session != 0 && session == _session->getStartTime() &&
+        _session->getTotalPointCount() > 0 &&
+        startReplaySince(client, since)) {
+        client.historyPending = false;
+        return;
+    }
+
+    // The client's cook is gone and there is nothing to replace it with yet:
+    // tell it to clear, as after a new-session command
+    if (session != 0 && _ws && (!_session || _session->getTotalPointCount() == 0)) {
+        char buf[128];
+        size_t n = bbq_protocol::buildSessionReset(buf, sizeof(buf), _setpoint);
+        _ws->text(client.id, buf, n);
+    }
+    sendInitial(client);
+#endif
+}
+
+void BBQWebServer::sendInitial(WsClient& client) {
+#ifndef NATIVE_BUILD
+    client.historyPending = false;
+    if (!_ws) return;
+
+    bool binary = client.binVersion > 0;
+    if (_session && _session->getTotalPointCount() > 0) {
+        startReplay(client);
+        return;
+    }
+
+    SystemSnapshot snap;
+    readSnapshot(snap);
+    bbq_protocol::DataPayload payload = buildDataPayload(snap);
+    if (binary) {
+        uint8_t bin[BIN_DATA_FRAME_SIZE];
+        size_t n = bbq_protocol::encodeDataFrame(bin, sizeof(bin), payload);
+        _ws->binary(client.id, bin, n);
+    } else {
+        char buf[512];
+        size_t n = bbq_protocol::buildDataMessage(buf, sizeof(buf), payload);
+        _ws->text(client.id, buf, n);
+    }
+#endif
+}
+
+#ifndef NATIVE_BUILD
+// One session download: the cursor and exporter run on the loop, the pipe
+// carries their output to the response callback on the network task
+struct BBQWebServer::SessionExportJob {
+    SessionCursor     cursor;
+    SessionExporter   exporter;
+    SessionExportPipe pipe;
+    uint32_t session;   // Cook being exported (its start time)
+    bool     fine;      // ?res=1s
+    bool     opened;    // Cursor opened by pumpExports()
+    bool     lost;      // The cook was cleared mid-export
+
+    SessionExportJob(SessionExporter::Format format, bool fineStream)
+        : exporter(format, next, this, truncated)
+        , session(0)
+        , fine(fineStream)
+        , opened(false)
+        , lost(false)
+    {}
+
+    // SessionExporter source: the cursor, until the cook it reads is cleared
+    static bool next(void* ctx, DataPoint& out) {
+        SessionExportJob* job = static_cast<SessionExportJob*>(ctx);
+        if (job->cursor.session->getStartTime() != job->session) {
+            job->lost = true;
+            return false;
+        }
+        return CookSession::cursorNext(&job->cursor, out);
+    }
+
+    static bool truncated(void* ctx) {
+        SessionExportJob* job = static_cast<SessionExportJob*>(ctx);
+        return job->lost || CookSession::cursorTruncated(&job->cursor);
+    }
+};
+
+void BBQWebServer::sendSessionExport(AsyncWebServerRequest* request,
+                                     SessionExporter::Format format) {
+    if (!_session) {
+        request->send(503, "text/plain", "Session unavailable");
+        return;
+    }
+
+    SessionExportSlot* slot = nullptr;
+    for (uint8_t i = 0; i < WEB_EXPORT_MAX && !slot; i++) {
+        if (!_exports[i].busy.load(std::memory_order_acquire)) slot = &_exports[i];
+    }
+    if (!slot) {
+        request->send(503, "text/plain", "Too many downloads");
+        return;
+    }
+
+    // The job lives as long as the response or the loop holds it. This task
+    // only reads its pipe; each chunk is copied into the TCP buffer
+    // AsyncWebServer hands over, so heap use stays flat however long the cook.
+    bool fine = request->hasParam("res") && request->getParam("res")->value() == "1s";
+    std::shared_ptr<SessionExportJob> job = std::make_shared<SessionExportJob>(format, fine);
+
+    AsyncWebServerResponse* response = request->beginChunkedResponse(
+        job->exporter.getContentType(),
+        [job](uint8_t* buf, size_t maxLen, size_t index) -> size_t {
+            size_t n = job->pipe.read(buf, maxLen);
+            if (n > 0 || job->pipe.isDone()) return n;
+            return RESPONSE_TRY_AGAIN;  // update() has not formatted more yet
+        });
+
+    char disposition[64];
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"%s\"",
+             job->exporter.getFileName());
+    response->addHeader("Content-Disposition", disposition);
+
+    slot->job = job;
+    slot->busy.store(true, std::memory_order_release);
+    request->send(response);
+}
+#endif
+
+void BBQWebServer::pumpExports() {
+#ifndef NATIVE_BUILD
+    for (uint8_t i = 0; i < WEB_EXPORT_MAX; i++) {
+        SessionExportSlot& slot = _exports[i];
+        if (!slot.busy.load(std::memory_order_acquire)) continue;
+        SessionExportJob& job = *slot.job;
+
+        // Held only here: the response is gone (sent, or the client left)
+        bool abandoned = slot.job.use_count() == 1;
+        if (!abandoned) {
+            if (!job.opened) {
+                _session->openCursor(job.cursor, 0, job.fine);
+                job.session = _session->getStartTime();
+                job.opened = true;
+            }
+            job.pipe.pump(job.exporter);
+            if (!job.pipe.isEnded()) continue;
+        }
+
+        if (job.exporter.isTruncated()) {
+            Serial.printf("[WEB] Session export truncated at point %u (%s)\n", job.cursor.index,
+                          job.lost ? "session cleared" : "flash read failed");
+        }
+        if (job.opened) _session->closeCursor(job.cursor);
+        slot.job.reset();
+        slot.busy.store(false, std::memory_order_release);
+    }
+#endif
+}
+
+void BBQWebServer::handleWebSocketMessage(uint32_t clientId, const char* data, size_t len) {
 #ifndef NATIVE_BUILD
     bbq_protocol::ParsedCommand cmd = bbq_protocol::parseCommand(data, len);
 
     switch (cmd.type) {
         case bbq_protocol::CmdType::SET_SP:
-            _setpoint = cmd.setpoint;
+            // _setpoint follows the snapshot once the control path applies it
             if (_onSetpoint) _onSetpoint(cmd.setpoint);
             Serial.printf("[WS] Client %u set setpoint to %.0f\n", clientId, cmd.setpoint);
             break;
@@ -248,12 +1195,57 @@ void BBQWebServer::handleWebSocketMessage(uint8_t clientId, const char* data, si
             break;
 
         case bbq_protocol::CmdType::SESSION_NEW:
+            // The reset goes out from broadcastSessionReset() once the
+            // queued command has actually cleared the session
             if (_onSession) _onSession("new", "");
-            // Broadcast session reset to all clients
+            break;
+
+        case bbq_protocol::CmdType::HELLO:
             {
-                char buf[128];
-                size_t n = bbq_protocol::buildSessionReset(buf, sizeof(buf), _setpoint);
-                _ws->textAll(buf, n);
+                WsClient* c = _clients.find(clientId);
+                if (!c) break;
+                c->binVersion = cmd.binVersion < BIN_PROTOCOL_VERSION
+                              ? cmd.binVersion : BIN_PROTOCOL_VERSION;
+                char buf[48];
+                size_t n = bbq_protocol::buildHelloAck(buf, sizeof(buf), c->binVersion);
+                _ws->text(clientId, buf, n);
+                Serial.printf("[WS] Client %u negotiated %s frames\n", clientId,
+                              c->binVersion > 0 ? "binary" : "JSON");
+            }
+            break;
+
+        case bbq_protocol::CmdType::SYNC:
+            {
+                // Answered from update(), with the session lookups and
+                // replays, never from inside command handling
+                WsClient* c = _clients.find(clientId);
+                if (!c) break;
+                c->syncPending = true;
+                c->syncSession = cmd.session;
+                c->syncSince = cmd.since;
+            }
+            break;
+
+        case bbq_protocol::CmdType::SUBSCRIBE:
+        case bbq_protocol::CmdType::UNSUBSCRIBE:
+            {
+                WsClient* c = _clients.find(clientId);
+                if (!c) break;
+                if (cmd.type == bbq_protocol::CmdType::SUBSCRIBE) {
+                    // Diag batches only exist as binary frames
+                    uint8_t channels = cmd.channels;
+                    if (c->binVersion == 0) {
+                        channels &= (uint8_t)~bbq_protocol::channelBit(bbq_protocol::Channel::DIAG);
+                    }
+                    c->sub.subscribe(channels, cmd.rateMs);
+                } else {
+                    c->sub.unsubscribe(cmd.channels);
+                }
+                char buf[96];
+                size_t n = bbq_protocol::buildSubscriptionAck(buf, sizeof(buf),
+                                                              c->sub.channels, c->sub.rateMs);
+                _ws->text(clientId, buf, n);
+                Serial.printf("[WS] Client %u channels 0x%02x\n", clientId, c->sub.channels);
             }
             break;
 
@@ -264,15 +1256,12 @@ void BBQWebServer::handleWebSocketMessage(uint8_t clientId, const char* data, si
             break;
 
         case bbq_protocol::CmdType::SESSION_DOWNLOAD:
-            if (_session) {
-                String csvData = _session->toCSV();
-                size_t envLen = 0;
-                char* envelope = bbq_protocol::buildCSVDownloadEnvelope(
-                    csvData.c_str(), csvData.length(), &envLen);
-                if (envelope) {
-                    _ws->text(clientId, envelope, envLen);
-                    free(envelope);
-                }
+            // Point the client at the chunked export rather than build the
+            // whole cook as one String
+            {
+                char buf[128];
+                size_t n = bbq_protocol::buildSessionDownload(buf, sizeof(buf), cmd.format);
+                if (n > 0) _ws->text(clientId, buf, n);
             }
             break;
 
@@ -283,35 +1272,86 @@ void BBQWebServer::handleWebSocketMessage(uint8_t clientId, const char* data, si
 #endif
 }
 
+void BBQWebServer::handleWsEvent(const WsEvent& e) {
+#ifndef NATIVE_BUILD
+    switch (e.type) {
+        case WsEventType::CONNECT:
+            // History (or a snapshot) follows the client's sync, or goes out
+            // as JSON once WS_SYNC_TIMEOUT passes without one
+            if (!_clients.add(e.id, e.ms)) {
+                Serial.printf("[WS] No slot for client #%u, closing\n", e.id);
+                AsyncWebSocketClient* ac = _ws ? _ws->client(e.id) : nullptr;
+                if (ac) ac->close();
+            }
+            break;
+
+        case WsEventType::DISCONNECT:
+            _clients.remove(e.id);
+            break;
+
+        case WsEventType::TEXT:
+            {
+                // A command can arrive as several frames (continuations) or
+                // as one frame over several TCP reads; reassemble it per
+                // client into a bounded buffer
+                WsClient* c = _clients.find(e.id);
+                if (!c) break;
+                c->lastSeenMs = e.ms;
+                bbq_protocol::CommandAssembler::Result r =
+                    c->command.feed(e.data, e.len, e.start, e.end);
+                if (r == bbq_protocol::CommandAssembler::Result::COMPLETE) {
+                    handleWebSocketMessage(e.id, c->command.data(), c->command.length());
+                } else if (r == bbq_protocol::CommandAssembler::Result::DROPPED) {
+                    Serial.printf("[WS] Client #%u command over %u bytes dropped\n",
+                                  e.id, (unsigned)WS_CMD_MAX_LEN);
+                }
+            }
+            break;
+
+        case WsEventType::SEEN:
+            {
+                WsClient* c = _clients.find(e.id);
+                if (c) c->lastSeenMs = e.ms;
+            }
+            break;
+    }
+#endif
+}
+
 void BBQWebServer::onWsEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
                            AwsEventType type, void* arg, uint8_t* data, size_t len) {
 #ifndef NATIVE_BUILD
+    // Runs on the network task (a disconnect also on the loop, when it aborts
+    // a client): nothing here touches the client table
+    uint32_t now = millis();
     switch (type) {
         case WS_EVT_CONNECT:
             Serial.printf("[WS] Client #%u connected from %s\n",
                           client->id(), client->remoteIP().toString().c_str());
-            // Send history if session has data, otherwise send current snapshot
-            if (_session && _session->getPointCount() > 0) {
-                sendHistory(client->id());
-            } else {
-                bbq_protocol::DataPayload payload = buildDataPayload();
-                char buf[512];
-                size_t n = bbq_protocol::buildDataMessage(buf, sizeof(buf), payload);
-                _ws->text(client->id(), buf, n);
+            if (!_events.post(WsEvent::make(WsEventType::CONNECT, client->id(), now))) {
+                Serial.printf("[WS] Event queue full, closing client #%u\n", client->id());
+                client->close();
             }
             break;
 
         case WS_EVT_DISCONNECT:
             Serial.printf("[WS] Client #%u disconnected.\n", client->id());
+            _events.post(WsEvent::make(WsEventType::DISCONNECT, client->id(), now));
             break;
 
         case WS_EVT_DATA:
             {
                 AwsFrameInfo* info = (AwsFrameInfo*)arg;
-                if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
-                    // Complete text message received
-                    data[len] = '\0';  // Null-terminate
-                    handleWebSocketMessage(client->id(), (char*)data, len);
+                if (info->message_opcode != WS_TEXT) {
+                    _events.post(WsEvent::make(WsEventType::SEEN, client->id(), now));
+                    break;
+                }
+                bool start = info->num == 0 && info->index == 0;
+                bool end = info->final && info->index + len == info->len;
+                if (!_events.post(WsEvent::text(client->id(), now, (const char*)data, len,
+                                                start, end))) {
+                    Serial.printf("[WS] Event queue full, client #%u message lost\n",
+                                  client->id());
                 }
             }
             break;
@@ -321,6 +1361,7 @@ void BBQWebServer::onWsEvent(AsyncWebSocket* server, AsyncWebSocketClient* clien
             break;
 
         case WS_EVT_PONG:
+            _events.post(WsEvent::make(WsEventType::SEEN, client->id(), now));
             break;
     }
 #endif
@@ -2,7 +2,16 @@
 
 #include "config.h"
 #include "web_protocol.h"
+#include "history_message.h"
+#include "binary_frame.h"
+#include "ws_clients.h"
+#include "ws_events.h"
+#include "broadcast_gate.h"
+#include "session_export.h"
+#include "web_assets.h"
 #include <stdint.h>
+#include <atomic>
+#include <memory>
 
 #ifndef NATIVE_BUILD
 #include <ESPAsyncWebServer.h>
@@ -13,13 +22,12 @@
 
 // Forward declarations for external module references
 class TempManager;
-class PidController;
-class FanController;
-class ServoController;
-class ConfigManager;
 class CookSession;
-class AlarmManager;
-class ErrorManager;
+class LoopStats;
+class JitterHistogram;
+class CommandQueue;
+struct SystemSnapshot;
+template <typename T> class Seqlock;
 
 // Callback types for commands received from WebSocket clients
 typedef void (*SetpointCallback)(float setpoint);
@@ -39,14 +47,27 @@ public:
     // Initialize HTTP server and WebSocket. Call once from setup().
     void begin();
 
-    // Periodic update: broadcast data to all connected WebSocket clients.
-    // Respects WS_SEND_INTERVAL internally. Call every loop().
+    // Periodic update: broadcast data to all connected WebSocket clients
+    // when it changes (or every WS_SEND_INTERVAL with WS_ADAPTIVE_BROADCAST=0).
+    // Call every loop().
     void update();
 
-    // Set references to other modules for building data messages
-    void setModules(TempManager* temp, PidController* pid, FanController* fan,
-                    ServoController* servo, ConfigManager* config, CookSession* session,
-                    AlarmManager* alarm, ErrorManager* error);
+    // Set references to other modules: the diagnostic sampler and the session
+    void setModules(TempManager* temp, CookSession* session);
+
+    // Snapshot published by the control path; data, control and history
+    // messages are built from a copy of it
+    void setSnapshot(const Seqlock<SystemSnapshot>* snapshot) { _snapshot = snapshot; }
+
+    // Loop timing statistics reported by GET /api/stats
+    void setLoopStats(const LoopStats* stats) { _loopStats = stats; }
+
+    // Control-cycle period jitter reported by GET /api/stats (run time and
+    // command latency come from the snapshot)
+    void setControlStats(const JitterHistogram* jitter) { _controlJitter = jitter; }
+
+    // Command queue counters and post-to-apply latency reported by GET /api/stats
+    void setCommandQueue(const CommandQueue* commands) { _commands = commands; }
 
     // Set callbacks for incoming WebSocket commands
     void onSetpoint(SetpointCallback cb)  { _onSetpoint = cb; }
@@ -54,12 +75,13 @@ public:
     void onSession(SessionCallback cb)    { _onSession = cb; }
     void onFanMode(FanModeCallback cb)    { _onFanMode = cb; }
 
-    // Send history replay to a specific client on connect
-    void sendHistory(uint8_t clientId);
-
-    // Force-send data to all clients immediately (bypasses interval)
+    // Send data to all clients now, whether or not it changed
     void broadcastNow();
 
+    // Tell every client the cook was cleared. Loop task, once the new
+    // session has started, whichever side asked for it.
+    void broadcastSessionReset(float setpoint);
+
     // Get number of connected WebSocket clients
     uint8_t getClientCount() const;
 
@@ -70,13 +92,87 @@ public:
     void setEstimatedTime(uint32_t est) { _estimatedTime = est; }
 
 private:
-    // Build the data payload from current sensor/PID state
-    bbq_protocol::DataPayload buildDataPayload();
+    // Copy the newest published snapshot (defaults before the first one)
+    void readSnapshot(SystemSnapshot& out) const;
+
+    // Build the data payload from a snapshot. Error texts point into snap,
+    // so it must outlive the payload.
+    bbq_protocol::DataPayload buildDataPayload(const SystemSnapshot& snap);
+
+    // Build the control-channel payload from a snapshot of the PID state
+    bbq_protocol::ControlPayload buildControlPayload(const SystemSnapshot& snap, uint32_t nowMs);
+
+    // Produce a data frame if the gate (or the fixed interval) says so, and
+    // send the newest to every subscriber it is due
+    void pollData(const SystemSnapshot& snap, uint32_t nowMs);
+
+    // Send a control frame to every subscriber it is due. Nothing is built
+    // while no client subscribes.
+    void pollControl(const SystemSnapshot& snap, uint32_t nowMs);
+
+    // Run the ADC diagnostic stream while a client subscribes to it, and
+    // send what it sampled since the last poll as diag frames
+    void pollDiag(uint32_t nowMs);
+
+    // Send the data to every live client it is due, each in its negotiated
+    // format. Each format is serialized once into a pooled buffer that every
+    // client queue shares.
+    void broadcastData(const bbq_protocol::DataPayload& payload, uint32_t nowMs);
+
+    // First message(s) after connect: history if the session has data,
+    // otherwise a data snapshot
+    void sendInitial(WsClient& client);
+
+    // Answer a client sync: the points it missed if it holds this session,
+    // otherwise the full replay
+    void syncClient(WsClient& client, uint32_t session, uint32_t since);
+
+    // Start a chunked replay of the whole session. The chunks are sent from
+    // update() as the client's queue drains.
+    void startReplay(WsClient& client);
+
+    // Start a replay of only the points recorded after since, as an append.
+    // Returns false (nothing started) if more are missing than one replay holds.
+    bool startReplaySince(WsClient& client, uint32_t since);
+
+    // Queue a pooled frame for a client, counted against its WsFlow
+    void queueShared(WsClient& client, AsyncWebSocketClient* ac, WsBroadcastPool::Buffer* buf,
+                     bool binary);
+
+    // Send the snapshot held for each slow client once its queue has drained
+    void flushHeldData();
+
+    // Ping clients every WS_PING_INTERVAL and evict those silent for
+    // WS_PONG_TIMEOUT
+    void checkClientLiveness(uint32_t nowMs);
+
+    // Format the client's next history chunk into _chunkBuf and send it
+    void sendHistoryChunk(WsClient& client);
+
+    // Fill a chunk with raw samples, or with a rollup tier (min/max pair per
+    // bucket), advancing the replay position
+    void fillRawChunk(HistoryReplay& replay, bbq_protocol::HistoryChunkWriter& out);
+    void fillRollupChunk(HistoryReplay& replay, bbq_protocol::HistoryChunkWriter& out);
+
+#ifndef NATIVE_BUILD
+    // Stream the full session (flash + RAM tail) as a chunked HTTP download.
+    // ?res=1s exports the 1 s stream held in the PSRAM arena instead.
+    // Network task: hands the download to update() through _exports.
+    void sendSessionExport(AsyncWebServerRequest* request, SessionExporter::Format format);
+#endif
+
+    // Open the downloads handed over in _exports and format the next part of
+    // each into its pipe. Loop task only.
+    void pumpExports();
 
     // Handle incoming WebSocket messages
-    void handleWebSocketMessage(uint8_t clientId, const char* data, size_t len);
+    void handleWebSocketMessage(uint32_t clientId, const char* data, size_t len);
+
+    // Act on a WebSocket event posted by onWsEvent(): track the client,
+    // reassemble and run its commands. Loop task only.
+    void handleWsEvent(const WsEvent& e);
 
-    // WebSocket event handler
+    // WebSocket event handler (network task): posts the event for update()
     void onWsEvent(AsyncWebSocket* server, AsyncWebSocketClient* client,
                    AwsEventType type, void* arg, uint8_t* data, size_t len);
 
@@ -87,20 +183,61 @@ private:
 
     // Module references
     TempManager*    _temp;
-    PidController*  _pid;
-    FanController*  _fan;
-    ServoController* _servo;
-    ConfigManager*  _config;
     CookSession*    _session;
-    AlarmManager*   _alarm;
-    ErrorManager*   _error;
+    const Seqlock<SystemSnapshot>* _snapshot;
+    const LoopStats* _loopStats;
+    const JitterHistogram* _controlJitter;
+    const CommandQueue* _commands;
+
+    // Connected clients and their negotiated frame format. Loop task only:
+    // the network task reaches it through _events.
+    WsClientTable _clients;
+    WsEventQueue  _events;
+
+    // History chunks are formatted here one at a time, so a replay costs the
+    // same heap whatever the cook length
+    uint8_t _chunkBuf[WS_HISTORY_CHUNK_SIZE];
+
+    // Shared data-broadcast buffers
+    WsBroadcastPool _broadcastPool;
+
+    // Web UI bundle index, loaded from LittleFS at begin()
+    WebAssetTable _assets;
+
+    // Session downloads. The response callback (network task) only reads a
+    // job's pipe; the cursor and exporter are run by pumpExports() on the
+    // loop, which owns the session. The network task fills a free slot and
+    // sets busy; the loop clears it once the job is finished or abandoned.
+    struct SessionExportJob;
+    struct SessionExportSlot {
+        std::atomic<bool> busy{false};
+        std::shared_ptr<SessionExportJob> job;
+    };
+    SessionExportSlot _exports[WEB_EXPORT_MAX];
+
+    // Diag frames are drained and encoded here (copied per subscriber)
+    AdcSample _diagBatch[WS_DIAG_BATCH_MAX];
+    uint8_t   _diagFrame[BIN_DIAG_HEADER_SIZE + WS_DIAG_BATCH_MAX * BIN_DIAG_RECORD_SIZE];
+    uint8_t   _diagSeq;
 
     // State
     float    _setpoint;
     uint32_t _estimatedTime;
 
-    // Timing
+    // Timing (channel poll; data frame produced, with WS_ADAPTIVE_BROADCAST=0)
+    unsigned long _lastPollMs;
     unsigned long _lastBroadcastMs;
+    BroadcastGate _gate;
+
+    // How broadcast sends were served (GET /api/stats)
+    uint32_t _broadcasts;
+    uint32_t _sharedSends;      // Queued by reference to a pooled buffer
+    uint32_t _copiedSends;      // Pool exhausted: AsyncWebSocket copied the payload
+    uint32_t _copiedBytes;
+    uint32_t _controlFrames;    // Control messages built (once per send, for all subscribers)
+    uint32_t _diagFrames;       // Diag frames built
+    uint32_t _evictions;        // Clients dropped for not answering pings
+    unsigned long _lastPingMs;
 
     // Callbacks
     SetpointCallback _onSetpoint;
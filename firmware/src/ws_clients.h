@@ -0,0 +1,308 @@
+#pragma once
+
+#include "config.h"
+#include "web_protocol.h"
+#include "broadcast_pool.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Data broadcasts are serialized once into one of these and shared by every
+// client's send queue
+typedef BroadcastPool<WS_BROADCAST_SLOTS, WS_BROADCAST_BUF_SIZE> WsBroadcastPool;
+
+// Progress of a chunked history replay. Indexes are session points for raw
+// replays and buckets of the rollup tier otherwise.
+struct HistoryReplay {
+    bool     active;
+    bool     append;        // Points after the client's sync position
+    int8_t   tier;          // Rollup tier, -1 = raw samples
+    uint32_t seq;           // Next chunk number
+    uint32_t session;       // Cook being replayed; abandoned if it changes
+    uint32_t next;          // Next index to send
+    uint32_t end;           // One past the last index
+    uint32_t step;          // Decimation step
+};
+
+// Data frames on their way to one client. At most WS_CLIENT_QUEUE_MAX sit in
+// its send queue; while it is that far behind, each newer snapshot replaces
+// the one held here instead of queueing behind it, since only the latest
+// telemetry matters. sent() is called from the network task, when
+// AsyncWebSocket deletes a sent message; everything else runs on the loop.
+struct WsFlow {
+    std::atomic<uint8_t> queued;                    // Data frames in the send queue
+    std::atomic<WsBroadcastPool::Buffer*> pending;  // Newest snapshot held back
+    uint8_t  peak;          // Most data frames ever queued at once
+    uint32_t frames;        // Data frames queued
+    uint32_t coalesced;     // Snapshots replaced by a newer one before sending
+    uint32_t dropped;       // Snapshots lost (no buffer to hold, queue full)
+
+    void reset() {
+        WsBroadcastPool::Buffer* p = pending.exchange(nullptr);
+        if (p) p->release();
+        queued.store(0);
+        peak = 0;
+        frames = coalesced = dropped = 0;
+    }
+
+    bool behind() const { return queued.load(std::memory_order_acquire) >= WS_CLIENT_QUEUE_MAX; }
+
+    // A data frame entered the send queue
+    void onQueued() {
+        uint8_t q = queued.fetch_add(1, std::memory_order_acq_rel) + 1;
+        if (q > peak) peak = q;
+        frames++;
+    }
+
+    // A data frame left the send queue (sent, or discarded with the client)
+    void sent() {
+        uint8_t q = queued.load(std::memory_order_relaxed);
+        while (q > 0 && !queued.compare_exchange_weak(q, q - 1, std::memory_order_acq_rel)) {}
+    }
+
+    // Hold the newest snapshot while the client is behind, replacing any older one
+    void hold(WsBroadcastPool::Buffer* buf) {
+        buf->retain();
+        WsBroadcastPool::Buffer* old = pending.exchange(buf, std::memory_order_acq_rel);
+        if (old) {
+            old->release();
+            coalesced++;
+        }
+    }
+
+    // The held snapshot, or nullptr. The caller takes over its reference.
+    WsBroadcastPool::Buffer* takePending() {
+        return pending.exchange(nullptr, std::memory_order_acq_rel);
+    }
+};
+
+// What one client receives: a bit per bbq_protocol::Channel, the rate it
+// takes each at, and whether the channel has produced a frame it has not had
+// yet. A channel with rate 0 goes out as it is produced; otherwise the client
+// gets at most one frame per rateMs, the newest, so a slow subscriber sees
+// the latest value late rather than missing it.
+struct WsSubscription {
+    static const uint8_t COUNT = (uint8_t)bbq_protocol::Channel::COUNT;
+
+    uint8_t  channels;
+    uint16_t rateMs[COUNT];
+    uint32_t lastMs[COUNT];     // When the last frame was queued
+    bool     stale[COUNT];      // Produced since the last frame queued
+
+    void reset() {
+        channels = bbq_protocol::channelBit(bbq_protocol::Channel::DATA);
+        for (uint8_t i = 0; i < COUNT; i++) {
+            rateMs[i] = 0;
+            lastMs[i] = 0;
+            stale[i] = false;
+        }
+    }
+
+    bool wants(bbq_protocol::Channel ch) const {
+        return (channels & bbq_protocol::channelBit(ch)) != 0;
+    }
+
+    // Add channels at rateMs, clamped to WS_SUB_MIN_RATE..WS_SUB_MAX_RATE.
+    // 0 means the channel's default: as produced for DATA, WS_CONTROL_RATE
+    // for CONTROL. DIAG ignores the rate and goes out batch by batch, as its
+    // samples cannot be coalesced. The newest frame of each is owed straight away.
+    void subscribe(uint8_t mask, uint32_t rateMsAsked) {
+        for (uint8_t i = 0; i < COUNT; i++) {
+            if (!(mask & (1u << i))) continue;
+            uint32_t r = rateMsAsked;
+            if (i == (uint8_t)bbq_protocol::Channel::DIAG) r = 0;
+            if (r == 0 && i == (uint8_t)bbq_protocol::Channel::CONTROL) r = WS_CONTROL_RATE;
+            if (r != 0 && r < WS_SUB_MIN_RATE) r = WS_SUB_MIN_RATE;
+            if (r > WS_SUB_MAX_RATE) r = WS_SUB_MAX_RATE;
+            rateMs[i] = (uint16_t)r;
+            lastMs[i] = 0;
+            stale[i] = true;
+        }
+        channels |= mask & (uint8_t)((1u << COUNT) - 1);
+    }
+
+    void unsubscribe(uint8_t mask) { channels &= (uint8_t)~mask; }
+
+    // The channel produced a frame
+    void produced(bbq_protocol::Channel ch) { stale[(uint8_t)ch] = true; }
+
+    // Whether the client should get the channel's newest frame now
+    bool due(bbq_protocol::Channel ch, uint32_t nowMs) const {
+        uint8_t i = (uint8_t)ch;
+        return wants(ch) && stale[i] && (rateMs[i] == 0 || nowMs - lastMs[i] >= rateMs[i]);
+    }
+
+    // A frame of the channel was queued (or held) for the client. A client
+    // kept up with keeps its cadence (lastMs steps by the rate), so polling
+    // at a coarser interval does not stretch it.
+    void delivered(bbq_protocol::Channel ch, uint32_t nowMs) {
+        uint8_t i = (uint8_t)ch;
+        uint32_t next = lastMs[i] + rateMs[i];
+        stale[i] = false;
+        bool onTime = nowMs - lastMs[i] < 2u * rateMs[i] && (int32_t)(nowMs - next) >= 0;
+        lastMs[i] = rateMs[i] != 0 && onTime ? next : nowMs;
+    }
+};
+
+// Per-connection WebSocket state
+struct WsClient {
+    uint32_t id;            // AsyncWebSocket client id / mongoose connection id
+    uint32_t connectedMs;
+    uint32_t lastSeenMs;    // Last frame or pong received
+    uint8_t  binVersion;    // Negotiated binary frame version, 0 = JSON
+    bool     historyPending;  // No history sent yet (waiting for a sync)
+    bool     syncPending;   // Sync received, answered by the next update()
+    uint32_t syncSession;   // Session and last point the client holds
+    uint32_t syncSince;
+    HistoryReplay replay;   // History chunks still to send
+    bbq_protocol::CommandAssembler command;  // Inbound command being reassembled
+    WsFlow   flow;          // Data frames queued for this client
+    WsSubscription sub;     // Channels and rates (data only until a sub)
+};
+
+// Fixed table of connected WebSocket clients, shared by the firmware web
+// server and the simulator. A new client is held back from broadcasts until
+// it sends a sync or WS_SYNC_TIMEOUT passes. Its hello (sent first) picks the
+// frame format and the sync says how much history it already holds; clients
+// that send neither get a full JSON replay. History goes out as a run of
+// chunks, and data broadcasts resume once the last one is sent. A client that
+// has sent nothing (not even a pong) for WS_PONG_TIMEOUT is reported stale.
+//
+// Entries keep their address while connected, so queued messages can point
+// at a client's WsFlow; size() and operator[] iterate the connected ones.
+// There is no lock: the table belongs to one task. The firmware web server
+// touches it only from the loop, which applies connects, disconnects and
+// commands the network task posts to a WsEventQueue (ws_events.h).
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class WsClientTable {
+public:
+    WsClientTable() : _count(0) {
+        for (uint8_t i = 0; i < WS_CLIENT_SLOTS; i++) {
+            _used[i] = false;
+            _slots[i].flow.pending.store(nullptr);
+        }
+    }
+
+    // Track a new connection. Returns nullptr if every slot is taken.
+    WsClient* add(uint32_t id, uint32_t nowMs) {
+        if (_count >= WS_CLIENT_SLOTS) return nullptr;
+        uint8_t slot = 0;
+        while (_used[slot]) slot++;
+        _used[slot] = true;
+        _order[_count++] = slot;
+
+        WsClient& c = _slots[slot];
+        c.id = id;
+        c.connectedMs = nowMs;
+        c.lastSeenMs = nowMs;
+        c.binVersion = 0;
+        c.historyPending = true;
+        c.syncPending = false;
+        c.syncSession = c.syncSince = 0;
+        c.replay.active = false;
+        c.command = bbq_protocol::CommandAssembler();
+        c.flow.reset();
+        c.sub.reset();
+        return &c;
+    }
+
+    void remove(uint32_t id) {
+        for (uint8_t i = 0; i < _count; i++) {
+            WsClient& c = _slots[_order[i]];
+            if (c.id == id) {
+                c.flow.reset();
+                _used[_order[i]] = false;
+                _order[i] = _order[--_count];
+                return;
+            }
+        }
+    }
+
+    WsClient* find(uint32_t id) {
+        for (uint8_t i = 0; i < _count; i++) {
+            if (_slots[_order[i]].id == id) return &_slots[_order[i]];
+        }
+        return nullptr;
+    }
+
+    // Next client still waiting for a sync after WS_SYNC_TIMEOUT, or nullptr
+    WsClient* nextSyncTimeout(uint32_t nowMs) {
+        for (uint8_t i = 0; i < _count; i++) {
+            WsClient& c = _slots[_order[i]];
+            if (c.historyPending && !c.syncPending &&
+                nowMs - c.connectedMs >= WS_SYNC_TIMEOUT) return &c;
+        }
+        return nullptr;
+    }
+
+    // Next client whose sync has not been answered yet, or nullptr
+    WsClient* nextSyncRequest() {
+        for (uint8_t i = 0; i < _count; i++) {
+            WsClient& c = _slots[_order[i]];
+            if (c.syncPending) return &c;
+        }
+        return nullptr;
+    }
+
+    // Next client silent for WS_PONG_TIMEOUT (dead connection), or nullptr
+    WsClient* nextStale(uint32_t nowMs) {
+        for (uint8_t i = 0; i < _count; i++) {
+            WsClient& c = _slots[_order[i]];
+            if (nowMs - c.lastSeenMs >= WS_PONG_TIMEOUT) return &c;
+        }
+        return nullptr;
+    }
+
+    uint8_t size() const { return _count; }
+    WsClient& operator[](uint8_t i) { return _slots[_order[i]]; }
+
+    // Whether a client has had its history and takes broadcasts
+    static bool isLive(const WsClient& c) { return !c.historyPending && !c.replay.active; }
+
+    // Whether any live client wants this frame format
+    bool anyBinary() const { return countLive(true) > 0; }
+    bool anyJson() const   { return countLive(false) > 0; }
+
+    // The channel produced a frame: every subscriber is owed it
+    void produced(bbq_protocol::Channel ch) {
+        for (uint8_t i = 0; i < _count; i++) _slots[_order[i]].sub.produced(ch);
+    }
+
+    // Live clients subscribed to the channel, due a frame or not
+    uint8_t countSubscribed(bbq_protocol::Channel ch) const {
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            const WsClient& c = _slots[_order[i]];
+            if (isLive(c) && c.sub.wants(ch)) n++;
+        }
+        return n;
+    }
+
+    // Live clients due a frame of the channel now, in this frame format
+    // (binary: 1 = binary, 0 = JSON, -1 = either)
+    uint8_t countDue(bbq_protocol::Channel ch, uint32_t nowMs, int8_t binary = -1) const {
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            const WsClient& c = _slots[_order[i]];
+            if (isLive(c) && c.sub.due(ch, nowMs) &&
+                (binary < 0 || (c.binVersion > 0) == (binary > 0))) n++;
+        }
+        return n;
+    }
+
+private:
+    uint8_t countLive(bool binary) const {
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            const WsClient& c = _slots[_order[i]];
+            if (isLive(c) && (c.binVersion > 0) == binary) n++;
+        }
+        return n;
+    }
+
+    WsClient _slots[WS_CLIENT_SLOTS];
+    bool     _used[WS_CLIENT_SLOTS];
+    uint8_t  _order[WS_CLIENT_SLOTS];   // Slots of connected clients, in no order
+    uint8_t  _count;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "config.h"
+#include "mpsc_queue.h"
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// WebSocket events as the network task sees them, for the loop to act on.
+// The client table, replays and sends belong to the loop; the event handler
+// only posts these, and update() drains them before it touches any client.
+enum class WsEventType : uint8_t {
+    CONNECT,        // A client connected
+    DISCONNECT,     // A client went away (its send queue is already gone)
+    TEXT,           // A piece of a text message (command)
+    SEEN            // A pong or a non-text frame: the client is alive
+};
+
+struct WsEvent {
+    WsEventType type = WsEventType::SEEN;
+    bool     start = false;     // TEXT: first piece of a message
+    bool     end = false;       // TEXT: last piece of a message
+    uint16_t len = 0;           // TEXT: bytes in data
+    uint32_t id = 0;            // AsyncWebSocket client id
+    uint32_t ms = 0;            // When it happened (millis)
+
+    // A piece longer than any command is cut to WS_CMD_MAX_LEN + 1 bytes,
+    // which is still too long for the CommandAssembler, so it is dropped there
+    char     data[WS_CMD_MAX_LEN + 1];
+
+    static WsEvent make(WsEventType type, uint32_t id, uint32_t ms) {
+        WsEvent e;
+        e.type = type;
+        e.id = id;
+        e.ms = ms;
+        return e;
+    }
+
+    static WsEvent text(uint32_t id, uint32_t ms, const char* data, size_t len,
+                        bool start, bool end) {
+        WsEvent e = make(WsEventType::TEXT, id, ms);
+        e.start = start;
+        e.end = end;
+        e.len = (uint16_t)(len > sizeof(e.data) ? sizeof(e.data) : len);
+        memcpy(e.data, data, e.len);
+        return e;
+    }
+};
+
+// The queue plus its counters. Any task may post (a disconnect can fire on
+// the loop when it aborts a client); only the loop drains.
+//
+// Pure C++ — no Arduino dependencies. Fully testable on native.
+class WsEventQueue {
+public:
+    WsEventQueue() : _posted(0), _dropped(0) {}
+
+    // Any producer. Returns false (and counts a drop) if the queue is full.
+    bool post(const WsEvent& e) {
+        if (!_queue.push(e)) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _posted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer only: handle every queued event in order. Returns the count.
+    template <typename Handle>
+    uint16_t drain(Handle handle) {
+        uint16_t n = 0;
+        WsEvent e;
+        while (_queue.pop(e)) {
+            handle(e);
+            n++;
+        }
+        return n;
+    }
+
+    uint32_t getPosted() const    { return _posted.load(std::memory_order_relaxed); }
+    uint32_t getDropped() const   { return _dropped.load(std::memory_order_relaxed); }
+    uint32_t getQueuePeak() const { return _queue.getHighWater(); }
+
+private:
+    MpscQueue<WsEvent, WS_EVENT_QUEUE_DEPTH> _queue;
+    std::atomic<uint32_t> _posted;
+    std::atomic<uint32_t> _dropped;
+};
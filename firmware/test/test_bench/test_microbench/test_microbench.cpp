@@ -0,0 +1,455 @@
+/**
+ * test_microbench.cpp
+ *
+ * Microbenchmarks for the pure C++ modules, run by the bench environment:
+ *
+ *   pio test -e bench
+ *
+ * Each benchmark reports ns/op (best of BENCH_REPEATS timed passes), heap
+ * allocations per op and bytes allocated per op, counted by hooking the
+ * allocator (malloc/calloc/realloc on glibc, operator new everywhere), plus
+ * the size of what the op produced. Results are printed and written as JSON
+ * to BENCH_RESULTS_PATH (or $BENCH_OUT) so runs on two commits can be
+ * compared with bench_compare.py.
+ *
+ * Benchmarks:
+ *   - buildDataMessage (no allocations)
+ *   - buildHistoryMessage over a full RAM buffer (600 points)
+ *   - parseCommand over a mix of commands (no allocations)
+ *   - GraphHistory::addPoint, amortized over condenses
+ *   - GraphHistory::condense (the addPoint that finds the buffer full)
+ *   - TempPredictor::computeSlope over a full window (through getMeat1Rate)
+ *   - splitRange across outputs and fan modes
+ *   - oversampleReduce (Hampel) over TEMP_AVG_SAMPLES conversions with a glitch
+ *   - CookSession::toCSV over 600 points
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------------------------
+// Minimal Arduino String stub for native build (CookSession::toCSV)
+// --------------------------------------------------------------------------
+
+class String {
+public:
+    String() : _data() {}
+    String(const char* s) : _data(s ? s : "") {}
+
+    String& operator+=(const char* s) {
+        if (s) _data += s;
+        return *this;
+    }
+
+    void reserve(size_t size) { _data.reserve(size); }
+    const char* c_str() const { return _data.c_str(); }
+    size_t length() const { return _data.length(); }
+
+private:
+    std::string _data;
+};
+
+#include "config.h"
+#include "web_protocol.h"
+#include "web_protocol.cpp"
+#include "data_message.cpp"
+#include "history_message.cpp"
+#include "binary_frame.cpp"
+#include "split_range.h"
+#include "oversample_filter.h"
+#include "temp_predictor.h"
+#include "temp_predictor.cpp"
+#include "display/graph_history.h"
+#include "display/graph_history.cpp"
+#include "cook_session.h"
+#include "cook_session.cpp"
+#include "session_export.cpp"
+#include "session_codec.cpp"
+#include "session_index.cpp"
+#include "session_rollup.cpp"
+#include "session_writer.cpp"
+
+using namespace bbq_protocol;
+
+#ifndef BENCH_RESULTS_PATH
+#define BENCH_RESULTS_PATH "bench_results.json"
+#endif
+#define BENCH_REPEATS 5         // Timed passes per benchmark; the fastest counts
+#define BENCH_MAX_RESULTS 16
+#define BENCH_SESSION_POINTS 600  // A full internal RAM buffer
+
+// --------------------------------------------------------------------------
+// Allocation hooks
+// --------------------------------------------------------------------------
+
+static size_t g_allocs = 0;
+static size_t g_allocBytes = 0;
+
+#if defined(__GLIBC__)
+#define BENCH_ALLOC_HOOK "malloc"
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t n);
+void  __libc_free(void* p);
+
+void* malloc(size_t n) {
+    g_allocs++;
+    g_allocBytes += n;
+    return __libc_malloc(n);
+}
+
+void* calloc(size_t n, size_t size) {
+    g_allocs++;
+    g_allocBytes += n * size;
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* p, size_t n) {
+    g_allocs++;
+    g_allocBytes += n;
+    return __libc_realloc(p, n);
+}
+
+void free(void* p) { __libc_free(p); }
+}
+
+// operator new goes through malloc, so it is already counted
+#else
+#define BENCH_ALLOC_HOOK "new"
+void* operator new(size_t n) {
+    g_allocs++;
+    g_allocBytes += n;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+#endif
+
+// --------------------------------------------------------------------------
+// Harness
+// --------------------------------------------------------------------------
+
+struct BenchResult {
+    const char* name;
+    uint32_t ops;
+    double   nsPerOp;
+    double   allocsPerOp;
+    double   allocBytesPerOp;
+    size_t   outBytes;          // What one op produced (0 = nothing measurable)
+};
+
+static BenchResult g_results[BENCH_MAX_RESULTS];
+static int g_resultCount = 0;
+
+static BenchResult& record(const char* name, uint32_t ops, double bestNs,
+                           size_t allocs, size_t allocBytes, size_t outBytes) {
+    BenchResult& r = g_results[g_resultCount < BENCH_MAX_RESULTS ? g_resultCount++ : BENCH_MAX_RESULTS - 1];
+    r.name = name;
+    r.ops = ops;
+    r.nsPerOp = bestNs / ops;
+    r.allocsPerOp = (double)allocs / ops;
+    r.allocBytesPerOp = (double)allocBytes / ops;
+    r.outBytes = outBytes;
+    printf("  %-36s %10.1f ns/op %8.2f allocs/op %10.1f B/op  out %zu B\n",
+           name, r.nsPerOp, r.allocsPerOp, r.allocBytesPerOp, outBytes);
+    return r;
+}
+
+// Run op(i) ops times per pass (after a warm-up pass), BENCH_REPEATS passes.
+// op returns the size of what it produced.
+template <typename Op>
+static BenchResult& bench(const char* name, uint32_t ops, Op op) {
+    volatile size_t sink = 0;
+    for (uint32_t i = 0; i < ops / 10 + 1; i++) sink += op(i);
+
+    double bestNs = 1e300;
+    size_t allocs = 0, allocBytes = 0, out = 0;
+    for (int rep = 0; rep < BENCH_REPEATS; rep++) {
+        size_t allocsBefore = g_allocs, bytesBefore = g_allocBytes;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ops; i++) out = op(i);
+        auto t1 = std::chrono::steady_clock::now();
+        allocs = g_allocs - allocsBefore;
+        allocBytes = g_allocBytes - bytesBefore;
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        if (ns < bestNs) bestNs = ns;
+        sink += out;
+    }
+    (void)sink;
+    return record(name, ops, bestNs, allocs, allocBytes, out);
+}
+
+// Make the compiler assume p's object is read and changed here, so work on
+// it can't be hoisted out of the timed loop
+static inline void escape(const void* p) {
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+static DataPayload makePayload() {
+    DataPayload d;
+    memset(&d, 0, sizeof(d));
+    d.ts = 1707600000;
+    d.pit = 225.5f;
+    d.meat1 = 145.2f;
+    d.meat2 = NAN;
+    d.fan = 45;
+    d.damper = 80;
+    d.sp = 225;
+    d.meat1Target = 203;
+    d.est = 1707614400;
+    d.fanMode = "fan_and_damper";
+    return d;
+}
+
+static std::vector<HistoryPoint> makeHistory(size_t count) {
+    std::vector<HistoryPoint> points(count);
+    for (size_t i = 0; i < count; i++) {
+        HistoryPoint& p = points[i];
+        p.ts = 1707600000 + (uint32_t)i * 5;
+        p.pit = 225.0f + 3.0f * sinf(i * 0.05f);
+        p.meat1 = 40.0f + i * 0.25f;
+        p.meat2 = (i % 97 == 0) ? NAN : 38.0f + i * 0.2f;
+        p.fan = (uint8_t)(i % 100);
+        p.damper = (uint8_t)((i * 3) % 100);
+        p.sp = 225.0f;
+        p.lid = (i % 150) < 3;
+    }
+    return points;
+}
+
+static void fillSession(CookSession& session, size_t count) {
+    std::vector<HistoryPoint> points = makeHistory(count);
+    for (const HistoryPoint& p : points) {
+        DataPoint dp;
+        memset(&dp, 0, sizeof(dp));
+        dp.timestamp = p.ts;
+        dp.pitTemp = (int16_t)(p.pit * 10.0f);
+        dp.meat1Temp = (int16_t)(p.meat1 * 10.0f);
+        dp.meat2Temp = std::isnan(p.meat2) ? 0 : (int16_t)(p.meat2 * 10.0f);
+        dp.fanPct = p.fan;
+        dp.damperPct = p.damper;
+        dp.flags = p.lid ? DP_FLAG_LID_OPEN : 0;
+        session.addPoint(dp);
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Protocol
+// --------------------------------------------------------------------------
+
+void test_bench_build_data_message(void) {
+    DataPayload d = makePayload();
+    char buf[512];
+    BenchResult& r = bench("buildDataMessage", 200000, [&](uint32_t i) {
+        d.ts = 1707600000 + i;
+        d.pit = 225.0f + (i & 7) * 0.1f;
+        return buildDataMessage(buf, sizeof(buf), d);
+    });
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(r.allocsPerOp * r.ops));
+    TEST_ASSERT_TRUE(r.outBytes > 0);
+}
+
+void test_bench_build_history_message(void) {
+    std::vector<HistoryPoint> points = makeHistory(BENCH_SESSION_POINTS);
+    BenchResult& r = bench("buildHistoryMessage/600", 300, [&](uint32_t) {
+        size_t len = 0;
+        char* msg = buildHistoryMessage(points.data(), points.size(), 225.0f, 203.0f, 0.0f, &len);
+        free(msg);
+        return len;
+    });
+    TEST_ASSERT_TRUE(r.outBytes > BENCH_SESSION_POINTS * 40);
+}
+
+void test_bench_parse_command(void) {
+    static const char* CMDS[] = {
+        "{\"type\":\"set\",\"sp\":250}",
+        "{\"type\":\"alarm\",\"meat1Target\":203,\"meat2Target\":185,\"pitBand\":15}",
+        "{\"type\":\"hello\",\"bin\":1}",
+        "{\"type\":\"sync\",\"session\":1707600000,\"since\":1707603000}",
+        "{\"type\":\"sub\",\"channels\":[\"data\",\"control\"],\"rateMs\":1000}",
+        "{\"type\":\"config\",\"fanMode\":\"fan_and_damper\"}",
+    };
+    static const size_t N = sizeof(CMDS) / sizeof(CMDS[0]);
+    size_t lens[N];
+    for (size_t i = 0; i < N; i++) lens[i] = strlen(CMDS[i]);
+
+    size_t unknown = 0;
+    BenchResult& r = bench("parseCommand", 300000, [&](uint32_t i) {
+        ParsedCommand cmd = parseCommand(CMDS[i % N], lens[i % N]);
+        if (cmd.type == CmdType::UNKNOWN) unknown++;
+        return lens[i % N];
+    });
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)unknown);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(r.allocsPerOp * r.ops));
+}
+
+// --------------------------------------------------------------------------
+// Graph history
+// --------------------------------------------------------------------------
+
+void test_bench_graph_add_point(void) {
+    static GraphHistory history;
+    BenchResult& r = bench("GraphHistory::addPoint", 1000000, [&](uint32_t i) {
+        history.addPoint(225.0f + (i & 15), 150.0f, 140.0f, 225.0f, false, false, (i & 63) == 0);
+        return (size_t)0;
+    });
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(r.allocsPerOp * r.ops));
+    TEST_ASSERT_TRUE(history.getCount() > GRAPH_HISTORY_SIZE / 2);
+}
+
+void test_bench_graph_condense(void) {
+    // Only the addPoint that finds the buffer full (and condenses it) is timed
+    static GraphHistory history;
+    const uint32_t CONDENSES = 2000;
+    double bestNs = 1e300;
+    size_t allocs = 0, allocBytes = 0;
+    for (int rep = 0; rep < BENCH_REPEATS; rep++) {
+        double ns = 0;
+        size_t allocsBefore = g_allocs, bytesBefore = g_allocBytes;
+        for (uint32_t c = 0; c < CONDENSES; c++) {
+            while (history.getCount() < GRAPH_HISTORY_SIZE) {
+                history.addPoint(225.0f, 150.0f, 140.0f, 225.0f, false, false, false);
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            history.addPoint(226.0f, 151.0f, 141.0f, 225.0f, false, false, true);
+            auto t1 = std::chrono::steady_clock::now();
+            ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        }
+        allocs = g_allocs - allocsBefore;
+        allocBytes = g_allocBytes - bytesBefore;
+        if (ns < bestNs) bestNs = ns;
+    }
+    record("GraphHistory::condense", CONDENSES, bestNs, allocs, allocBytes, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)allocs);
+    TEST_ASSERT_EQUAL_UINT16(GRAPH_HISTORY_SIZE / 2 + 1, history.getCount());
+}
+
+// --------------------------------------------------------------------------
+// Control
+// --------------------------------------------------------------------------
+
+void test_bench_compute_slope(void) {
+    TempPredictor predictor;
+    predictor.begin();
+    for (uint32_t i = 0; i < PREDICTOR_WINDOW_SIZE; i++) {
+        predictor.addSample(PREDICTOR_MEAT1, 1707600000 + i * 5, 150.0f + i * 0.05f);
+    }
+    float rate = 0;
+    BenchResult& r = bench("TempPredictor::computeSlope", 300000, [&](uint32_t) {
+        escape(&predictor);
+        rate = predictor.getMeat1Rate();
+        return (size_t)0;
+    });
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.6f, rate);  // 0.05 F per 5 s
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(r.allocsPerOp * r.ops));
+}
+
+void test_bench_split_range(void) {
+    static const char* MODES[] = { "fan_only", "fan_and_damper", "damper_primary" };
+    float sum = 0;
+    BenchResult& r = bench("splitRange", 1000000, [&](uint32_t i) {
+        SplitRangeOutput out = splitRange((float)(i % 101), MODES[i % 3], 30.0f);
+        sum += out.fanPercent;
+        return (size_t)0;
+    });
+    TEST_ASSERT_TRUE(sum > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(r.allocsPerOp * r.ops));
+}
+
+void test_bench_oversample_reduce(void) {
+    int16_t samples[TEMP_AVG_SAMPLES];
+    int16_t value = 0;
+    BenchResult& r = bench("oversampleReduce/hampel", 1000000, [&](uint32_t i) {
+        for (uint8_t k = 0; k < TEMP_AVG_SAMPLES; k++) samples[k] = (int16_t)(15000 + ((i + k) & 7));
+        samples[i % TEMP_AVG_SAMPLES] = (i & 1) ? 32767 : 0;   // One glitch per reading
+        escape(samples);
+        OversampleResult out = oversampleReduce(samples, TEMP_AVG_SAMPLES, OutlierFilter::HAMPEL,
+                                                TEMP_HAMPEL_K, TEMP_HAMPEL_MIN_SPREAD);
+        value = out.value;
+        return (size_t)0;
+    });
+    TEST_ASSERT_TRUE(value >= 15000 && value <= 15007);   // The glitch was dropped
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)(r.allocsPerOp * r.ops));
+}
+
+// --------------------------------------------------------------------------
+// Session
+// --------------------------------------------------------------------------
+
+void test_bench_session_to_csv(void) {
+    CookSession session;
+    fillSession(session, BENCH_SESSION_POINTS);
+    BenchResult& r = bench("CookSession::toCSV/600", 300, [&](uint32_t) {
+        return session.toCSV().length();
+    });
+    TEST_ASSERT_TRUE(r.outBytes > BENCH_SESSION_POINTS * 20);
+}
+
+// --------------------------------------------------------------------------
+// Results
+// --------------------------------------------------------------------------
+
+static void writeResults() {
+    const char* path = getenv("BENCH_OUT");
+    if (!path || !*path) path = BENCH_RESULTS_PATH;
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        printf("  could not write %s\n", path);
+        return;
+    }
+    fprintf(f, "{\n  \"compiler\": \"%s\",\n  \"alloc_hook\": \"%s\",\n  \"results\": [\n",
+            __VERSION__, BENCH_ALLOC_HOOK);
+    for (int i = 0; i < g_resultCount; i++) {
+        const BenchResult& r = g_results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"ops\": %u, \"ns_per_op\": %.2f, "
+                   "\"allocs_per_op\": %.3f, \"alloc_bytes_per_op\": %.1f, \"out_bytes\": %zu}%s\n",
+                r.name, r.ops, r.nsPerOp, r.allocsPerOp, r.allocBytesPerOp, r.outBytes,
+                i + 1 < g_resultCount ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    printf("  results written to %s\n", path);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Protocol
+    RUN_TEST(test_bench_build_data_message);
+    RUN_TEST(test_bench_build_history_message);
+    RUN_TEST(test_bench_parse_command);
+
+    // Graph history
+    RUN_TEST(test_bench_graph_add_point);
+    RUN_TEST(test_bench_graph_condense);
+
+    // Control
+    RUN_TEST(test_bench_compute_slope);
+    RUN_TEST(test_bench_split_range);
+    RUN_TEST(test_bench_oversample_reduce);
+
+    // Session
+    RUN_TEST(test_bench_session_to_csv);
+
+    writeResults();
+    return UNITY_END();
+}
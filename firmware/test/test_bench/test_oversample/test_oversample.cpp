@@ -0,0 +1,272 @@
+/**
+ * test_oversample.cpp
+ *
+ * Glitch-trace benchmark for the probe oversampling filter, run by the
+ * bench environment:
+ *
+ *   pio test -e bench
+ *
+ * A probe is simulated at the ADC: a true temperature turned into ADS1115
+ * counts and Gaussian conversion noise, first on its own, then with
+ * injected glitches (full-scale I2C reads of 0 or 32767, and ignition-spark
+ * spikes of a few hundred to a few thousand counts). Every pipeline gets
+ * the same TEMP_AVG_SAMPLES conversions per one-second interval, so
+ * acquisition latency is the same for all of them; "single" uses only the
+ * last one, as the firmware did before oversampling. Each reading then goes through TempManager's
+ * open/short checks, Steinhart-Hart and EMA.
+ *
+ * Reported per pipeline: standard deviation and worst error of the
+ * filtered temperature, standard deviation of its change per interval (what
+ * the PID derivative term sees), intervals a glitch marked the probe
+ * disconnected, step-response delay, and ns per reduction (timer overhead
+ * included; the microbench has the exact figure).
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <cmath>
+
+#include "config.h"
+#include "adc_diag.h"
+#include "units.h"
+#include "oversample_filter.h"
+
+#define TRACE_INTERVALS   20000   // One-second intervals per trace (~5.5 h)
+#define NOISE_COUNTS      4.0f    // Gaussian conversion noise (std dev, counts)
+#define GLITCH_PCT        1       // Conversions hit by a glitch (percent)
+#define PIT_F             225.0f
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Probe model
+// --------------------------------------------------------------------------
+
+// Deterministic noise so every pipeline sees the same trace
+struct Rng {
+    uint32_t state;
+    explicit Rng(uint32_t seed) : state(seed) {}
+
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+    float gaussian() {
+        float u1 = uniform() + 1e-7f, u2 = uniform();
+        return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+    }
+};
+
+// TempManager's conversion (Steinhart-Hart, default coefficients), in F
+static float countsToF(float counts) {
+    float r = REFERENCE_RESISTANCE * ((float)ADC_MAX_VALUE / counts - 1.0f);
+    float lnR = logf(r);
+    float invT = THERM_A + THERM_B * lnR + THERM_C * lnR * lnR * lnR;
+    return celsiusToFahrenheit(1.0f / invT - 273.15f);
+}
+
+// Counts for a temperature: counts rise with temperature, so bisect
+static float fToCounts(float f) {
+    float lo = ERROR_PROBE_SHORT_THRESHOLD + 1, hi = ERROR_PROBE_OPEN_THRESHOLD - 1;
+    for (int i = 0; i < 40; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (countsToF(mid) < f) lo = mid;
+        else                    hi = mid;
+    }
+    return 0.5f * (lo + hi);
+}
+
+static int16_t convert(Rng& rng, float trueCounts, uint32_t glitchPct) {
+    float c = trueCounts + NOISE_COUNTS * rng.gaussian();
+    if (rng.next() % 100 < glitchPct) {
+        uint32_t kind = rng.next() % 4;
+        if (kind == 0)      c = 0;                                    // I2C read of zeros
+        else if (kind == 1) c = 32767;                                // I2C read of ones
+        else {
+            float spike = 300.0f + 2700.0f * rng.uniform();           // Ignition spark
+            c += (kind == 2) ? spike : -spike;
+        }
+    }
+    if (c < 0) c = 0;
+    if (c > 32767) c = 32767;
+    return (int16_t)lroundf(c);
+}
+
+// TempManager::applyReading: open/short checks reset the EMA, else convert and smooth
+struct ProbeModel {
+    float ema = 0.0f;
+    bool  first = true;
+    bool  connected = false;
+
+    void apply(int16_t raw) {
+        if (raw >= ERROR_PROBE_OPEN_THRESHOLD || raw <= ERROR_PROBE_SHORT_THRESHOLD) {
+            connected = false;
+            first = true;
+            return;
+        }
+        float f = countsToF(raw);
+        ema = first ? f : (float)TEMP_EMA_ALPHA * f + (1.0f - (float)TEMP_EMA_ALPHA) * ema;
+        first = false;
+        connected = true;
+    }
+};
+
+// --------------------------------------------------------------------------
+// Pipelines
+// --------------------------------------------------------------------------
+
+enum class Pipeline : uint8_t { SINGLE, MEAN, MEDIAN, HAMPEL };
+static const char* PIPELINE_NAMES[] = { "single", "mean", "median", "hampel" };
+static const uint8_t PIPELINES = 4;
+
+static int16_t reduce(Pipeline p, const int16_t* s, uint8_t n) {
+    switch (p) {
+        case Pipeline::SINGLE: return s[n - 1];
+        case Pipeline::MEAN:
+            return oversampleReduce(s, n, OutlierFilter::MEAN, TEMP_HAMPEL_K, TEMP_HAMPEL_MIN_SPREAD).value;
+        case Pipeline::MEDIAN:
+            return oversampleReduce(s, n, OutlierFilter::MEDIAN, TEMP_HAMPEL_K, TEMP_HAMPEL_MIN_SPREAD).value;
+        case Pipeline::HAMPEL:
+        default:
+            return oversampleReduce(s, n, OutlierFilter::HAMPEL, TEMP_HAMPEL_K, TEMP_HAMPEL_MIN_SPREAD).value;
+    }
+}
+
+struct TraceResult {
+    double stdDevF;         // Filtered temperature around the true one
+    double maxErrF;
+    double slopeStdDevF;    // Change per interval (derivative term input)
+    uint32_t dropouts;      // Intervals shown as disconnected
+    uint32_t stepIntervals; // Intervals to 90 % of a 10 F step
+    double nsPerReduce;
+};
+
+// Steady pit, then a clean 10 F step for the delay
+static TraceResult runTrace(Pipeline p, uint32_t glitchPct) {
+    TraceResult r = {};
+    Rng rng(0x5EED1234u);
+    ProbeModel probe;
+    const float trueCounts = fToCounts(PIT_F);
+    int16_t s[OVERSAMPLE_MAX_SAMPLES];
+
+    double sum = 0, sq = 0, slopeSq = 0;
+    uint32_t n = 0;
+    float last = PIT_F;
+    double ns = 0;
+    for (uint32_t i = 0; i < TRACE_INTERVALS; i++) {
+        for (uint8_t k = 0; k < TEMP_AVG_SAMPLES; k++) s[k] = convert(rng, trueCounts, glitchPct);
+
+        auto t0 = std::chrono::steady_clock::now();
+        int16_t raw = reduce(p, s, TEMP_AVG_SAMPLES);
+        auto t1 = std::chrono::steady_clock::now();
+        ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+
+        probe.apply(raw);
+        if (!probe.connected) {
+            r.dropouts++;
+            continue;
+        }
+        if (i < 30) {               // Let the EMA settle
+            last = probe.ema;
+            continue;
+        }
+        double err = probe.ema - PIT_F;
+        sum += err;
+        sq += err * err;
+        if (fabs(err) > r.maxErrF) r.maxErrF = fabs(err);
+        slopeSq += (probe.ema - last) * (probe.ema - last);
+        last = probe.ema;
+        n++;
+    }
+    double mean = sum / n;
+    r.stdDevF = sqrt(sq / n - mean * mean);
+    r.slopeStdDevF = sqrt(slopeSq / n);
+    r.nsPerReduce = ns / TRACE_INTERVALS;
+
+    // Step response without noise: the delay the pipeline itself adds
+    ProbeModel step;
+    const float before = fToCounts(PIT_F), after = fToCounts(PIT_F + 10.0f);
+    for (uint8_t k = 0; k < TEMP_AVG_SAMPLES; k++) s[k] = (int16_t)lroundf(before);
+    for (int i = 0; i < 10; i++) step.apply(reduce(p, s, TEMP_AVG_SAMPLES));
+    for (uint8_t k = 0; k < TEMP_AVG_SAMPLES; k++) s[k] = (int16_t)lroundf(after);
+    for (uint32_t i = 1; i < 100; i++) {
+        step.apply(reduce(p, s, TEMP_AVG_SAMPLES));
+        if (step.ema >= PIT_F + 9.0f) {
+            r.stepIntervals = i;
+            break;
+        }
+    }
+    return r;
+}
+
+// --------------------------------------------------------------------------
+// Benchmark
+// --------------------------------------------------------------------------
+
+static void runAll(TraceResult* res, uint32_t glitchPct) {
+    printf("  %u samples/interval, noise %.1f counts, %u%% glitches\n",
+           (unsigned)TEMP_AVG_SAMPLES, NOISE_COUNTS, (unsigned)glitchPct);
+    printf("  %-8s %10s %10s %12s %9s %6s %10s\n",
+           "pipeline", "stddev F", "max err F", "slope sd F", "dropouts", "step", "ns/reduce");
+    for (uint8_t i = 0; i < PIPELINES; i++) {
+        res[i] = runTrace((Pipeline)i, glitchPct);
+        printf("  %-8s %10.3f %10.3f %12.3f %9u %6u %10.1f\n", PIPELINE_NAMES[i],
+               res[i].stdDevF, res[i].maxErrF, res[i].slopeStdDevF, res[i].dropouts,
+               res[i].stepIntervals, res[i].nsPerReduce);
+    }
+}
+
+void test_bench_noise_only(void) {
+    TraceResult res[PIPELINES];
+    runAll(res, 0);
+    const TraceResult& single = res[(int)Pipeline::SINGLE];
+    const TraceResult& hampel = res[(int)Pipeline::HAMPEL];
+
+    // Averaging four conversions: about half the spread of one
+    TEST_ASSERT_TRUE(hampel.stdDevF < single.stdDevF * 0.7);
+    TEST_ASSERT_TRUE(res[(int)Pipeline::MEAN].stdDevF < single.stdDevF * 0.7);
+    TEST_ASSERT_EQUAL_UINT32(0, hampel.dropouts);
+    TEST_ASSERT_EQUAL_UINT32(single.stepIntervals, hampel.stepIntervals);
+}
+
+void test_bench_glitch_traces(void) {
+    TraceResult res[PIPELINES];
+    runAll(res, GLITCH_PCT);
+    const TraceResult& single = res[(int)Pipeline::SINGLE];
+    const TraceResult& mean   = res[(int)Pipeline::MEAN];
+    const TraceResult& hampel = res[(int)Pipeline::HAMPEL];
+
+    // Lower variance than one conversion or a plain mean of the same samples
+    TEST_ASSERT_TRUE(hampel.stdDevF < single.stdDevF / 4);
+    TEST_ASSERT_TRUE(hampel.stdDevF < mean.stdDevF / 4);
+    TEST_ASSERT_TRUE(hampel.slopeStdDevF < single.slopeStdDevF / 4);
+    TEST_ASSERT_TRUE(hampel.maxErrF < single.maxErrF);
+
+    // A full-scale glitch no longer reads as an unplugged probe
+    TEST_ASSERT_TRUE(single.dropouts > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, hampel.dropouts);
+
+    // Same delay: the filter works within one interval's samples
+    TEST_ASSERT_EQUAL_UINT32(single.stepIntervals, hampel.stepIntervals);
+    TEST_ASSERT_EQUAL_UINT32(mean.stepIntervals, hampel.stepIntervals);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bench_noise_only);
+    RUN_TEST(test_bench_glitch_traces);
+
+    return UNITY_END();
+}
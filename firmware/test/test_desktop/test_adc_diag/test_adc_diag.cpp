@@ -0,0 +1,362 @@
+/**
+ * test_adc_diag.cpp
+ *
+ * Tests for the raw ADC diagnostic stream: the lock-free ring the sampler
+ * task pushes into, the binary diag frames the web server batches it into,
+ * and the "diag" subscription channel.
+ *
+ * Tests cover:
+ *   - Counts -> ohms through the reference divider
+ *   - AdcDiagRing: order kept across batched drains, a full ring drops (and
+ *     counts) rather than blocks
+ *   - Diag frame byte layout, round trip, saturating time deltas and a
+ *     micros() wrap, rejection of short/foreign/newer/truncated frames
+ *   - Diag subscriptions ignore the rate asked for: every batch goes out
+ *   - Sampler thread at 860 samples/s for 0.5 s drained every
+ *     WS_CHANGE_POLL_MS: nothing dropped, every sample framed in order
+ *   - Benchmark: ring + framing throughput with an unpaced producer
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "adc_diag.h"
+#include "binary_frame.h"
+#include "binary_frame.cpp"
+#include "ws_clients.h"
+
+using namespace bbq_protocol;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+static AdcSample makeSample(uint32_t us, uint8_t probe, int16_t raw) {
+    AdcSample s;
+    s.us = us;
+    s.probe = probe;
+    s.raw = raw;
+    s.ohms = adcCountsToOhms(raw);
+    return s;
+}
+
+static uint16_t le16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t le32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#define DIAG_FRAME_MAX (BIN_DIAG_HEADER_SIZE + WS_DIAG_BATCH_MAX * BIN_DIAG_RECORD_SIZE)
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: ring
+// --------------------------------------------------------------------------
+
+void test_counts_to_ohms(void) {
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, 0.0f, adcCountsToOhms(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, 0.0f, adcCountsToOhms(-5));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, (float)REFERENCE_RESISTANCE, adcCountsToOhms(ADC_MAX_VALUE / 2 + 1));
+    TEST_ASSERT_TRUE(adcCountsToOhms(2626) > adcCountsToOhms(21895));  // Cold reads higher
+}
+
+void test_ring_keeps_order_across_drains(void) {
+    AdcDiagRing ring;
+    for (uint32_t i = 0; i < 300; i++) {
+        TEST_ASSERT_TRUE(ring.push(makeSample(i * 1163, i % 3, (int16_t)(20000 + i))));
+    }
+
+    AdcSample batch[WS_DIAG_BATCH_MAX];
+    uint32_t next = 0;
+    uint16_t n;
+    while ((n = ring.drain(batch, WS_DIAG_BATCH_MAX)) > 0) {
+        TEST_ASSERT_TRUE(n <= WS_DIAG_BATCH_MAX);
+        for (uint16_t i = 0; i < n; i++, next++) {
+            TEST_ASSERT_EQUAL_UINT32(next * 1163, batch[i].us);
+            TEST_ASSERT_EQUAL_INT16(20000 + next, batch[i].raw);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(300, next);
+    TEST_ASSERT_EQUAL_UINT32(300, ring.getPushed());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(300, ring.getHighWater());
+}
+
+void test_full_ring_drops(void) {
+    AdcDiagRing ring;
+    const uint32_t cap = (uint32_t)AdcDiagRing::capacity();
+    for (uint32_t i = 0; i < cap + 5; i++) ring.push(makeSample(i, 0, 1000));
+    TEST_ASSERT_EQUAL_UINT32(cap, ring.getPushed());
+    TEST_ASSERT_EQUAL_UINT32(5, ring.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(cap, ring.size());
+
+    // The oldest are kept; the sampler resumes once the consumer catches up
+    AdcSample s;
+    TEST_ASSERT_EQUAL_UINT16(1, ring.drain(&s, 1));
+    TEST_ASSERT_EQUAL_UINT32(0, s.us);
+    TEST_ASSERT_TRUE(ring.push(makeSample(999999, 1, 1000)));
+}
+
+// --------------------------------------------------------------------------
+// Tests: diag frame
+// --------------------------------------------------------------------------
+
+void test_diag_frame_layout(void) {
+    AdcSample s[2] = { makeSample(1000000, 0, 21895), makeSample(1001163, 2, -3) };
+    uint8_t buf[DIAG_FRAME_MAX];
+    size_t len = encodeDiagFrame(buf, sizeof(buf), 7, 42, s, 2);
+
+    TEST_ASSERT_EQUAL_UINT32(BIN_DIAG_HEADER_SIZE + 2 * BIN_DIAG_RECORD_SIZE, len);
+    TEST_ASSERT_EQUAL_UINT8(BIN_FRAME_DIAG, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(BIN_PROTOCOL_VERSION, buf[1]);
+    TEST_ASSERT_EQUAL_UINT8(7, buf[2]);
+    TEST_ASSERT_EQUAL_UINT8(2, buf[3]);
+    TEST_ASSERT_EQUAL_UINT32(42, le32(buf + 4));
+    TEST_ASSERT_EQUAL_UINT32(1000000, le32(buf + 8));
+
+    const uint8_t* r0 = buf + BIN_DIAG_HEADER_SIZE;
+    const uint8_t* r1 = r0 + BIN_DIAG_RECORD_SIZE;
+    TEST_ASSERT_EQUAL_UINT16(0, le16(r0));
+    TEST_ASSERT_EQUAL_UINT8(0, r0[2]);
+    TEST_ASSERT_EQUAL_INT16(21895, (int16_t)le16(r0 + 3));
+    uint32_t bits = le32(r0 + 5);
+    float ohms;
+    memcpy(&ohms, &bits, sizeof(ohms));
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, s[0].ohms, ohms);
+    TEST_ASSERT_EQUAL_UINT16(1163, le16(r1));
+    TEST_ASSERT_EQUAL_UINT8(2, r1[2]);
+    TEST_ASSERT_EQUAL_INT16(-3, (int16_t)le16(r1 + 3));
+}
+
+void test_diag_frame_round_trip(void) {
+    // Crosses the micros() wrap, then a gap too long for a u16 delta
+    AdcSample in[4] = {
+        makeSample(0xFFFFFF00u, 0, 2626),
+        makeSample(0x00000300u, 1, 21895),
+        makeSample(0x00000300u + 100000, 2, 31233),
+        makeSample(0x00000300u + 101163, 0, 32767),
+    };
+    uint8_t buf[DIAG_FRAME_MAX];
+    size_t len = encodeDiagFrame(buf, sizeof(buf), 255, 0, in, 4);
+
+    DiagFrameInfo info;
+    AdcSample out[4];
+    TEST_ASSERT_TRUE(decodeDiagFrame(buf, len, info, out, 4));
+    TEST_ASSERT_EQUAL_UINT8(255, info.seq);
+    TEST_ASSERT_EQUAL_UINT8(4, info.count);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFF00u, info.t0);
+    TEST_ASSERT_EQUAL_UINT32(in[1].us, out[1].us);                  // 0x400 us across the wrap
+    TEST_ASSERT_EQUAL_UINT32(in[1].us + 0xFFFF, out[2].us);         // Saturated
+    TEST_ASSERT_EQUAL_UINT32(in[1].us + 0xFFFF + 1163, out[3].us);  // Later deltas still exact
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_UINT8(in[i].probe, out[i].probe);
+        TEST_ASSERT_EQUAL_INT16(in[i].raw, out[i].raw);
+        TEST_ASSERT_FLOAT_WITHIN(0.0f, in[i].ohms, out[i].ohms);
+    }
+
+    // An empty batch is a bare header
+    TEST_ASSERT_EQUAL_UINT32(BIN_DIAG_HEADER_SIZE, encodeDiagFrame(buf, sizeof(buf), 0, 3, in, 0));
+    TEST_ASSERT_TRUE(decodeDiagFrame(buf, BIN_DIAG_HEADER_SIZE, info, out, 4));
+    TEST_ASSERT_EQUAL_UINT8(0, info.count);
+    TEST_ASSERT_EQUAL_UINT32(3, info.dropped);
+}
+
+void test_diag_frame_rejects(void) {
+    AdcSample s[3] = { makeSample(0, 0, 100), makeSample(1, 1, 200), makeSample(2, 2, 300) };
+    uint8_t buf[DIAG_FRAME_MAX];
+    TEST_ASSERT_EQUAL_UINT32(0, encodeDiagFrame(buf, BIN_DIAG_HEADER_SIZE + 2 * BIN_DIAG_RECORD_SIZE,
+                                                0, 0, s, 3));
+    size_t len = encodeDiagFrame(buf, sizeof(buf), 0, 0, s, 3);
+
+    DiagFrameInfo info;
+    AdcSample out[3];
+    TEST_ASSERT_FALSE(decodeDiagFrame(buf, BIN_DIAG_HEADER_SIZE - 1, info, out, 3));
+    TEST_ASSERT_FALSE(decodeDiagFrame(buf, len - 1, info, out, 3));     // Record cut short
+
+    uint8_t copy[DIAG_FRAME_MAX];
+    memcpy(copy, buf, len);
+    copy[0] = BIN_FRAME_DATA;
+    TEST_ASSERT_FALSE(decodeDiagFrame(copy, len, info, out, 3));
+    memcpy(copy, buf, len);
+    copy[1] = BIN_PROTOCOL_VERSION + 1;
+    TEST_ASSERT_FALSE(decodeDiagFrame(copy, len, info, out, 3));
+
+    // A smaller output array takes the first samples only
+    TEST_ASSERT_TRUE(decodeDiagFrame(buf, len, info, out, 1));
+    TEST_ASSERT_EQUAL_UINT8(3, info.count);
+    TEST_ASSERT_EQUAL_INT16(100, out[0].raw);
+}
+
+// --------------------------------------------------------------------------
+// Tests: subscription
+// --------------------------------------------------------------------------
+
+void test_diag_subscription_every_batch(void) {
+    WsClientTable table;
+    WsClient* viewer = table.add(1, 0);
+    WsClient* diag = table.add(2, 0);
+    viewer->historyPending = false;
+    diag->historyPending = false;
+    diag->binVersion = 1;
+
+    TEST_ASSERT_EQUAL_STRING("diag", channelName(Channel::DIAG));
+    TEST_ASSERT_EQUAL_UINT8(0, table.countSubscribed(Channel::DIAG));
+
+    // The rate is ignored: samples cannot be coalesced into a newer batch
+    diag->sub.subscribe(channelBit(Channel::DIAG), 5000);
+    TEST_ASSERT_EQUAL_UINT16(0, diag->sub.rateMs[(uint8_t)Channel::DIAG]);
+    TEST_ASSERT_EQUAL_UINT8(1, table.countSubscribed(Channel::DIAG));
+
+    for (uint32_t t = 100; t <= 1000; t += 100) {
+        table.produced(Channel::DIAG);
+        TEST_ASSERT_EQUAL_UINT8(1, table.countDue(Channel::DIAG, t));
+        TEST_ASSERT_TRUE(diag->sub.due(Channel::DIAG, t));
+        diag->sub.delivered(Channel::DIAG, t);
+        TEST_ASSERT_FALSE(viewer->sub.due(Channel::DIAG, t));
+    }
+
+    diag->sub.unsubscribe(channelBit(Channel::DIAG));
+    TEST_ASSERT_EQUAL_UINT8(0, table.countSubscribed(Channel::DIAG));
+    TEST_ASSERT_TRUE(diag->sub.wants(Channel::DATA));
+}
+
+// --------------------------------------------------------------------------
+// Scenario: sustained stream
+// --------------------------------------------------------------------------
+
+void test_sustained_stream(void) {
+    // The sampler thread paces itself like the device task; the consumer
+    // drains and frames on the web server's poll interval
+    const uint32_t RATE = 860;
+    const uint32_t TOTAL = RATE / 2;
+    AdcDiagRing ring;
+    std::atomic<bool> done(false);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread sampler([&]() {
+        auto next = t0;
+        for (uint32_t i = 0; i < TOTAL; i++) {
+            next += std::chrono::microseconds(1000000 / RATE);
+            std::this_thread::sleep_until(next);
+            ring.push(makeSample(i * (1000000 / RATE), i % 3, (int16_t)(21000 + i % 1000)));
+        }
+        done.store(true);
+    });
+
+    AdcSample batch[WS_DIAG_BATCH_MAX];
+    AdcSample decoded[WS_DIAG_BATCH_MAX];
+    uint8_t frame[DIAG_FRAME_MAX];
+    uint32_t received = 0, frames = 0, bytes = 0;
+    bool inOrder = true;
+    uint8_t seq = 0;
+    for (;;) {
+        bool last = done.load();
+        uint16_t n;
+        while ((n = ring.drain(batch, WS_DIAG_BATCH_MAX)) > 0) {
+            size_t len = encodeDiagFrame(frame, sizeof(frame), seq++, ring.getDropped(),
+                                         batch, (uint8_t)n);
+            DiagFrameInfo info;
+            TEST_ASSERT_TRUE(decodeDiagFrame(frame, len, info, decoded, WS_DIAG_BATCH_MAX));
+            for (uint8_t i = 0; i < info.count; i++, received++) {
+                if (decoded[i].us != received * (1000000 / RATE)) inOrder = false;
+            }
+            frames++;
+            bytes += (uint32_t)len;
+        }
+        if (last) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(WS_CHANGE_POLL_MS));
+    }
+    sampler.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("  %u samples in %.2f s (%.0f/s): %u frames, %u B (%.0f B/s), ring peak %u/%u, %u dropped\n",
+           received, secs, received / secs, frames, bytes, bytes / secs,
+           ring.getHighWater(), (unsigned)AdcDiagRing::capacity(), ring.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(TOTAL, received);
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getDropped());
+    TEST_ASSERT_TRUE(ring.getHighWater() < AdcDiagRing::capacity() / 2);
+}
+
+// --------------------------------------------------------------------------
+// Benchmark: unpaced producer
+// --------------------------------------------------------------------------
+
+#define BENCH_SAMPLES 200000
+
+void test_benchmark_throughput(void) {
+    AdcDiagRing ring;
+    std::atomic<bool> done(false);
+    uint32_t fullSpins = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::thread sampler([&]() {
+        for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+            AdcSample s = makeSample(i, i % 3, (int16_t)(i & 0x3FFF));
+            while (!ring.push(s)) {
+                fullSpins++;
+                std::this_thread::yield();
+            }
+        }
+        done.store(true);
+    });
+
+    AdcSample batch[WS_DIAG_BATCH_MAX];
+    uint8_t frame[DIAG_FRAME_MAX];
+    uint32_t received = 0;
+    volatile uint32_t sink = 0;
+    for (;;) {
+        bool last = done.load();
+        uint16_t n;
+        while ((n = ring.drain(batch, WS_DIAG_BATCH_MAX)) > 0) {
+            size_t len = encodeDiagFrame(frame, sizeof(frame), 0, 0, batch, (uint8_t)n);
+            sink += frame[len - 1];
+            received += n;
+        }
+        if (last && ring.size() == 0) break;
+    }
+    sampler.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    (void)sink;
+
+    printf("  %u samples pushed, drained and framed in %.3f s: %.2f M samples/s "
+           "(%.0fx the ADS1115's 860 SPS); producer found the ring full %u times\n",
+           received, secs, received / secs / 1e6, received / secs / 860.0, fullSpins);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_SAMPLES, received);
+    TEST_ASSERT_TRUE(received / secs > 100.0 * 860.0);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Ring
+    RUN_TEST(test_counts_to_ohms);
+    RUN_TEST(test_ring_keeps_order_across_drains);
+    RUN_TEST(test_full_ring_drops);
+
+    // Diag frame
+    RUN_TEST(test_diag_frame_layout);
+    RUN_TEST(test_diag_frame_round_trip);
+    RUN_TEST(test_diag_frame_rejects);
+
+    // Subscription
+    RUN_TEST(test_diag_subscription_every_batch);
+
+    // Scenario
+    RUN_TEST(test_sustained_stream);
+
+    // Benchmark
+    RUN_TEST(test_benchmark_throughput);
+
+    return UNITY_END();
+}
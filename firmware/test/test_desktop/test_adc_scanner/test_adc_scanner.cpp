@@ -0,0 +1,239 @@
+/**
+ * test_adc_scanner.cpp
+ *
+ * Tests for the non-blocking probe acquisition state machine, driven by a
+ * mock single-shot ADC with a configurable conversion latency and a fake
+ * microsecond clock.
+ *
+ * Tests cover:
+ *   - Sweep order: pit, meat1, meat2, then the spare input
+ *   - One conversion collected per 10 ms tick at 128 SPS; never a wait
+ *   - Slower conversions span several ticks; ready is only asked, not awaited
+ *   - Timeouts and start failures leave the slot invalid, the sweep goes on
+ *   - A sweep asked for while one runs is skipped; abort drops the sweep
+ *   - Stats: conversions, longest conversion, sweep duration
+ *   - Oversampling: channels interleaved round by round, samples per slot
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "adc_scanner.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Mock ADC: a conversion is ready latencyUs after start() on a fake clock
+// --------------------------------------------------------------------------
+
+struct MockAdc {
+    uint32_t nowUs = 0;
+    uint32_t latencyUs = ADC_CONVERSION_US;
+    int16_t  value[4] = {1000, 2000, 3000, 4000};
+    bool     failStart[4] = {};
+    bool     stuck[4] = {};         // Never reports ready
+
+    // What the scanner did
+    uint8_t  started[16] = {};
+    uint8_t  startCount = 0;
+    uint32_t readyCalls = 0;
+    uint8_t  channel = 0;
+    uint32_t startedUs = 0;
+    bool     converting = false;
+
+    bool start(uint8_t ch) {
+        if (failStart[ch]) return false;
+        if (startCount < sizeof(started)) started[startCount] = ch;
+        startCount++;
+        channel = ch;
+        startedUs = nowUs;
+        converting = true;
+        return true;
+    }
+
+    bool ready() {
+        readyCalls++;
+        return converting && !stuck[channel] && nowUs - startedUs >= latencyUs;
+    }
+
+    int16_t read() {
+        converting = false;
+        return value[channel];
+    }
+};
+
+static const uint8_t CHANNELS[4] = {
+    ADC_CHANNEL_PIT, ADC_CHANNEL_MEAT1, ADC_CHANNEL_MEAT2, ADC_CHANNEL_SPARE
+};
+
+// Tick every tickUs until the sweep completes; returns the ticks it took
+template <typename Scanner>
+static uint32_t runSweep(Scanner& scan, MockAdc& adc, uint32_t tickUs, uint32_t maxTicks = 100) {
+    scan.requestSweep(adc.nowUs);
+    for (uint32_t t = 1; t <= maxTicks; t++) {
+        adc.nowUs += tickUs;
+        if (scan.poll(adc.nowUs)) return t;
+    }
+    return 0;
+}
+
+// --------------------------------------------------------------------------
+// Tests
+// --------------------------------------------------------------------------
+
+void test_sweep_order_includes_spare(void) {
+    MockAdc adc;
+    AdcScanner<MockAdc> scan(adc, CHANNELS, 4, ADC_CONVERSION_TIMEOUT_US);
+
+    TEST_ASSERT_EQUAL_UINT32(4, runSweep(scan, adc, 10000));
+    TEST_ASSERT_EQUAL_UINT8(4, adc.startCount);
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_UINT8(CHANNELS[i], adc.started[i]);
+        TEST_ASSERT_TRUE(scan.isValid(i));
+        TEST_ASSERT_EQUAL_INT16(adc.value[CHANNELS[i]], scan.getRaw(i));
+    }
+    TEST_ASSERT_EQUAL_UINT8(ADC_CHANNEL_SPARE, scan.getChannel(3));
+    TEST_ASSERT_FALSE(scan.busy());
+}
+
+void test_one_conversion_per_tick(void) {
+    MockAdc adc;
+    AdcScanner<MockAdc> scan(adc, CHANNELS, 4, ADC_CONVERSION_TIMEOUT_US);
+
+    scan.requestSweep(adc.nowUs);
+    TEST_ASSERT_EQUAL_UINT8(1, adc.startCount);   // Started, not waited for
+    TEST_ASSERT_EQUAL_UINT32(0, adc.readyCalls);
+
+    for (uint8_t t = 1; t <= 3; t++) {
+        adc.nowUs += 10000;
+        TEST_ASSERT_FALSE(scan.poll(adc.nowUs));
+        TEST_ASSERT_EQUAL_UINT8(t + 1, adc.startCount);
+        TEST_ASSERT_EQUAL_UINT32(t, adc.readyCalls);   // One question per tick
+    }
+    adc.nowUs += 10000;
+    TEST_ASSERT_TRUE(scan.poll(adc.nowUs));
+    TEST_ASSERT_FALSE(scan.poll(adc.nowUs));          // Reported once
+    TEST_ASSERT_EQUAL_UINT32(40000, scan.getStats().lastSweepUs);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.getStats().sweeps);
+}
+
+void test_slow_conversion_spans_ticks(void) {
+    MockAdc adc;
+    adc.latencyUs = 25000;                              // e.g. a slower data rate
+    AdcScanner<MockAdc> scan(adc, CHANNELS, 4, 100000);
+
+    TEST_ASSERT_EQUAL_UINT32(12, runSweep(scan, adc, 10000));
+    const AdcScanStats& st = scan.getStats();
+    TEST_ASSERT_EQUAL_UINT32(4, st.conversions);
+    TEST_ASSERT_EQUAL_UINT32(30000, st.maxConversionUs);
+    TEST_ASSERT_EQUAL_UINT32(12, adc.readyCalls);
+    TEST_ASSERT_EQUAL_UINT32(0, st.timeouts);
+}
+
+void test_timeout_and_start_failure(void) {
+    MockAdc adc;
+    adc.stuck[ADC_CHANNEL_MEAT1] = true;
+    adc.failStart[ADC_CHANNEL_MEAT2] = true;
+    AdcScanner<MockAdc> scan(adc, CHANNELS, 4, 25000);
+
+    // Pit (1 tick), meat1 times out (3 ticks), meat2 skipped, spare (1 tick)
+    TEST_ASSERT_EQUAL_UINT32(5, runSweep(scan, adc, 10000));
+    TEST_ASSERT_TRUE(scan.isValid(0));
+    TEST_ASSERT_FALSE(scan.isValid(1));
+    TEST_ASSERT_FALSE(scan.isValid(2));
+    TEST_ASSERT_TRUE(scan.isValid(3));
+    TEST_ASSERT_EQUAL_UINT32(1, scan.getStats().timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.getStats().startErrors);
+
+    // Every start failing still completes the sweep on the next poll
+    for (uint8_t i = 0; i < 4; i++) adc.failStart[i] = true;
+    scan.requestSweep(adc.nowUs);
+    TEST_ASSERT_FALSE(scan.busy());
+    TEST_ASSERT_TRUE(scan.poll(adc.nowUs));
+    TEST_ASSERT_FALSE(scan.isValid(0));
+}
+
+void test_skip_and_abort(void) {
+    MockAdc adc;
+    AdcScanner<MockAdc> scan(adc, CHANNELS, 4, ADC_CONVERSION_TIMEOUT_US);
+
+    scan.requestSweep(0);
+    scan.requestSweep(0);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.getStats().skipped);
+    TEST_ASSERT_EQUAL_UINT8(1, adc.startCount);
+
+    scan.abort();
+    TEST_ASSERT_FALSE(scan.busy());
+    adc.nowUs += 10000;
+    TEST_ASSERT_FALSE(scan.poll(adc.nowUs));
+    TEST_ASSERT_EQUAL_UINT32(1, scan.getStats().aborted);
+    TEST_ASSERT_EQUAL_UINT32(0, scan.getStats().sweeps);
+
+    // A fresh sweep starts over from the pit
+    TEST_ASSERT_EQUAL_UINT32(4, runSweep(scan, adc, 10000));
+    TEST_ASSERT_EQUAL_UINT8(ADC_CHANNEL_PIT, adc.started[1]);
+}
+
+void test_clock_wrap(void) {
+    MockAdc adc;
+    adc.nowUs = 0xFFFFFFFFu - 15000;
+    AdcScanner<MockAdc> scan(adc, CHANNELS, 4, ADC_CONVERSION_TIMEOUT_US);
+
+    TEST_ASSERT_EQUAL_UINT32(4, runSweep(scan, adc, 10000));
+    TEST_ASSERT_EQUAL_UINT32(0, scan.getStats().timeouts);
+    TEST_ASSERT_EQUAL_UINT32(40000, scan.getStats().lastSweepUs);
+}
+
+void test_oversampling_interleaves(void) {
+    MockAdc adc;
+    AdcScanner<MockAdc> scan(adc, CHANNELS, 4, ADC_CONVERSION_TIMEOUT_US, 3);
+    TEST_ASSERT_EQUAL_UINT8(3, scan.getSamplesPerChannel());
+
+    // Each conversion returns a different value so the order shows
+    uint32_t ticks = 0;
+    scan.requestSweep(adc.nowUs);
+    while (!scan.poll(adc.nowUs) && ticks < 100) {
+        adc.nowUs += 10000;
+        for (uint8_t ch = 0; ch < 4; ch++) adc.value[ch] = (int16_t)(ch * 1000 + adc.startCount);
+        ticks++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(12, ticks);
+    TEST_ASSERT_EQUAL_UINT8(12, adc.startCount);
+    for (uint8_t i = 0; i < 12; i++) TEST_ASSERT_EQUAL_UINT8(CHANNELS[i % 4], adc.started[i]);
+
+    for (uint8_t slot = 0; slot < 4; slot++) {
+        TEST_ASSERT_EQUAL_UINT8(3, scan.getSampleCount(slot));
+        const int16_t* s = scan.getSamples(slot);
+        TEST_ASSERT_TRUE(s[0] < s[1] && s[1] < s[2]);   // Oldest first
+        TEST_ASSERT_EQUAL_INT16(s[2], scan.getRaw(slot));
+    }
+    TEST_ASSERT_EQUAL_UINT32(12, scan.getStats().conversions);
+
+    // A slot whose conversions all time out has no samples
+    adc.stuck[ADC_CHANNEL_MEAT2] = true;
+    TEST_ASSERT_TRUE(runSweep(scan, adc, 10000) > 0);
+    TEST_ASSERT_EQUAL_UINT8(0, scan.getSampleCount(2));
+    TEST_ASSERT_FALSE(scan.isValid(2));
+    TEST_ASSERT_EQUAL_UINT8(3, scan.getSampleCount(3));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_sweep_order_includes_spare);
+    RUN_TEST(test_one_conversion_per_tick);
+    RUN_TEST(test_slow_conversion_spans_ticks);
+    RUN_TEST(test_timeout_and_start_failure);
+    RUN_TEST(test_skip_and_abort);
+    RUN_TEST(test_clock_wrap);
+    RUN_TEST(test_oversampling_interleaves);
+
+    return UNITY_END();
+}
@@ -0,0 +1,648 @@
+/**
+ * test_binary_frame.cpp
+ *
+ * Tests for the binary WebSocket frames negotiated by a client hello, and
+ * for the per-client table that tracks which format each client gets.
+ *
+ * Tests cover:
+ *   - Data frame byte layout (offsets, little-endian, tenths)
+ *   - Data frame round trip, disconnected/shorted probes, fan mode codes
+ *   - Rejection of short, foreign and newer-version frames
+ *   - Binary history chunk: header, patched count and final flag, records
+ *   - HistoryPoint and DataPoint records encode identically
+ *   - Append chunks carry their flag, seq and the session id
+ *   - WsClientTable add/find/remove, slot limit, sync timeout, a sync held
+ *     for the next update and not timed out meanwhile, format mix,
+ *     clients mid-replay held back from broadcasts, stable entries, stale
+ *     (silent) clients
+ *   - WsFlow: a slow client's queue stays at WS_CLIENT_QUEUE_MAX while newer
+ *     snapshots replace the held one; buffers all return to the pool
+ *   - WsSubscription: data-only default, rate clamping, newest frame owed
+ *     to slower subscribers, a control subscriber leaves data viewers'
+ *     frames and builds unchanged
+ *   - Benchmark: 720-point history as JSON vs. binary chunks; bytes and
+ *     time printed, binary asserted at least 5x smaller
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <chrono>
+
+#include "binary_frame.h"
+#include "binary_frame.cpp"
+#include "history_message.h"
+#include "history_message.cpp"
+#include "ws_clients.h"
+
+using namespace bbq_protocol;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+static DataPayload makePayload() {
+    DataPayload d;
+    memset(&d, 0, sizeof(d));
+    d.ts = 1707600000;
+    d.pit = 225.5f;
+    d.meat1 = 145.2f;
+    d.meat2 = -12.3f;
+    d.fan = 45;
+    d.damper = 80;
+    d.sp = 225;
+    d.lid = false;
+    d.meat1Target = 203;
+    d.meat2Target = 0;
+    d.est = 1707614400;
+    d.fanMode = "fan_and_damper";
+    d.errorCount = 1;
+    return d;
+}
+
+static DataPoint makePoint(uint32_t ts, int16_t pit, int16_t meat1, int16_t meat2,
+                           uint8_t fan, uint8_t flags) {
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = ts;
+    dp.pitTemp   = pit;
+    dp.meat1Temp = meat1;
+    dp.meat2Temp = meat2;
+    dp.fanPct    = fan;
+    dp.damperPct = 100 - fan;
+    dp.flags     = flags;
+    return dp;
+}
+
+static uint16_t u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: data frame
+// --------------------------------------------------------------------------
+
+void test_data_frame_layout(void) {
+    DataPayload d = makePayload();
+    uint8_t buf[64];
+    TEST_ASSERT_EQUAL_UINT32(BIN_DATA_FRAME_SIZE, encodeDataFrame(buf, sizeof(buf), d));
+
+    TEST_ASSERT_EQUAL_UINT8(BIN_FRAME_DATA, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(BIN_PROTOCOL_VERSION, buf[1]);
+    TEST_ASSERT_EQUAL_UINT16(0, u16(buf + 2));
+    TEST_ASSERT_EQUAL_UINT32(1707600000, u32(buf + 4));
+    TEST_ASSERT_EQUAL_INT16(2255, (int16_t)u16(buf + 8));
+    TEST_ASSERT_EQUAL_INT16(1452, (int16_t)u16(buf + 10));
+    TEST_ASSERT_EQUAL_INT16(-123, (int16_t)u16(buf + 12));
+    TEST_ASSERT_EQUAL_UINT8(45, buf[14]);
+    TEST_ASSERT_EQUAL_UINT8(80, buf[15]);
+    TEST_ASSERT_EQUAL_UINT32(1707614400, u32(buf + 16));
+    TEST_ASSERT_EQUAL_INT16(225, (int16_t)u16(buf + 20));
+    TEST_ASSERT_EQUAL_UINT16(203, u16(buf + 22));
+    TEST_ASSERT_EQUAL_UINT16(0, u16(buf + 24));
+    TEST_ASSERT_EQUAL_UINT8(BIN_FAN_MODE_FAN_AND_DAMPER, buf[26]);
+    TEST_ASSERT_EQUAL_UINT8(1, buf[27]);
+}
+
+void test_data_frame_round_trip(void) {
+    DataPayload d = makePayload();
+    d.lid = true;
+    uint8_t buf[BIN_DATA_FRAME_SIZE];
+    encodeDataFrame(buf, sizeof(buf), d);
+
+    DataPayload out;
+    TEST_ASSERT_TRUE(decodeDataFrame(buf, sizeof(buf), out));
+    TEST_ASSERT_EQUAL_UINT32(d.ts, out.ts);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 225.5f, out.pit);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 145.2f, out.meat1);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -12.3f, out.meat2);
+    TEST_ASSERT_EQUAL_UINT8(45, out.fan);
+    TEST_ASSERT_EQUAL_UINT8(80, out.damper);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 225.0f, out.sp);
+    TEST_ASSERT_TRUE(out.lid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 203.0f, out.meat1Target);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, out.meat2Target);
+    TEST_ASSERT_EQUAL_UINT32(d.est, out.est);
+    TEST_ASSERT_EQUAL_STRING("fan_and_damper", out.fanMode);
+}
+
+void test_data_frame_disconnected_and_shorted(void) {
+    DataPayload d = makePayload();
+    d.pit = NAN;
+    d.meat1 = -1.0f;
+    uint8_t buf[BIN_DATA_FRAME_SIZE];
+    encodeDataFrame(buf, sizeof(buf), d);
+
+    TEST_ASSERT_EQUAL_UINT16(BIN_FLAG_PIT_DISC | BIN_FLAG_MEAT1_SHORT, u16(buf + 2));
+
+    DataPayload out;
+    TEST_ASSERT_TRUE(decodeDataFrame(buf, sizeof(buf), out));
+    TEST_ASSERT_TRUE(std::isnan(out.pit));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -1.0f, out.meat1);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -12.3f, out.meat2);
+}
+
+void test_fan_mode_codes(void) {
+    const char* modes[] = { "fan_only", "fan_and_damper", "damper_primary" };
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_STRING(modes[i], fanModeName(fanModeCode(modes[i])));
+    }
+    TEST_ASSERT_EQUAL_UINT8(BIN_FAN_MODE_UNKNOWN, fanModeCode("turbo"));
+    TEST_ASSERT_EQUAL_UINT8(BIN_FAN_MODE_UNKNOWN, fanModeCode(nullptr));
+    TEST_ASSERT_NULL(fanModeName(BIN_FAN_MODE_UNKNOWN));
+}
+
+void test_data_frame_rejects_bad_input(void) {
+    DataPayload d = makePayload();
+    uint8_t buf[BIN_DATA_FRAME_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(0, encodeDataFrame(buf, sizeof(buf) - 1, d));
+    encodeDataFrame(buf, sizeof(buf), d);
+
+    DataPayload out;
+    TEST_ASSERT_FALSE(decodeDataFrame(buf, sizeof(buf) - 1, out));
+
+    buf[1] = BIN_PROTOCOL_VERSION + 1;
+    TEST_ASSERT_FALSE(decodeDataFrame(buf, sizeof(buf), out));
+
+    buf[1] = BIN_PROTOCOL_VERSION;
+    buf[0] = BIN_FRAME_HISTORY;
+    TEST_ASSERT_FALSE(decodeDataFrame(buf, sizeof(buf), out));
+}
+
+// --------------------------------------------------------------------------
+// Tests: history chunk
+// --------------------------------------------------------------------------
+
+void test_binary_history_chunk(void) {
+    uint8_t buf[256];
+    HistoryChunkWriter w(buf, sizeof(buf), true);
+    TEST_ASSERT_TRUE(w.isBinary());
+    HistoryChunkHeader h = { 0, 0, false, 250.0f, 203.0f, 0 };
+    w.begin(h);
+    w.add(makePoint(1700000000, 2255, -15, 0, 42, DP_FLAG_LID_OPEN | DP_FLAG_MEAT2_DISC), 250.0f);
+    w.add(makePoint(1700000005, 2260, -10, 0, 43, DP_FLAG_MEAT2_DISC), 250.0f);
+
+    size_t len = w.finish(true);
+    TEST_ASSERT_EQUAL_UINT32(BIN_HISTORY_HEADER_SIZE + 2 * BIN_HISTORY_RECORD_SIZE, len);
+
+    TEST_ASSERT_EQUAL_UINT8(BIN_FRAME_HISTORY, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(BIN_PROTOCOL_VERSION, buf[1]);
+    TEST_ASSERT_EQUAL_UINT8(BIN_HISTORY_FINAL, buf[2]);
+    TEST_ASSERT_EQUAL_UINT8(0, buf[3]);
+    TEST_ASSERT_EQUAL_UINT32(0, u32(buf + 4));
+    TEST_ASSERT_EQUAL_INT16(250, (int16_t)u16(buf + 8));
+    TEST_ASSERT_EQUAL_UINT16(203, u16(buf + 10));
+    TEST_ASSERT_EQUAL_UINT16(0, u16(buf + 12));
+    TEST_ASSERT_EQUAL_UINT16(2, u16(buf + 14));
+
+    const uint8_t* r = buf + BIN_HISTORY_HEADER_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(1700000000, u32(r));
+    TEST_ASSERT_EQUAL_INT16(2255, (int16_t)u16(r + 4));
+    TEST_ASSERT_EQUAL_INT16(-15, (int16_t)u16(r + 6));
+    TEST_ASSERT_EQUAL_UINT8(42, r[10]);
+    TEST_ASSERT_EQUAL_UINT8(58, r[11]);
+    TEST_ASSERT_EQUAL_INT16(250, (int16_t)u16(r + 12));
+    TEST_ASSERT_EQUAL_UINT16(BIN_FLAG_LID | BIN_FLAG_MEAT2_DISC, u16(r + 14));
+
+    r += BIN_HISTORY_RECORD_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(1700000005, u32(r));
+    TEST_ASSERT_EQUAL_UINT16(BIN_FLAG_MEAT2_DISC, u16(r + 14));
+}
+
+void test_binary_history_append_chunk(void) {
+    uint8_t buf[256];
+    HistoryChunkWriter w(buf, sizeof(buf), true);
+    HistoryChunkHeader h = { 3, 1700000000, true, 225.0f, 0, 0 };
+    w.begin(h);
+    w.add(makePoint(1700000600, 2255, 0, 0, 40, 0), 225.0f);
+
+    w.finish(false);
+    TEST_ASSERT_EQUAL_UINT8(BIN_FRAME_HISTORY, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(BIN_HISTORY_APPEND, buf[2]);
+    TEST_ASSERT_EQUAL_UINT8(3, buf[3]);
+    TEST_ASSERT_EQUAL_UINT32(1700000000, u32(buf + 4));
+    TEST_ASSERT_EQUAL_UINT16(1, u16(buf + 14));
+    TEST_ASSERT_EQUAL_UINT32(1700000600, u32(buf + BIN_HISTORY_HEADER_SIZE));
+}
+
+void test_binary_history_chunk_full(void) {
+    uint8_t buf[BIN_HISTORY_HEADER_SIZE + 3 * BIN_HISTORY_RECORD_SIZE];
+    HistoryChunkWriter w(buf, sizeof(buf), true);
+    HistoryChunkHeader h = { 0, 0, false, 225.0f, 0, 0 };
+    w.begin(h);
+    TEST_ASSERT_TRUE(w.hasRoom(3));
+    TEST_ASSERT_FALSE(w.hasRoom(4));
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(w.add(makePoint(1700000000 + i * 5, 2250, 0, 0, 40, 0), 225.0f));
+    }
+    TEST_ASSERT_FALSE(w.add(makePoint(1700000015, 2250, 0, 0, 40, 0), 225.0f));
+    TEST_ASSERT_EQUAL_UINT32(3, w.getCount());
+    TEST_ASSERT_EQUAL_UINT32(sizeof(buf), w.finish(false));
+}
+
+void test_history_point_record_matches_data_point(void) {
+    DataPoint dp = makePoint(1700000000, 2255, 1452, 0, 42, DP_FLAG_MEAT2_DISC | DP_FLAG_LID_OPEN);
+    HistoryPoint hp = { 1700000000, 225.5f, 145.2f, NAN, 42, 58, 225.0f, true };
+
+    uint8_t a[BIN_HISTORY_RECORD_SIZE], b[BIN_HISTORY_RECORD_SIZE];
+    encodeHistoryRecord(a, dp, 225.0f);
+    encodeHistoryRecord(b, hp);
+    TEST_ASSERT_EQUAL_MEMORY(a, b, BIN_HISTORY_RECORD_SIZE);
+}
+
+// --------------------------------------------------------------------------
+// Tests: WsClientTable
+// --------------------------------------------------------------------------
+
+void test_client_table_add_find_remove(void) {
+    WsClientTable t;
+    TEST_ASSERT_NOT_NULL(t.add(7, 1000));
+    TEST_ASSERT_NOT_NULL(t.add(9, 1000));
+    TEST_ASSERT_EQUAL_UINT8(2, t.size());
+
+    WsClient* c = t.find(9);
+    TEST_ASSERT_NOT_NULL(c);
+    TEST_ASSERT_TRUE(c->historyPending);
+    TEST_ASSERT_EQUAL_UINT8(0, c->binVersion);
+
+    t.remove(7);
+    TEST_ASSERT_NULL(t.find(7));
+    TEST_ASSERT_NOT_NULL(t.find(9));
+    TEST_ASSERT_EQUAL_UINT8(1, t.size());
+}
+
+void test_client_table_full(void) {
+    WsClientTable t;
+    for (uint32_t i = 0; i < WS_CLIENT_SLOTS; i++) TEST_ASSERT_NOT_NULL(t.add(i, 0));
+    TEST_ASSERT_NULL(t.add(100, 0));
+    t.remove(3);
+    TEST_ASSERT_NOT_NULL(t.add(100, 0));
+}
+
+void test_client_table_sync_timeout(void) {
+    WsClientTable t;
+    t.add(1, 1000);
+    t.add(2, 1200);
+    t.find(1)->historyPending = false;  // Synced
+
+    TEST_ASSERT_NULL(t.nextSyncTimeout(1200 + WS_SYNC_TIMEOUT - 1));
+    WsClient* late = t.nextSyncTimeout(1200 + WS_SYNC_TIMEOUT);
+    TEST_ASSERT_NOT_NULL(late);
+    TEST_ASSERT_EQUAL_UINT32(2, late->id);
+}
+
+void test_client_table_sync_request(void) {
+    WsClientTable t;
+    t.add(1, 1000);
+    t.add(2, 1000);
+    TEST_ASSERT_NULL(t.nextSyncRequest());
+    TEST_ASSERT_FALSE(t.find(1)->syncPending);
+
+    // The command only records it; update() answers it
+    WsClient* c = t.find(2);
+    c->syncPending = true;
+    c->syncSession = 1700000000;
+    c->syncSince = 1700003600;
+    TEST_ASSERT_EQUAL_PTR(c, t.nextSyncRequest());
+
+    // A sync waiting for its answer is not a missing one
+    WsClient* late = t.nextSyncTimeout(1000 + WS_SYNC_TIMEOUT);
+    TEST_ASSERT_NOT_NULL(late);
+    TEST_ASSERT_EQUAL_UINT32(1, late->id);
+    late->historyPending = false;
+    TEST_ASSERT_NULL(t.nextSyncTimeout(1000 + WS_SYNC_TIMEOUT));
+
+    c->syncPending = false;
+    TEST_ASSERT_NULL(t.nextSyncRequest());
+
+    // A reused slot starts with no sync
+    t.remove(2);
+    TEST_ASSERT_FALSE(t.add(3, 2000)->syncPending);
+}
+
+void test_client_table_format_mix(void) {
+    WsClientTable t;
+    t.add(1, 0);
+    t.add(2, 0);
+    TEST_ASSERT_FALSE(t.anyBinary());  // Pending clients don't count
+    TEST_ASSERT_FALSE(t.anyJson());
+
+    WsClient* c = t.find(1);
+    c->historyPending = false;
+    c->binVersion = 1;
+    TEST_ASSERT_TRUE(t.anyBinary());
+    TEST_ASSERT_FALSE(t.anyJson());
+
+    t.find(2)->historyPending = false;
+    TEST_ASSERT_TRUE(t.anyJson());
+}
+
+void test_client_table_replay_holds_broadcasts(void) {
+    WsClientTable t;
+    WsClient* c = t.add(1, 0);
+    TEST_ASSERT_FALSE(c->replay.active);
+
+    c->historyPending = false;
+    c->replay.active = true;  // Chunks still to send
+    TEST_ASSERT_FALSE(t.anyJson());
+
+    c->replay.active = false;
+    TEST_ASSERT_TRUE(t.anyJson());
+}
+
+void test_client_table_entries_stay_put(void) {
+    // Queued messages point at a client's WsFlow, so removing another
+    // client must not move it
+    WsClientTable t;
+    t.add(1, 0);
+    WsClient* b = t.add(2, 0);
+    t.add(3, 0);
+    t.remove(1);
+    TEST_ASSERT_TRUE(t.find(2) == b);
+    TEST_ASSERT_EQUAL_UINT8(2, t.size());
+
+    bool seen2 = false, seen3 = false;
+    for (uint8_t i = 0; i < t.size(); i++) {
+        if (t[i].id == 2) seen2 = true;
+        if (t[i].id == 3) seen3 = true;
+    }
+    TEST_ASSERT_TRUE(seen2 && seen3);
+}
+
+void test_client_table_stale(void) {
+    WsClientTable t;
+    t.add(1, 0);
+    t.add(2, 0);
+    t.find(1)->lastSeenMs = 20000;  // Answered a ping
+
+    TEST_ASSERT_NULL(t.nextStale(WS_PONG_TIMEOUT - 1));
+    WsClient* stale = t.nextStale(WS_PONG_TIMEOUT);
+    TEST_ASSERT_NOT_NULL(stale);
+    TEST_ASSERT_EQUAL_UINT32(2, stale->id);
+    t.remove(2);
+    TEST_ASSERT_NULL(t.nextStale(WS_PONG_TIMEOUT));
+}
+
+void test_flow_coalesces_slow_client(void) {
+    WsBroadcastPool pool;
+    WsClientTable t;
+    WsClient* c = t.add(1, 0);
+
+    // Queue fills to the limit, then the stuck client stops taking frames
+    WsBroadcastPool::Buffer* queued[WS_CLIENT_QUEUE_MAX];
+    for (int i = 0; i < WS_CLIENT_QUEUE_MAX; i++) {
+        TEST_ASSERT_FALSE(c->flow.behind());
+        queued[i] = pool.acquire();     // Its reference stands for the queued message's
+        c->flow.onQueued();
+    }
+    TEST_ASSERT_TRUE(c->flow.behind());
+
+    // 100 more broadcasts: each replaces the held one, nothing piles up
+    for (int i = 0; i < 100; i++) {
+        WsBroadcastPool::Buffer* b = pool.acquire();
+        TEST_ASSERT_NOT_NULL(b);
+        b->len = (size_t)i;
+        c->flow.hold(b);
+        b->release();
+    }
+    TEST_ASSERT_EQUAL_UINT8(WS_CLIENT_QUEUE_MAX, c->flow.queued.load());
+    TEST_ASSERT_EQUAL_UINT8(WS_CLIENT_QUEUE_MAX, c->flow.peak);
+    TEST_ASSERT_EQUAL_UINT32(99, c->flow.coalesced);
+    TEST_ASSERT_EQUAL_UINT8(WS_CLIENT_QUEUE_MAX + 1, pool.inUse());
+
+    // The queue drains, and the newest snapshot is what goes next
+    for (int i = 0; i < WS_CLIENT_QUEUE_MAX; i++) {
+        queued[i]->release();
+        c->flow.sent();
+    }
+    TEST_ASSERT_FALSE(c->flow.behind());
+    WsBroadcastPool::Buffer* held = c->flow.takePending();
+    TEST_ASSERT_NOT_NULL(held);
+    TEST_ASSERT_EQUAL_UINT32(99, held->len);
+    TEST_ASSERT_NULL(c->flow.takePending());
+    held->release();
+    TEST_ASSERT_EQUAL_UINT8(0, pool.inUse());
+
+    // A spurious extra sent() never underflows the depth
+    c->flow.sent();
+    TEST_ASSERT_EQUAL_UINT8(0, c->flow.queued.load());
+}
+
+void test_flow_released_with_client(void) {
+    WsBroadcastPool pool;
+    WsClientTable t;
+    WsClient* c = t.add(1, 0);
+    WsBroadcastPool::Buffer* b = pool.acquire();
+    c->flow.hold(b);
+    b->release();
+    TEST_ASSERT_EQUAL_UINT8(1, pool.inUse());
+
+    t.remove(1);  // Held snapshot goes back to the pool
+    TEST_ASSERT_EQUAL_UINT8(0, pool.inUse());
+}
+
+// --------------------------------------------------------------------------
+// Tests: WsSubscription
+// --------------------------------------------------------------------------
+
+void test_subscription_defaults_and_clamps(void) {
+    WsClientTable t;
+    WsClient* c = t.add(1, 0);
+    TEST_ASSERT_TRUE(c->sub.wants(Channel::DATA));
+    TEST_ASSERT_FALSE(c->sub.wants(Channel::CONTROL));
+
+    c->sub.subscribe(channelBit(Channel::CONTROL), 0);
+    TEST_ASSERT_EQUAL_UINT16(WS_CONTROL_RATE, c->sub.rateMs[(uint8_t)Channel::CONTROL]);
+    c->sub.subscribe(channelBit(Channel::CONTROL), 10);
+    TEST_ASSERT_EQUAL_UINT16(WS_SUB_MIN_RATE, c->sub.rateMs[(uint8_t)Channel::CONTROL]);
+    c->sub.subscribe(channelBit(Channel::DATA), 3600000);
+    TEST_ASSERT_EQUAL_UINT16(WS_SUB_MAX_RATE, c->sub.rateMs[(uint8_t)Channel::DATA]);
+    c->sub.subscribe(channelBit(Channel::DATA), 0);
+    TEST_ASSERT_EQUAL_UINT16(0, c->sub.rateMs[(uint8_t)Channel::DATA]);  // As produced
+
+    c->sub.unsubscribe(channelBit(Channel::DATA));
+    TEST_ASSERT_FALSE(c->sub.wants(Channel::DATA));
+    TEST_ASSERT_TRUE(c->sub.wants(Channel::CONTROL));
+
+    // Unknown bits are never kept; a new client starts over
+    c->sub.subscribe(0x80, 0);
+    TEST_ASSERT_EQUAL_UINT8(channelBit(Channel::CONTROL), c->sub.channels);
+    t.remove(1);
+    TEST_ASSERT_EQUAL_UINT8(channelBit(Channel::DATA), t.add(2, 0)->sub.channels);
+}
+
+void test_subscription_slow_client_gets_newest(void) {
+    WsClientTable t;
+    WsClient* tablet = t.add(1, 0);
+    tablet->historyPending = false;
+    tablet->sub.subscribe(channelBit(Channel::DATA), 5000);
+    tablet->sub.delivered(Channel::DATA, 0);
+    WsClient* viewer = t.add(2, 0);
+    viewer->historyPending = false;
+
+    // A frame at t = 1 s: the viewer is due, the tablet waits for its rate
+    t.produced(Channel::DATA);
+    TEST_ASSERT_TRUE(viewer->sub.due(Channel::DATA, 1000));
+    TEST_ASSERT_FALSE(tablet->sub.due(Channel::DATA, 1000));
+    TEST_ASSERT_EQUAL_UINT8(1, t.countDue(Channel::DATA, 1000));
+    viewer->sub.delivered(Channel::DATA, 1000);
+
+    // Nothing new until 5 s, but the tablet is still owed the frame
+    TEST_ASSERT_EQUAL_UINT8(0, t.countDue(Channel::DATA, 4999));
+    TEST_ASSERT_TRUE(tablet->sub.due(Channel::DATA, 5000));
+    TEST_ASSERT_EQUAL_UINT8(1, t.countDue(Channel::DATA, 5000, 0));
+    TEST_ASSERT_EQUAL_UINT8(0, t.countDue(Channel::DATA, 5000, 1));
+    tablet->sub.delivered(Channel::DATA, 5000);
+    TEST_ASSERT_FALSE(tablet->sub.due(Channel::DATA, 20000));  // Nothing newer
+
+    // Clients mid-replay are not due anything
+    tablet->replay.active = true;
+    t.produced(Channel::DATA);
+    TEST_ASSERT_EQUAL_UINT8(1, t.countDue(Channel::DATA, 20000));
+}
+
+void test_subscription_control_leaves_viewers_alone(void) {
+    // Three data viewers and one tuner on control at 4 Hz; a minute of
+    // 100 ms polls run the way the web server does: a channel is built only
+    // when some subscriber is due, then sent to just those
+    WsClientTable t;
+    for (uint32_t id = 1; id <= 4; id++) t.add(id, 0)->historyPending = false;
+    WsClient* tuner = t.find(4);
+    tuner->sub.subscribe(channelBit(Channel::CONTROL), 250);
+
+    uint32_t dataBuilds = 0, controlBuilds = 0;
+    uint32_t dataFrames[5] = {0}, controlFrames[5] = {0};
+    for (uint32_t now = 100; now <= 60000; now += 100) {
+        if (now % 1500 == 0) t.produced(Channel::DATA);
+        t.produced(Channel::CONTROL);
+
+        if (t.countDue(Channel::DATA, now) > 0) {
+            dataBuilds++;
+            for (uint8_t i = 0; i < t.size(); i++) {
+                if (!t[i].sub.due(Channel::DATA, now)) continue;
+                t[i].sub.delivered(Channel::DATA, now);
+                dataFrames[t[i].id]++;
+            }
+        }
+        if (t.countDue(Channel::CONTROL, now) > 0) {
+            controlBuilds++;
+            for (uint8_t i = 0; i < t.size(); i++) {
+                if (!t[i].sub.due(Channel::CONTROL, now)) continue;
+                t[i].sub.delivered(Channel::CONTROL, now);
+                controlFrames[t[i].id]++;
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(40, dataBuilds);       // Once per frame, not per client
+    for (uint32_t id = 1; id <= 4; id++) TEST_ASSERT_EQUAL_UINT32(40, dataFrames[id]);
+    for (uint32_t id = 1; id <= 3; id++) TEST_ASSERT_EQUAL_UINT32(0, controlFrames[id]);
+    TEST_ASSERT_EQUAL_UINT32(controlBuilds, controlFrames[4]);
+    TEST_ASSERT_TRUE(controlFrames[4] >= 239 && controlFrames[4] <= 240);  // 4 Hz, even at 100 ms polls
+    printf("  1 min: data built %u times (4 clients), control built %u times (1 subscriber)\n",
+           dataBuilds, controlBuilds);
+}
+
+// --------------------------------------------------------------------------
+// Benchmark: 720-point history replay, JSON vs. binary chunks
+// --------------------------------------------------------------------------
+
+#define BENCH_POINTS 720
+#define BENCH_RUNS   200
+
+// Replay pts as WS_HISTORY_CHUNK_SIZE chunks; returns the total bytes sent
+static size_t replayChunks(const DataPoint* pts, uint32_t n, bool binary) {
+    static uint8_t buf[WS_HISTORY_CHUNK_SIZE];
+    HistoryChunkWriter w(buf, sizeof(buf), binary);
+    HistoryChunkHeader h = { 0, 1700000000, false, 225.0f, 203.0f, 0 };
+    size_t total = 0;
+    uint32_t i = 0;
+    do {
+        w.begin(h);
+        while (i < n && w.add(pts[i], 225.0f)) i++;
+        total += w.finish(i >= n);
+        h.seq++;
+    } while (i < n);
+    return total;
+}
+
+void test_benchmark_history_json_vs_binary(void) {
+    static DataPoint pts[BENCH_POINTS];
+    for (uint32_t i = 0; i < BENCH_POINTS; i++) {
+        pts[i] = makePoint(1700000000 + i * 5, (int16_t)(2250 + i % 9),
+                           (int16_t)(1200 + i / 10), 0, (uint8_t)(i % 100),
+                           DP_FLAG_MEAT2_DISC);
+    }
+
+    size_t jsonLen = 0, binLen = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) jsonLen = replayChunks(pts, BENCH_POINTS, false);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) binLen = replayChunks(pts, BENCH_POINTS, true);
+    auto t2 = std::chrono::steady_clock::now();
+
+    double jsonUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / BENCH_RUNS;
+    double binUs  = std::chrono::duration<double, std::micro>(t2 - t1).count() / BENCH_RUNS;
+    printf("  history %u pts: JSON %u B in %.1f us, binary %u B in %.1f us (%.1fx bytes, %.1fx time)\n",
+           BENCH_POINTS, (unsigned)jsonLen, jsonUs, (unsigned)binLen, binUs,
+           (double)jsonLen / binLen, jsonUs / binUs);
+
+    // 255 records per binary chunk: three chunks, three headers
+    uint32_t perChunk = (WS_HISTORY_CHUNK_SIZE - BIN_HISTORY_HEADER_SIZE) / BIN_HISTORY_RECORD_SIZE;
+    uint32_t chunks = (BENCH_POINTS + perChunk - 1) / perChunk;
+    TEST_ASSERT_EQUAL_UINT32(chunks * BIN_HISTORY_HEADER_SIZE + BENCH_POINTS * BIN_HISTORY_RECORD_SIZE,
+                             binLen);
+    TEST_ASSERT_TRUE(jsonLen >= 5 * binLen);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Data frame
+    RUN_TEST(test_data_frame_layout);
+    RUN_TEST(test_data_frame_round_trip);
+    RUN_TEST(test_data_frame_disconnected_and_shorted);
+    RUN_TEST(test_fan_mode_codes);
+    RUN_TEST(test_data_frame_rejects_bad_input);
+
+    // History chunk
+    RUN_TEST(test_binary_history_chunk);
+    RUN_TEST(test_binary_history_append_chunk);
+    RUN_TEST(test_binary_history_chunk_full);
+    RUN_TEST(test_history_point_record_matches_data_point);
+
+    // WsClientTable
+    RUN_TEST(test_client_table_add_find_remove);
+    RUN_TEST(test_client_table_full);
+    RUN_TEST(test_client_table_sync_timeout);
+    RUN_TEST(test_client_table_sync_request);
+    RUN_TEST(test_client_table_format_mix);
+    RUN_TEST(test_client_table_replay_holds_broadcasts);
+    RUN_TEST(test_client_table_entries_stay_put);
+    RUN_TEST(test_client_table_stale);
+
+    // WsFlow
+    RUN_TEST(test_flow_coalesces_slow_client);
+    RUN_TEST(test_flow_released_with_client);
+
+    // WsSubscription
+    RUN_TEST(test_subscription_defaults_and_clamps);
+    RUN_TEST(test_subscription_slow_client_gets_newest);
+    RUN_TEST(test_subscription_control_leaves_viewers_alone);
+
+    // Benchmark
+    RUN_TEST(test_benchmark_history_json_vs_binary);
+
+    return UNITY_END();
+}
@@ -0,0 +1,275 @@
+/**
+ * test_broadcast_gate.cpp
+ *
+ * Tests for BroadcastGate, which decides when a data frame is worth
+ * broadcasting instead of sending one every WS_SEND_INTERVAL.
+ *
+ * Tests cover:
+ *   - First frame always sent; heartbeat when nothing changes
+ *   - Changes below the deadband, or that do not change the displayed
+ *     whole degree, are not sent
+ *   - Temperature, fan/damper and estimate deadbands, and the minimum gap
+ *   - Discrete flips (lid, probe disconnect/short, setpoint, targets, fan
+ *     mode, errors, alarms) sent at once, even inside the minimum gap
+ *   - force() and per-reason counters, perHour()
+ *   - 12-hour steady hold with sensor noise: frames per hour vs. the fixed
+ *     1.5 s interval, and lid-open latency at the WS_CHANGE_POLL_MS rate
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+
+#include "broadcast_gate.h"
+#include "broadcast_gate.cpp"
+
+using namespace bbq_protocol;
+typedef BroadcastGate::Reason Reason;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+static DataPayload makePayload() {
+    DataPayload d;
+    memset(&d, 0, sizeof(d));
+    d.ts = 1707600000;
+    d.pit = 225.0f;
+    d.meat1 = 150.0f;
+    d.meat2 = NAN;
+    d.fan = 40;
+    d.damper = 70;
+    d.sp = 225.0f;
+    d.meat1Target = 203.0f;
+    d.fanMode = "fan_and_damper";
+    return d;
+}
+
+// Send the first frame at t = 0
+static void prime(BroadcastGate& g, const DataPayload& d) {
+    TEST_ASSERT_TRUE(g.check(d, 0, 0) == Reason::FIRST);
+    g.sent(d, 0, 0, Reason::FIRST);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: values and heartbeat
+// --------------------------------------------------------------------------
+
+void test_quiet_until_heartbeat(void) {
+    DataPayload d = makePayload();
+    BroadcastGate g;
+    prime(g, d);
+    TEST_ASSERT_TRUE(g.check(d, 0, WS_HEARTBEAT_INTERVAL - 1) == Reason::NONE);
+    TEST_ASSERT_TRUE(g.check(d, 0, WS_HEARTBEAT_INTERVAL) == Reason::HEARTBEAT);
+}
+
+void test_below_deadband_ignored(void) {
+    DataPayload d = makePayload();
+    BroadcastGate g;
+    prime(g, d);
+
+    d.pit = 225.0f + WS_DEADBAND_TEMP - 0.1f;   // Shows a new degree, but noise-sized
+    d.meat1 = 150.0f - WS_DEADBAND_TEMP + 0.1f;
+    d.fan = 40 + WS_DEADBAND_PCT - 1;
+    TEST_ASSERT_TRUE(g.check(d, 0, 5000) == Reason::NONE);
+
+    d.pit = 225.0f + WS_DEADBAND_TEMP;
+    TEST_ASSERT_TRUE(g.check(d, 0, 5000) == Reason::VALUE);
+}
+
+void test_display_resolution(void) {
+    // A deadband finer than a degree still only sends when the shown
+    // whole degree changes
+    BroadcastGate g(0.3f, 5, 60000, 0);
+    DataPayload d = makePayload();
+    prime(g, d);
+
+    d.pit = 225.45f;    // Moved 0.45, still shows 225
+    TEST_ASSERT_TRUE(g.check(d, 0, 1) == Reason::NONE);
+    d.pit = 225.55f;    // Shows 226
+    TEST_ASSERT_TRUE(g.check(d, 0, 1) == Reason::VALUE);
+}
+
+void test_deadbands(void) {
+    DataPayload d = makePayload();
+    BroadcastGate g;
+    prime(g, d);
+
+    DataPayload fan = d;
+    fan.fan = 40 + WS_DEADBAND_PCT;
+    TEST_ASSERT_TRUE(g.check(fan, 0, 1000) == Reason::VALUE);
+
+    DataPayload damper = d;
+    damper.damper = 70 - WS_DEADBAND_PCT;
+    TEST_ASSERT_TRUE(g.check(damper, 0, 1000) == Reason::VALUE);
+
+    // Estimate: appearing is a flip, then it must move WS_DEADBAND_EST_MIN
+    DataPayload est = d;
+    est.est = 1707614400;
+    TEST_ASSERT_TRUE(g.check(est, 0, 1000) == Reason::STATE);
+    g.sent(est, 0, 1000, Reason::STATE);
+    est.est += (WS_DEADBAND_EST_MIN - 1) * 60;
+    TEST_ASSERT_TRUE(g.check(est, 0, 2000) == Reason::NONE);
+    est.est += 60;
+    TEST_ASSERT_TRUE(g.check(est, 0, 2000) == Reason::VALUE);
+
+    // Wider deadband from the constructor
+    BroadcastGate wide(5.0f, 10, 60000, 0);
+    wide.sent(d, 0, 0, Reason::FIRST);
+    DataPayload warm = d;
+    warm.pit = 229.9f;
+    TEST_ASSERT_TRUE(wide.check(warm, 0, 1) == Reason::NONE);
+    warm.pit = 230.0f;
+    TEST_ASSERT_TRUE(wide.check(warm, 0, 1) == Reason::VALUE);
+}
+
+void test_min_gap_for_values(void) {
+    DataPayload d = makePayload();
+    BroadcastGate g;
+    prime(g, d);
+    d.pit = 230.0f;
+    TEST_ASSERT_TRUE(g.check(d, 0, WS_MIN_SEND_GAP - 1) == Reason::NONE);
+    TEST_ASSERT_TRUE(g.check(d, 0, WS_MIN_SEND_GAP) == Reason::VALUE);
+}
+
+// --------------------------------------------------------------------------
+// Tests: discrete flips
+// --------------------------------------------------------------------------
+
+void test_state_flips_sent_at_once(void) {
+    DataPayload base = makePayload();
+    BroadcastGate g;
+    prime(g, base);
+    const uint32_t t = 1;   // Well inside the minimum gap
+
+    DataPayload d = base;
+    d.lid = true;
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    d = base;
+    d.meat1 = NAN;          // Probe unplugged
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    d = base;
+    d.pit = -1.0f;          // Shorted
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    d = base;
+    d.meat2 = 90.0f;        // Probe plugged in
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    d = base;
+    d.sp = 250.0f;
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    d = base;
+    d.meat1Target = 0;
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    d = base;
+    d.fanMode = "fan_only";
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    d = base;
+    d.errors[0] = "Fire out";
+    d.errorCount = 1;
+    TEST_ASSERT_TRUE(g.check(d, 0, t) == Reason::STATE);
+
+    TEST_ASSERT_TRUE(g.check(base, 1u << 3, t) == Reason::STATE);  // Alarm
+    TEST_ASSERT_TRUE(g.check(base, 0, t) == Reason::NONE);
+}
+
+void test_force_and_counters(void) {
+    DataPayload d = makePayload();
+    BroadcastGate g;
+    prime(g, d);
+    g.force();
+    TEST_ASSERT_TRUE(g.check(d, 0, 1) == Reason::FORCED);
+    g.sent(d, 0, 1, Reason::FORCED);
+    TEST_ASSERT_TRUE(g.check(d, 0, 2) == Reason::NONE);
+
+    d.lid = true;
+    g.sent(d, 0, 3, Reason::STATE);
+    g.sent(d, 0, 20000, Reason::HEARTBEAT);
+    TEST_ASSERT_EQUAL_UINT32(4, g.getFrames());
+    TEST_ASSERT_EQUAL_UINT32(1, g.getCount(Reason::FIRST));
+    TEST_ASSERT_EQUAL_UINT32(1, g.getCount(Reason::FORCED));
+    TEST_ASSERT_EQUAL_UINT32(1, g.getCount(Reason::STATE));
+    TEST_ASSERT_EQUAL_UINT32(1, g.getCount(Reason::HEARTBEAT));
+
+    TEST_ASSERT_EQUAL_UINT32(2400, BroadcastGate::perHour(1, 1500));
+    TEST_ASSERT_EQUAL_UINT32(360, BroadcastGate::perHour(720, 7200000));
+    TEST_ASSERT_EQUAL_UINT32(0, BroadcastGate::perHour(5, 0));
+}
+
+// --------------------------------------------------------------------------
+// Scenario: 12-hour steady hold
+// --------------------------------------------------------------------------
+
+void test_steady_hold_frames_per_hour(void) {
+    // Pit holding 225 with +-0.8 F sensor noise and slow fan hunting, meat
+    // creeping up 150 -> 175; one lid opening 6 hours in
+    const uint32_t HOLD_MS = 12u * 3600u * 1000u;
+    const uint32_t LID_AT = 6u * 3600u * 1000u;
+    BroadcastGate g;
+    DataPayload d = makePayload();
+    uint32_t seed = 12345;
+    uint32_t lidLatency = UINT32_MAX;
+
+    for (uint32_t t = 0; t < HOLD_MS; t += WS_CHANGE_POLL_MS) {
+        seed = seed * 1103515245u + 12345u;
+        float noise = ((float)((seed >> 16) & 0x7FFF) / 32767.0f - 0.5f) * 1.6f;
+        float hours = (float)t / 3600000.0f;
+        d.ts = 1707600000 + t / 1000;
+        d.pit = 225.0f + noise;
+        d.meat1 = 150.0f + hours * (25.0f / 12.0f);
+        d.fan = (uint8_t)(40 + 2 * std::sin(hours * 20.0f));
+        d.lid = t >= LID_AT && t < LID_AT + 60000;
+
+        Reason why = g.check(d, 0, t);
+        if (why == Reason::NONE) continue;
+        g.sent(d, 0, t, why);
+        if (d.lid && lidLatency == UINT32_MAX) lidLatency = t - LID_AT;
+    }
+
+    uint32_t adaptive = BroadcastGate::perHour(g.getFrames(), HOLD_MS);
+    uint32_t fixed = BroadcastGate::perHour(1, WS_SEND_INTERVAL);
+    printf("  12 h hold: adaptive %u frames/h (value %u, state %u, heartbeat %u), fixed %u frames/h; "
+           "lid-open sent after %u ms\n",
+           adaptive, BroadcastGate::perHour(g.getCount(Reason::VALUE), HOLD_MS),
+           g.getCount(Reason::STATE), BroadcastGate::perHour(g.getCount(Reason::HEARTBEAT), HOLD_MS),
+           fixed, lidLatency);
+
+    TEST_ASSERT_EQUAL_UINT32(0, lidLatency);        // First poll after the flip
+    TEST_ASSERT_EQUAL_UINT32(2, g.getCount(Reason::STATE));  // Lid open, lid closed
+    TEST_ASSERT_TRUE(adaptive * 4 < fixed);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Values and heartbeat
+    RUN_TEST(test_quiet_until_heartbeat);
+    RUN_TEST(test_below_deadband_ignored);
+    RUN_TEST(test_display_resolution);
+    RUN_TEST(test_deadbands);
+    RUN_TEST(test_min_gap_for_values);
+
+    // Discrete flips
+    RUN_TEST(test_state_flips_sent_at_once);
+    RUN_TEST(test_force_and_counters);
+
+    // Scenario
+    RUN_TEST(test_steady_hold_frames_per_hour);
+
+    return UNITY_END();
+}
@@ -0,0 +1,252 @@
+/**
+ * test_broadcast_pool.cpp
+ *
+ * Tests for the fixed pool of reference-counted buffers that data
+ * broadcasts are serialized into once and shared by every client queue.
+ *
+ * Tests cover:
+ *   - acquire() hands out a buffer holding one reference
+ *   - A buffer stays in use until its last reference is released
+ *   - Exhaustion returns nullptr and is counted; freed buffers are reused
+ *   - Peak-in-use and acquire counters
+ *   - References released from another thread while the owner acquires
+ *   - Benchmark: allocations and bytes copied per broadcast as the client
+ *     count grows, pooled vs. one copy per client
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <thread>
+
+#include "config.h"
+#include "broadcast_pool.h"
+#include "web_protocol.h"
+#include "json_writer.h"
+#include "data_message.cpp"
+
+using namespace bbq_protocol;
+
+typedef BroadcastPool<4, 64> SmallPool;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+// Count every operator new, to measure heap churn per broadcast
+static size_t g_newCount = 0;
+
+void* operator new(size_t n) {
+    g_newCount++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static DataPayload makePayload() {
+    DataPayload d;
+    memset(&d, 0, sizeof(d));
+    d.ts = 1707600000;
+    d.pit = 225.5f;
+    d.meat1 = 145.2f;
+    d.meat2 = NAN;
+    d.fan = 45;
+    d.damper = 80;
+    d.sp = 225.0f;
+    d.fanMode = "fan_and_damper";
+    d.meat1Target = 203.0f;
+    d.est = 1707614400;
+    return d;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: BroadcastPool
+// --------------------------------------------------------------------------
+
+void test_acquire_holds_one_reference(void) {
+    SmallPool pool;
+    TEST_ASSERT_EQUAL_UINT8(0, pool.inUse());
+
+    SmallPool::Buffer* b = pool.acquire();
+    TEST_ASSERT_NOT_NULL(b);
+    TEST_ASSERT_EQUAL_UINT8(1, b->refs.load());
+    TEST_ASSERT_EQUAL_UINT32(0, b->len);
+    TEST_ASSERT_EQUAL_UINT8(1, pool.inUse());
+
+    b->release();
+    TEST_ASSERT_EQUAL_UINT8(0, pool.inUse());
+}
+
+void test_shared_until_last_release(void) {
+    SmallPool pool;
+    SmallPool::Buffer* b = pool.acquire();
+    b->len = 5;
+    memcpy(b->data, "hello", 5);
+
+    // Three client messages take references, then the owner drops its own
+    b->retain();
+    b->retain();
+    b->retain();
+    b->release();
+    TEST_ASSERT_EQUAL_UINT8(1, pool.inUse());
+
+    // The next broadcast must not get the buffer still being sent
+    SmallPool::Buffer* other = pool.acquire();
+    TEST_ASSERT_TRUE(other != b);
+
+    b->release();
+    b->release();
+    TEST_ASSERT_EQUAL_UINT8(2, pool.inUse());
+    b->release();
+    TEST_ASSERT_EQUAL_UINT8(1, pool.inUse());
+    other->release();
+}
+
+void test_exhaustion_and_reuse(void) {
+    SmallPool pool;
+    SmallPool::Buffer* held[4];
+    for (int i = 0; i < 4; i++) {
+        held[i] = pool.acquire();
+        TEST_ASSERT_NOT_NULL(held[i]);
+    }
+    TEST_ASSERT_NULL(pool.acquire());
+    TEST_ASSERT_NULL(pool.acquire());
+    TEST_ASSERT_EQUAL_UINT32(2, pool.getExhausted());
+    TEST_ASSERT_EQUAL_UINT32(4, pool.getAcquired());
+    TEST_ASSERT_EQUAL_UINT8(4, pool.getPeakInUse());
+
+    held[2]->release();
+    SmallPool::Buffer* again = pool.acquire();
+    TEST_ASSERT_TRUE(again == held[2]);
+
+    for (int i = 0; i < 4; i++) held[i]->release();
+    TEST_ASSERT_EQUAL_UINT8(0, pool.inUse());
+    TEST_ASSERT_EQUAL_UINT8(4, pool.getPeakInUse());
+}
+
+void test_release_from_other_thread(void) {
+    // The loop acquires and shares; the network task releases as clients
+    // finish sending. Every buffer must come back exactly once.
+    SmallPool pool;
+    const int ROUNDS = 20000;
+    const int CLIENTS = 3;
+    std::atomic<SmallPool::Buffer*> handoff[ROUNDS];
+    for (int i = 0; i < ROUNDS; i++) handoff[i].store(nullptr);
+
+    std::thread sender([&]() {
+        for (int i = 0; i < ROUNDS; i++) {
+            SmallPool::Buffer* b;
+            while ((b = handoff[i].load(std::memory_order_acquire)) == nullptr) {
+                std::this_thread::yield();
+            }
+            for (int c = 0; c < CLIENTS; c++) b->release();
+        }
+    });
+
+    int sent = 0;
+    while (sent < ROUNDS) {
+        SmallPool::Buffer* b = pool.acquire();
+        if (!b) {
+            std::this_thread::yield();
+            continue;
+        }
+        b->len = (size_t)snprintf((char*)b->data, sizeof(b->data), "%d", sent);
+        for (int c = 0; c < CLIENTS; c++) b->retain();
+        b->release();
+        handoff[sent++].store(b, std::memory_order_release);
+    }
+    sender.join();
+
+    TEST_ASSERT_EQUAL_UINT8(0, pool.inUse());
+    TEST_ASSERT_EQUAL_UINT32(ROUNDS, pool.getAcquired());
+}
+
+// --------------------------------------------------------------------------
+// Benchmark: heap churn per broadcast vs. client count
+// --------------------------------------------------------------------------
+
+#define BENCH_RUNS 20000
+
+void test_benchmark_broadcast(void) {
+    DataPayload d = makePayload();
+    BroadcastPool<WS_BROADCAST_SLOTS, WS_BROADCAST_BUF_SIZE> pool;
+    volatile size_t sink = 0;
+
+    for (int clients = 1; clients <= WS_MAX_CLIENTS * 2; clients *= 2) {
+        // Previous path: one serialization, then a heap copy per client queue
+        // (what AsyncWebSocket's text() does)
+        char json[WS_BROADCAST_BUF_SIZE];
+        size_t newBefore = g_newCount;
+        size_t copied = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            d.ts++;
+            size_t len = buildDataMessage(json, sizeof(json), d);
+            for (int c = 0; c < clients; c++) {
+                uint8_t* msg = new uint8_t[len + 1];
+                memcpy(msg, json, len);
+                copied += len;
+                sink += msg[len / 2];
+                delete[] msg;
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        double copyAllocs = (double)(g_newCount - newBefore) / BENCH_RUNS;
+        double copyNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_RUNS;
+
+        // Pooled path: serialize once into a shared buffer, a reference per client
+        newBefore = g_newCount;
+        auto t2 = std::chrono::steady_clock::now();
+        for (int r = 0; r < BENCH_RUNS; r++) {
+            d.ts++;
+            auto* b = pool.acquire();
+            b->len = buildDataMessage((char*)b->data, sizeof(b->data), d);
+            for (int c = 0; c < clients; c++) b->retain();
+            b->release();
+            for (int c = 0; c < clients; c++) {
+                sink += b->data[b->len / 2];
+                b->release();
+            }
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        size_t poolAllocs = g_newCount - newBefore;
+        double poolNs = std::chrono::duration<double, std::nano>(t3 - t2).count() / BENCH_RUNS;
+
+        TEST_ASSERT_EQUAL_UINT32(0, poolAllocs);
+        TEST_ASSERT_EQUAL_UINT32(0, pool.getExhausted());
+        printf("  %d client(s): copy %.0f ns, %.0f allocs, %zu B copied; pooled %.0f ns, 0 allocs, 0 B copied\n",
+               clients, copyNs, copyAllocs, copied / BENCH_RUNS, poolNs);
+    }
+    (void)sink;
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // BroadcastPool
+    RUN_TEST(test_acquire_holds_one_reference);
+    RUN_TEST(test_shared_until_last_release);
+    RUN_TEST(test_exhaustion_and_reuse);
+    RUN_TEST(test_release_from_other_thread);
+
+    // Benchmark
+    RUN_TEST(test_benchmark_broadcast);
+
+    return UNITY_END();
+}
@@ -0,0 +1,436 @@
+/**
+ * test_command_parser.cpp
+ *
+ * Tests for parseCommand's single-pass command scanner and for
+ * CommandAssembler, which rebuilds commands split across WebSocket frames.
+ *
+ * Tests cover:
+ *   - Every command shape: set, alarm, config, hello, sync, session,
+ *     sub/unsub (channel lists, unknown names and non-strings ignored)
+ *   - Alarm targets: number sets, null or absent clears, other types ignored
+ *   - Key order, whitespace, escapes, unknown keys with nested values
+ *   - Rejection: malformed JSON, non-object, deep nesting, oversized frames
+ *   - Works on unterminated buffers (reads exactly len bytes)
+ *   - CommandAssembler: split pieces, orphan continuations, overflow drop
+ *   - Same results as the previous ArduinoJson parser over a command corpus
+ *     (when ArduinoJson is available, as in env:native)
+ *   - Benchmark: ns and allocations per command, scanner vs. JsonDocument
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <new>
+#include <string>
+
+#include "web_protocol.h"
+#include "web_protocol.cpp"
+
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#define HAVE_ARDUINOJSON 1
+#else
+#define HAVE_ARDUINOJSON 0
+#endif
+
+using namespace bbq_protocol;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+// Count every operator new, to show the scanner never allocates
+static size_t g_newCount = 0;
+
+void* operator new(size_t n) {
+    g_newCount++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static ParsedCommand parse(const char* json) {
+    return parseCommand(json, strlen(json));
+}
+
+static bool sameCommand(const ParsedCommand& a, const ParsedCommand& b) {
+    return a.type == b.type &&
+           a.setpoint == b.setpoint &&
+           a.hasMeat1Target == b.hasMeat1Target && a.meat1Target == b.meat1Target &&
+           a.hasMeat2Target == b.hasMeat2Target && a.meat2Target == b.meat2Target &&
+           a.hasPitBand == b.hasPitBand && a.pitBand == b.pitBand &&
+           strcmp(a.format, b.format) == 0 &&
+           strcmp(a.fanMode, b.fanMode) == 0 &&
+           a.binVersion == b.binVersion &&
+           a.session == b.session && a.since == b.since;
+}
+
+// Commands the web UI sends, plus awkward variants of them
+static const char* CORPUS[] = {
+    "{\"type\":\"set\",\"sp\":250}",
+    "{\"type\":\"set\",\"sp\":225.5}",
+    "{\"type\":\"set\"}",
+    "{\"type\":\"alarm\",\"meat1Target\":203,\"meat2Target\":185,\"pitBand\":15}",
+    "{\"type\":\"alarm\",\"meat1Target\":null,\"meat2Target\":185.5}",
+    "{\"type\":\"alarm\",\"pitBand\":20}",
+    "{\"type\":\"alarm\",\"meat1Target\":\"203\"}",
+    "{\"type\":\"config\",\"fanMode\":\"fan_and_damper\"}",
+    "{\"type\":\"config\",\"fanMode\":\"\"}",
+    "{\"type\":\"config\",\"fanMode\":\"a_fan_mode_name_that_is_too_long\"}",
+    "{\"type\":\"hello\",\"bin\":1}",
+    "{\"type\":\"hello\",\"bin\":300}",
+    "{\"type\":\"hello\",\"bin\":-4}",
+    "{\"type\":\"hello\"}",
+    "{\"type\":\"sync\",\"session\":1707590000,\"since\":1707600000}",
+    "{\"type\":\"sync\",\"session\":0,\"since\":0}",
+    "{\"type\":\"session\",\"action\":\"new\"}",
+    "{\"type\":\"session\",\"action\":\"download\",\"format\":\"json\"}",
+    "{\"type\":\"session\",\"action\":\"download\"}",
+    "{\"type\":\"session\",\"action\":\"other\"}",
+    " { \"sp\" : 240 , \"type\" : \"set\" } ",
+    "{\"extra\":{\"a\":[1,2,{\"b\":null}],\"c\":\"}\"},\"type\":\"set\",\"sp\":230}",
+    "{\"type\":\"s\\u0065t\",\"sp\":1e2}",
+    "{\"type\":\"nope\"}",
+    "{}",
+    "[]",
+    "\"set\"",
+    "{\"type\":\"set\",\"sp\":250",
+    "{\"type\":\"set\",\"sp\":}",
+    "{\"type\":\"set\" \"sp\":250}",
+    "{\"type\":\"set\",}",
+    "{\"type\":tru}",
+    "",
+};
+static const size_t CORPUS_SIZE = sizeof(CORPUS) / sizeof(CORPUS[0]);
+
+#if HAVE_ARDUINOJSON
+// The previous parseCommand, verbatim
+static ParsedCommand legacyParse(const char* data, size_t len) {
+    ParsedCommand cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.type = CmdType::UNKNOWN;
+
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, data, len);
+    if (err) return cmd;
+
+    const char* type = doc["type"] | "";
+
+    if (strcmp(type, "set") == 0) {
+        cmd.type = CmdType::SET_SP;
+        cmd.setpoint = doc["sp"].as<float>();
+    }
+    else if (strcmp(type, "alarm") == 0) {
+        cmd.type = CmdType::ALARM;
+        if (doc["meat1Target"].is<float>()) {
+            cmd.hasMeat1Target = true;
+            cmd.meat1Target = doc["meat1Target"].as<float>();
+        } else if (doc["meat1Target"].isNull()) {
+            cmd.hasMeat1Target = true;
+            cmd.meat1Target = 0;
+        }
+        if (doc["meat2Target"].is<float>()) {
+            cmd.hasMeat2Target = true;
+            cmd.meat2Target = doc["meat2Target"].as<float>();
+        } else if (doc["meat2Target"].isNull()) {
+            cmd.hasMeat2Target = true;
+            cmd.meat2Target = 0;
+        }
+        if (doc["pitBand"].is<float>()) {
+            cmd.hasPitBand = true;
+            cmd.pitBand = doc["pitBand"].as<float>();
+        }
+    }
+    else if (strcmp(type, "config") == 0) {
+        const char* fm = doc["fanMode"] | "";
+        if (fm[0] != '\0') {
+            cmd.type = CmdType::SET_FAN_MODE;
+            strncpy(cmd.fanMode, fm, sizeof(cmd.fanMode) - 1);
+            cmd.fanMode[sizeof(cmd.fanMode) - 1] = '\0';
+        }
+    }
+    else if (strcmp(type, "hello") == 0) {
+        cmd.type = CmdType::HELLO;
+        int bin = doc["bin"] | 0;
+        cmd.binVersion = bin < 0 ? 0 : (bin > 255 ? 255 : (uint8_t)bin);
+    }
+    else if (strcmp(type, "sync") == 0) {
+        cmd.type = CmdType::SYNC;
+        cmd.session = doc["session"] | 0u;
+        cmd.since = doc["since"] | 0u;
+    }
+    else if (strcmp(type, "session") == 0) {
+        const char* action = doc["action"] | "";
+        if (strcmp(action, "new") == 0) {
+            cmd.type = CmdType::SESSION_NEW;
+        } else if (strcmp(action, "download") == 0) {
+            cmd.type = CmdType::SESSION_DOWNLOAD;
+            const char* fmt = doc["format"] | "csv";
+            strncpy(cmd.format, fmt, sizeof(cmd.format) - 1);
+            cmd.format[sizeof(cmd.format) - 1] = '\0';
+        }
+    }
+    return cmd;
+}
+#endif
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: command shapes
+// --------------------------------------------------------------------------
+
+void test_set_setpoint(void) {
+    ParsedCommand c = parse("{\"type\":\"set\",\"sp\":250}");
+    TEST_ASSERT_TRUE(c.type == CmdType::SET_SP);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 250.0f, c.setpoint);
+
+    c = parse("{\"type\":\"set\",\"sp\":\"250\"}");  // Not a number
+    TEST_ASSERT_TRUE(c.type == CmdType::SET_SP);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, c.setpoint);
+}
+
+void test_alarm_targets(void) {
+    ParsedCommand c = parse("{\"type\":\"alarm\",\"meat1Target\":203,\"meat2Target\":null,\"pitBand\":15.5}");
+    TEST_ASSERT_TRUE(c.type == CmdType::ALARM);
+    TEST_ASSERT_TRUE(c.hasMeat1Target);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 203.0f, c.meat1Target);
+    TEST_ASSERT_TRUE(c.hasMeat2Target);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, c.meat2Target);
+    TEST_ASSERT_TRUE(c.hasPitBand);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 15.5f, c.pitBand);
+
+    // Absent targets clear, as they always have; strings are ignored
+    c = parse("{\"type\":\"alarm\",\"meat1Target\":\"x\"}");
+    TEST_ASSERT_FALSE(c.hasMeat1Target);
+    TEST_ASSERT_TRUE(c.hasMeat2Target);
+    TEST_ASSERT_FALSE(c.hasPitBand);
+}
+
+void test_config_hello_sync_session(void) {
+    ParsedCommand c = parse("{\"type\":\"config\",\"fanMode\":\"damper_primary\"}");
+    TEST_ASSERT_TRUE(c.type == CmdType::SET_FAN_MODE);
+    TEST_ASSERT_EQUAL_STRING("damper_primary", c.fanMode);
+    TEST_ASSERT_TRUE(parse("{\"type\":\"config\"}").type == CmdType::UNKNOWN);
+
+    c = parse("{\"type\":\"hello\",\"bin\":1}");
+    TEST_ASSERT_TRUE(c.type == CmdType::HELLO);
+    TEST_ASSERT_EQUAL_UINT8(1, c.binVersion);
+    TEST_ASSERT_EQUAL_UINT8(255, parse("{\"type\":\"hello\",\"bin\":999}").binVersion);
+    TEST_ASSERT_EQUAL_UINT8(0, parse("{\"type\":\"hello\",\"bin\":-1}").binVersion);
+
+    c = parse("{\"type\":\"sync\",\"session\":1707590000,\"since\":4294967295}");
+    TEST_ASSERT_TRUE(c.type == CmdType::SYNC);
+    TEST_ASSERT_EQUAL_UINT32(1707590000, c.session);
+    TEST_ASSERT_EQUAL_UINT32(4294967295u, c.since);
+
+    TEST_ASSERT_TRUE(parse("{\"type\":\"session\",\"action\":\"new\"}").type == CmdType::SESSION_NEW);
+    c = parse("{\"type\":\"session\",\"action\":\"download\"}");
+    TEST_ASSERT_TRUE(c.type == CmdType::SESSION_DOWNLOAD);
+    TEST_ASSERT_EQUAL_STRING("csv", c.format);
+    TEST_ASSERT_EQUAL_STRING("json",
+        parse("{\"type\":\"session\",\"action\":\"download\",\"format\":\"json\"}").format);
+}
+
+void test_subscribe_unsubscribe(void) {
+    ParsedCommand c = parse("{\"type\":\"sub\",\"channels\":[\"control\"],\"rateMs\":250}");
+    TEST_ASSERT_TRUE(c.type == CmdType::SUBSCRIBE);
+    TEST_ASSERT_EQUAL_UINT8(channelBit(Channel::CONTROL), c.channels);
+    TEST_ASSERT_EQUAL_UINT32(250, c.rateMs);
+
+    c = parse("{\"channels\":[\"data\", 7, \"nope\", {\"x\":[]}, \"control\"],\"type\":\"sub\"}");
+    TEST_ASSERT_TRUE(c.type == CmdType::SUBSCRIBE);
+    TEST_ASSERT_EQUAL_UINT8(channelBit(Channel::DATA) | channelBit(Channel::CONTROL), c.channels);
+    TEST_ASSERT_EQUAL_UINT32(0, c.rateMs);  // Channel default
+
+    c = parse("{\"type\":\"unsub\",\"channels\":[\"data\"]}");
+    TEST_ASSERT_TRUE(c.type == CmdType::UNSUBSCRIBE);
+    TEST_ASSERT_EQUAL_UINT8(channelBit(Channel::DATA), c.channels);
+
+    // Not a list, or a name too long to be one: no channels
+    TEST_ASSERT_EQUAL_UINT8(0, parse("{\"type\":\"sub\",\"channels\":\"data\"}").channels);
+    TEST_ASSERT_EQUAL_UINT8(0,
+        parse("{\"type\":\"sub\",\"channels\":[\"controlcontrolcontrolcontrol\"]}").channels);
+    TEST_ASSERT_TRUE(parse("{\"type\":\"sub\",\"channels\":[\"data\"}").type == CmdType::UNKNOWN);
+}
+
+void test_order_whitespace_unknown_keys(void) {
+    ParsedCommand c = parse(" {\n \"extra\" : {\"a\":[1,{\"b\":\"}\"}],\"c\":true} ,\"sp\":240,\t\"type\":\"set\" } ");
+    TEST_ASSERT_TRUE(c.type == CmdType::SET_SP);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 240.0f, c.setpoint);
+
+    c = parse("{\"type\":\"s\\u0065t\",\"sp\":2.25e2}");
+    TEST_ASSERT_TRUE(c.type == CmdType::SET_SP);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 225.0f, c.setpoint);
+}
+
+// --------------------------------------------------------------------------
+// Tests: rejection
+// --------------------------------------------------------------------------
+
+void test_rejects_malformed(void) {
+    const char* bad[] = {
+        "", "   ", "[]", "\"set\"", "{", "{\"type\":\"set\"",
+        "{\"type\":\"set\",}", "{\"type\" \"set\"}", "{\"type\":\"set\",\"sp\":}",
+        "{\"type\":\"set\",\"sp\":-}", "{\"type\":\"set\",\"sp\":1.}", "{\"type\":tru}",
+        "{\"type\":\"se\\qt\"}", "{\"type\":\"se\nt\"}", "{type:\"set\"}",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        TEST_ASSERT_TRUE(parse(bad[i]).type == CmdType::UNKNOWN);
+    }
+}
+
+void test_rejects_deep_nesting(void) {
+    std::string ok = "{\"type\":\"set\",\"sp\":1,\"x\":";
+    std::string deep = ok;
+    for (int i = 0; i < 7; i++) ok += "[";
+    for (int i = 0; i < 7; i++) ok += "]";
+    ok += "}";
+    for (int i = 0; i < 8; i++) deep += "[";
+    for (int i = 0; i < 8; i++) deep += "]";
+    deep += "}";
+    TEST_ASSERT_TRUE(parse(ok.c_str()).type == CmdType::SET_SP);
+    TEST_ASSERT_TRUE(parse(deep.c_str()).type == CmdType::UNKNOWN);
+}
+
+void test_rejects_oversized(void) {
+    std::string big = "{\"type\":\"set\",\"sp\":250,\"pad\":\"";
+    big.append(WS_CMD_MAX_LEN, 'x');
+    big += "\"}";
+    TEST_ASSERT_TRUE(parse(big.c_str()).type == CmdType::UNKNOWN);
+}
+
+void test_reads_only_len_bytes(void) {
+    // No NUL after the command, and junk beyond it
+    const char raw[] = "{\"type\":\"set\",\"sp\":250}{\"type\":\"session\"";
+    ParsedCommand c = parseCommand(raw, 23);
+    TEST_ASSERT_TRUE(c.type == CmdType::SET_SP);
+    TEST_ASSERT_TRUE(parseCommand(raw, 22).type == CmdType::UNKNOWN);  // Cut short
+}
+
+// --------------------------------------------------------------------------
+// Tests: CommandAssembler
+// --------------------------------------------------------------------------
+
+void test_assembler_joins_pieces(void) {
+    CommandAssembler a;
+    const char* cmd = "{\"type\":\"set\",\"sp\":250}";
+    TEST_ASSERT_TRUE(a.feed(cmd, 5, true, false) == CommandAssembler::Result::PENDING);
+    TEST_ASSERT_TRUE(a.feed(cmd + 5, 10, false, false) == CommandAssembler::Result::PENDING);
+    TEST_ASSERT_TRUE(a.feed(cmd + 15, strlen(cmd) - 15, false, true) ==
+                     CommandAssembler::Result::COMPLETE);
+    TEST_ASSERT_EQUAL_STRING(cmd, a.data());
+    TEST_ASSERT_TRUE(parseCommand(a.data(), a.length()).type == CmdType::SET_SP);
+
+    // Single-piece message
+    TEST_ASSERT_TRUE(a.feed(cmd, strlen(cmd), true, true) == CommandAssembler::Result::COMPLETE);
+    TEST_ASSERT_EQUAL_UINT32(strlen(cmd), a.length());
+}
+
+void test_assembler_orphan_and_overflow(void) {
+    CommandAssembler a;
+    // A continuation without its start is ignored
+    TEST_ASSERT_TRUE(a.feed("sp\":1}", 6, false, true) == CommandAssembler::Result::PENDING);
+
+    // Oversized message is dropped once, then the next one goes through
+    static char big[WS_CMD_MAX_LEN];
+    memset(big, 'x', sizeof(big));
+    TEST_ASSERT_TRUE(a.feed(big, sizeof(big), true, false) == CommandAssembler::Result::PENDING);
+    TEST_ASSERT_TRUE(a.feed(big, 1, false, false) == CommandAssembler::Result::PENDING);
+    TEST_ASSERT_TRUE(a.feed(big, sizeof(big), false, true) == CommandAssembler::Result::DROPPED);
+
+    const char* cmd = "{\"type\":\"session\",\"action\":\"new\"}";
+    TEST_ASSERT_TRUE(a.feed(cmd, strlen(cmd), true, true) == CommandAssembler::Result::COMPLETE);
+    TEST_ASSERT_TRUE(parseCommand(a.data(), a.length()).type == CmdType::SESSION_NEW);
+}
+
+// --------------------------------------------------------------------------
+// Tests: equivalence with the ArduinoJson parser
+// --------------------------------------------------------------------------
+
+void test_matches_arduinojson(void) {
+#if HAVE_ARDUINOJSON
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        ParsedCommand a = parseCommand(CORPUS[i], strlen(CORPUS[i]));
+        ParsedCommand b = legacyParse(CORPUS[i], strlen(CORPUS[i]));
+        if (!sameCommand(a, b)) printf("  mismatch: %s\n", CORPUS[i]);
+        TEST_ASSERT_TRUE(sameCommand(a, b));
+    }
+#else
+    TEST_IGNORE_MESSAGE("ArduinoJson not available (env:native provides it)");
+#endif
+}
+
+// --------------------------------------------------------------------------
+// Benchmark: ns and allocations per command
+// --------------------------------------------------------------------------
+
+#define BENCH_RUNS 20000
+
+void test_benchmark_parse(void) {
+    volatile int sink = 0;
+    size_t newBefore = g_newCount;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        const char* c = CORPUS[r % CORPUS_SIZE];
+        sink += (int)parseCommand(c, strlen(c)).type;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    TEST_ASSERT_EQUAL_UINT32(0, g_newCount - newBefore);
+    double scanNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_RUNS;
+
+#if HAVE_ARDUINOJSON
+    auto t2 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        const char* c = CORPUS[r % CORPUS_SIZE];
+        sink += (int)legacyParse(c, strlen(c)).type;
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    double docNs = std::chrono::duration<double, std::nano>(t3 - t2).count() / BENCH_RUNS;
+    printf("  parse: scanner %.0f ns, 0 allocs; JsonDocument %.0f ns (%.1fx)\n",
+           scanNs, docNs, docNs / scanNs);
+#else
+    printf("  parse: scanner %.0f ns per command, 0 allocs (ArduinoJson not available)\n", scanNs);
+#endif
+    (void)sink;
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Command shapes
+    RUN_TEST(test_set_setpoint);
+    RUN_TEST(test_alarm_targets);
+    RUN_TEST(test_config_hello_sync_session);
+    RUN_TEST(test_subscribe_unsubscribe);
+    RUN_TEST(test_order_whitespace_unknown_keys);
+
+    // Rejection
+    RUN_TEST(test_rejects_malformed);
+    RUN_TEST(test_rejects_deep_nesting);
+    RUN_TEST(test_rejects_oversized);
+    RUN_TEST(test_reads_only_len_bytes);
+
+    // CommandAssembler
+    RUN_TEST(test_assembler_joins_pieces);
+    RUN_TEST(test_assembler_orphan_and_overflow);
+
+    // ArduinoJson equivalence
+    RUN_TEST(test_matches_arduinojson);
+
+    // Benchmark
+    RUN_TEST(test_benchmark_parse);
+
+    return UNITY_END();
+}
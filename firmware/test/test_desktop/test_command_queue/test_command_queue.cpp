@@ -0,0 +1,203 @@
+/**
+ * test_command_queue.cpp
+ *
+ * Tests for the lock-free MPSC queue and the command queue the web server
+ * and touch UI use to hand commands to the control cycle.
+ *
+ * Tests cover:
+ *   - MpscQueue: FIFO order, full at capacity, index wrap-around
+ *   - MpscQueue: high-water mark
+ *   - MpscQueue: several producer threads, no loss, per-producer order
+ *   - CommandQueue: drops counted when full, drain order and count
+ *   - CommandQueue: post-to-apply latency, over-a-period count, window reset
+ *   - ControlCommand: text is truncated and terminated
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "mpsc_queue.h"
+#include "control_command.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: MpscQueue
+// --------------------------------------------------------------------------
+
+void test_fifo_order(void) {
+    MpscQueue<uint32_t, 8> q;
+    TEST_ASSERT_TRUE(q.empty());
+    for (uint32_t i = 1; i <= 5; i++) TEST_ASSERT_TRUE(q.push(i));
+    TEST_ASSERT_EQUAL_UINT32(5, q.size());
+
+    uint32_t v = 0;
+    for (uint32_t i = 1; i <= 5; i++) {
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL_UINT32(i, v);
+    }
+    TEST_ASSERT_FALSE(q.pop(v));
+    TEST_ASSERT_TRUE(q.empty());
+}
+
+void test_full_at_capacity(void) {
+    MpscQueue<uint32_t, 4> q;
+    TEST_ASSERT_EQUAL_UINT32(4, q.capacity());
+    for (uint32_t i = 0; i < 4; i++) TEST_ASSERT_TRUE(q.push(i));
+    TEST_ASSERT_FALSE(q.push(99));
+
+    uint32_t v = 0;
+    TEST_ASSERT_TRUE(q.pop(v));
+    TEST_ASSERT_EQUAL_UINT32(0, v);
+    TEST_ASSERT_TRUE(q.push(4));
+    TEST_ASSERT_FALSE(q.push(5));
+    TEST_ASSERT_EQUAL_UINT32(4, q.getHighWater());
+}
+
+void test_wraps_around(void) {
+    MpscQueue<uint32_t, 4> q;
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(q.push(i));
+        TEST_ASSERT_TRUE(q.push(i + 1));
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL_UINT32(i, v);
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL_UINT32(i + 1, v);
+    }
+    TEST_ASSERT_TRUE(q.empty());
+    TEST_ASSERT_EQUAL_UINT32(2, q.getHighWater());
+}
+
+void test_producer_threads_no_loss(void) {
+    static MpscQueue<uint32_t, 16> q;
+    const uint32_t PRODUCERS = 4;
+    const uint32_t EACH = 50000;
+
+    // Item = producer << 24 | sequence
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([p]() {
+            for (uint32_t i = 0; i < EACH; i++) {
+                while (!q.push((p << 24) | i)) std::this_thread::yield();
+            }
+        });
+    }
+
+    uint32_t next[PRODUCERS] = {};
+    uint32_t outOfOrder = 0;
+    uint32_t received = 0;
+    uint32_t v = 0;
+    while (received < PRODUCERS * EACH) {
+        if (!q.pop(v)) continue;
+        uint32_t p = v >> 24;
+        if (p >= PRODUCERS || (v & 0xFFFFFF) != next[p]) outOfOrder++;
+        else next[p]++;
+        received++;
+    }
+    for (std::thread& t : producers) t.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    for (uint32_t p = 0; p < PRODUCERS; p++) TEST_ASSERT_EQUAL_UINT32(EACH, next[p]);
+    TEST_ASSERT_FALSE(q.pop(v));
+}
+
+// --------------------------------------------------------------------------
+// Tests: CommandQueue
+// --------------------------------------------------------------------------
+
+void test_drops_when_full(void) {
+    CommandQueue q;
+    for (uint32_t i = 0; i < CONTROL_COMMAND_QUEUE_DEPTH; i++) {
+        TEST_ASSERT_TRUE(q.post(ControlCommand::make(CommandType::SETPOINT, (float)i), 0));
+    }
+    TEST_ASSERT_FALSE(q.post(ControlCommand::make(CommandType::ALARM_ACK), 0));
+    TEST_ASSERT_EQUAL_UINT32(CONTROL_COMMAND_QUEUE_DEPTH, q.getPosted());
+    TEST_ASSERT_EQUAL_UINT32(1, q.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(CONTROL_COMMAND_QUEUE_DEPTH, q.getQueuePeak());
+}
+
+void test_drain_applies_in_order(void) {
+    CommandQueue q;
+    q.post(ControlCommand::make(CommandType::SETPOINT, 250.0f), 0);
+    q.post(ControlCommand::make(CommandType::MEAT_TARGET, 203.0f, 2), 0);
+    q.post(ControlCommand::withText(CommandType::FAN_MODE, "fan_only"), 0);
+
+    ControlCommand seen[4];
+    uint16_t count = 0;
+    uint16_t n = q.drain(100, [&](const ControlCommand& cmd) {
+        if (count < 4) seen[count] = cmd;
+        count++;
+    });
+
+    TEST_ASSERT_EQUAL_UINT16(3, n);
+    TEST_ASSERT_EQUAL_UINT16(3, count);
+    TEST_ASSERT_TRUE(seen[0].type == CommandType::SETPOINT);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 250.0f, seen[0].value);
+    TEST_ASSERT_TRUE(seen[1].type == CommandType::MEAT_TARGET);
+    TEST_ASSERT_EQUAL_UINT8(2, seen[1].probe);
+    TEST_ASSERT_TRUE(seen[2].type == CommandType::FAN_MODE);
+    TEST_ASSERT_EQUAL_STRING("fan_only", seen[2].text);
+    TEST_ASSERT_EQUAL_UINT32(3, q.getApplied());
+
+    // Nothing left for the next cycle
+    TEST_ASSERT_EQUAL_UINT16(0, q.drain(200, [](const ControlCommand&) {}));
+}
+
+void test_latency_recorded(void) {
+    CommandQueue q(10000);
+    q.post(ControlCommand::make(CommandType::SETPOINT, 225.0f), 1000);
+    q.post(ControlCommand::make(CommandType::SETPOINT, 230.0f), 4000);
+    q.drain(9000, [](const ControlCommand&) {});       // 8000 and 5000 us
+
+    const LoopStats& lat = q.getLatency();
+    TEST_ASSERT_EQUAL_UINT32(8000, lat.getMaxUs());
+    TEST_ASSERT_EQUAL_UINT32(6500, lat.getAvgUs());
+    TEST_ASSERT_EQUAL_UINT32(0, lat.getOverruns());
+
+    // Waited longer than one period
+    q.post(ControlCommand::make(CommandType::ALARM_ACK), 10000);
+    q.drain(35000, [](const ControlCommand&) {});
+    TEST_ASSERT_EQUAL_UINT32(25000, lat.getMaxUs());
+    TEST_ASSERT_EQUAL_UINT32(1, lat.getOverruns());
+
+    q.resetLatencyWindow();
+    TEST_ASSERT_EQUAL_UINT32(0, lat.getMaxUs());
+    TEST_ASSERT_EQUAL_UINT32(25000, lat.getAllTimeMaxUs());
+}
+
+void test_text_truncated(void) {
+    ControlCommand c = ControlCommand::withText(CommandType::FAN_MODE,
+                                                "a_mode_name_longer_than_the_field");
+    TEST_ASSERT_EQUAL_UINT32(CONTROL_COMMAND_TEXT_MAX - 1, strlen(c.text));
+
+    ControlCommand n = ControlCommand::withText(CommandType::FAN_MODE, nullptr);
+    TEST_ASSERT_EQUAL_STRING("", n.text);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // MpscQueue
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_full_at_capacity);
+    RUN_TEST(test_wraps_around);
+    RUN_TEST(test_producer_threads_no_loss);
+
+    // CommandQueue
+    RUN_TEST(test_drops_when_full);
+    RUN_TEST(test_drain_applies_in_order);
+    RUN_TEST(test_latency_recorded);
+    RUN_TEST(test_text_truncated);
+
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+/**
+ * test_control_jitter.cpp
+ *
+ * Tests for the control-period jitter histogram reported at /api/stats.
+ *
+ * Tests cover:
+ *   - Empty histogram reads as zeros
+ *   - Early and late intervals both count as jitter, bucket edges
+ *   - Shortest/longest interval, max jitter and late cycles
+ *   - Percentile bounds, including the open-ended bucket
+ *   - Reset
+ */
+
+#include <unity.h>
+#include <stdint.h>
+
+#include "control_jitter.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests
+// --------------------------------------------------------------------------
+
+void test_empty_histogram(void) {
+    JitterHistogram h(10000);
+    TEST_ASSERT_EQUAL_UINT32(0, h.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, h.getMinIntervalUs());
+    TEST_ASSERT_EQUAL_UINT32(0, h.getMaxIntervalUs());
+    TEST_ASSERT_EQUAL_UINT32(0, h.percentileUs(99));
+    for (uint8_t i = 0; i < JitterHistogram::BUCKETS; i++) {
+        TEST_ASSERT_EQUAL_UINT32(0, h.getBucket(i));
+    }
+}
+
+void test_early_and_late_are_both_jitter(void) {
+    JitterHistogram h(10000);
+    h.record(10020);   // 20 us late
+    h.record(9980);    // 20 us early
+    TEST_ASSERT_EQUAL_UINT32(2, h.getBucket(0));
+    TEST_ASSERT_EQUAL_UINT32(20, h.getMaxJitterUs());
+    TEST_ASSERT_EQUAL_UINT32(9980, h.getMinIntervalUs());
+    TEST_ASSERT_EQUAL_UINT32(10020, h.getMaxIntervalUs());
+}
+
+void test_bucket_edges(void) {
+    JitterHistogram h(10000);
+    h.record(10000 + 49);     // < 50
+    h.record(10000 + 50);     // < 100
+    h.record(10000 + 249);    // < 250
+    h.record(10000 + 1000);   // < 2500
+    h.record(10000 + 5000);   // open-ended
+    TEST_ASSERT_EQUAL_UINT32(1, h.getBucket(0));
+    TEST_ASSERT_EQUAL_UINT32(1, h.getBucket(1));
+    TEST_ASSERT_EQUAL_UINT32(1, h.getBucket(2));
+    TEST_ASSERT_EQUAL_UINT32(0, h.getBucket(3));
+    TEST_ASSERT_EQUAL_UINT32(0, h.getBucket(4));
+    TEST_ASSERT_EQUAL_UINT32(1, h.getBucket(5));
+    TEST_ASSERT_EQUAL_UINT32(1, h.getBucket(7));
+    TEST_ASSERT_EQUAL_UINT32(5, h.getCount());
+}
+
+void test_late_cycles(void) {
+    JitterHistogram h(10000);
+    h.record(19999);
+    TEST_ASSERT_EQUAL_UINT32(0, h.getLate());
+    h.record(20000);   // Missed a whole period
+    h.record(45000);
+    TEST_ASSERT_EQUAL_UINT32(2, h.getLate());
+    TEST_ASSERT_EQUAL_UINT32(35000, h.getMaxJitterUs());
+    TEST_ASSERT_EQUAL_UINT32(3, h.getBucket(7));
+}
+
+void test_percentiles(void) {
+    JitterHistogram h(10000);
+    for (int i = 0; i < 98; i++) h.record(10010);   // < 50
+    h.record(10300);                                 // < 500
+    h.record(10000 + 8000);                          // open-ended
+    TEST_ASSERT_EQUAL_UINT32(50, h.percentileUs(50));
+    TEST_ASSERT_EQUAL_UINT32(50, h.percentileUs(98));
+    TEST_ASSERT_EQUAL_UINT32(500, h.percentileUs(99));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, h.percentileUs(100));
+}
+
+void test_reset(void) {
+    JitterHistogram h(10000);
+    h.record(25000);
+    h.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, h.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, h.getLate());
+    TEST_ASSERT_EQUAL_UINT32(0, h.getMaxJitterUs());
+    TEST_ASSERT_EQUAL_UINT32(0, h.getBucket(7));
+    TEST_ASSERT_EQUAL_UINT32(10000, h.getPeriodUs());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_empty_histogram);
+    RUN_TEST(test_early_and_late_are_both_jitter);
+    RUN_TEST(test_bucket_edges);
+    RUN_TEST(test_late_cycles);
+    RUN_TEST(test_percentiles);
+    RUN_TEST(test_reset);
+
+    return UNITY_END();
+}
@@ -0,0 +1,388 @@
+/**
+ * test_data_message.cpp
+ *
+ * Tests for the allocation-free JSON messages (JsonWriter, data_message.cpp)
+ * that replaced the ArduinoJson JsonDocument builders.
+ *
+ * Tests cover:
+ *   - Golden bytes for the data, session reset and download, hello, control
+ *     and subscription messages
+ *   - Disconnected/shorted probes, unset targets and estimate as null
+ *   - String escaping in the fanMode and errors fields
+ *   - JsonTenths matches printf("%.1f") across the probe range, halfway
+ *     cases and negative zero
+ *   - A buffer too small for the message yields 0, not truncated JSON
+ *   - Byte-identical output to the previous ArduinoJson builder over a
+ *     sweep of payloads (when ArduinoJson is available, as in env:native)
+ *   - Benchmark: ns and allocations per data message, JsonWriter vs.
+ *     JsonDocument
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <chrono>
+#include <new>
+#include <string>
+
+#include "web_protocol.h"
+#include "json_writer.h"
+#include "data_message.cpp"
+
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#define HAVE_ARDUINOJSON 1
+#else
+#define HAVE_ARDUINOJSON 0
+#endif
+
+using namespace bbq_protocol;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+// Count every operator new, to show the writer path never allocates
+static size_t g_newCount = 0;
+
+void* operator new(size_t n) {
+    g_newCount++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static DataPayload makePayload() {
+    DataPayload d;
+    memset(&d, 0, sizeof(d));
+    d.ts = 1707600000;
+    d.pit = 225.5f;
+    d.meat1 = 145.2f;
+    d.meat2 = -12.3f;
+    d.fan = 45;
+    d.damper = 80;
+    d.sp = 225;
+    d.lid = false;
+    d.meat1Target = 203;
+    d.meat2Target = 0;
+    d.est = 1707614400;
+    d.fanMode = "fan_and_damper";
+    d.errors[0] = "Pit probe disconnected";
+    d.errorCount = 1;
+    return d;
+}
+
+static std::string tenths(float v) {
+    char buf[32];
+    JsonWriter w(buf, sizeof(buf));
+    w.beginArray("v");
+    w.element(JsonTenths{v});
+    w.endArray();
+    size_t n = w.finish();
+    // "v":[x]
+    return std::string(buf + 5, n - 6);
+}
+
+#if HAVE_ARDUINOJSON
+// Counts JsonDocument heap traffic
+struct CountingAllocator : ArduinoJson::Allocator {
+    size_t allocs = 0;
+    void* allocate(size_t n) override { allocs++; return malloc(n); }
+    void deallocate(void* p) override { free(p); }
+    void* reallocate(void* p, size_t n) override { allocs++; return realloc(p, n); }
+};
+
+// The previous buildDataMessage, verbatim apart from the allocator
+static size_t legacyDataMessage(char* buf, size_t bufSize, const DataPayload& d,
+                                ArduinoJson::Allocator* alloc) {
+    JsonDocument doc(alloc);
+    doc["type"] = "data";
+    doc["ts"] = d.ts;
+
+    char pitStr[16], m1Str[16], m2Str[16];
+
+    if (std::isnan(d.pit))    doc["pit"] = (const char*)nullptr;
+    else if (d.pit == -1.0f)  doc["pit"] = -1;
+    else { snprintf(pitStr, sizeof(pitStr), "%.1f", d.pit); doc["pit"] = serialized(pitStr); }
+
+    if (std::isnan(d.meat1))   doc["meat1"] = (const char*)nullptr;
+    else if (d.meat1 == -1.0f) doc["meat1"] = -1;
+    else { snprintf(m1Str, sizeof(m1Str), "%.1f", d.meat1); doc["meat1"] = serialized(m1Str); }
+
+    if (std::isnan(d.meat2))   doc["meat2"] = (const char*)nullptr;
+    else if (d.meat2 == -1.0f) doc["meat2"] = -1;
+    else { snprintf(m2Str, sizeof(m2Str), "%.1f", d.meat2); doc["meat2"] = serialized(m2Str); }
+
+    doc["fan"] = (int)d.fan;
+    doc["damper"] = (int)d.damper;
+    doc["sp"] = (int)d.sp;
+    doc["lid"] = d.lid;
+    if (d.fanMode) doc["fanMode"] = d.fanMode;
+
+    if (d.meat1Target > 0)  doc["meat1Target"] = (int)d.meat1Target;
+    else                    doc["meat1Target"] = (const char*)nullptr;
+
+    if (d.meat2Target > 0)  doc["meat2Target"] = (int)d.meat2Target;
+    else                    doc["meat2Target"] = (const char*)nullptr;
+
+    if (d.est > 0)  doc["est"] = d.est;
+    else            doc["est"] = (const char*)nullptr;
+
+    JsonArray errors = doc["errors"].to<JsonArray>();
+    for (uint8_t i = 0; i < d.errorCount && i < 8; i++) {
+        errors.add(d.errors[i]);
+    }
+
+    return serializeJson(doc, buf, bufSize);
+}
+#endif
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: golden output
+// --------------------------------------------------------------------------
+
+void test_data_message_golden(void) {
+    DataPayload d = makePayload();
+    char buf[512];
+    size_t n = buildDataMessage(buf, sizeof(buf), d);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"data\",\"ts\":1707600000,\"pit\":225.5,\"meat1\":145.2,\"meat2\":-12.3,"
+        "\"fan\":45,\"damper\":80,\"sp\":225,\"lid\":false,\"fanMode\":\"fan_and_damper\","
+        "\"meat1Target\":203,\"meat2Target\":null,\"est\":1707614400,"
+        "\"errors\":[\"Pit probe disconnected\"]}",
+        buf);
+    TEST_ASSERT_EQUAL_UINT32(strlen(buf), n);
+}
+
+void test_data_message_nulls(void) {
+    DataPayload d = makePayload();
+    d.pit = NAN;
+    d.meat1 = -1.0f;
+    d.meat2 = NAN;
+    d.lid = true;
+    d.meat1Target = 0;
+    d.est = 0;
+    d.fanMode = nullptr;
+    d.errorCount = 0;
+
+    char buf[512];
+    buildDataMessage(buf, sizeof(buf), d);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"data\",\"ts\":1707600000,\"pit\":null,\"meat1\":-1,\"meat2\":null,"
+        "\"fan\":45,\"damper\":80,\"sp\":225,\"lid\":true,"
+        "\"meat1Target\":null,\"meat2Target\":null,\"est\":null,\"errors\":[]}",
+        buf);
+}
+
+void test_string_escaping(void) {
+    DataPayload d = makePayload();
+    d.errors[0] = "say \"hi\"\\";
+    d.errors[1] = "a\nb\tc\rd";
+    d.errorCount = 2;
+
+    char buf[512];
+    buildDataMessage(buf, sizeof(buf), d);
+    const char* errors = strstr(buf, "\"errors\":");
+    TEST_ASSERT_NOT_NULL(errors);
+    TEST_ASSERT_EQUAL_STRING(
+        "\"errors\":[\"say \\\"hi\\\"\\\\\",\"a\\nb\\tc\\rd\"]}", errors);
+}
+
+void test_session_reset_and_hello(void) {
+    char buf[128];
+    size_t n = buildSessionReset(buf, sizeof(buf), 250.7f);
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"session\",\"action\":\"reset\",\"sp\":250}", buf);
+    TEST_ASSERT_EQUAL_UINT32(strlen(buf), n);
+
+    buildHelloAck(buf, sizeof(buf), 1);
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"hello\",\"bin\":1}", buf);
+}
+
+void test_session_download(void) {
+    char buf[128];
+    size_t n = buildSessionDownload(buf, sizeof(buf), "csv");
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"session\",\"action\":\"download\",\"format\":\"csv\","
+        "\"url\":\"/api/session.csv\"}", buf);
+    TEST_ASSERT_EQUAL_UINT32(strlen(buf), n);
+
+    n = buildSessionDownload(buf, sizeof(buf), "json");
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"session\",\"action\":\"download\",\"format\":\"json\","
+        "\"url\":\"/api/session.json\"}", buf);
+    TEST_ASSERT_EQUAL_UINT32(strlen(buf), n);
+}
+
+void test_control_and_sub_ack(void) {
+    char buf[256];
+    ControlPayload c;
+    memset(&c, 0, sizeof(c));
+    c.ms = 123456;
+    c.pit = 224.56f;
+    c.sp = 225.0f;
+    c.out = 41.25f;
+    c.p = 1.76f;
+    c.i = 40.5f;
+    c.d = -1.01f;
+    c.fan = 41.2f;
+    c.damper = 100.0f;
+    size_t n = buildControlMessage(buf, sizeof(buf), c);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"control\",\"ms\":123456,\"pit\":224.6,\"sp\":225.0,\"out\":41.2,"
+        "\"p\":1.8,\"i\":40.5,\"d\":-1.0,\"fan\":41.2,\"damper\":100.0,\"lid\":false}", buf);
+    TEST_ASSERT_EQUAL_UINT32(strlen(buf), n);
+
+    uint16_t rates[(uint8_t)Channel::COUNT] = { 0, 250 };
+    buildSubscriptionAck(buf, sizeof(buf), channelBit(Channel::DATA) | channelBit(Channel::CONTROL), rates);
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"sub\",\"channels\":{\"data\":0,\"control\":250}}", buf);
+    buildSubscriptionAck(buf, sizeof(buf), 0, rates);
+    TEST_ASSERT_EQUAL_STRING("{\"type\":\"sub\",\"channels\":{}}", buf);
+}
+
+void test_tenths_match_printf(void) {
+    char ref[32];
+    // Every tenth across the probe range, nudged either side
+    for (int32_t i = -1000; i <= 10000; i++) {
+        float base = i / 10.0f;
+        float vals[3] = { base, nextafterf(base, -INFINITY), nextafterf(base, INFINITY) };
+        for (float v : vals) {
+            snprintf(ref, sizeof(ref), "%.1f", v);
+            TEST_ASSERT_EQUAL_STRING(ref, tenths(v).c_str());
+        }
+    }
+    // Exact halfway cases round to even, like printf
+    float halves[] = { 0.25f, 0.75f, 2.25f, -0.25f, 1023.75f, 0.05f, -0.05f };
+    for (float v : halves) {
+        snprintf(ref, sizeof(ref), "%.1f", v);
+        TEST_ASSERT_EQUAL_STRING(ref, tenths(v).c_str());
+    }
+    TEST_ASSERT_EQUAL_STRING("-0.0", tenths(-0.04f).c_str());
+    TEST_ASSERT_EQUAL_STRING("0.0", tenths(0.0f).c_str());
+}
+
+void test_overflow_returns_zero(void) {
+    DataPayload d = makePayload();
+    char buf[512];
+    size_t full = buildDataMessage(buf, sizeof(buf), d);
+
+    char small[64];
+    TEST_ASSERT_EQUAL_UINT32(0, buildDataMessage(small, sizeof(small), d));
+    TEST_ASSERT_EQUAL_UINT32(0, buildDataMessage(buf, full, d));  // No room for the NUL
+    TEST_ASSERT_EQUAL_UINT32(full, buildDataMessage(buf, full + 1, d));
+}
+
+// --------------------------------------------------------------------------
+// Tests: equivalence with the ArduinoJson builder
+// --------------------------------------------------------------------------
+
+void test_matches_arduinojson(void) {
+#if HAVE_ARDUINOJSON
+    const char* modes[] = { "fan_only", "fan_and_damper", "damper_primary", nullptr };
+    const char* errs[] = { "Pit probe disconnected", "Meat 1 \"shorted\"", "ADC\\fault" };
+    CountingAllocator alloc;
+    char a[512], b[512];
+    uint32_t checked = 0;
+
+    for (uint32_t i = 0; i < 20000; i++) {
+        DataPayload d = makePayload();
+        d.ts = 1707600000 + i * 5;
+        d.pit   = (i % 17 == 0) ? NAN : (i % 23 == 0 ? -1.0f : -40.0f + i * 0.037f);
+        d.meat1 = (i % 19 == 0) ? NAN : (i % 29 == 0 ? -1.0f : 32.0f + (i % 2000) * 0.1f);
+        d.meat2 = (i % 13 == 0) ? NAN : 700.0f - i * 0.0331f;
+        d.fan = (uint8_t)(i % 101);
+        d.damper = (uint8_t)(100 - i % 101);
+        d.sp = 180.0f + (i % 200) * 0.7f;
+        d.lid = (i % 7) == 0;
+        d.meat1Target = (i % 3 == 0) ? 0 : 150.0f + (i % 60);
+        d.meat2Target = (i % 5 == 0) ? 0 : 160.5f + (i % 40);
+        d.est = (i % 4 == 0) ? 0 : 1707614400 + i;
+        d.fanMode = modes[i % 4];
+        d.errorCount = (uint8_t)(i % 4);
+        for (uint8_t e = 0; e < d.errorCount; e++) d.errors[e] = errs[e];
+
+        size_t na = buildDataMessage(a, sizeof(a), d);
+        size_t nb = legacyDataMessage(b, sizeof(b), d, &alloc);
+        TEST_ASSERT_EQUAL_UINT32(nb, na);
+        TEST_ASSERT_EQUAL_STRING(b, a);
+        checked++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(20000, checked);
+#else
+    TEST_IGNORE_MESSAGE("ArduinoJson not available (env:native provides it)");
+#endif
+}
+
+// --------------------------------------------------------------------------
+// Benchmark: ns and allocations per data message
+// --------------------------------------------------------------------------
+
+#define BENCH_RUNS 100000
+
+void test_benchmark_data_message(void) {
+    DataPayload d = makePayload();
+    char buf[512];
+    volatile size_t sink = 0;
+
+    size_t newBefore = g_newCount;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        d.ts++;
+        sink += buildDataMessage(buf, sizeof(buf), d);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    size_t writerAllocs = g_newCount - newBefore;
+    double writerNs = std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_RUNS;
+    TEST_ASSERT_EQUAL_UINT32(0, writerAllocs);
+
+#if HAVE_ARDUINOJSON
+    CountingAllocator alloc;
+    auto t2 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        d.ts++;
+        sink += legacyDataMessage(buf, sizeof(buf), d, &alloc);
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    double docNs = std::chrono::duration<double, std::nano>(t3 - t2).count() / BENCH_RUNS;
+    printf("  data message: JsonWriter %.0f ns, 0 allocs; JsonDocument %.0f ns, %.1f allocs (%.1fx)\n",
+           writerNs, docNs, (double)alloc.allocs / BENCH_RUNS, docNs / writerNs);
+    TEST_ASSERT_TRUE(alloc.allocs > 0);
+#else
+    printf("  data message: JsonWriter %.0f ns, 0 allocs (ArduinoJson not available)\n", writerNs);
+#endif
+    (void)sink;
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Golden output
+    RUN_TEST(test_data_message_golden);
+    RUN_TEST(test_data_message_nulls);
+    RUN_TEST(test_string_escaping);
+    RUN_TEST(test_session_reset_and_hello);
+    RUN_TEST(test_session_download);
+    RUN_TEST(test_control_and_sub_ack);
+    RUN_TEST(test_tenths_match_printf);
+    RUN_TEST(test_overflow_returns_zero);
+
+    // ArduinoJson equivalence
+    RUN_TEST(test_matches_arduinojson);
+
+    // Benchmark
+    RUN_TEST(test_benchmark_data_message);
+
+    return UNITY_END();
+}
@@ -0,0 +1,291 @@
+/**
+ * test_history_message.cpp
+ *
+ * Tests for HistoryMessageBuilder and HistoryChunkWriter, which format the
+ * history replay straight from session records.
+ *
+ * Tests cover:
+ *   - Envelope (setpoint, meat targets, empty data array)
+ *   - history_chunk envelope: seq, session id, append and final markers
+ *   - Chunked replay of a long session: every chunk within the fixed
+ *     buffer, points identical to the single-message output
+ *   - DataPoint formatting: tenths, negatives, disconnected probes as null
+ *   - Golden equivalence with the HistoryPoint path (float + snprintf)
+ *   - Buffer growth past the initial estimate
+ *   - Benchmark: ring -> HistoryPoint array -> message (previous sendHistory
+ *     path) vs. ring spans -> message; timings printed, output asserted equal
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <chrono>
+#include <string>
+
+#include "config.h"
+#include "history_message.h"
+#include "history_message.cpp"
+#include "binary_frame.cpp"
+#include "ring_view.h"
+
+using bbq_protocol::HistoryMessageBuilder;
+using bbq_protocol::HistoryChunkWriter;
+using bbq_protocol::HistoryChunkHeader;
+using bbq_protocol::HistoryPoint;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+static DataPoint makePoint(uint32_t ts, int16_t pit, int16_t meat1, int16_t meat2,
+                           uint8_t fan, uint8_t flags) {
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = ts;
+    dp.pitTemp   = pit;
+    dp.meat1Temp = meat1;
+    dp.meat2Temp = meat2;
+    dp.fanPct    = fan;
+    dp.damperPct = 100 - fan;
+    dp.flags     = flags;
+    return dp;
+}
+
+// The DataPoint -> HistoryPoint conversion sendHistory used to stage
+static void toHistoryPoint(const DataPoint& dp, float sp, HistoryPoint& out) {
+    out.ts     = dp.timestamp;
+    out.pit    = (dp.flags & DP_FLAG_PIT_DISC)   ? NAN : dp.pitTemp / 10.0f;
+    out.meat1  = (dp.flags & DP_FLAG_MEAT1_DISC) ? NAN : dp.meat1Temp / 10.0f;
+    out.meat2  = (dp.flags & DP_FLAG_MEAT2_DISC) ? NAN : dp.meat2Temp / 10.0f;
+    out.fan    = dp.fanPct;
+    out.damper = dp.damperPct;
+    out.sp     = sp;
+    out.lid    = (dp.flags & DP_FLAG_LID_OPEN) != 0;
+}
+
+static std::string buildFromPoints(const DataPoint* pts, size_t n, float sp) {
+    HistoryMessageBuilder b;
+    b.begin(n, sp, 0, 0);
+    for (size_t i = 0; i < n; i++) b.add(pts[i], sp);
+    size_t len = 0;
+    char* msg = b.finish(&len);
+    std::string out(msg, len);
+    free(msg);
+    return out;
+}
+
+static std::string buildFromHistory(const DataPoint* pts, size_t n, float sp) {
+    HistoryPoint* hp = (HistoryPoint*)malloc(n * sizeof(HistoryPoint));
+    for (size_t i = 0; i < n; i++) toHistoryPoint(pts[i], sp, hp[i]);
+    size_t len = 0;
+    char* msg = bbq_protocol::buildHistoryMessage(hp, n, sp, 0, 0, &len);
+    free(hp);
+    std::string out(msg, len);
+    free(msg);
+    return out;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: formatting
+// --------------------------------------------------------------------------
+
+void test_empty_message_envelope(void) {
+    HistoryMessageBuilder b;
+    TEST_ASSERT_TRUE(b.begin(0, 225.0f, 203.0f, 0));
+    size_t len = 0;
+    char* msg = b.finish(&len);
+    TEST_ASSERT_NOT_NULL(msg);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"type\":\"history\",\"sp\":225,\"meat1Target\":203,\"meat2Target\":null,\"data\":[]}",
+        msg);
+    TEST_ASSERT_EQUAL_UINT32(strlen(msg), len);
+    free(msg);
+}
+
+void test_chunk_envelope(void) {
+    char buf[512];
+    HistoryChunkWriter w((uint8_t*)buf, sizeof(buf), false);
+    HistoryChunkHeader h = { 2, 1700000000, true, 225.0f, 0, 180.0f };
+    w.begin(h);
+    size_t len = w.finish(true);
+    TEST_ASSERT_EQUAL_STRING_LEN(
+        "{\"type\":\"history_chunk\",\"seq\":2,\"session\":1700000000,\"append\":true,"
+        "\"sp\":225,\"meat1Target\":null,\"meat2Target\":180,\"data\":[],\"final\":true}",
+        buf, len);
+}
+
+void test_chunked_replay_bounded(void) {
+    // A 24-hour cook at 5 s: far more than one chunk holds
+    const size_t N = 17280;
+    DataPoint* pts = (DataPoint*)malloc(N * sizeof(DataPoint));
+    for (size_t i = 0; i < N; i++) {
+        pts[i] = makePoint(1700000000 + (uint32_t)i * 5, (int16_t)(2250 + i % 40),
+                           (int16_t)(i / 20), 0, (uint8_t)(i % 101),
+                           i % 9 == 0 ? DP_FLAG_MEAT2_DISC : 0);
+    }
+
+    static uint8_t buf[WS_HISTORY_CHUNK_SIZE];
+    HistoryChunkWriter w(buf, sizeof(buf), false);
+    HistoryChunkHeader h = { 0, 1700000000, false, 225.0f, 0, 0 };
+    std::string points;
+    size_t i = 0, chunks = 0;
+    bool final = false;
+    while (!final) {
+        h.seq = (uint32_t)chunks++;
+        w.begin(h);
+        while (i < N && w.add(pts[i], 225.0f)) i++;
+        final = i >= N;
+        size_t len = w.finish(final);
+        TEST_ASSERT_TRUE(len <= sizeof(buf));
+        TEST_ASSERT_TRUE(w.getCount() > 0);
+
+        // Pull the data array back out and stitch the chunks together
+        std::string chunk((const char*)buf, len);
+        size_t from = chunk.find("\"data\":[") + 8;
+        size_t to = chunk.rfind("],\"final\":");
+        TEST_ASSERT_EQUAL_STRING(final ? "],\"final\":true}" : "],\"final\":false}",
+                                 chunk.substr(to).c_str());
+        if (!points.empty()) points += ',';
+        points += chunk.substr(from, to - from);
+    }
+
+    std::string whole = buildFromPoints(pts, N, 225.0f);
+    free(pts);
+    size_t from = whole.find("\"data\":[") + 8;
+    TEST_ASSERT_TRUE(whole.substr(from, whole.size() - 2 - from) == points);
+    TEST_ASSERT_TRUE(chunks > whole.size() / sizeof(buf));
+    printf("  %u pts: %u chunks of <= %u B (single message %u B)\n",
+           (unsigned)N, (unsigned)chunks, (unsigned)sizeof(buf), (unsigned)whole.size());
+}
+
+void test_datapoint_fields(void) {
+    DataPoint dp = makePoint(1700000000, 2255, -15, 0, 42,
+                             DP_FLAG_LID_OPEN | DP_FLAG_MEAT2_DISC);
+    std::string msg = buildFromPoints(&dp, 1, 250.0f);
+    TEST_ASSERT_TRUE(msg.find("{\"ts\":1700000000,\"pit\":225.5,\"meat1\":-1.5,\"meat2\":null,"
+                              "\"fan\":42,\"damper\":58,\"sp\":250,\"lid\":true}") != std::string::npos);
+}
+
+void test_golden_matches_history_point_path(void) {
+    // Every tenth from -20.0 to 700.0 plus disconnects and lid flags
+    const size_t N = 7201;
+    DataPoint* pts = (DataPoint*)malloc(N * sizeof(DataPoint));
+    for (size_t i = 0; i < N; i++) {
+        int16_t t = (int16_t)((int32_t)i - 200);
+        uint8_t flags = (i % 7 == 0 ? DP_FLAG_PIT_DISC : 0) |
+                        (i % 11 == 0 ? DP_FLAG_LID_OPEN : 0) |
+                        (i % 13 == 0 ? DP_FLAG_MEAT1_DISC : 0);
+        pts[i] = makePoint(1700000000 + (uint32_t)i * 5, t, (int16_t)(t / 3), (int16_t)-t,
+                           (uint8_t)(i % 101), flags);
+    }
+
+    std::string a = buildFromPoints(pts, N, 225.0f);
+    std::string b = buildFromHistory(pts, N, 225.0f);
+    free(pts);
+
+    TEST_ASSERT_EQUAL_UINT32(b.size(), a.size());
+    TEST_ASSERT_TRUE(a == b);
+}
+
+void test_grows_past_estimate(void) {
+    HistoryMessageBuilder b;
+    TEST_ASSERT_TRUE(b.begin(1, 225.0f, 0, 0));  // Far too small on purpose
+    DataPoint dp = makePoint(1700000000, 2250, 1500, 1400, 50, 0);
+    for (int i = 0; i < 500; i++) TEST_ASSERT_TRUE(b.add(dp, 225.0f));
+
+    size_t len = 0;
+    char* msg = b.finish(&len);
+    TEST_ASSERT_NOT_NULL(msg);
+    TEST_ASSERT_EQUAL_UINT32(500, b.getCount());
+    TEST_ASSERT_EQUAL_STRING("]}", msg + len - 2);
+    free(msg);
+}
+
+// --------------------------------------------------------------------------
+// Benchmark: history replay from a full, wrapped 600-point ring
+// --------------------------------------------------------------------------
+
+#define BENCH_RING   600
+#define BENCH_RUNS   200
+
+void test_benchmark_history_from_ring(void) {
+    static DataPoint ring[BENCH_RING];
+    uint32_t head = 0;
+    for (uint32_t i = 0; i < BENCH_RING + 137; i++) {  // Wrapped
+        ring[head] = makePoint(1700000000 + i * 5, (int16_t)(2250 + i % 9),
+                               (int16_t)(1200 + i / 10), 0, (uint8_t)(i % 100),
+                               DP_FLAG_MEAT2_DISC);
+        head = (head + 1) % BENCH_RING;
+    }
+    const float sp = 225.0f;
+
+    // Previous path: getPoint()-style modulo walk into a malloc'd
+    // HistoryPoint array, then format each float with snprintf
+    std::string legacy;
+    size_t legacyHeap = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        HistoryPoint* hp = (HistoryPoint*)malloc(BENCH_RING * sizeof(HistoryPoint));
+        for (uint32_t i = 0; i < BENCH_RING; i++) {
+            toHistoryPoint(ring[(head + i) % BENCH_RING], sp, hp[i]);
+        }
+        size_t len = 0;
+        char* msg = bbq_protocol::buildHistoryMessage(hp, BENCH_RING, sp, 0, 0, &len);
+        free(hp);
+        if (r == 0) legacy.assign(msg, len);
+        free(msg);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    legacyHeap = BENCH_RING * sizeof(HistoryPoint);
+
+    // Span path: walk the ring in place, format integers directly
+    std::string spans;
+    auto t2 = std::chrono::steady_clock::now();
+    for (int r = 0; r < BENCH_RUNS; r++) {
+        RingView<DataPoint> view = RingView<DataPoint>::fromRing(ring, BENCH_RING, head, BENCH_RING);
+        HistoryMessageBuilder b;
+        b.begin(view.size(), sp, 0, 0);
+        for (const DataPoint& dp : view) b.add(dp, sp);
+        size_t len = 0;
+        char* msg = b.finish(&len);
+        if (r == 0) spans.assign(msg, len);
+        free(msg);
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    TEST_ASSERT_TRUE(legacy == spans);
+
+    double legacyUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / BENCH_RUNS;
+    double spanUs   = std::chrono::duration<double, std::micro>(t3 - t2).count() / BENCH_RUNS;
+    printf("  history %u pts (%u bytes): array+snprintf %.1f us (+%u B staging), "
+           "spans+direct %.1f us (+0 B), %.1fx\n",
+           BENCH_RING, (unsigned)spans.size(), legacyUs, (unsigned)legacyHeap,
+           spanUs, legacyUs / spanUs);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Formatting
+    RUN_TEST(test_empty_message_envelope);
+    RUN_TEST(test_chunk_envelope);
+    RUN_TEST(test_chunked_replay_bounded);
+    RUN_TEST(test_datapoint_fields);
+    RUN_TEST(test_golden_matches_history_point_path);
+    RUN_TEST(test_grows_past_estimate);
+
+    // Benchmark
+    RUN_TEST(test_benchmark_history_from_ring);
+
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+/**
+ * test_oversample_filter.cpp
+ *
+ * Tests for the per-probe oversampling filter: the conversions of one probe
+ * in one sample interval reduced to one reading, with outliers rejected.
+ *
+ * Tests cover:
+ *   - Median of odd and even counts, input left unchanged
+ *   - Mean keeps every sample; median ignores a spike
+ *   - Hampel: drops a spike and averages the rest, keeps ordinary noise,
+ *     keeps everything when all samples agree (zero MAD)
+ *   - Hampel: full-scale I2C glitches (0 and 32767) among eight samples
+ *   - Spread of the samples used; one sample; more than the window holds
+ *   - ProbeNoise: counts, last / average / max spread, reset
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "oversample_filter.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static OversampleResult hampel(const int16_t* s, uint8_t n) {
+    return oversampleReduce(s, n, OutlierFilter::HAMPEL, TEMP_HAMPEL_K, TEMP_HAMPEL_MIN_SPREAD);
+}
+
+// --------------------------------------------------------------------------
+// Tests: median
+// --------------------------------------------------------------------------
+
+void test_median_odd_and_even(void) {
+    int16_t odd[5] = {50, 10, 40, 20, 30};
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 30.0f, oversampleMedian(odd, 5));
+    TEST_ASSERT_EQUAL_INT16(50, odd[0]);   // Sorted a copy
+
+    int16_t even[4] = {400, 100, 300, 200};
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 250.0f, oversampleMedian(even, 4));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, oversampleMedian(even, 0));
+}
+
+void test_mean_and_median_modes(void) {
+    int16_t s[4] = {10000, 10004, 10002, 20000};   // One spike
+
+    OversampleResult mean = oversampleReduce(s, 4, OutlierFilter::MEAN, 3.0f, 8.0f);
+    TEST_ASSERT_EQUAL_INT16(12502, mean.value);
+    TEST_ASSERT_EQUAL_UINT8(4, mean.used);
+    TEST_ASSERT_EQUAL_UINT8(0, mean.rejected);
+
+    OversampleResult med = oversampleReduce(s, 4, OutlierFilter::MEDIAN, 3.0f, 8.0f);
+    TEST_ASSERT_EQUAL_INT16(10003, med.value);
+    TEST_ASSERT_EQUAL_UINT8(0, med.rejected);
+}
+
+// --------------------------------------------------------------------------
+// Tests: Hampel
+// --------------------------------------------------------------------------
+
+void test_hampel_drops_spike(void) {
+    int16_t s[4] = {10000, 10004, 10002, 20000};
+    OversampleResult r = hampel(s, 4);
+    TEST_ASSERT_EQUAL_UINT8(3, r.used);
+    TEST_ASSERT_EQUAL_UINT8(1, r.rejected);
+    TEST_ASSERT_EQUAL_INT16(10002, r.value);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.633f, r.spread);
+}
+
+void test_hampel_keeps_ordinary_noise(void) {
+    int16_t s[8] = {10000, 10006, 9995, 10003, 9998, 10010, 9991, 10001};
+    OversampleResult r = hampel(s, 8);
+    TEST_ASSERT_EQUAL_UINT8(0, r.rejected);
+    TEST_ASSERT_EQUAL_INT16(10001, r.value);   // 80004 / 8 = 10000.5
+
+    // All equal: MAD is zero, the floor keeps a one-count step
+    int16_t flat[4] = {12000, 12000, 12000, 12001};
+    OversampleResult f = hampel(flat, 4);
+    TEST_ASSERT_EQUAL_UINT8(0, f.rejected);
+    TEST_ASSERT_EQUAL_INT16(12000, f.value);
+}
+
+void test_hampel_full_scale_glitches(void) {
+    // An I2C read of 0 and one of full scale among eight good conversions
+    int16_t s[8] = {15000, 15003, 0, 14998, 15001, 32767, 15002, 14999};
+    OversampleResult r = hampel(s, 8);
+    TEST_ASSERT_EQUAL_UINT8(2, r.rejected);
+    TEST_ASSERT_EQUAL_UINT8(6, r.used);
+    TEST_ASSERT_EQUAL_INT16(15001, r.value);   // 90003 / 6 = 15000.5
+    TEST_ASSERT_TRUE(r.spread < 2.0f);
+
+    // The plain mean moves the probe by over three hundred counts
+    OversampleResult mean = oversampleReduce(s, 8, OutlierFilter::MEAN, 3.0f, 8.0f);
+    TEST_ASSERT_EQUAL_INT16(15346, mean.value);
+}
+
+void test_one_sample_and_overlong_input(void) {
+    int16_t one[1] = {12345};
+    OversampleResult r = hampel(one, 1);
+    TEST_ASSERT_EQUAL_INT16(12345, r.value);
+    TEST_ASSERT_EQUAL_UINT8(1, r.used);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, r.spread);
+
+    // Only the first OVERSAMPLE_MAX_SAMPLES are used
+    int16_t many[12];
+    for (uint8_t i = 0; i < 12; i++) many[i] = i < OVERSAMPLE_MAX_SAMPLES ? 1000 : 30000;
+    OversampleResult m = oversampleReduce(many, 12, OutlierFilter::MEAN, 3.0f, 8.0f);
+    TEST_ASSERT_EQUAL_UINT8(OVERSAMPLE_MAX_SAMPLES, m.used);
+    TEST_ASSERT_EQUAL_INT16(1000, m.value);
+
+    OversampleResult none = hampel(one, 0);
+    TEST_ASSERT_EQUAL_UINT8(0, none.used);
+}
+
+// --------------------------------------------------------------------------
+// Tests: ProbeNoise
+// --------------------------------------------------------------------------
+
+void test_probe_noise(void) {
+    ProbeNoise noise;
+    int16_t a[4] = {10000, 10004, 10002, 20000};
+    int16_t b[4] = {10000, 10002, 10000, 10002};
+
+    noise.record(hampel(a, 4));
+    noise.record(hampel(b, 4));
+    noise.record(OversampleResult());   // Nothing converted: not counted
+
+    TEST_ASSERT_EQUAL_UINT32(2, noise.getReadings());
+    TEST_ASSERT_EQUAL_UINT32(8, noise.getSamples());
+    TEST_ASSERT_EQUAL_UINT32(1, noise.getRejected());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, noise.getSpread());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.633f, noise.getMaxSpread());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.316f, noise.getAvgSpread());
+
+    noise.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, noise.getReadings());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, noise.getAvgSpread());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Median
+    RUN_TEST(test_median_odd_and_even);
+    RUN_TEST(test_mean_and_median_modes);
+
+    // Hampel
+    RUN_TEST(test_hampel_drops_spike);
+    RUN_TEST(test_hampel_keeps_ordinary_noise);
+    RUN_TEST(test_hampel_full_scale_glitches);
+    RUN_TEST(test_one_sample_and_overlong_input);
+
+    // ProbeNoise
+    RUN_TEST(test_probe_noise);
+
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+/**
+ * test_ring_view.cpp
+ *
+ * Tests for RingView, the two-span view over the CookSession ring buffer.
+ *
+ * Tests cover:
+ *   - Empty, unwrapped and wrapped rings split into the right spans
+ *   - Iteration order across the wrap point and indexed access
+ *   - Slices that fall in either span or straddle the wrap
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <vector>
+
+#include "ring_view.h"
+
+// Ring of 8 holding values 0..n-1 written in order
+static void fillRing(uint32_t* buf, uint32_t n, uint32_t* head, uint32_t* count) {
+    *head = 0;
+    *count = 0;
+    for (uint32_t v = 0; v < n; v++) {
+        buf[*head] = v;
+        *head = (*head + 1) % 8;
+        if (*count < 8) (*count)++;
+    }
+}
+
+static std::vector<uint32_t> collect(const RingView<uint32_t>& view) {
+    std::vector<uint32_t> out;
+    for (uint32_t v : view) out.push_back(v);
+    return out;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: spans
+// --------------------------------------------------------------------------
+
+void test_empty_ring(void) {
+    uint32_t buf[8];
+    RingView<uint32_t> view = RingView<uint32_t>::fromRing(buf, 8, 0, 0);
+    TEST_ASSERT_TRUE(view.empty());
+    TEST_ASSERT_TRUE(view.begin() == view.end());
+    TEST_ASSERT_EQUAL_UINT32(0, collect(view).size());
+}
+
+void test_unwrapped_ring_is_one_span(void) {
+    uint32_t buf[8], head, count;
+    fillRing(buf, 5, &head, &count);
+    RingView<uint32_t> view = RingView<uint32_t>::fromRing(buf, 8, head, count);
+
+    TEST_ASSERT_EQUAL_UINT32(5, view.first().size);
+    TEST_ASSERT_TRUE(view.second().empty());
+    TEST_ASSERT_EQUAL_PTR(buf, view.first().data);
+}
+
+void test_full_ring_at_zero_is_one_span(void) {
+    uint32_t buf[8], head, count;
+    fillRing(buf, 16, &head, &count);  // head back at 0
+    RingView<uint32_t> view = RingView<uint32_t>::fromRing(buf, 8, head, count);
+
+    TEST_ASSERT_EQUAL_UINT32(8, view.first().size);
+    TEST_ASSERT_TRUE(view.second().empty());
+    TEST_ASSERT_EQUAL_UINT32(8, view[0]);
+}
+
+void test_wrapped_ring_is_two_spans(void) {
+    uint32_t buf[8], head, count;
+    fillRing(buf, 11, &head, &count);  // Holds 3..10, oldest at slot 3
+    RingView<uint32_t> view = RingView<uint32_t>::fromRing(buf, 8, head, count);
+
+    TEST_ASSERT_EQUAL_UINT32(5, view.first().size);
+    TEST_ASSERT_EQUAL_UINT32(3, view.second().size);
+    TEST_ASSERT_EQUAL_PTR(buf + 3, view.first().data);
+    TEST_ASSERT_EQUAL_PTR(buf, view.second().data);
+}
+
+// --------------------------------------------------------------------------
+// Tests: iteration and indexing
+// --------------------------------------------------------------------------
+
+void test_iterates_oldest_first_across_wrap(void) {
+    uint32_t buf[8], head, count;
+    fillRing(buf, 11, &head, &count);
+    RingView<uint32_t> view = RingView<uint32_t>::fromRing(buf, 8, head, count);
+
+    std::vector<uint32_t> got = collect(view);
+    TEST_ASSERT_EQUAL_UINT32(8, got.size());
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_UINT32(3 + i, got[i]);
+        TEST_ASSERT_EQUAL_UINT32(3 + i, view[i]);
+    }
+}
+
+// --------------------------------------------------------------------------
+// Tests: slices
+// --------------------------------------------------------------------------
+
+void test_slices(void) {
+    uint32_t buf[8], head, count;
+    fillRing(buf, 11, &head, &count);  // 3..10; first span 3..7, second 8..10
+    RingView<uint32_t> view = RingView<uint32_t>::fromRing(buf, 8, head, count);
+
+    RingView<uint32_t> a = view.slice(1, 3);   // Inside first span
+    TEST_ASSERT_TRUE(a.second().empty());
+    TEST_ASSERT_EQUAL_UINT32(4, a[0]);
+    TEST_ASSERT_EQUAL_UINT32(3, a.size());
+
+    RingView<uint32_t> b = view.slice(6, 10);  // Inside second, clamped
+    TEST_ASSERT_EQUAL_UINT32(2, b.size());
+    TEST_ASSERT_EQUAL_UINT32(9, b[0]);
+
+    RingView<uint32_t> c = view.slice(3, 4);   // Straddles the wrap
+    std::vector<uint32_t> got = collect(c);
+    TEST_ASSERT_EQUAL_UINT32(4, got.size());
+    TEST_ASSERT_EQUAL_UINT32(6, got[0]);
+    TEST_ASSERT_EQUAL_UINT32(9, got[3]);
+
+    TEST_ASSERT_TRUE(view.slice(8, 1).empty());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Spans
+    RUN_TEST(test_empty_ring);
+    RUN_TEST(test_unwrapped_ring_is_one_span);
+    RUN_TEST(test_full_ring_at_zero_is_one_span);
+    RUN_TEST(test_wrapped_ring_is_two_spans);
+
+    // Iteration and indexing
+    RUN_TEST(test_iterates_oldest_first_across_wrap);
+
+    // Slices
+    RUN_TEST(test_slices);
+
+    return UNITY_END();
+}
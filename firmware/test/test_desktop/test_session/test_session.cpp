@@ -3,14 +3,22 @@
  *
  * Tests for CookSession logic on the native platform.
  *
- * LittleFS operations (flush, loadFromFlash) are guarded by #ifndef NATIVE_BUILD,
- * so they are no-ops on native. The begin() method, update() method, and flush()
- * are also guarded. We test the pure in-memory logic:
+ * LittleFS operations (loadFromFlash, file I/O in the session writer) are guarded
+ * by #ifndef NATIVE_BUILD, so they are no-ops on native. begin() and update()
+ * are also guarded. flush() runs, with the writer draining inline into an
+ * in-memory image of the session file that cursors read. We test:
  *   - DataPoint encoding (temps stored as int16 * 10)
  *   - Circular buffer (addPoint, getPoint, wrapping)
  *   - Point count tracking
  *   - CSV generation format
  *   - Session active state management
+ *   - Block batches handed to the session writer on flush / end of session;
+ *     a final flush longer than the writer's queues indexes every block
+ *   - External (PSRAM) arena: sizing, whole-cook ring, 1 s stream
+ *   - Two-span view of the RAM ring
+ *   - Timestamp search for resuming a client (findFirstAfter)
+ *   - Export through a cursor across the flash/RAM boundary; a point that
+ *     cannot be read (short file, damaged block) ends the export as truncated
  *
  * The String class is used by toCSV() and toJSON(). On native builds with
  * PlatformIO, the Arduino String class is not available. We provide a minimal
@@ -83,7 +91,13 @@ private:
 
 // Now include the module under test
 #include "cook_session.h"
+#include "system_snapshot.h"
 #include "cook_session.cpp"
+#include "session_export.cpp"
+#include "session_codec.cpp"
+#include "session_index.cpp"
+#include "session_rollup.cpp"
+#include "session_writer.cpp"
 
 // --------------------------------------------------------------------------
 // setUp / tearDown
@@ -386,19 +400,16 @@ void test_getElapsedSec_zero_on_native(void) {
 }
 
 // --------------------------------------------------------------------------
-// Tests: setDataSources (just verify it doesn't crash)
+// Tests: setSnapshot (just verify it doesn't crash)
 // --------------------------------------------------------------------------
 
-static float stubPitTemp()   { return 225.0f; }
-static float stubMeat1Temp() { return 165.0f; }
-static float stubMeat2Temp() { return 0.0f; }
-static uint8_t stubFanPct()  { return 50; }
-static uint8_t stubDamper()  { return 30; }
-static uint8_t stubFlags()   { return 0; }
-
-void test_setDataSources_no_crash(void) {
-    session->setDataSources(stubPitTemp, stubMeat1Temp, stubMeat2Temp,
-                             stubFanPct, stubDamper, stubFlags);
+void test_setSnapshot_no_crash(void) {
+    static SystemSnapshot snap;
+    snap.temp[PROBE_PIT] = 225.0f;
+    snap.temp[PROBE_MEAT1] = 165.0f;
+    snap.fanPct = 50.0f;
+    snap.damperPct = 30.0f;
+    session->setSnapshot(&snap);
     // Just verifying no crash
     TEST_ASSERT_TRUE(true);
 }
@@ -436,6 +447,386 @@ void test_json_single_point(void) {
     TEST_ASSERT_TRUE(json.indexOf("\"fan\":50") >= 0);
 }
 
+// --------------------------------------------------------------------------
+// Tests: range reads (RAM tail only on native — no flash)
+// --------------------------------------------------------------------------
+
+void test_readRange_returns_requested_slice(void) {
+    for (uint32_t i = 0; i < 50; i++) {
+        session->addPoint(makePoint(1000 + i, 200.0f + i, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    DataPoint page[10];
+    uint32_t n = session->readRange(20, 30, page, 10);
+    TEST_ASSERT_EQUAL_UINT32(10, n);
+    TEST_ASSERT_EQUAL_UINT32(1020, page[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(1029, page[9].timestamp);
+}
+
+void test_readRange_clamps_to_end_and_max(void) {
+    for (uint32_t i = 0; i < 15; i++) {
+        session->addPoint(makePoint(1000 + i, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    DataPoint page[8];
+    TEST_ASSERT_EQUAL_UINT32(5, session->readRange(10, 100, page, 8));
+    TEST_ASSERT_EQUAL_UINT32(8, session->readRange(0, 15, page, 8));
+    TEST_ASSERT_EQUAL_UINT32(0, session->readRange(15, 20, page, 8));
+}
+
+void test_cursor_seek_backwards(void) {
+    for (uint32_t i = 0; i < 30; i++) {
+        session->addPoint(makePoint(1000 + i, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    SessionCursor cursor;
+    session->openCursor(cursor, 25);
+    DataPoint dp;
+    TEST_ASSERT_TRUE(session->readNext(cursor, dp));
+    TEST_ASSERT_EQUAL_UINT32(1025, dp.timestamp);
+
+    session->seek(cursor, 3);
+    TEST_ASSERT_TRUE(session->readNext(cursor, dp));
+    TEST_ASSERT_EQUAL_UINT32(1003, dp.timestamp);
+    session->closeCursor(cursor);
+}
+
+void test_cursor_stops_at_points_never_flushed(void) {
+    // Points that left the ring without being flushed are gone: the cursor
+    // stops there and says so rather than skip to the oldest point in RAM
+    for (uint32_t i = 0; i < SESSION_BUFFER_SIZE + 40; i++) {
+        session->addPoint(makePoint(1000 + i, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    DataPoint dp;
+    TEST_ASSERT_EQUAL_UINT32(0, session->readRange(0, 1, &dp, 1));
+
+    SessionCursor cursor;
+    session->openCursor(cursor, 0);
+    TEST_ASSERT_FALSE(session->readNext(cursor, dp));
+    TEST_ASSERT_TRUE(cursor.truncated);
+    TEST_ASSERT_EQUAL_UINT32(0, cursor.index);
+
+    // Seeking into RAM carries on
+    session->seek(cursor, 40);
+    TEST_ASSERT_TRUE(session->readNext(cursor, dp));
+    TEST_ASSERT_EQUAL_UINT32(1040, dp.timestamp);
+    session->closeCursor(cursor);
+}
+
+void test_ram_points_view_matches_getPoint(void) {
+    for (uint32_t i = 0; i < SESSION_BUFFER_SIZE + 75; i++) {
+        session->addPoint(makePoint(1000 + i, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    RingView<DataPoint> view = session->getRamPoints();
+    TEST_ASSERT_EQUAL_UINT32(SESSION_BUFFER_SIZE, view.size());
+    TEST_ASSERT_FALSE(view.second().empty());  // Wrapped: two spans
+
+    uint32_t i = 0;
+    for (const DataPoint& dp : view) {
+        TEST_ASSERT_EQUAL_UINT32(session->getPoint(i)->timestamp, dp.timestamp);
+        i++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(SESSION_BUFFER_SIZE, i);
+    TEST_ASSERT_EQUAL_UINT32(1075, view[0].timestamp);
+}
+
+void test_findFirstAfter_in_ram(void) {
+    for (uint32_t i = 0; i < SESSION_BUFFER_SIZE + 75; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    uint32_t total = session->getTotalPointCount();
+
+    // Exact timestamp: the next point; between samples: the one after
+    TEST_ASSERT_EQUAL_UINT32(total - 10, session->findFirstAfter(1000 + (total - 11) * 5));
+    TEST_ASSERT_EQUAL_UINT32(total - 10, session->findFirstAfter(1000 + (total - 11) * 5 + 2));
+    TEST_ASSERT_EQUAL_UINT32(total, session->findFirstAfter(1000 + (total - 1) * 5));
+    TEST_ASSERT_EQUAL_UINT32(total, session->findFirstAfter(0xFFFFFFFF));
+}
+
+void test_findFirstAfter_empty_and_older_than_ram(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, session->findFirstAfter(1000));
+
+    for (uint32_t i = 0; i < 20; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, session->findFirstAfter(500));
+}
+
+// --------------------------------------------------------------------------
+// Tests: rollup tiers
+// --------------------------------------------------------------------------
+
+void test_rollups_fed_by_addPoint(void) {
+    // 20 minutes at 5 s, starting minute-aligned
+    for (uint32_t i = 0; i < 240; i++) {
+        session->addPoint(makePoint(1700000040 + i * 5, 225.0f + (i % 12), 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(60, session->getRollupInterval(0));
+    TEST_ASSERT_EQUAL_UINT32(19, session->getRollupCount(0));
+
+    RollupPoint rp[4];
+    TEST_ASSERT_EQUAL_UINT32(4, session->readRollups(0, 2, 6, rp, 4));
+    TEST_ASSERT_EQUAL_UINT32(1700000040 + 2 * 60, rp[0].timestamp);
+    TEST_ASSERT_EQUAL_INT16(2250, rp[0].pitMin);
+    TEST_ASSERT_EQUAL_INT16(2360, rp[0].pitMax);
+
+    RollupPoint partial;
+    TEST_ASSERT_TRUE(session->getPartialRollup(0, partial));
+    TEST_ASSERT_EQUAL_UINT8(12, partial.count);
+}
+
+void test_rollups_cleared_with_session(void) {
+    for (uint32_t i = 0; i < 100; i++) {
+        session->addPoint(makePoint(1700000040 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    session->clear();
+
+    RollupPoint rp;
+    TEST_ASSERT_EQUAL_UINT32(0, session->getRollupCount(0));
+    TEST_ASSERT_FALSE(session->getPartialRollup(0, rp));
+    TEST_ASSERT_EQUAL_UINT32(0, session->readRollups(0, 0, 10, &rp, 1));
+}
+
+// --------------------------------------------------------------------------
+// Tests: session writer
+// --------------------------------------------------------------------------
+
+void test_flush_submits_complete_blocks_only(void) {
+    session->startSession();
+    for (uint32_t i = 0; i < 30; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    session->flush();
+    const SessionWriter& writer = session->getWriter();
+    TEST_ASSERT_EQUAL_UINT32(2, writer.getBlocksWritten());
+    TEST_ASSERT_TRUE(writer.getFileSize() > SESSION_FILE_HEADER_SIZE);
+
+    // Nothing new: a second flush writes nothing
+    session->flush();
+    TEST_ASSERT_EQUAL_UINT32(2, writer.getBlocksWritten());
+    TEST_ASSERT_EQUAL_UINT32(0, writer.getWriteErrors());
+}
+
+void test_endSession_writes_partial_block(void) {
+    session->startSession();
+    for (uint32_t i = 0; i < 30; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    session->endSession();
+    TEST_ASSERT_EQUAL_UINT32(3, session->getWriter().getBlocksWritten());
+}
+
+void test_final_flush_indexes_every_block(void) {
+    // Far more blocks than the writer's queues hold: the final flush must
+    // collect reports as it goes rather than leave the writer unable to report
+    const uint32_t blocks = SESSION_WRITE_QUEUE_DEPTH * 2 + 8;
+    session->startSession();
+    for (uint32_t i = 0; i < blocks * SESSION_BLOCK_POINTS; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+
+    session->endSession();
+    TEST_ASSERT_EQUAL_UINT32(blocks, session->getWriter().getBlocksWritten());
+    TEST_ASSERT_EQUAL_UINT16(blocks, session->getIndex().getCount());
+
+    uint32_t first = 0, offset = 0;
+    TEST_ASSERT_TRUE(session->getIndex().find((blocks - 1) * SESSION_BLOCK_POINTS, &first, &offset));
+    TEST_ASSERT_EQUAL_UINT32((blocks - 1) * SESSION_BLOCK_POINTS, first);
+}
+
+// Point i of the cook recorded by recordFlushedCook()
+static DataPoint cookPoint(uint32_t i) {
+    return makePoint(1000 + i * 5, 200.0f + (i % 50), 100.0f + i / 20.0f,
+                     0.0f, (uint8_t)(i % 101), 0, 0);
+}
+
+// Record a cook longer than the RAM ring, flushing as the device does, so
+// the oldest points are only on "flash" (the writer's file image)
+static void recordFlushedCook(uint32_t points) {
+    session->startSession();
+    for (uint32_t i = 0; i < points; i++) {
+        session->addPoint(cookPoint(i));
+        if (i % SESSION_BLOCK_POINTS == SESSION_BLOCK_POINTS - 1) session->flush();
+    }
+}
+
+// Drain an exporter into a std::string in web-server-sized chunks
+static std::string drainExport(SessionExporter& exp) {
+    std::string out;
+    uint8_t buf[300];
+    size_t n;
+    while ((n = exp.read(buf, sizeof(buf))) > 0) out.append((const char*)buf, n);
+    return out;
+}
+
+void test_export_across_flash_and_ram(void) {
+    const uint32_t points = SESSION_BUFFER_SIZE + 250;
+    recordFlushedCook(points);
+    TEST_ASSERT_EQUAL_UINT32(SESSION_BUFFER_SIZE, session->getPointCount());
+
+    SessionCursor cursor;
+    session->openCursor(cursor, 0);
+    SessionExporter exp(SessionExporter::Format::CSV, CookSession::cursorNext, &cursor,
+                        CookSession::cursorTruncated);
+    std::string csv = drainExport(exp);
+    session->closeCursor(cursor);
+    TEST_ASSERT_FALSE(exp.isTruncated());
+    TEST_ASSERT_EQUAL_UINT32(points, exp.getPointsWritten());
+
+    // Row for row what was recorded, flash part and RAM part alike
+    std::string expected = "timestamp,pit,meat1,meat2,fan,damper,flags\n";
+    char line[SESSION_EXPORT_LINE_SIZE];
+    for (uint32_t i = 0; i < points; i++) {
+        SessionExporter::formatCSVRow(line, sizeof(line), cookPoint(i));
+        expected += line;
+    }
+    TEST_ASSERT_TRUE(csv == expected);
+}
+
+void test_export_truncated_at_short_file(void) {
+    recordFlushedCook(SESSION_BUFFER_SIZE + 250);
+
+    // Lose the file from the third block on
+    uint32_t first = 0, offset = 0;
+    TEST_ASSERT_TRUE(session->getIndex().find(2 * SESSION_BLOCK_POINTS, &first, &offset));
+    std::vector<uint8_t>& image = const_cast<SessionWriter&>(session->getWriter()).getFileImage();
+    image.resize(offset);
+
+    SessionCursor cursor;
+    session->openCursor(cursor, 0);
+    SessionExporter exp(SessionExporter::Format::JSON, CookSession::cursorNext, &cursor,
+                        CookSession::cursorTruncated);
+    std::string json = drainExport(exp);
+    session->closeCursor(cursor);
+    TEST_ASSERT_TRUE(exp.isTruncated());
+    TEST_ASSERT_EQUAL_UINT32(2 * SESSION_BLOCK_POINTS, exp.getPointsWritten());
+    TEST_ASSERT_TRUE(json.find(']') == std::string::npos);
+}
+
+void test_export_truncated_at_damaged_block(void) {
+    recordFlushedCook(SESSION_BUFFER_SIZE + 250);
+
+    // Damage the third block's payload so its CRC fails. The reader finds
+    // the fourth block, which says where it belongs: the gap shows.
+    uint32_t first = 0, offset = 0;
+    TEST_ASSERT_TRUE(session->getIndex().find(2 * SESSION_BLOCK_POINTS, &first, &offset));
+    std::vector<uint8_t>& image = const_cast<SessionWriter&>(session->getWriter()).getFileImage();
+    image[offset + SESSION_BLOCK_HEADER_SIZE + 3] ^= 0xFF;
+
+    SessionCursor cursor;
+    session->openCursor(cursor, 0);
+    SessionExporter exp(SessionExporter::Format::CSV, CookSession::cursorNext, &cursor,
+                        CookSession::cursorTruncated);
+    drainExport(exp);
+    TEST_ASSERT_TRUE(exp.isTruncated());
+    TEST_ASSERT_EQUAL_UINT32(2 * SESSION_BLOCK_POINTS, exp.getPointsWritten());
+
+    // Past the gap the points are read under their own index
+    DataPoint dp;
+    session->seek(cursor, 3 * SESSION_BLOCK_POINTS);
+    TEST_ASSERT_TRUE(session->readNext(cursor, dp));
+    TEST_ASSERT_EQUAL_UINT32(cookPoint(3 * SESSION_BLOCK_POINTS).timestamp, dp.timestamp);
+    session->closeCursor(cursor);
+}
+
+void test_clear_removes_written_file(void) {
+    session->startSession();
+    for (uint32_t i = 0; i < 24; i++) {
+        session->addPoint(makePoint(1000 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    session->flush();
+    TEST_ASSERT_TRUE(session->getWriter().getFileSize() > 0);
+
+    session->startSession();
+    TEST_ASSERT_EQUAL_UINT32(0, session->getWriter().getFileSize());
+
+    // The new session's first block lands straight after a fresh header
+    for (uint32_t i = 0; i < SESSION_BLOCK_POINTS; i++) {
+        session->addPoint(makePoint(2000 + i * 5, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    session->flush();
+    uint32_t size = session->getWriter().getFileSize();
+    TEST_ASSERT_TRUE(size > SESSION_FILE_HEADER_SIZE);
+    TEST_ASSERT_TRUE(size <= SESSION_FILE_HEADER_SIZE + SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_POINTS));
+}
+
+// --------------------------------------------------------------------------
+// Tests: PSRAM arena (plain static buffers on native)
+// --------------------------------------------------------------------------
+
+void test_arena_plan_sizes_for_24h(void) {
+    // Plenty of PSRAM: 24 h at 5 s and 24 h at 1 s
+    SessionArenaPlan plan = planSessionArena(8u * 1024 * 1024, SESSION_PSRAM_RESERVE);
+    TEST_ASSERT_EQUAL_UINT32(17280, plan.points);
+    TEST_ASSERT_EQUAL_UINT32(86400, plan.finePoints);
+
+    // 2 MB part: the 5 s stream keeps its full day, the 1 s stream gets the rest
+    plan = planSessionArena(2u * 1024 * 1024, SESSION_PSRAM_RESERVE);
+    TEST_ASSERT_EQUAL_UINT32(17280, plan.points);
+    uint32_t rest = (2u * 1024 * 1024 - SESSION_PSRAM_RESERVE) / sizeof(DataPoint) - 17280;
+    TEST_ASSERT_EQUAL_UINT32(rest, plan.finePoints);
+
+    // No PSRAM to spare: stay on the internal buffer
+    plan = planSessionArena(256u * 1024, SESSION_PSRAM_RESERVE);
+    TEST_ASSERT_EQUAL_UINT32(0, plan.points);
+    TEST_ASSERT_EQUAL_UINT32(0, plan.finePoints);
+}
+
+void test_arena_holds_whole_cook(void) {
+    static DataPoint arena[2000];
+    session->attachArena(arena, 2000, nullptr, 0);
+    TEST_ASSERT_EQUAL_UINT32(2000, session->getCapacity());
+
+    // More than the internal buffer could hold, none of it lost
+    for (uint32_t i = 0; i < 1500; i++) {
+        session->addPoint(makePoint(1000 + i, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1500, session->getPointCount());
+
+    DataPoint dp;
+    TEST_ASSERT_EQUAL_UINT32(1, session->readRange(0, 1, &dp, 1));
+    TEST_ASSERT_EQUAL_UINT32(1000, dp.timestamp);
+    TEST_ASSERT_EQUAL_UINT32(1, session->readRange(1499, 1500, &dp, 1));
+    TEST_ASSERT_EQUAL_UINT32(2499, dp.timestamp);
+}
+
+void test_fine_stream_ring(void) {
+    static DataPoint arena[SESSION_BUFFER_SIZE * 2];
+    static DataPoint fine[10];
+    session->attachArena(arena, SESSION_BUFFER_SIZE * 2, fine, 10);
+
+    for (uint32_t i = 0; i < 15; i++) {
+        session->addFinePoint(makePoint(5000 + i, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, session->getFinePointCount());
+    TEST_ASSERT_EQUAL_UINT32(5005, session->getFinePoint(0)->timestamp);
+    TEST_ASSERT_EQUAL_UINT32(5014, session->getFinePoint(9)->timestamp);
+    TEST_ASSERT_NULL(session->getFinePoint(10));
+
+    // A fine cursor walks the 1 s stream, independent of the 5 s ring
+    SessionCursor cursor;
+    session->openCursor(cursor, 0, true);
+    DataPoint dp;
+    uint32_t n = 0;
+    while (session->readNext(cursor, dp)) n++;
+    session->closeCursor(cursor);
+    TEST_ASSERT_EQUAL_UINT32(10, n);
+
+    session->clear();
+    TEST_ASSERT_EQUAL_UINT32(0, session->getFinePointCount());
+}
+
+void test_fine_stream_ignored_without_arena(void) {
+    session->addFinePoint(makePoint(5000, 225.0f, 0.0f, 0.0f, 0, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, session->getFinePointCount());
+    TEST_ASSERT_EQUAL_UINT32(SESSION_BUFFER_SIZE, session->getCapacity());
+}
+
 // --------------------------------------------------------------------------
 // Main
 // --------------------------------------------------------------------------
@@ -482,7 +873,7 @@ int main(int argc, char** argv) {
     RUN_TEST(test_getElapsedSec_zero_on_native);
 
     // Data sources
-    RUN_TEST(test_setDataSources_no_crash);
+    RUN_TEST(test_setSnapshot_no_crash);
 
     // Struct size
     RUN_TEST(test_datapoint_struct_size);
@@ -491,5 +882,33 @@ int main(int argc, char** argv) {
     RUN_TEST(test_json_empty_is_array);
     RUN_TEST(test_json_single_point);
 
+    // Range reads
+    RUN_TEST(test_readRange_returns_requested_slice);
+    RUN_TEST(test_readRange_clamps_to_end_and_max);
+    RUN_TEST(test_cursor_seek_backwards);
+    RUN_TEST(test_cursor_stops_at_points_never_flushed);
+    RUN_TEST(test_ram_points_view_matches_getPoint);
+    RUN_TEST(test_findFirstAfter_in_ram);
+    RUN_TEST(test_findFirstAfter_empty_and_older_than_ram);
+
+    // Rollup tiers
+    RUN_TEST(test_rollups_fed_by_addPoint);
+    RUN_TEST(test_rollups_cleared_with_session);
+
+    // Session writer
+    RUN_TEST(test_flush_submits_complete_blocks_only);
+    RUN_TEST(test_endSession_writes_partial_block);
+    RUN_TEST(test_final_flush_indexes_every_block);
+    RUN_TEST(test_clear_removes_written_file);
+    RUN_TEST(test_export_across_flash_and_ram);
+    RUN_TEST(test_export_truncated_at_short_file);
+    RUN_TEST(test_export_truncated_at_damaged_block);
+
+    // PSRAM arena
+    RUN_TEST(test_arena_plan_sizes_for_24h);
+    RUN_TEST(test_arena_holds_whole_cook);
+    RUN_TEST(test_fine_stream_ring);
+    RUN_TEST(test_fine_stream_ignored_without_arena);
+
     return UNITY_END();
 }
@@ -0,0 +1,369 @@
+/**
+ * test_session_codec.cpp
+ *
+ * Tests for the delta/varint block format used for the on-flash session file.
+ *
+ * Tests cover:
+ *   - Varint and zigzag round trips, CRC-32 check value
+ *   - File header detection (version 2 magic vs. legacy version 1)
+ *   - Block round trip with irregular timestamps and extreme temperatures
+ *   - Blocks record the session index of their first point
+ *   - Rejection of corrupted and truncated blocks
+ *   - Compression ratio on a realistic cook vs. raw DataPoint records
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "session_codec.h"
+#include "session_codec.cpp"
+
+using namespace session_codec;
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+// Steady cook: 5 s samples, pit hovering around 225F, meats climbing slowly,
+// fan duty settling in a narrow band, occasional lid-open flag.
+static DataPoint cookPoint(uint32_t i) {
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = 1700000000 + i * 5;
+    dp.pitTemp   = (int16_t)(2250 + (int16_t)((i * 7) % 9) - 4);
+    dp.meat1Temp = (int16_t)(400 + i / 4);
+    dp.meat2Temp = (int16_t)(380 + i / 5);
+    dp.fanPct    = (uint8_t)(30 + (i / 6) % 3);
+    dp.damperPct = 100;
+    dp.flags     = (i % 500) < 3 ? DP_FLAG_LID_OPEN : 0;
+    return dp;
+}
+
+static void assertPointsEqual(const DataPoint& a, const DataPoint& b) {
+    TEST_ASSERT_EQUAL_UINT32(a.timestamp, b.timestamp);
+    TEST_ASSERT_EQUAL_INT16(a.pitTemp, b.pitTemp);
+    TEST_ASSERT_EQUAL_INT16(a.meat1Temp, b.meat1Temp);
+    TEST_ASSERT_EQUAL_INT16(a.meat2Temp, b.meat2Temp);
+    TEST_ASSERT_EQUAL_UINT8(a.fanPct, b.fanPct);
+    TEST_ASSERT_EQUAL_UINT8(a.damperPct, b.damperPct);
+    TEST_ASSERT_EQUAL_UINT8(a.flags, b.flags);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: primitives
+// --------------------------------------------------------------------------
+
+void test_varint_round_trip(void) {
+    const uint32_t values[] = { 0, 1, 127, 128, 300, 16383, 16384, 0xFFFFFFFFUL };
+    uint8_t buf[8];
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        size_t n = putVarint(buf, sizeof(buf), values[i]);
+        TEST_ASSERT_TRUE(n > 0 && n <= 5);
+        uint32_t v = 0;
+        TEST_ASSERT_EQUAL_UINT32(n, getVarint(buf, n, &v));
+        TEST_ASSERT_EQUAL_UINT32(values[i], v);
+    }
+    // Small values take one byte
+    TEST_ASSERT_EQUAL_UINT32(1, putVarint(buf, sizeof(buf), 127));
+    TEST_ASSERT_EQUAL_UINT32(2, putVarint(buf, sizeof(buf), 128));
+}
+
+void test_varint_truncated_and_overflow(void) {
+    uint8_t buf[8];
+    size_t n = putVarint(buf, sizeof(buf), 300);
+    uint32_t v;
+    TEST_ASSERT_EQUAL_UINT32(0, getVarint(buf, n - 1, &v));
+    TEST_ASSERT_EQUAL_UINT32(0, putVarint(buf, 1, 300));
+}
+
+void test_zigzag_round_trip(void) {
+    const int32_t values[] = { 0, -1, 1, -2, 2, 32767, -32768, 65535, -65536 };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        TEST_ASSERT_EQUAL_INT32(values[i], unzigzag(zigzag(values[i])));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, zigzag(0));
+    TEST_ASSERT_EQUAL_UINT32(1, zigzag(-1));
+    TEST_ASSERT_EQUAL_UINT32(2, zigzag(1));
+}
+
+void test_crc32_check_value(void) {
+    const char* s = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926UL, crc32((const uint8_t*)s, 9));
+    // Running CRC over two halves matches the one-shot CRC
+    uint32_t crc = crc32((const uint8_t*)s, 4);
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926UL, crc32((const uint8_t*)s + 4, 5, crc));
+}
+
+// --------------------------------------------------------------------------
+// Tests: file header
+// --------------------------------------------------------------------------
+
+void test_file_header_v2(void) {
+    uint8_t hdr[SESSION_FILE_HEADER_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(SESSION_FILE_HEADER_SIZE, writeFileHeader(hdr, 1700000123, 12));
+
+    uint32_t start = 0;
+    size_t hsize = 0;
+    TEST_ASSERT_TRUE(parseFileHeader(hdr, sizeof(hdr), &start, &hsize) == FileFormat::BLOCK_V2);
+    TEST_ASSERT_EQUAL_UINT32(1700000123, start);
+    TEST_ASSERT_EQUAL_UINT32(SESSION_FILE_HEADER_SIZE, hsize);
+    TEST_ASSERT_EQUAL_UINT8(12, hdr[4]);
+}
+
+void test_file_header_v1_legacy(void) {
+    // Version 1: bare little-endian start epoch followed by raw records
+    uint32_t epoch = 1700000000;
+    uint8_t data[SESSION_V1_HEADER_SIZE + sizeof(DataPoint)];
+    memset(data, 0, sizeof(data));
+    memcpy(data, &epoch, sizeof(epoch));
+
+    uint32_t start = 0;
+    size_t hsize = 0;
+    TEST_ASSERT_TRUE(parseFileHeader(data, sizeof(data), &start, &hsize) == FileFormat::RAW_V1);
+    TEST_ASSERT_EQUAL_UINT32(epoch, start);
+    TEST_ASSERT_EQUAL_UINT32(SESSION_V1_HEADER_SIZE, hsize);
+}
+
+void test_file_header_too_short(void) {
+    uint8_t data[2] = { 0, 0 };
+    TEST_ASSERT_TRUE(parseFileHeader(data, sizeof(data), nullptr, nullptr) == FileFormat::INVALID);
+}
+
+// --------------------------------------------------------------------------
+// Tests: blocks
+// --------------------------------------------------------------------------
+
+void test_block_round_trip_steady(void) {
+    DataPoint in[12];
+    for (uint32_t i = 0; i < 12; i++) in[i] = cookPoint(i);
+
+    uint8_t buf[SESSION_BLOCK_MAX_SIZE(12)];
+    size_t len = encodeBlock(in, 12, 0, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(len > SESSION_BLOCK_HEADER_SIZE);
+    TEST_ASSERT_EQUAL_UINT32(len, blockSize(buf));
+
+    DataPoint out[12];
+    uint8_t count = 0;
+    TEST_ASSERT_EQUAL_UINT32(len, decodeBlock(buf, len, out, 12, &count));
+    TEST_ASSERT_EQUAL_UINT8(12, count);
+    for (uint8_t i = 0; i < 12; i++) assertPointsEqual(in[i], out[i]);
+}
+
+void test_block_records_first_point(void) {
+    DataPoint in[12];
+    for (uint32_t i = 0; i < 12; i++) in[i] = cookPoint(100000 + i);
+
+    uint8_t buf[SESSION_BLOCK_MAX_SIZE(12)];
+    size_t len = encodeBlock(in, 12, 100000, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_UINT8(SESSION_BLOCK_SYNC, buf[0]);
+
+    DataPoint out[12];
+    uint8_t count = 0;
+    uint32_t first = 0;
+    TEST_ASSERT_EQUAL_UINT32(len, decodeBlock(buf, len, out, 12, &count, &first));
+    TEST_ASSERT_EQUAL_UINT32(100000, first);
+    assertPointsEqual(in[11], out[11]);
+
+    // The largest first point still fits the worst-case size
+    uint8_t big[SESSION_BLOCK_MAX_SIZE(12)];
+    TEST_ASSERT_TRUE(encodeBlock(in, 12, 0xFFFFFFFFUL, big, sizeof(big)) > 0);
+}
+
+void test_block_round_trip_extremes(void) {
+    // Irregular timestamps (gap, clock step back) and full-range temperatures
+    DataPoint in[6];
+    memset(in, 0, sizeof(in));
+    const uint32_t ts[]  = { 0, 5, 10, 3600, 3595, 0xFFFFFFF0UL };
+    const int16_t  pit[] = { 32767, -32768, 0, -1, 32767, -32768 };
+    for (uint8_t i = 0; i < 6; i++) {
+        in[i].timestamp = ts[i];
+        in[i].pitTemp   = pit[i];
+        in[i].meat1Temp = (int16_t)-pit[i] - 1;
+        in[i].meat2Temp = -9999;
+        in[i].fanPct    = (uint8_t)(i * 51);
+        in[i].damperPct = (uint8_t)(255 - i);
+        in[i].flags     = (uint8_t)(1 << i);
+    }
+
+    uint8_t buf[SESSION_BLOCK_MAX_SIZE(6)];
+    size_t len = encodeBlock(in, 6, 0, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_TRUE(len <= sizeof(buf));
+
+    DataPoint out[6];
+    uint8_t count = 0;
+    TEST_ASSERT_EQUAL_UINT32(len, decodeBlock(buf, len, out, 6, &count));
+    TEST_ASSERT_EQUAL_UINT8(6, count);
+    for (uint8_t i = 0; i < 6; i++) assertPointsEqual(in[i], out[i]);
+}
+
+void test_block_single_point(void) {
+    DataPoint in = cookPoint(42);
+    uint8_t buf[SESSION_BLOCK_MAX_SIZE(1)];
+    size_t len = encodeBlock(&in, 1, 42, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(len > 0);
+
+    DataPoint out;
+    uint8_t count = 0;
+    TEST_ASSERT_EQUAL_UINT32(len, decodeBlock(buf, len, &out, 1, &count));
+    TEST_ASSERT_EQUAL_UINT8(1, count);
+    assertPointsEqual(in, out);
+}
+
+void test_block_encode_rejects_small_buffer(void) {
+    DataPoint in[12];
+    for (uint32_t i = 0; i < 12; i++) in[i] = cookPoint(i);
+    uint8_t buf[16];
+    TEST_ASSERT_EQUAL_UINT32(0, encodeBlock(in, 12, 0, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT32(0, encodeBlock(in, 0, 0, buf, sizeof(buf)));
+}
+
+void test_block_rejects_corruption(void) {
+    DataPoint in[12];
+    for (uint32_t i = 0; i < 12; i++) in[i] = cookPoint(i);
+    uint8_t buf[SESSION_BLOCK_MAX_SIZE(12)];
+    size_t len = encodeBlock(in, 12, 0, buf, sizeof(buf));
+
+    DataPoint out[12];
+    uint8_t count;
+
+    // Flip one payload bit: CRC mismatch
+    buf[len - 1] ^= 0x04;
+    TEST_ASSERT_EQUAL_UINT32(0, decodeBlock(buf, len, out, 12, &count));
+    buf[len - 1] ^= 0x04;
+
+    // Bad sync marker
+    buf[0] ^= 0xFF;
+    TEST_ASSERT_EQUAL_UINT32(0, blockSize(buf));
+    TEST_ASSERT_EQUAL_UINT32(0, decodeBlock(buf, len, out, 12, &count));
+    buf[0] ^= 0xFF;
+
+    // More points than the caller can hold
+    TEST_ASSERT_EQUAL_UINT32(0, decodeBlock(buf, len, out, 8, &count));
+
+    // Intact block still decodes
+    TEST_ASSERT_EQUAL_UINT32(len, decodeBlock(buf, len, out, 12, &count));
+}
+
+void test_block_rejects_truncation(void) {
+    // A torn write (power loss mid-flush) leaves a partial block at EOF
+    DataPoint in[12];
+    for (uint32_t i = 0; i < 12; i++) in[i] = cookPoint(i);
+    uint8_t buf[SESSION_BLOCK_MAX_SIZE(12)];
+    size_t len = encodeBlock(in, 12, 0, buf, sizeof(buf));
+
+    DataPoint out[12];
+    uint8_t count;
+    for (size_t cut = 0; cut < len; cut++) {
+        TEST_ASSERT_EQUAL_UINT32(0, decodeBlock(buf, cut, out, 12, &count));
+    }
+}
+
+void test_blocks_concatenate(void) {
+    // Two blocks back to back, walked via blockSize() as the flash reader does
+    uint8_t file[2 * SESSION_BLOCK_MAX_SIZE(12)];
+    size_t used = 0;
+    for (uint32_t b = 0; b < 2; b++) {
+        DataPoint in[12];
+        for (uint32_t i = 0; i < 12; i++) in[i] = cookPoint(b * 12 + i);
+        used += encodeBlock(in, 12, b * 12, file + used, sizeof(file) - used);
+    }
+
+    size_t pos = 0;
+    uint32_t index = 0;
+    while (pos < used) {
+        DataPoint out[12];
+        uint8_t count;
+        size_t n = decodeBlock(file + pos, used - pos, out, 12, &count);
+        TEST_ASSERT_TRUE(n > 0);
+        for (uint8_t i = 0; i < count; i++) assertPointsEqual(cookPoint(index++), out[i]);
+        pos += n;
+    }
+    TEST_ASSERT_EQUAL_UINT32(24, index);
+}
+
+// --------------------------------------------------------------------------
+// Tests: compression ratio
+// --------------------------------------------------------------------------
+
+// 12-hour cook at the 5 s sample interval
+#define RATIO_COOK_POINTS (12UL * 3600UL / 5UL)
+
+static size_t encodedCookSize(uint8_t pointsPerBlock) {
+    size_t total = SESSION_FILE_HEADER_SIZE;
+    DataPoint pts[SESSION_BLOCK_MAX_POINTS];
+    uint8_t buf[SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_MAX_POINTS)];
+
+    for (uint32_t i = 0; i < RATIO_COOK_POINTS; i += pointsPerBlock) {
+        uint8_t n = 0;
+        while (n < pointsPerBlock && i + n < RATIO_COOK_POINTS) {
+            pts[n] = cookPoint(i + n);
+            n++;
+        }
+        size_t len = encodeBlock(pts, n, i, buf, sizeof(buf));
+        TEST_ASSERT_TRUE(len > 0);
+        total += len;
+    }
+    return total;
+}
+
+void test_compression_ratio_flush_block(void) {
+    // One block per 60 s flush (12 points) — the on-device layout
+    size_t raw = SESSION_V1_HEADER_SIZE + RATIO_COOK_POINTS * sizeof(DataPoint);
+    size_t encoded = encodedCookSize(12);
+    float ratio = (float)raw / (float)encoded;
+    printf("  12-point blocks: %u raw bytes -> %u encoded (%.2fx)\n",
+           (unsigned)raw, (unsigned)encoded, ratio);
+    TEST_ASSERT_TRUE(ratio >= 3.0f);
+}
+
+void test_compression_ratio_large_block(void) {
+    // Larger blocks amortize the header and absolute first values further
+    size_t raw = SESSION_V1_HEADER_SIZE + RATIO_COOK_POINTS * sizeof(DataPoint);
+    size_t encoded = encodedCookSize(SESSION_BLOCK_MAX_POINTS);
+    float ratio = (float)raw / (float)encoded;
+    printf("  64-point blocks: %u raw bytes -> %u encoded (%.2fx)\n",
+           (unsigned)raw, (unsigned)encoded, ratio);
+    TEST_ASSERT_TRUE(ratio >= 4.0f);
+    TEST_ASSERT_TRUE(encoded < encodedCookSize(12));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Primitives
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_varint_truncated_and_overflow);
+    RUN_TEST(test_zigzag_round_trip);
+    RUN_TEST(test_crc32_check_value);
+
+    // File header
+    RUN_TEST(test_file_header_v2);
+    RUN_TEST(test_file_header_v1_legacy);
+    RUN_TEST(test_file_header_too_short);
+
+    // Blocks
+    RUN_TEST(test_block_round_trip_steady);
+    RUN_TEST(test_block_records_first_point);
+    RUN_TEST(test_block_round_trip_extremes);
+    RUN_TEST(test_block_single_point);
+    RUN_TEST(test_block_encode_rejects_small_buffer);
+    RUN_TEST(test_block_rejects_corruption);
+    RUN_TEST(test_block_rejects_truncation);
+    RUN_TEST(test_blocks_concatenate);
+
+    // Compression ratio
+    RUN_TEST(test_compression_ratio_flush_block);
+    RUN_TEST(test_compression_ratio_large_block);
+
+    return UNITY_END();
+}
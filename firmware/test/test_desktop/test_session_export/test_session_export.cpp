@@ -0,0 +1,390 @@
+/**
+ * test_session_export.cpp
+ *
+ * Tests for SessionExporter (streaming CSV/JSON formatter) on the native platform.
+ *
+ * Tests cover:
+ *   - CSV header and row format (matches CookSession::toCSV)
+ *   - JSON array framing and comma separators
+ *   - Output is identical regardless of chunk size
+ *   - A source that stops short ends the export marked as truncated
+ *   - SessionExportPipe: same bytes as a direct read, at most a pipe's worth
+ *     formatted per pump, and a producer thread pumping while the consumer
+ *     reads
+ *   - Multi-MB export with bounded heap (global operator new/delete are
+ *     hooked to count live bytes and allocations)
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "session_export.h"
+#include "session_export.cpp"
+
+// --------------------------------------------------------------------------
+// Heap accounting: hook global new/delete so tests can measure peak usage
+// --------------------------------------------------------------------------
+
+static size_t g_liveBytes   = 0;
+static size_t g_peakBytes   = 0;
+static size_t g_allocCount  = 0;
+
+void* operator new(size_t size) {
+    size_t* p = (size_t*)malloc(size + sizeof(size_t));
+    if (!p) throw std::bad_alloc();
+    *p = size;
+    g_liveBytes += size;
+    g_allocCount++;
+    if (g_liveBytes > g_peakBytes) g_peakBytes = g_liveBytes;
+    return p + 1;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    size_t* p = (size_t*)ptr - 1;
+    g_liveBytes -= *p;
+    free(p);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+static void resetHeapStats() {
+    g_peakBytes = g_liveBytes;
+    g_allocCount = 0;
+}
+
+// --------------------------------------------------------------------------
+// Synthetic point source: a steady cook with slowly rising meat temps
+// --------------------------------------------------------------------------
+
+struct SyntheticSource {
+    uint32_t index;
+    uint32_t count;
+    bool     stoppedShort;   // Reported by syntheticShort() once drained
+};
+
+static bool syntheticNext(void* ctx, DataPoint& out) {
+    SyntheticSource* src = static_cast<SyntheticSource*>(ctx);
+    if (src->index >= src->count) return false;
+
+    uint32_t i = src->index++;
+    out.timestamp = 1700000000 + i * 5;
+    out.pitTemp   = (int16_t)(2250 + (int16_t)(i % 21) - 10);
+    out.meat1Temp = (int16_t)(400 + i / 10);
+    out.meat2Temp = (int16_t)(380 + i / 12);
+    out.fanPct    = (uint8_t)(i % 101);
+    out.damperPct = (uint8_t)(100 - i % 101);
+    out.flags     = (uint8_t)((i % 97) == 0 ? DP_FLAG_LID_OPEN : 0);
+    return true;
+}
+
+// SourceCheck: whether the synthetic source stopped short
+static bool syntheticShort(void* ctx) {
+    return static_cast<SyntheticSource*>(ctx)->stoppedShort;
+}
+
+// Drain an exporter into a std::string using the given chunk size
+static std::string drain(SessionExporter& exp, size_t chunkSize) {
+    std::string out;
+    uint8_t buf[2048];
+    size_t n;
+    while ((n = exp.read(buf, chunkSize)) > 0) {
+        out.append((const char*)buf, n);
+    }
+    return out;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: CSV
+// --------------------------------------------------------------------------
+
+void test_csv_empty_is_header_only(void) {
+    SyntheticSource src = { 0, 0, false };
+    SessionExporter exp(SessionExporter::Format::CSV, syntheticNext, &src);
+    std::string out = drain(exp, 512);
+    TEST_ASSERT_TRUE(out == "timestamp,pit,meat1,meat2,fan,damper,flags\n");
+    TEST_ASSERT_TRUE(exp.isDone());
+    TEST_ASSERT_EQUAL_UINT32(0, exp.getPointsWritten());
+}
+
+void test_csv_row_format(void) {
+    SyntheticSource src = { 0, 1, false };
+    SessionExporter exp(SessionExporter::Format::CSV, syntheticNext, &src);
+    std::string out = drain(exp, 512);
+    // i=0: pit 2240 -> 224.0, meat1 400 -> 40.0, meat2 380 -> 38.0, fan 0, damper 100, lid flag
+    TEST_ASSERT_TRUE(out == "timestamp,pit,meat1,meat2,fan,damper,flags\n"
+                            "1700000000,224.0,40.0,38.0,0,100,1\n");
+}
+
+void test_csv_negative_temp(void) {
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = 42;
+    dp.pitTemp = -105;
+    char line[SESSION_EXPORT_LINE_SIZE];
+    SessionExporter::formatCSVRow(line, sizeof(line), dp);
+    TEST_ASSERT_TRUE(strcmp(line, "42,-10.5,0.0,0.0,0,0,0\n") == 0);
+}
+
+void test_content_type_and_filename(void) {
+    SessionExporter csv(SessionExporter::Format::CSV, nullptr, nullptr);
+    SessionExporter json(SessionExporter::Format::JSON, nullptr, nullptr);
+    TEST_ASSERT_TRUE(strcmp(csv.getContentType(), "text/csv") == 0);
+    TEST_ASSERT_TRUE(strcmp(json.getContentType(), "application/json") == 0);
+    TEST_ASSERT_TRUE(strcmp(csv.getFileName(), "cook-session.csv") == 0);
+    TEST_ASSERT_TRUE(strcmp(json.getFileName(), "cook-session.json") == 0);
+}
+
+// --------------------------------------------------------------------------
+// Tests: JSON
+// --------------------------------------------------------------------------
+
+void test_json_empty_array(void) {
+    SyntheticSource src = { 0, 0, false };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &src);
+    TEST_ASSERT_TRUE(drain(exp, 512) == "[]");
+}
+
+void test_json_separators(void) {
+    SyntheticSource src = { 0, 3, false };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &src);
+    std::string out = drain(exp, 512);
+
+    TEST_ASSERT_EQUAL_UINT8('[', out.front());
+    TEST_ASSERT_EQUAL_UINT8(']', out.back());
+    TEST_ASSERT_TRUE(out.find("[{\"ts\":1700000000,") == 0);
+    TEST_ASSERT_TRUE(out.find("},{\"ts\":1700000005,") != std::string::npos);
+    TEST_ASSERT_TRUE(out.find("},{\"ts\":1700000010,") != std::string::npos);
+    TEST_ASSERT_TRUE(out.find(",,") == std::string::npos);
+    TEST_ASSERT_EQUAL_UINT32(3, exp.getPointsWritten());
+}
+
+// --------------------------------------------------------------------------
+// Tests: chunking
+// --------------------------------------------------------------------------
+
+void test_output_independent_of_chunk_size(void) {
+    SyntheticSource a = { 0, 500, false };
+    SessionExporter big(SessionExporter::Format::CSV, syntheticNext, &a);
+    std::string reference = drain(big, 2048);
+
+    const size_t sizes[] = { 1, 7, 64, 1436 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        SyntheticSource b = { 0, 500, false };
+        SessionExporter small(SessionExporter::Format::CSV, syntheticNext, &b);
+        TEST_ASSERT_TRUE(drain(small, sizes[s]) == reference);
+    }
+}
+
+void test_read_after_done_returns_zero(void) {
+    SyntheticSource src = { 0, 2, false };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &src);
+    drain(exp, 512);
+    uint8_t buf[16];
+    TEST_ASSERT_EQUAL_UINT32(0, exp.read(buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(exp.isDone());
+}
+
+// --------------------------------------------------------------------------
+// Tests: truncation
+// --------------------------------------------------------------------------
+
+void test_complete_source_keeps_footer(void) {
+    SyntheticSource src = { 0, 2, false };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &src, syntheticShort);
+    std::string out = drain(exp, 512);
+    TEST_ASSERT_EQUAL_UINT8(']', out.back());
+    TEST_ASSERT_FALSE(exp.isTruncated());
+}
+
+void test_short_csv_ends_with_marker(void) {
+    SyntheticSource src = { 0, 3, true };
+    SessionExporter exp(SessionExporter::Format::CSV, syntheticNext, &src, syntheticShort);
+    std::string out = drain(exp, 7);
+    TEST_ASSERT_TRUE(exp.isTruncated());
+    TEST_ASSERT_TRUE(exp.isDone());
+    TEST_ASSERT_EQUAL_UINT32(3, exp.getPointsWritten());
+    TEST_ASSERT_TRUE(out.size() > 12 && out.compare(out.size() - 12, 12, "# truncated\n") == 0);
+}
+
+void test_short_json_left_unclosed(void) {
+    SyntheticSource src = { 0, 3, true };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &src, syntheticShort);
+    std::string out = drain(exp, 512);
+    TEST_ASSERT_TRUE(exp.isTruncated());
+    TEST_ASSERT_EQUAL_UINT8('}', out.back());
+    TEST_ASSERT_TRUE(out.find(']') == std::string::npos);
+}
+
+// --------------------------------------------------------------------------
+// Tests: export pipe
+// --------------------------------------------------------------------------
+
+#define PIPE_BYTES ((SESSION_EXPORT_CHUNKS - 1) * SESSION_EXPORT_CHUNK_SIZE)
+
+void test_pipe_matches_direct_export(void) {
+    SyntheticSource a = { 0, 500, false };
+    SessionExporter direct(SessionExporter::Format::CSV, syntheticNext, &a);
+    std::string reference = drain(direct, 2048);
+
+    SyntheticSource b = { 0, 500, false };
+    SessionExporter exp(SessionExporter::Format::CSV, syntheticNext, &b);
+    SessionExportPipe pipe;
+    std::string out;
+    uint8_t buf[7];
+    while (!pipe.isDone()) {
+        pipe.pump(exp);
+        size_t n;
+        while ((n = pipe.read(buf, sizeof(buf))) > 0) out.append((const char*)buf, n);
+    }
+    TEST_ASSERT_TRUE(out == reference);
+    TEST_ASSERT_EQUAL_UINT32(0, pipe.read(buf, sizeof(buf)));
+}
+
+void test_pipe_pump_is_bounded(void) {
+    SyntheticSource src = { 0, 500, false };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &src);
+    SessionExportPipe pipe;
+
+    // One pump fills the pipe and no more; a full pipe formats nothing
+    TEST_ASSERT_EQUAL_UINT32(PIPE_BYTES, pipe.pump(exp));
+    TEST_ASSERT_EQUAL_UINT32(0, pipe.pump(exp));
+
+    // Reading it empty leaves the export open, not done
+    uint8_t buf[PIPE_BYTES + 1];
+    TEST_ASSERT_EQUAL_UINT32(PIPE_BYTES, pipe.read(buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_UINT32(0, pipe.read(buf, sizeof(buf)));
+    TEST_ASSERT_FALSE(pipe.isDone());
+    TEST_ASSERT_FALSE(exp.isDone());
+
+    // Ended early: what was queued still drains, then the pipe is done
+    TEST_ASSERT_EQUAL_UINT32(PIPE_BYTES, pipe.pump(exp));
+    pipe.end();
+    TEST_ASSERT_EQUAL_UINT32(0, pipe.pump(exp));
+    TEST_ASSERT_FALSE(pipe.isDone());
+    TEST_ASSERT_EQUAL_UINT32(PIPE_BYTES, pipe.read(buf, sizeof(buf)));
+    TEST_ASSERT_TRUE(pipe.isDone());
+}
+
+void test_pipe_across_threads(void) {
+    SyntheticSource a = { 0, 20000, false };
+    SessionExporter direct(SessionExporter::Format::JSON, syntheticNext, &a);
+    std::string reference = drain(direct, 2048);
+
+    // The producer pumps like update() on the loop; the consumer reads in
+    // AsyncTCP-sized pieces and finds nothing ready now and then
+    SyntheticSource b = { 0, 20000, false };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &b);
+    SessionExportPipe pipe;
+    std::thread producer([&]() {
+        while (!pipe.isEnded()) {
+            if (pipe.pump(exp) == 0) std::this_thread::yield();
+        }
+    });
+
+    std::string out;
+    uint8_t buf[1436];
+    while (!pipe.isDone()) {
+        size_t n = pipe.read(buf, sizeof(buf));
+        if (n == 0) std::this_thread::yield();
+        out.append((const char*)buf, n);
+    }
+    producer.join();
+    TEST_ASSERT_TRUE(out == reference);
+}
+
+// --------------------------------------------------------------------------
+// Tests: bounded heap on a multi-MB export
+// --------------------------------------------------------------------------
+
+// 24-hour cook at 1 s resolution — far past the 600-point RAM window
+#define LONG_COOK_POINTS (24UL * 3600UL)
+#define HEAP_LIMIT_BYTES 256
+
+void test_multi_mb_csv_export_heap_bounded(void) {
+    SyntheticSource src = { 0, (uint32_t)LONG_COOK_POINTS, false };
+    SessionExporter exp(SessionExporter::Format::CSV, syntheticNext, &src);
+
+    // Chunk size typical of an AsyncTCP send window
+    uint8_t chunk[1436];
+    size_t total = 0;
+    size_t n;
+
+    resetHeapStats();
+    size_t baseline = g_liveBytes;
+    while ((n = exp.read(chunk, sizeof(chunk))) > 0) {
+        total += n;
+    }
+
+    TEST_ASSERT_TRUE(total > 2UL * 1024UL * 1024UL);
+    TEST_ASSERT_EQUAL_UINT32(LONG_COOK_POINTS, exp.getPointsWritten());
+    TEST_ASSERT_TRUE(g_peakBytes - baseline <= HEAP_LIMIT_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(0, g_allocCount);
+}
+
+void test_multi_mb_json_export_heap_bounded(void) {
+    SyntheticSource src = { 0, (uint32_t)LONG_COOK_POINTS, false };
+    SessionExporter exp(SessionExporter::Format::JSON, syntheticNext, &src);
+
+    uint8_t chunk[1436];
+    size_t total = 0;
+    size_t n;
+
+    resetHeapStats();
+    size_t baseline = g_liveBytes;
+    while ((n = exp.read(chunk, sizeof(chunk))) > 0) {
+        total += n;
+    }
+
+    TEST_ASSERT_TRUE(total > 4UL * 1024UL * 1024UL);
+    TEST_ASSERT_TRUE(g_peakBytes - baseline <= HEAP_LIMIT_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(0, g_allocCount);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // CSV
+    RUN_TEST(test_csv_empty_is_header_only);
+    RUN_TEST(test_csv_row_format);
+    RUN_TEST(test_csv_negative_temp);
+    RUN_TEST(test_content_type_and_filename);
+
+    // JSON
+    RUN_TEST(test_json_empty_array);
+    RUN_TEST(test_json_separators);
+
+    // Chunking
+    RUN_TEST(test_output_independent_of_chunk_size);
+    RUN_TEST(test_read_after_done_returns_zero);
+
+    // Truncation
+    RUN_TEST(test_complete_source_keeps_footer);
+    RUN_TEST(test_short_csv_ends_with_marker);
+    RUN_TEST(test_short_json_left_unclosed);
+
+    // Export pipe
+    RUN_TEST(test_pipe_matches_direct_export);
+    RUN_TEST(test_pipe_pump_is_bounded);
+    RUN_TEST(test_pipe_across_threads);
+
+    // Bounded heap
+    RUN_TEST(test_multi_mb_csv_export_heap_bounded);
+    RUN_TEST(test_multi_mb_json_export_heap_bounded);
+
+    return UNITY_END();
+}
@@ -0,0 +1,335 @@
+/**
+ * test_session_index.cpp
+ *
+ * Tests for the sparse block index and block reader behind CookSession's
+ * paged range reads, run against an in-memory session file.
+ *
+ * Tests cover:
+ *   - Index lookup (binary search) and stride doubling when the table fills
+ *   - Sequential decode and random seeks across the whole file
+ *   - Resync past a corrupted block keeps the numbering of the blocks after
+ *     it; resync through junk reads the file a window at a time
+ *   - Per-page read latency benchmark: indexed seek vs. scanning from the
+ *     start of the file (bytes read are asserted; timings are printed)
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+#include "session_index.h"
+#include "session_index.cpp"
+#include "session_codec.cpp"
+
+// --------------------------------------------------------------------------
+// In-memory session file
+// --------------------------------------------------------------------------
+
+struct MemFile {
+    std::vector<uint8_t> data;
+    size_t bytesRead;
+    size_t reads;
+};
+
+static size_t memReadAt(void* ctx, uint32_t offset, uint8_t* buf, size_t len) {
+    MemFile* f = static_cast<MemFile*>(ctx);
+    f->reads++;
+    if (offset >= f->data.size()) return 0;
+    size_t n = f->data.size() - offset;
+    if (n > len) n = len;
+    memcpy(buf, f->data.data() + offset, n);
+    f->bytesRead += n;
+    return n;
+}
+
+static DataPoint pointAt(uint32_t i) {
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = 1700000000 + i * 5;
+    dp.pitTemp   = (int16_t)(2250 + (int16_t)(i % 7) - 3);
+    dp.meat1Temp = (int16_t)(400 + i / 4);
+    dp.meat2Temp = (int16_t)(380 + i / 5);
+    dp.fanPct    = (uint8_t)(30 + (i / 6) % 3);
+    dp.damperPct = 100;
+    return dp;
+}
+
+// Encode points [0, count) as the device does: one block per flush
+static void buildFile(MemFile& file, SessionIndex& index, uint32_t count) {
+    file.data.clear();
+    file.bytesRead = 0;
+    file.reads = 0;
+    index.clear();
+
+    uint8_t header[SESSION_FILE_HEADER_SIZE];
+    session_codec::writeFileHeader(header, 1700000000, SESSION_BLOCK_POINTS);
+    file.data.insert(file.data.end(), header, header + sizeof(header));
+
+    for (uint32_t first = 0; first < count; first += SESSION_BLOCK_POINTS) {
+        DataPoint pts[SESSION_BLOCK_POINTS];
+        uint8_t n = 0;
+        while (n < SESSION_BLOCK_POINTS && first + n < count) {
+            pts[n] = pointAt(first + n);
+            n++;
+        }
+        uint8_t block[SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_POINTS)];
+        size_t len = session_codec::encodeBlock(pts, n, first, block, sizeof(block));
+        index.addBlock(first, (uint32_t)file.data.size());
+        file.data.insert(file.data.end(), block, block + len);
+    }
+}
+
+// Position reader at point via the index, as CookSession::seek() does
+static bool seekIndexed(SessionBlockReader& reader, const SessionIndex& index, uint32_t point) {
+    uint32_t first, offset;
+    if (!index.find(point, &first, &offset)) return false;
+    reader.seekBlock(offset, first);
+    return reader.skipTo(point);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: SessionIndex
+// --------------------------------------------------------------------------
+
+void test_index_empty_find_fails(void) {
+    SessionIndex index;
+    TEST_ASSERT_FALSE(index.find(0, nullptr, nullptr));
+    TEST_ASSERT_EQUAL_UINT16(0, index.getCount());
+}
+
+void test_index_find_floor_entry(void) {
+    SessionIndex index;
+    index.addBlock(0, 12);
+    index.addBlock(12, 40);
+    index.addBlock(24, 70);
+
+    uint32_t first, offset;
+    TEST_ASSERT_TRUE(index.find(0, &first, &offset));
+    TEST_ASSERT_EQUAL_UINT32(0, first);
+    TEST_ASSERT_TRUE(index.find(23, &first, &offset));
+    TEST_ASSERT_EQUAL_UINT32(12, first);
+    TEST_ASSERT_EQUAL_UINT32(40, offset);
+    TEST_ASSERT_TRUE(index.find(1000, &first, &offset));
+    TEST_ASSERT_EQUAL_UINT32(24, first);
+    TEST_ASSERT_EQUAL_UINT32(70, offset);
+}
+
+void test_index_stride_doubles_when_full(void) {
+    SessionIndex index;
+    uint32_t blocks = SESSION_INDEX_SIZE * 4;
+    for (uint32_t b = 0; b < blocks; b++) {
+        index.addBlock(b * SESSION_BLOCK_POINTS, b * 100);
+    }
+
+    TEST_ASSERT_TRUE(index.getCount() <= SESSION_INDEX_SIZE);
+    TEST_ASSERT_EQUAL_UINT16(4, index.getStride());
+
+    // Every entry still points at a real block boundary, aligned to the stride
+    uint32_t first, offset;
+    TEST_ASSERT_TRUE(index.find(blocks * SESSION_BLOCK_POINTS - 1, &first, &offset));
+    TEST_ASSERT_EQUAL_UINT32(0, (offset / 100) % 4);
+    TEST_ASSERT_EQUAL_UINT32(first, (offset / 100) * SESSION_BLOCK_POINTS);
+    TEST_ASSERT_TRUE(blocks * SESSION_BLOCK_POINTS - 1 - first < 4 * SESSION_BLOCK_POINTS);
+}
+
+// --------------------------------------------------------------------------
+// Tests: SessionBlockReader
+// --------------------------------------------------------------------------
+
+void test_reader_sequential_whole_file(void) {
+    MemFile file;
+    SessionIndex index;
+    buildFile(file, index, 1000);
+
+    SessionBlockReader reader;
+    reader.begin(memReadAt, &file, SESSION_FILE_HEADER_SIZE);
+
+    DataPoint dp;
+    uint32_t i = 0;
+    while (reader.next(dp)) {
+        TEST_ASSERT_EQUAL_UINT32(pointAt(i).timestamp, dp.timestamp);
+        TEST_ASSERT_EQUAL_INT16(pointAt(i).meat1Temp, dp.meat1Temp);
+        i++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(1000, i);
+}
+
+void test_reader_random_seeks(void) {
+    MemFile file;
+    SessionIndex index;
+    buildFile(file, index, 5000);
+
+    SessionBlockReader reader;
+    reader.begin(memReadAt, &file, SESSION_FILE_HEADER_SIZE);
+
+    const uint32_t targets[] = { 4999, 0, 2500, 11, 12, 13, 4800, 1 };
+    for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++) {
+        TEST_ASSERT_TRUE(seekIndexed(reader, index, targets[t]));
+        TEST_ASSERT_EQUAL_UINT32(targets[t], reader.getNextPoint());
+        DataPoint dp;
+        TEST_ASSERT_TRUE(reader.next(dp));
+        TEST_ASSERT_EQUAL_UINT32(pointAt(targets[t]).timestamp, dp.timestamp);
+    }
+}
+
+void test_reader_seek_past_end_fails(void) {
+    MemFile file;
+    SessionIndex index;
+    buildFile(file, index, 100);
+
+    SessionBlockReader reader;
+    reader.begin(memReadAt, &file, SESSION_FILE_HEADER_SIZE);
+    TEST_ASSERT_FALSE(seekIndexed(reader, index, 100));
+}
+
+void test_reader_resyncs_after_corrupt_block(void) {
+    MemFile file;
+    SessionIndex index;
+    buildFile(file, index, 36);
+
+    // Corrupt a payload byte in the second block
+    uint32_t first, offset;
+    index.find(12, &first, &offset);
+    file.data[offset + SESSION_BLOCK_HEADER_SIZE + 2] ^= 0x55;
+
+    SessionBlockReader reader;
+    reader.begin(memReadAt, &file, SESSION_FILE_HEADER_SIZE);
+
+    TEST_ASSERT_TRUE(reader.nextBlock());
+    TEST_ASSERT_EQUAL_UINT32(pointAt(0).timestamp, reader.getBlock()[0].timestamp);
+
+    // Second block is skipped; the third decodes with its own numbering
+    TEST_ASSERT_TRUE(reader.nextBlock());
+    TEST_ASSERT_EQUAL_UINT32(pointAt(24).timestamp, reader.getBlock()[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(24, reader.getBlockFirstPoint());
+    TEST_ASSERT_FALSE(reader.nextBlock());
+
+    // A cursor that wanted point 12 sees the gap rather than point 24
+    reader.seekBlock(SESSION_FILE_HEADER_SIZE, 0);
+    TEST_ASSERT_FALSE(reader.skipTo(12));
+    TEST_ASSERT_EQUAL_UINT32(24, reader.getNextPoint());
+}
+
+void test_reader_resyncs_through_junk_in_windows(void) {
+    MemFile file;
+    SessionIndex index;
+    buildFile(file, index, 24);
+
+    // 4 KB of junk with no sync marker between the two blocks
+    uint32_t first, offset;
+    index.find(12, &first, &offset);
+    std::vector<uint8_t> junk(4096, 0x5A);
+    file.data.insert(file.data.begin() + offset, junk.begin(), junk.end());
+
+    SessionBlockReader reader;
+    reader.begin(memReadAt, &file, SESSION_FILE_HEADER_SIZE);
+    TEST_ASSERT_TRUE(reader.nextBlock());
+    file.reads = 0;
+    file.bytesRead = 0;
+
+    TEST_ASSERT_TRUE(reader.nextBlock());
+    TEST_ASSERT_EQUAL_UINT32(12, reader.getBlockFirstPoint());
+    TEST_ASSERT_EQUAL_UINT32(offset + junk.size(), reader.getBlockOffset());
+    TEST_ASSERT_EQUAL_UINT32(pointAt(12).timestamp, reader.getBlock()[0].timestamp);
+
+    // Whole windows, each byte read about once, not a read per byte
+    size_t window = SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_POINTS);
+    TEST_ASSERT_TRUE(file.reads <= junk.size() / (window - SESSION_BLOCK_HEADER_SIZE) + 2);
+    TEST_ASSERT_TRUE(file.bytesRead < junk.size() + 2 * window);
+}
+
+// --------------------------------------------------------------------------
+// Benchmark: per-page read latency
+// --------------------------------------------------------------------------
+
+// 24-hour cook at the 5 s sample interval
+#define BENCH_POINTS  (24UL * 3600UL / 5UL)
+#define BENCH_PAGE    60
+#define BENCH_PAGES   200
+
+void test_benchmark_page_read_latency(void) {
+    MemFile file;
+    SessionIndex index;
+    buildFile(file, index, BENCH_POINTS);
+
+    SessionBlockReader reader;
+    reader.begin(memReadAt, &file, SESSION_FILE_HEADER_SIZE);
+    DataPoint page[BENCH_PAGE];
+
+    // Pseudo-random page starts across the whole cook
+    uint32_t starts[BENCH_PAGES];
+    uint32_t seed = 12345;
+    for (int p = 0; p < BENCH_PAGES; p++) {
+        seed = seed * 1103515245UL + 12345UL;
+        starts[p] = (seed >> 8) % (BENCH_POINTS - BENCH_PAGE);
+    }
+
+    // Indexed: seek via the sparse index, then decode one page
+    file.bytesRead = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int p = 0; p < BENCH_PAGES; p++) {
+        TEST_ASSERT_TRUE(seekIndexed(reader, index, starts[p]));
+        for (int i = 0; i < BENCH_PAGE; i++) TEST_ASSERT_TRUE(reader.next(page[i]));
+        TEST_ASSERT_EQUAL_UINT32(pointAt(starts[p]).timestamp, page[0].timestamp);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    size_t indexedBytes = file.bytesRead;
+
+    // Baseline: scan from the start of the file for every page
+    file.bytesRead = 0;
+    auto t2 = std::chrono::steady_clock::now();
+    for (int p = 0; p < BENCH_PAGES; p++) {
+        reader.seekBlock(SESSION_FILE_HEADER_SIZE, 0);
+        TEST_ASSERT_TRUE(reader.skipTo(starts[p]));
+        for (int i = 0; i < BENCH_PAGE; i++) TEST_ASSERT_TRUE(reader.next(page[i]));
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    size_t scanBytes = file.bytesRead;
+
+    double indexedUs = std::chrono::duration<double, std::micro>(t1 - t0).count() / BENCH_PAGES;
+    double scanUs = std::chrono::duration<double, std::micro>(t3 - t2).count() / BENCH_PAGES;
+    printf("  %u-point pages over %u points (stride %u, %u entries):\n",
+           (unsigned)BENCH_PAGE, (unsigned)BENCH_POINTS,
+           (unsigned)index.getStride(), (unsigned)index.getCount());
+    printf("    indexed: %8.1f us/page  %7u bytes/page\n",
+           indexedUs, (unsigned)(indexedBytes / BENCH_PAGES));
+    printf("    scan:    %8.1f us/page  %7u bytes/page\n",
+           scanUs, (unsigned)(scanBytes / BENCH_PAGES));
+
+    // Flash traffic per page is bounded by page size + stride blocks,
+    // independent of where in the cook the page starts.
+    size_t maxBlocks = BENCH_PAGE / SESSION_BLOCK_POINTS + 1 + index.getStride();
+    TEST_ASSERT_TRUE(indexedBytes / BENCH_PAGES <= maxBlocks * SESSION_BLOCK_MAX_SIZE(SESSION_BLOCK_POINTS));
+    TEST_ASSERT_TRUE(indexedBytes * 20 < scanBytes);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // SessionIndex
+    RUN_TEST(test_index_empty_find_fails);
+    RUN_TEST(test_index_find_floor_entry);
+    RUN_TEST(test_index_stride_doubles_when_full);
+
+    // SessionBlockReader
+    RUN_TEST(test_reader_sequential_whole_file);
+    RUN_TEST(test_reader_random_seeks);
+    RUN_TEST(test_reader_seek_past_end_fails);
+    RUN_TEST(test_reader_resyncs_after_corrupt_block);
+    RUN_TEST(test_reader_resyncs_through_junk_in_windows);
+
+    // Benchmark
+    RUN_TEST(test_benchmark_page_read_latency);
+
+    return UNITY_END();
+}
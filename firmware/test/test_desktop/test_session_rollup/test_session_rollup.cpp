@@ -0,0 +1,214 @@
+/**
+ * test_session_rollup.cpp
+ *
+ * Tests for the multi-resolution rollup tiers (min/max/mean buckets) kept
+ * by CookSession for long-cook history replay.
+ *
+ * Tests cover:
+ *   - Bucket alignment and completion on interval boundaries
+ *   - Min/max/mean per channel, flag OR, min-before-max ordering
+ *   - Disconnected-probe samples excluded from channel statistics
+ *   - Tier ring indexing and RAM window
+ *   - Tier selection for a span and point budget
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "session_rollup.h"
+#include "session_rollup.cpp"
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+static DataPoint makePoint(uint32_t ts, int16_t pit, int16_t meat1, int16_t meat2,
+                           uint8_t fan, uint8_t flags) {
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = ts;
+    dp.pitTemp   = pit;
+    dp.meat1Temp = meat1;
+    dp.meat2Temp = meat2;
+    dp.fanPct    = fan;
+    dp.damperPct = 100 - fan;
+    dp.flags     = flags;
+    return dp;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: RollupAccumulator
+// --------------------------------------------------------------------------
+
+void test_bucket_completes_on_boundary(void) {
+    RollupAccumulator acc;
+    acc.setInterval(60);
+    RollupPoint done;
+
+    // T is minute-aligned; samples 40 s and 55 s in share a bucket
+    const uint32_t T = 1700000040;
+    TEST_ASSERT_FALSE(acc.add(makePoint(T + 40, 2250, 0, 0, 50, 0), done));
+    TEST_ASSERT_FALSE(acc.add(makePoint(T + 55, 2260, 0, 0, 50, 0), done));
+    TEST_ASSERT_TRUE(acc.add(makePoint(T + 60, 2270, 0, 0, 50, 0), done));
+
+    TEST_ASSERT_EQUAL_UINT32(T, done.timestamp);
+    TEST_ASSERT_EQUAL_UINT8(2, done.count);
+    TEST_ASSERT_EQUAL_INT16(2250, done.pitMin);
+    TEST_ASSERT_EQUAL_INT16(2260, done.pitMax);
+    TEST_ASSERT_EQUAL_INT16(2255, done.pitAvg);
+}
+
+void test_min_max_mean_and_flags(void) {
+    RollupAccumulator acc;
+    acc.setInterval(300);
+    uint32_t t0 = 1700000100;  // Aligned to 300 s
+    RollupPoint done;
+
+    acc.add(makePoint(t0,      2250, 400, 380, 40, 0), done);
+    acc.add(makePoint(t0 + 5,  1900, 402, 381, 80, DP_FLAG_LID_OPEN), done);  // Lid dip
+    acc.add(makePoint(t0 + 10, 2300, 404, 382, 60, DP_FLAG_ALARM_PIT), done);
+    TEST_ASSERT_TRUE(acc.getPartial(done));
+
+    TEST_ASSERT_EQUAL_INT16(1900, done.pitMin);
+    TEST_ASSERT_EQUAL_INT16(2300, done.pitMax);
+    TEST_ASSERT_EQUAL_INT16(2150, done.pitAvg);
+    TEST_ASSERT_EQUAL_INT16(400, done.meat1Min);
+    TEST_ASSERT_EQUAL_INT16(404, done.meat1Max);
+    TEST_ASSERT_EQUAL_INT16(402, done.meat1Avg);
+    TEST_ASSERT_EQUAL_UINT8(60, done.fanAvg);
+    TEST_ASSERT_EQUAL_UINT8(40, done.damperAvg);
+    TEST_ASSERT_EQUAL_UINT8(DP_FLAG_LID_OPEN | DP_FLAG_ALARM_PIT, done.flags);
+
+    // Pit dipped (min) before it peaked (max)
+    TEST_ASSERT_TRUE(done.minFirst & ROLLUP_MIN_FIRST_PIT);
+}
+
+void test_max_before_min_ordering(void) {
+    RollupAccumulator acc;
+    acc.setInterval(60);
+    RollupPoint done;
+
+    acc.add(makePoint(1700000040, 2250, 0, 0, 0, 0), done);
+    acc.add(makePoint(1700000045, 2400, 0, 0, 0, 0), done);
+    acc.add(makePoint(1700000050, 2000, 0, 0, 0, 0), done);
+    acc.getPartial(done);
+    TEST_ASSERT_FALSE(done.minFirst & ROLLUP_MIN_FIRST_PIT);
+}
+
+void test_disconnected_samples_excluded(void) {
+    RollupAccumulator acc;
+    acc.setInterval(60);
+    RollupPoint done;
+
+    // Meat 2 never connected; meat 1 drops out for one sample
+    uint8_t m2 = DP_FLAG_MEAT2_DISC;
+    acc.add(makePoint(1700000040, 2250, 400, 0, 0, m2), done);
+    acc.add(makePoint(1700000045, 2250, 0,   0, 0, m2 | DP_FLAG_MEAT1_DISC), done);
+    acc.add(makePoint(1700000050, 2250, 410, 0, 0, m2), done);
+    acc.getPartial(done);
+
+    TEST_ASSERT_EQUAL_INT16(400, done.meat1Min);
+    TEST_ASSERT_EQUAL_INT16(405, done.meat1Avg);
+    TEST_ASSERT_FALSE(done.flags & DP_FLAG_MEAT1_DISC);
+    TEST_ASSERT_TRUE(done.flags & DP_FLAG_MEAT2_DISC);
+}
+
+void test_empty_partial(void) {
+    RollupAccumulator acc;
+    RollupPoint done;
+    TEST_ASSERT_FALSE(acc.getPartial(done));
+}
+
+void test_rollup_point_has_no_padding(void) {
+    TEST_ASSERT_EQUAL_UINT32(28, sizeof(RollupPoint));
+}
+
+// --------------------------------------------------------------------------
+// Tests: RollupTier
+// --------------------------------------------------------------------------
+
+void test_tier_counts_buckets(void) {
+    RollupTier tier;
+    tier.begin(60);
+
+    // 10 minutes at 5 s -> 9 completed buckets + the 10th in progress
+    for (uint32_t i = 0; i < 120; i++) {
+        tier.add(makePoint(1700000040 + i * 5, 2250, 0, 0, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(9, tier.getCount());
+    TEST_ASSERT_NOT_NULL(tier.get(0));
+    TEST_ASSERT_EQUAL_UINT8(12, tier.get(0)->count);
+    TEST_ASSERT_NULL(tier.get(9));
+
+    TEST_ASSERT_TRUE(tier.finish());
+    TEST_ASSERT_EQUAL_UINT32(10, tier.getCount());
+    TEST_ASSERT_FALSE(tier.finish());
+}
+
+void test_tier_ring_window(void) {
+    RollupTier tier;
+    tier.begin(60);
+
+    uint32_t buckets = SESSION_ROLLUP_RING + 30;
+    for (uint32_t b = 0; b <= buckets; b++) {
+        tier.add(makePoint(1699999980 + b * 60, (int16_t)b, 0, 0, 0, 0));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(buckets, tier.getCount());
+    TEST_ASSERT_EQUAL_UINT32(30, tier.getRamStart());
+    TEST_ASSERT_NULL(tier.get(29));
+    TEST_ASSERT_EQUAL_INT16(30, tier.get(30)->pitAvg);
+    TEST_ASSERT_EQUAL_INT16((int16_t)(buckets - 1), tier.get(buckets - 1)->pitAvg);
+}
+
+// --------------------------------------------------------------------------
+// Tests: tier selection
+// --------------------------------------------------------------------------
+
+void test_select_tier_for_budget(void) {
+    // 30 min at 5 s = 360 raw points: raw fits a 360 budget
+    TEST_ASSERT_EQUAL_INT(-1, session_rollup::selectTier(30 * 60, 360));
+    // 10 h: 7200 raw, 600 one-minute buckets -> 1-minute tier
+    TEST_ASSERT_EQUAL_INT(0, session_rollup::selectTier(10 * 3600, 600));
+    // 10 h into 360 points -> 5-minute tier (120 buckets)
+    TEST_ASSERT_EQUAL_INT(1, session_rollup::selectTier(10 * 3600, 360));
+    // 48 h into 100 points -> nothing fits, coarsest tier
+    TEST_ASSERT_EQUAL_INT(2, session_rollup::selectTier(48 * 3600, 100));
+}
+
+void test_tier_intervals(void) {
+    TEST_ASSERT_EQUAL_UINT16(60, session_rollup::tierInterval(0));
+    TEST_ASSERT_EQUAL_UINT16(300, session_rollup::tierInterval(1));
+    TEST_ASSERT_EQUAL_UINT16(900, session_rollup::tierInterval(2));
+    TEST_ASSERT_EQUAL_UINT16(0, session_rollup::tierInterval(SESSION_ROLLUP_TIERS));
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // RollupAccumulator
+    RUN_TEST(test_bucket_completes_on_boundary);
+    RUN_TEST(test_min_max_mean_and_flags);
+    RUN_TEST(test_max_before_min_ordering);
+    RUN_TEST(test_disconnected_samples_excluded);
+    RUN_TEST(test_empty_partial);
+    RUN_TEST(test_rollup_point_has_no_padding);
+
+    // RollupTier
+    RUN_TEST(test_tier_counts_buckets);
+    RUN_TEST(test_tier_ring_window);
+
+    // Tier selection
+    RUN_TEST(test_select_tier_for_budget);
+    RUN_TEST(test_tier_intervals);
+
+    return UNITY_END();
+}
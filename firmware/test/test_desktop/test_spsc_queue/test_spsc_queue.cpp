@@ -0,0 +1,152 @@
+/**
+ * test_spsc_queue.cpp
+ *
+ * Tests for the lock-free single-producer / single-consumer queue that
+ * carries session batches from the control loop to the writer task, and for
+ * the loop-iteration timing statistics.
+ *
+ * Tests cover:
+ *   - FIFO order, full and empty detection, capacity of N - 1
+ *   - Index wrap-around and high-water tracking
+ *   - Producer and consumer on separate threads (no loss, no reordering)
+ *   - LoopStats window max/average, overruns and all-time max
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <thread>
+
+#include "spsc_queue.h"
+#include "loop_stats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests: SpscQueue
+// --------------------------------------------------------------------------
+
+void test_empty_queue_pops_nothing(void) {
+    SpscQueue<uint32_t, 4> q;
+    uint32_t v;
+    TEST_ASSERT_TRUE(q.empty());
+    TEST_ASSERT_FALSE(q.pop(v));
+    TEST_ASSERT_NULL(q.peek());
+}
+
+void test_fifo_order(void) {
+    SpscQueue<uint32_t, 8> q;
+    for (uint32_t i = 1; i <= 5; i++) TEST_ASSERT_TRUE(q.push(i));
+    TEST_ASSERT_EQUAL_UINT32(5, q.size());
+    TEST_ASSERT_EQUAL_UINT32(1, *q.peek());
+
+    uint32_t v;
+    for (uint32_t i = 1; i <= 5; i++) {
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL_UINT32(i, v);
+    }
+    TEST_ASSERT_TRUE(q.empty());
+}
+
+void test_full_at_capacity(void) {
+    SpscQueue<uint32_t, 4> q;
+    TEST_ASSERT_EQUAL_UINT32(3, q.capacity());
+    TEST_ASSERT_TRUE(q.push(1));
+    TEST_ASSERT_TRUE(q.push(2));
+    TEST_ASSERT_TRUE(q.push(3));
+    TEST_ASSERT_FALSE(q.push(4));
+
+    uint32_t v;
+    TEST_ASSERT_TRUE(q.pop(v));
+    TEST_ASSERT_TRUE(q.push(4));
+}
+
+void test_wraps_and_tracks_high_water(void) {
+    SpscQueue<uint32_t, 4> q;
+    uint32_t v;
+    for (uint32_t i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(q.push(i));
+        TEST_ASSERT_TRUE(q.push(i + 1000));
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL_UINT32(i, v);
+        TEST_ASSERT_TRUE(q.pop(v));
+        TEST_ASSERT_EQUAL_UINT32(i + 1000, v);
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, q.getHighWater());
+}
+
+void test_two_threads_no_loss(void) {
+    static SpscQueue<uint32_t, 16> q;
+    const uint32_t COUNT = 200000;
+
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < COUNT; ) {
+            if (q.push(i)) i++;
+            else std::this_thread::yield();
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    while (expected < COUNT) {
+        uint32_t v;
+        if (q.pop(v)) {
+            if (v != expected) ordered = false;
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_TRUE(q.empty());
+}
+
+// --------------------------------------------------------------------------
+// Tests: LoopStats
+// --------------------------------------------------------------------------
+
+void test_loop_stats_window(void) {
+    LoopStats stats(10000);
+    stats.record(2000);
+    stats.record(4000);
+    stats.record(30000);  // A stalled pass
+
+    TEST_ASSERT_EQUAL_UINT32(3, stats.getCount());
+    TEST_ASSERT_EQUAL_UINT32(30000, stats.getMaxUs());
+    TEST_ASSERT_EQUAL_UINT32(12000, stats.getAvgUs());
+    TEST_ASSERT_EQUAL_UINT32(1, stats.getOverruns());
+}
+
+void test_loop_stats_reset_keeps_all_time_max(void) {
+    LoopStats stats(10000);
+    stats.record(25000);
+    stats.resetWindow();
+    stats.record(1500);
+
+    TEST_ASSERT_EQUAL_UINT32(1500, stats.getMaxUs());
+    TEST_ASSERT_EQUAL_UINT32(0, stats.getOverruns());
+    TEST_ASSERT_EQUAL_UINT32(25000, stats.getAllTimeMaxUs());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // SpscQueue
+    RUN_TEST(test_empty_queue_pops_nothing);
+    RUN_TEST(test_fifo_order);
+    RUN_TEST(test_full_at_capacity);
+    RUN_TEST(test_wraps_and_tracks_high_water);
+    RUN_TEST(test_two_threads_no_loss);
+
+    // LoopStats
+    RUN_TEST(test_loop_stats_window);
+    RUN_TEST(test_loop_stats_reset_keeps_all_time_max);
+
+    return UNITY_END();
+}
@@ -0,0 +1,198 @@
+/**
+ * test_system_snapshot.cpp
+ *
+ * Tests for the snapshot the control path publishes once per cycle and the
+ * two-slot seqlock it is published through.
+ *
+ * Tests cover:
+ *   - Seqlock: default value before the first write, newest value after
+ *   - Seqlock: version counting, alternating slots
+ *   - Seqlock: writer and reader on separate threads (no torn copies)
+ *   - SystemSnapshot: alarm bits, probe error bits, session record flags
+ *   - SystemSnapshot: session record fields (temps * 10, outputs)
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#include "seqlock.h"
+#include "system_snapshot.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Every field holds the same value, so a torn copy shows as a mismatch
+struct Pattern {
+    uint32_t words[64];
+
+    Pattern() { fill(0); }
+    void fill(uint32_t v) {
+        for (uint32_t& w : words) w = v;
+    }
+    bool whole() const {
+        for (uint32_t w : words) {
+            if (w != words[0]) return false;
+        }
+        return true;
+    }
+};
+
+// --------------------------------------------------------------------------
+// Tests: Seqlock
+// --------------------------------------------------------------------------
+
+void test_read_before_write_is_default(void) {
+    Seqlock<Pattern> lock;
+    Pattern p;
+    p.fill(7);
+    lock.read(p);
+    TEST_ASSERT_EQUAL_UINT32(0, p.words[0]);
+    TEST_ASSERT_TRUE(p.whole());
+    TEST_ASSERT_EQUAL_UINT32(0, lock.getVersion());
+}
+
+void test_read_returns_newest(void) {
+    Seqlock<Pattern> lock;
+    Pattern p;
+    for (uint32_t v = 1; v <= 5; v++) {
+        p.fill(v);
+        lock.write(p);
+        TEST_ASSERT_EQUAL_UINT32(v, lock.getVersion());
+    }
+    Pattern out;
+    lock.read(out);
+    TEST_ASSERT_EQUAL_UINT32(5, out.words[0]);
+    TEST_ASSERT_TRUE(out.whole());
+    TEST_ASSERT_EQUAL_UINT32(0, lock.getRetries());
+}
+
+void test_snapshot_through_seqlock(void) {
+    Seqlock<SystemSnapshot> lock;
+    SystemSnapshot s;
+    s.cycle = 42;
+    s.setpoint = 250.0f;
+    s.errorCount = 1;
+    strncpy(s.errors[0].message, "Pit probe disconnected", sizeof(s.errors[0].message) - 1);
+    lock.write(s);
+
+    SystemSnapshot out;
+    lock.read(out);
+    TEST_ASSERT_EQUAL_UINT32(42, out.cycle);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 250.0f, out.setpoint);
+    TEST_ASSERT_EQUAL_STRING("Pit probe disconnected", out.errors[0].message);
+}
+
+void test_two_threads_no_torn_reads(void) {
+    static Seqlock<Pattern> lock;
+    std::atomic<bool> done(false);
+    const uint32_t WRITES = 200000;
+
+    std::thread writer([&]() {
+        Pattern p;
+        for (uint32_t v = 1; v <= WRITES; v++) {
+            p.fill(v);
+            lock.write(p);
+        }
+        done.store(true);
+    });
+
+    uint32_t torn = 0;
+    uint32_t backwards = 0;
+    uint32_t last = 0;
+    Pattern out;
+    while (!done.load()) {
+        lock.read(out);
+        if (!out.whole()) torn++;
+        if (out.words[0] < last) backwards++;
+        last = out.words[0];
+    }
+    writer.join();
+
+    lock.read(out);
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, backwards);
+    TEST_ASSERT_EQUAL_UINT32(WRITES, out.words[0]);
+}
+
+// --------------------------------------------------------------------------
+// Tests: SystemSnapshot
+// --------------------------------------------------------------------------
+
+void test_alarm_and_probe_bits(void) {
+    SystemSnapshot s;
+    TEST_ASSERT_EQUAL_UINT8(0, s.alarmBits());
+    TEST_ASSERT_EQUAL_UINT8(0, s.probeErrorBits());
+
+    s.alarms[0] = AlarmType::PIT_LOW;
+    s.alarms[1] = AlarmType::MEAT2_DONE;
+    s.alarmCount = 2;
+    s.status[PROBE_MEAT1] = ProbeStatus::OPEN_CIRCUIT;
+    s.status[PROBE_MEAT2] = ProbeStatus::SHORT_CIRCUIT;
+    TEST_ASSERT_EQUAL_UINT8((1u << 2) | (1u << 4), s.alarmBits());
+    TEST_ASSERT_EQUAL_UINT8(0x06, s.probeErrorBits());
+    TEST_ASSERT_TRUE(s.hasAlarm(AlarmType::PIT_LOW));
+    TEST_ASSERT_FALSE(s.hasAlarm(AlarmType::PIT_HIGH));
+}
+
+void test_data_point_flags(void) {
+    SystemSnapshot s;
+    for (uint8_t i = 0; i < NUM_PROBES; i++) s.connected[i] = true;
+    TEST_ASSERT_EQUAL_UINT8(0, s.dataPointFlags());
+
+    s.lidOpen = true;
+    s.fireOut = true;
+    s.connected[PROBE_MEAT2] = false;
+    s.alarms[0] = AlarmType::PIT_HIGH;
+    s.alarms[1] = AlarmType::MEAT1_DONE;
+    s.alarmCount = 2;
+    TEST_ASSERT_EQUAL_UINT8(DP_FLAG_LID_OPEN | DP_FLAG_ERROR_FIREOUT | DP_FLAG_MEAT2_DISC |
+                            DP_FLAG_ALARM_PIT | DP_FLAG_ALARM_MEAT1,
+                            s.dataPointFlags());
+}
+
+void test_to_data_point(void) {
+    SystemSnapshot s;
+    s.temp[PROBE_PIT] = 225.5f;
+    s.temp[PROBE_MEAT1] = 165.0f;
+    s.temp[PROBE_MEAT2] = 0.0f;
+    s.connected[PROBE_PIT] = true;
+    s.connected[PROBE_MEAT1] = true;
+    s.fanPct = 42.7f;
+    s.damperPct = 100.0f;
+
+    DataPoint dp;
+    memset(&dp, 0, sizeof(dp));
+    dp.timestamp = 1700000000;
+    s.toDataPoint(dp);
+    TEST_ASSERT_EQUAL_UINT32(1700000000, dp.timestamp);
+    TEST_ASSERT_EQUAL_INT16(2255, dp.pitTemp);
+    TEST_ASSERT_EQUAL_INT16(1650, dp.meat1Temp);
+    TEST_ASSERT_EQUAL_INT16(0, dp.meat2Temp);
+    TEST_ASSERT_EQUAL_UINT8(42, dp.fanPct);
+    TEST_ASSERT_EQUAL_UINT8(100, dp.damperPct);
+    TEST_ASSERT_EQUAL_UINT8(DP_FLAG_MEAT2_DISC, dp.flags);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Seqlock
+    RUN_TEST(test_read_before_write_is_default);
+    RUN_TEST(test_read_returns_newest);
+    RUN_TEST(test_snapshot_through_seqlock);
+    RUN_TEST(test_two_threads_no_torn_reads);
+
+    // SystemSnapshot
+    RUN_TEST(test_alarm_and_probe_bits);
+    RUN_TEST(test_data_point_flags);
+    RUN_TEST(test_to_data_point);
+
+    return UNITY_END();
+}
@@ -0,0 +1,254 @@
+/**
+ * test_web_assets.cpp
+ *
+ * Tests for the web UI asset table: the index written by web_assets.py,
+ * path lookup, and the 200/304 and caching decision both web servers make.
+ *
+ * Tests cover:
+ *   - Loading an index: fields, gzip/immutable flags, comments, CRLF
+ *   - Malformed lines are skipped; an oversized index or one with too
+ *     many assets loads nothing
+ *   - loadPacked(): a compiled-in table is served in place (no copy of
+ *     the bytes); too many assets loads nothing; the file index clears it
+ *   - find(): exact paths, "/" serves /index.html, unknown paths
+ *   - If-None-Match: exact, lists, W/ prefix, "*", near misses
+ *   - reply(): 304 only on a match; immutable vs no-cache policy
+ *   - A repeat visit revalidates every asset to 304
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "config.h"
+#include "web_assets.h"
+#include "web_assets.cpp"
+
+// --------------------------------------------------------------------------
+// Helpers
+// --------------------------------------------------------------------------
+
+static const char* INDEX =
+    "# url file etag type flags\n"
+    "/app.5558ca3b79.js /app.5558ca3b79.js.gz \"c30eac3477a5b4aa\" application/javascript gi\n"
+    "/favicon.svg /favicon.svg.gz \"9cde1b9552fdac8c\" image/svg+xml g\n"
+    "/index.html /index.html.gz \"5f08cdd2ae8ff3a8\" text/html g\n"
+    "/manifest.json /manifest.json.gz \"ef94b3518b7466bd\" application/manifest+json g\n"
+    "/style.fc781aff46.css /style.fc781aff46.css.gz \"136015751ab21e7f\" text/css gi\n"
+    "/sw.js /sw.js.gz \"0a2c523eb6c9275c\" application/javascript g\n";
+
+static WebAssetTable table;
+
+static const WebAsset* find(const char* path) {
+    return table.find(path, strlen(path));
+}
+
+static int status(const WebAsset* a, const char* ifNoneMatch) {
+    return WebAssetTable::reply(*a, ifNoneMatch, ifNoneMatch ? strlen(ifNoneMatch) : 0).status;
+}
+
+static bool matches(const char* header, const char* etag) {
+    return WebAssetTable::etagMatches(header, strlen(header), etag);
+}
+
+void setUp(void) {
+    table.load(INDEX, strlen(INDEX));
+}
+
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Loading
+// --------------------------------------------------------------------------
+
+void test_load_parses_every_field(void) {
+    TEST_ASSERT_EQUAL_UINT8(6, table.size());
+
+    const WebAsset& app = table.at(0);
+    TEST_ASSERT_EQUAL_STRING("/app.5558ca3b79.js", app.url);
+    TEST_ASSERT_EQUAL_STRING("/app.5558ca3b79.js.gz", app.file);
+    TEST_ASSERT_EQUAL_STRING("\"c30eac3477a5b4aa\"", app.etag);
+    TEST_ASSERT_EQUAL_STRING("application/javascript", app.type);
+    TEST_ASSERT_TRUE(app.gzip);
+    TEST_ASSERT_TRUE(app.immutable);
+
+    const WebAsset& html = table.at(2);
+    TEST_ASSERT_EQUAL_STRING("/index.html", html.url);
+    TEST_ASSERT_TRUE(html.gzip);
+    TEST_ASSERT_FALSE(html.immutable);
+}
+
+void test_load_plain_asset_and_crlf(void) {
+    const char* text = "/a.png /a.png \"0011\" image/png -\r\n"
+                       "\r\n"
+                       "/b.txt /b.txt.gz \"0022\" text/plain g\r\n";
+    TEST_ASSERT_EQUAL_UINT8(2, table.load(text, strlen(text)));
+    TEST_ASSERT_EQUAL_STRING("/a.png", table.at(0).file);
+    TEST_ASSERT_FALSE(table.at(0).gzip);
+    TEST_ASSERT_FALSE(table.at(0).immutable);
+    TEST_ASSERT_EQUAL_STRING("\"0022\"", table.at(1).etag);
+    TEST_ASSERT_EQUAL_STRING("text/plain", table.at(1).type);
+    TEST_ASSERT_TRUE(table.at(1).gzip);
+}
+
+void test_load_skips_malformed_lines(void) {
+    const char* text = "/short /short.gz \"01\"\n"              // Missing fields
+                       "relative /r.gz \"02\" text/plain g\n"   // URL not absolute
+                       "/noquote /n.gz 03 text/plain g\n"       // ETag not quoted
+                       "/ok /ok.gz \"04\" text/plain g\n";
+    TEST_ASSERT_EQUAL_UINT8(1, table.load(text, strlen(text)));
+    TEST_ASSERT_EQUAL_STRING("/ok", table.at(0).url);
+}
+
+void test_load_rejects_oversized_index(void) {
+    std::string big(INDEX);
+    while (big.size() < WEB_ASSET_INDEX_MAX) big += "# padding padding padding padding\n";
+    TEST_ASSERT_EQUAL_UINT8(0, table.load(big.c_str(), big.size()));
+    TEST_ASSERT_EQUAL_UINT8(0, table.size());
+    TEST_ASSERT_NULL(find("/index.html"));
+
+    TEST_ASSERT_EQUAL_UINT8(0, table.load(nullptr, 0));
+}
+
+void test_load_rejects_too_many_assets(void) {
+    std::string text;
+    char line[64];
+    for (int i = 0; i <= WEB_ASSET_MAX; i++) {
+        snprintf(line, sizeof(line), "/f%d /f%d.gz \"%04d\" text/plain g\n", i, i, i);
+        text += line;
+    }
+    TEST_ASSERT_EQUAL_UINT8(0, table.load(text.c_str(), text.size()));
+
+    // Exactly WEB_ASSET_MAX fits
+    text = text.substr(0, text.rfind("/f"));
+    TEST_ASSERT_EQUAL_UINT8(WEB_ASSET_MAX, table.load(text.c_str(), text.size()));
+}
+
+void test_load_packed_serves_in_place(void) {
+    static const uint8_t PAGE[] = { 0x1f, 0x8b, 0x08, 0x00, 0x01 };
+    static const uint8_t ICON[] = { '<', 's', 'v', 'g', '>' };
+    static const WebAsset PACKED[] = {
+        { "/index.html", "/index.html.gz", "\"aa11\"", "text/html", true, false, PAGE, sizeof(PAGE) },
+        { "/icon.svg", "/icon.svg", "\"bb22\"", "image/svg+xml", false, true, ICON, sizeof(ICON) },
+    };
+    TEST_ASSERT_EQUAL_UINT8(2, table.loadPacked(PACKED, 2));
+
+    const WebAsset* page = find("/");
+    TEST_ASSERT_NOT_NULL(page);
+    TEST_ASSERT_EQUAL_PTR(PAGE, page->data);     // The table's bytes, not a copy
+    TEST_ASSERT_EQUAL_UINT32(sizeof(PAGE), page->size);
+    TEST_ASSERT_TRUE(page->gzip);
+    TEST_ASSERT_EQUAL_INT(304, status(page, "\"aa11\""));
+    TEST_ASSERT_EQUAL_STRING(WEB_CACHE_IMMUTABLE,
+                             WebAssetTable::reply(*find("/icon.svg"), nullptr, 0).cacheControl);
+    TEST_ASSERT_NULL(find("/app.5558ca3b79.js"));  // Replaced, not merged
+
+    // Assets loaded from an index have no bytes in memory
+    table.load(INDEX, strlen(INDEX));
+    TEST_ASSERT_NULL(find("/")->data);
+    TEST_ASSERT_EQUAL_UINT32(0, find("/")->size);
+}
+
+void test_load_packed_rejects_too_many(void) {
+    WebAsset many[WEB_ASSET_MAX + 1];
+    for (int i = 0; i <= WEB_ASSET_MAX; i++) many[i] = table.at(0);
+    TEST_ASSERT_EQUAL_UINT8(0, table.loadPacked(many, WEB_ASSET_MAX + 1));
+    TEST_ASSERT_EQUAL_UINT8(0, table.size());
+    TEST_ASSERT_EQUAL_UINT8(0, table.loadPacked(nullptr, 0));
+}
+
+// --------------------------------------------------------------------------
+// Lookup
+// --------------------------------------------------------------------------
+
+void test_find_paths(void) {
+    TEST_ASSERT_NOT_NULL(find("/sw.js"));
+    TEST_ASSERT_EQUAL_STRING("text/css", find("/style.fc781aff46.css")->type);
+
+    // The root serves the page
+    TEST_ASSERT_EQUAL_PTR(find("/index.html"), find("/"));
+
+    // Unfingerprinted names and prefixes don't match
+    TEST_ASSERT_NULL(find("/app.js"));
+    TEST_ASSERT_NULL(find("/sw"));
+    TEST_ASSERT_NULL(find("/sw.js.gz"));
+    TEST_ASSERT_NULL(find(""));
+
+    // Length-bounded (mongoose paths aren't NUL-terminated)
+    TEST_ASSERT_NOT_NULL(table.find("/sw.jsXYZ", 6));
+}
+
+// --------------------------------------------------------------------------
+// Validators
+// --------------------------------------------------------------------------
+
+void test_etag_matching(void) {
+    const char* etag = "\"5f08cdd2ae8ff3a8\"";
+    TEST_ASSERT_TRUE(matches("\"5f08cdd2ae8ff3a8\"", etag));
+    TEST_ASSERT_TRUE(matches("W/\"5f08cdd2ae8ff3a8\"", etag));
+    TEST_ASSERT_TRUE(matches("\"aaaa\", \"5f08cdd2ae8ff3a8\"", etag));
+    TEST_ASSERT_TRUE(matches("\"aaaa\",W/\"5f08cdd2ae8ff3a8\" ,\"bbbb\"", etag));
+    TEST_ASSERT_TRUE(matches("*", etag));
+    TEST_ASSERT_TRUE(matches("  *  ", etag));
+
+    TEST_ASSERT_FALSE(matches("", etag));
+    TEST_ASSERT_FALSE(matches("5f08cdd2ae8ff3a8", etag));        // Unquoted
+    TEST_ASSERT_FALSE(matches("\"5f08cdd2ae8ff3a\"", etag));     // One short
+    TEST_ASSERT_FALSE(matches("\"5f08cdd2ae8ff3a8x\"", etag));   // One long
+    TEST_ASSERT_FALSE(matches("\"aaaa\", \"bbbb\"", etag));
+    TEST_ASSERT_FALSE(matches(",,", etag));
+}
+
+void test_reply_status_and_caching(void) {
+    const WebAsset* html = find("/");
+    const WebAsset* app = find("/app.5558ca3b79.js");
+
+    TEST_ASSERT_EQUAL_INT(200, status(html, nullptr));
+    TEST_ASSERT_EQUAL_INT(200, status(html, "\"0a2c523eb6c9275c\""));  // Another asset's tag
+    TEST_ASSERT_EQUAL_INT(304, status(html, "\"5f08cdd2ae8ff3a8\""));
+
+    // Fingerprinted files are cached for good; the rest revalidate
+    WebAssetReply r = WebAssetTable::reply(*app, nullptr, 0);
+    TEST_ASSERT_EQUAL_STRING(WEB_CACHE_IMMUTABLE, r.cacheControl);
+    r = WebAssetTable::reply(*html, html->etag, strlen(html->etag));
+    TEST_ASSERT_EQUAL_INT(304, r.status);
+    TEST_ASSERT_EQUAL_STRING(WEB_CACHE_REVALIDATE, r.cacheControl);
+}
+
+void test_repeat_visit_all_not_modified(void) {
+    // A browser coming back sends each stored ETag; nothing needs a body
+    int notModified = 0;
+    for (uint8_t i = 0; i < table.size(); i++) {
+        const WebAsset& a = table.at(i);
+        if (WebAssetTable::reply(a, a.etag, strlen(a.etag)).status == 304) notModified++;
+    }
+    TEST_ASSERT_EQUAL_INT(table.size(), notModified);
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    // Loading
+    RUN_TEST(test_load_parses_every_field);
+    RUN_TEST(test_load_plain_asset_and_crlf);
+    RUN_TEST(test_load_skips_malformed_lines);
+    RUN_TEST(test_load_rejects_oversized_index);
+    RUN_TEST(test_load_rejects_too_many_assets);
+    RUN_TEST(test_load_packed_serves_in_place);
+    RUN_TEST(test_load_packed_rejects_too_many);
+
+    // Lookup
+    RUN_TEST(test_find_paths);
+
+    // Validators
+    RUN_TEST(test_etag_matching);
+    RUN_TEST(test_reply_status_and_caching);
+    RUN_TEST(test_repeat_visit_all_not_modified);
+
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+/**
+ * test_ws_events.cpp
+ *
+ * Tests for the queue that hands WebSocket events from the network task to
+ * the loop, which owns the client table.
+ *
+ * Tests cover:
+ *   - Drain order and count; drops counted when full
+ *   - Text pieces reassembled into a command on the consumer side
+ *   - A piece longer than any command is cut and still dropped as too long
+ *   - A producer thread posting while the consumer drains: nothing lost,
+ *     connect before data before disconnect for every client
+ */
+
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+
+#include "web_protocol.h"
+#include "web_protocol.cpp"
+#include "ws_events.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// --------------------------------------------------------------------------
+// Tests
+// --------------------------------------------------------------------------
+
+void test_drain_order_and_drops(void) {
+    WsEventQueue q;
+    TEST_ASSERT_TRUE(q.post(WsEvent::make(WsEventType::CONNECT, 7, 100)));
+    TEST_ASSERT_TRUE(q.post(WsEvent::make(WsEventType::SEEN, 7, 200)));
+    TEST_ASSERT_TRUE(q.post(WsEvent::make(WsEventType::DISCONNECT, 7, 300)));
+
+    WsEventType seen[3];
+    uint32_t ms[3];
+    uint8_t n = 0;
+    TEST_ASSERT_EQUAL_UINT16(3, q.drain([&](const WsEvent& e) {
+        seen[n] = e.type;
+        ms[n++] = e.ms;
+    }));
+    TEST_ASSERT_TRUE(seen[0] == WsEventType::CONNECT);
+    TEST_ASSERT_TRUE(seen[1] == WsEventType::SEEN);
+    TEST_ASSERT_TRUE(seen[2] == WsEventType::DISCONNECT);
+    TEST_ASSERT_EQUAL_UINT32(300, ms[2]);
+
+    for (uint32_t i = 0; i < WS_EVENT_QUEUE_DEPTH; i++) {
+        TEST_ASSERT_TRUE(q.post(WsEvent::make(WsEventType::SEEN, i, 0)));
+    }
+    TEST_ASSERT_FALSE(q.post(WsEvent::make(WsEventType::SEEN, 99, 0)));
+    TEST_ASSERT_EQUAL_UINT32(WS_EVENT_QUEUE_DEPTH + 3, q.getPosted());
+    TEST_ASSERT_EQUAL_UINT32(1, q.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(WS_EVENT_QUEUE_DEPTH, q.getQueuePeak());
+}
+
+void test_pieces_reassembled_by_consumer(void) {
+    WsEventQueue q;
+    const char* msg = "{\"type\":\"set\",\"sp\":250}";
+    size_t len = strlen(msg);
+    q.post(WsEvent::text(3, 0, msg, 10, true, false));
+    q.post(WsEvent::text(3, 0, msg + 10, len - 10, false, true));
+
+    bbq_protocol::CommandAssembler cmd;
+    int complete = 0;
+    q.drain([&](const WsEvent& e) {
+        if (cmd.feed(e.data, e.len, e.start, e.end) ==
+            bbq_protocol::CommandAssembler::Result::COMPLETE) complete++;
+    });
+    TEST_ASSERT_EQUAL_INT(1, complete);
+    TEST_ASSERT_EQUAL_STRING(msg, cmd.data());
+}
+
+void test_overlong_piece_dropped(void) {
+    static char big[WS_CMD_MAX_LEN * 3];
+    memset(big, 'x', sizeof(big));
+    WsEvent e = WsEvent::text(1, 0, big, sizeof(big), true, true);
+    TEST_ASSERT_EQUAL_UINT16(WS_CMD_MAX_LEN + 1, e.len);
+
+    bbq_protocol::CommandAssembler cmd;
+    TEST_ASSERT_TRUE(cmd.feed(e.data, e.len, e.start, e.end) ==
+                     bbq_protocol::CommandAssembler::Result::DROPPED);
+
+    // Exactly the longest command still fits
+    WsEvent fits = WsEvent::text(1, 0, big, WS_CMD_MAX_LEN, true, true);
+    TEST_ASSERT_TRUE(cmd.feed(fits.data, fits.len, fits.start, fits.end) ==
+                     bbq_protocol::CommandAssembler::Result::COMPLETE);
+}
+
+void test_producer_thread_no_loss(void) {
+    static WsEventQueue q;
+    const uint32_t CLIENTS = 20000;
+    std::atomic<bool> done(false);
+
+    // Network task: connect, a piece of data, disconnect, for each client
+    std::thread producer([&]() {
+        for (uint32_t id = 1; id <= CLIENTS; id++) {
+            while (!q.post(WsEvent::make(WsEventType::CONNECT, id, 0))) std::this_thread::yield();
+            while (!q.post(WsEvent::text(id, 0, "{}", 2, true, true))) std::this_thread::yield();
+            while (!q.post(WsEvent::make(WsEventType::DISCONNECT, id, 0))) std::this_thread::yield();
+        }
+        done.store(true);
+    });
+
+    // Loop: every client's events arrive whole and in order
+    uint32_t expectId = 1;
+    uint8_t expectStep = 0;
+    bool ordered = true;
+    auto handle = [&](const WsEvent& e) {
+        static const WsEventType STEPS[3] = {
+            WsEventType::CONNECT, WsEventType::TEXT, WsEventType::DISCONNECT
+        };
+        if (e.id != expectId || e.type != STEPS[expectStep]) ordered = false;
+        if (e.type == WsEventType::TEXT && (e.len != 2 || memcmp(e.data, "{}", 2) != 0)) {
+            ordered = false;
+        }
+        if (++expectStep == 3) {
+            expectStep = 0;
+            expectId++;
+        }
+    };
+    while (!done.load()) q.drain(handle);
+    q.drain(handle);
+    producer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_EQUAL_UINT32(CLIENTS + 1, expectId);
+    TEST_ASSERT_EQUAL_UINT32(CLIENTS * 3, q.getPosted());
+}
+
+// --------------------------------------------------------------------------
+// Main
+// --------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_drain_order_and_drops);
+    RUN_TEST(test_pieces_reassembled_by_consumer);
+    RUN_TEST(test_overlong_piece_dropped);
+    RUN_TEST(test_producer_thread_no_loss);
+
+    return UNITY_END();
+}
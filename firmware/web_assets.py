@@ -0,0 +1,204 @@
+"""
+Build the web UI bundle served by the device and the simulator.
+
+Reads the sources in data/, gzips every asset, renames app.js and style.css
+after a hash of their content (app.<hash>.js) and points index.html and sw.js
+at the new names. The output goes to .pio/web/ together with web.idx, the
+index the web servers load: one line per asset with its URL, stored file,
+strong ETag, content type and flags (g = gzip, i = immutable).
+
+It also writes the same bundle as a C++ table of const arrays to
+.pio/web_packed/web_assets_packed.h, which web_assets_packed.cpp compiles into
+the image (rodata, read in place from flash) unless the build sets
+WEB_ASSETS_EMBEDDED=0.
+
+As a PlatformIO extra script it runs before every build and puts the table on
+the include path. The filesystem image (`--target uploadfs`) holds the bundle
+only when it is not embedded; otherwise LittleFS is left to config and
+session data. Standalone:
+
+  python3 web_assets.py [SRC_DIR] [OUT_DIR] [PACKED_DIR]
+"""
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+# Assets renamed after their content; every other file keeps its URL
+FINGERPRINTED = ("app.js", "style.css")
+
+# Pages that reference the fingerprinted assets
+REWRITTEN = ("index.html", "sw.js")
+
+INDEX_NAME = "web.idx"
+PACKED_NAME = "web_assets_packed.h"
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+}
+
+
+def content_hash(data, length):
+    return hashlib.sha256(data).hexdigest()[:length]
+
+
+def content_type(name):
+    if name == "manifest.json":
+        return "application/manifest+json"
+    return CONTENT_TYPES.get(os.path.splitext(name)[1], "application/octet-stream")
+
+
+def fingerprint_name(name, data):
+    base, ext = os.path.splitext(name)
+    return "%s.%s%s" % (base, content_hash(data, 10), ext)
+
+
+def rewrite_refs(text, renames):
+    """Point quoted "/name" references at the fingerprinted names."""
+    for old, new in renames.items():
+        text = re.sub(r"(['\"])/%s\1" % re.escape(old), r"\1/%s\1" % new, text)
+    return text
+
+
+def write_if_changed(path, data):
+    """Skip unchanged files so the filesystem image isn't rebuilt needlessly."""
+    if os.path.isfile(path):
+        with open(path, "rb") as f:
+            if f.read() == data:
+                return
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def c_string(text):
+    return '"%s"' % text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def write_packed(path, entries, bodies):
+    """Emit the bundle as const arrays plus a WebAsset table."""
+    lines = [
+        "// Generated by web_assets.py from data/. Do not edit.",
+        "#pragma once",
+        "",
+        '#include "web_assets.h"',
+        "",
+    ]
+    for i, body in enumerate(bodies):
+        lines.append("static const uint8_t WEB_ASSET_DATA_%d[%d] = {" % (i, len(body)))
+        for off in range(0, len(body), 16):
+            lines.append("    " + ",".join("0x%02x" % b for b in body[off:off + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+    lines.append("static const WebAsset WEB_ASSETS_PACKED[] = {")
+    for i, (url, stored, etag, ctype, flags) in enumerate(entries):
+        lines.append("    { %s, %s, %s, %s, %s, %s, WEB_ASSET_DATA_%d, %d }," % (
+            c_string(url), c_string(stored), c_string(etag), c_string(ctype),
+            "true" if "g" in flags else "false",
+            "true" if "i" in flags else "false",
+            i, len(bodies[i])))
+    lines.append("};")
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    write_if_changed(path, ("\n".join(lines) + "\n").encode("ascii"))
+
+
+def build(src_dir, out_dir, packed_dir=None, verbose=True):
+    names = sorted(
+        n for n in os.listdir(src_dir)
+        if os.path.isfile(os.path.join(src_dir, n)) and not n.startswith(".")
+    )
+    sources = {}
+    for name in names:
+        with open(os.path.join(src_dir, name), "rb") as f:
+            sources[name] = f.read()
+
+    renames = {
+        n: fingerprint_name(n, sources[n]) for n in FINGERPRINTED if n in sources
+    }
+    for name in REWRITTEN:
+        if name in sources:
+            sources[name] = rewrite_refs(sources[name].decode("utf-8"), renames).encode("utf-8")
+
+    # A new bundle must also replace the service worker's offline cache
+    if "sw.js" in sources:
+        bundle = content_hash(b"".join(sources[n] for n in names), 10)
+        sources["sw.js"] = re.sub(
+            rb"(CACHE_VERSION\s*=\s*')[^']*(')",
+            lambda m: m.group(1) + b"pitclaw-" + bundle.encode("ascii") + m.group(2),
+            sources["sw.js"],
+        )
+
+    os.makedirs(out_dir, exist_ok=True)
+    entries = []
+    bodies = []
+    written = set()
+    raw_total = 0
+    stored_total = 0
+    for name in names:
+        data = sources[name]
+        url_name = renames.get(name, name)
+        # mtime=0 keeps the output (and so the ETag) identical across builds
+        packed = gzip.compress(data, compresslevel=9, mtime=0)
+        flags = "i" if name in renames else ""
+        if len(packed) < len(data):
+            stored, body, flags = url_name + ".gz", packed, "g" + flags
+        else:
+            stored, body = url_name, data
+        write_if_changed(os.path.join(out_dir, stored), body)
+        written.add(stored)
+        bodies.append(body)
+        entries.append((
+            "/" + url_name, "/" + stored, '"%s"' % content_hash(body, 16),
+            content_type(name), flags or "-",
+        ))
+        raw_total += len(sources[name])
+        stored_total += len(body)
+        if verbose:
+            print("  %-26s %7d -> %6d bytes" % ("/" + url_name, len(data), len(body)))
+
+    index = "# url file etag type flags\n" + "".join(" ".join(e) + "\n" for e in entries)
+    write_if_changed(os.path.join(out_dir, INDEX_NAME), index.encode("ascii"))
+    written.add(INDEX_NAME)
+    if packed_dir:
+        write_packed(os.path.join(packed_dir, PACKED_NAME), entries, bodies)
+
+    # Drop earlier builds' fingerprinted files
+    for name in os.listdir(out_dir):
+        if name not in written and os.path.isfile(os.path.join(out_dir, name)):
+            os.remove(os.path.join(out_dir, name))
+
+    if verbose:
+        print("Web UI: %d assets, %d -> %d bytes (%.1fx)" % (
+            len(entries), raw_total, stored_total,
+            raw_total / float(stored_total) if stored_total else 0.0))
+    return entries
+
+
+if __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(__file__))
+    src = sys.argv[1] if len(sys.argv) > 1 else os.path.join(here, "data")
+    out = sys.argv[2] if len(sys.argv) > 2 else os.path.join(here, ".pio", "web")
+    packed = sys.argv[3] if len(sys.argv) > 3 else os.path.join(here, ".pio", "web_packed")
+    build(src, out, packed)
+else:
+    Import("env")
+
+    project_dir = env.subst("$PROJECT_DIR")
+    out_dir = os.path.join(project_dir, ".pio", "web")
+    packed_dir = os.path.join(project_dir, ".pio", "web_packed")
+    build(os.path.join(project_dir, "data"), out_dir, packed_dir)
+    env.Append(CPPPATH=[packed_dir])
+
+    build_flags = " ".join(env.GetProjectOption("build_flags", []))
+    if re.search(r"-DWEB_ASSETS_EMBEDDED=0\b", build_flags):
+        env.Replace(PROJECT_DATA_DIR=out_dir)
+    else:
+        fs_dir = os.path.join(project_dir, ".pio", "fs")
+        os.makedirs(fs_dir, exist_ok=True)
+        env.Replace(PROJECT_DATA_DIR=fs_dir)